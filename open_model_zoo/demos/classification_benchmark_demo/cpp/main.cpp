@@ -332,9 +332,8 @@ int main(int argc, char *argv[]) {
 
         slog::info << "Metrics report:" << slog::endl;
         metrics.logTotal();
-        logLatencyPerStage(readerMetrics.getTotal().latency, pipeline.getPreprocessMetrics().getTotal().latency,
-            pipeline.getInferenceMetircs().getTotal().latency, pipeline.getPostprocessMetrics().getTotal().latency,
-            renderMetrics.getTotal().latency);
+        logLatencyPerStage(readerMetrics, pipeline.getPreprocessMetrics(),
+            pipeline.getInferenceMetircs(), pipeline.getPostprocessMetrics(), renderMetrics);
         slog::info << presenter.reportMeans() << slog::endl;
     }
     catch (const std::exception& error) {
@@ -0,0 +1,196 @@
+// Copyright (C) 2021 Intel Corporation
+// SPDX-License-Identifier: Apache-2.0
+//
+
+// Checks that AssignmentSolver finds optimal assignments of random dissimilarity matrices with and without gating,
+// comparing it with brute force on small matrices and with KuhnMunkres on large ones, and compares its speed with
+// KuhnMunkres solving the full matrix, as the pedestrian and smart classroom trackers did before.
+// Usage: assignment_solver_benchmark
+
+#include <algorithm>
+#include <cmath>
+#include <iomanip>
+#include <iostream>
+#include <limits>
+#include <random>
+#include <string>
+#include <vector>
+
+#include <opencv2/core.hpp>
+
+#include <utils/assignment_solver.hpp>
+#include <utils/kuhn_munkres.hpp>
+
+#include "benchmark_utils.hpp"
+
+namespace {
+const float noGating = std::numeric_limits<float>::infinity();
+const float impossible = std::numeric_limits<float>::infinity();
+// Stands in for gated and impossible pairs in matrices given to KuhnMunkres
+const float kuhnMunkresInfinity = 1e4f;
+const int bruteForceCasesNum = 2000;
+const int bruteForceMaxSize = 6;
+const double maxCostError = 1e-4;
+// KuhnMunkres is slow on large matrices, they are not checked and are timed with a single run
+const int singleRunSize = 200;
+
+// Random costs in [0, 1), a share of pairs is impossible
+cv::Mat makeMatrix(int rows, int cols, float impossibleShare, std::mt19937& generator) {
+    std::uniform_real_distribution<float> cost(0, 1);
+    cv::Mat matrix(rows, cols, CV_32F);
+    for (int row = 0; row < rows; row++) {
+        for (int col = 0; col < cols; col++) {
+            matrix.at<float>(row, col) = cost(generator) < impossibleShare ? impossible : cost(generator);
+        }
+    }
+    return matrix;
+}
+
+// Total cost of an assignment, every unassigned row costs maxCost if gating is enabled.
+// Fails if the assignment is invalid
+double assignmentCost(const cv::Mat& matrix, const std::vector<size_t>& assignment, float maxCost,
+                      const std::string& name) {
+    benchmark::check(assignment.size() == static_cast<size_t>(matrix.rows), "wrong result size on " + name);
+    const bool gated = std::isfinite(maxCost);
+    std::vector<char> isColUsed(matrix.cols, 0);
+    double cost = 0;
+    int assignedNum = 0;
+    for (int row = 0; row < matrix.rows; row++) {
+        const size_t col = assignment[row];
+        if (col == static_cast<size_t>(-1)) {
+            cost += gated ? maxCost : 0;
+            continue;
+        }
+        benchmark::check(col < static_cast<size_t>(matrix.cols) && !isColUsed[col],
+                         "invalid assignment on " + name);
+        const float pairCost = matrix.at<float>(row, static_cast<int>(col));
+        benchmark::check(std::isfinite(pairCost) && pairCost < maxCost, "gated pair is assigned on " + name);
+        isColUsed[col] = 1;
+        cost += pairCost;
+        assignedNum++;
+    }
+    benchmark::check(gated || assignedNum == std::min(matrix.rows, matrix.cols), "rows are left unassigned on " + name);
+    return cost;
+}
+
+// Optimal cost by enumerating assignments of rows one by one. Without gating rows may stay unassigned only if
+// there are more rows than columns
+void bruteForce(const cv::Mat& matrix, float maxCost, int row, int skipsLeft, double cost,
+                std::vector<char>& isColUsed, double& bestCost) {
+    if (row == matrix.rows) {
+        bestCost = std::min(bestCost, cost);
+        return;
+    }
+    for (int col = 0; col < matrix.cols; col++) {
+        const float pairCost = matrix.at<float>(row, col);
+        if (!isColUsed[col] && std::isfinite(pairCost) && pairCost < maxCost) {
+            isColUsed[col] = 1;
+            bruteForce(matrix, maxCost, row + 1, skipsLeft, cost + pairCost, isColUsed, bestCost);
+            isColUsed[col] = 0;
+        }
+    }
+    if (std::isfinite(maxCost)) {
+        bruteForce(matrix, maxCost, row + 1, skipsLeft, cost + maxCost, isColUsed, bestCost);
+    } else if (skipsLeft > 0) {
+        bruteForce(matrix, maxCost, row + 1, skipsLeft - 1, cost, isColUsed, bestCost);
+    }
+}
+
+double bruteForceCost(const cv::Mat& matrix, float maxCost) {
+    std::vector<char> isColUsed(matrix.cols, 0);
+    double bestCost = std::numeric_limits<double>::infinity();
+    bruteForce(matrix, maxCost, 0, std::max(matrix.rows - matrix.cols, 0), 0, isColUsed, bestCost);
+    return bestCost;
+}
+
+// KuhnMunkres has no gating, so every row gets a private column with cost maxCost and gated pairs get a cost
+// no optimal assignment takes
+double kuhnMunkresCost(const cv::Mat& matrix, float maxCost, const std::string& name) {
+    cv::Mat augmented(matrix.rows, matrix.cols + matrix.rows, CV_32F, cv::Scalar(kuhnMunkresInfinity));
+    for (int row = 0; row < matrix.rows; row++) {
+        for (int col = 0; col < matrix.cols; col++) {
+            const float pairCost = matrix.at<float>(row, col);
+            if (std::isfinite(pairCost) && pairCost < maxCost) {
+                augmented.at<float>(row, col) = pairCost;
+            }
+        }
+        augmented.at<float>(row, matrix.cols + row) = maxCost;
+    }
+    std::vector<size_t> assignment = KuhnMunkres().Solve(augmented);
+    for (size_t& col : assignment) {
+        if (col >= static_cast<size_t>(matrix.cols)) {
+            col = static_cast<size_t>(-1);
+        }
+    }
+    return assignmentCost(matrix, assignment, maxCost, name);
+}
+
+int candidatesNum(const cv::Mat& matrix, float maxCost) {
+    int num = 0;
+    for (int row = 0; row < matrix.rows; row++) {
+        const float* costs = matrix.ptr<float>(row);
+        num += static_cast<int>(std::count_if(costs, costs + matrix.cols, [maxCost](float cost) {
+            return cost < maxCost;
+        }));
+    }
+    return num;
+}
+
+template <typename Function>
+double timeMs(int size, Function&& function) {
+    return size > singleRunSize ? benchmark::medianTimeMs(function, 1, std::chrono::milliseconds(0))
+                                : benchmark::medianTimeMs(function);
+}
+}  // namespace
+
+int main() {
+    try {
+        std::mt19937 generator(0);
+        AssignmentSolver ungatedSolver;
+        std::uniform_int_distribution<int> size(1, bruteForceMaxSize);
+        for (int i = 0; i < bruteForceCasesNum; i++) {
+            const bool gated = i % 2 == 0;
+            const float maxCost = gated ? 0.6f : noGating;
+            const cv::Mat matrix = makeMatrix(size(generator), size(generator), gated ? 0.2f : 0.0f, generator);
+            const std::string name = std::to_string(matrix.rows) + "x" + std::to_string(matrix.cols) + " matrix #"
+                + std::to_string(i);
+            AssignmentSolver gatedSolver(maxCost);
+            AssignmentSolver& solver = gated ? gatedSolver : ungatedSolver;
+            const double cost = assignmentCost(matrix, solver.Solve(matrix), maxCost, name);
+            benchmark::check(std::abs(cost - bruteForceCost(matrix, maxCost)) <= maxCostError,
+                             "assignment is not optimal on " + name);
+        }
+
+        std::cout << std::left << std::setw(12) << "Matrix" << std::right << std::setw(12) << "Candidates"
+                  << std::setw(18) << "KuhnMunkres, ms" << std::setw(12) << "Solver, ms" << std::setw(10)
+                  << "Speedup" << std::endl;
+        for (int n : {50, 200, 500}) {
+            // About 5 candidates per row pass the gate, as in crowded tracking
+            const float maxCost = 5.0f / n;
+            const cv::Mat matrix = makeMatrix(n, n, 0.0f, generator);
+            const std::string name = std::to_string(n) + "x" + std::to_string(n) + " matrix";
+            AssignmentSolver solver(maxCost);
+            const double cost = assignmentCost(matrix, solver.Solve(matrix), maxCost, name);
+            // Larger matrices are only timed, KuhnMunkres takes over a minute on their augmented form
+            if (n <= singleRunSize) {
+                benchmark::check(std::abs(cost - kuhnMunkresCost(matrix, maxCost, name)) <= maxCostError * n,
+                                 "assignment is not optimal on " + name);
+                benchmark::check(std::abs(assignmentCost(matrix, ungatedSolver.Solve(matrix), noGating, name) -
+                                          assignmentCost(matrix, KuhnMunkres().Solve(matrix), noGating, name))
+                                     <= maxCostError * n,
+                                 "assignment without gating is not optimal on " + name);
+            }
+
+            const double kuhnMunkresMs = timeMs(n, [&] { KuhnMunkres().Solve(matrix); });
+            const double solverMs = timeMs(n, [&] { solver.Solve(matrix); });
+            std::cout << std::left << std::setw(12) << name.substr(0, name.find(' ')) << std::right
+                      << std::setw(12) << candidatesNum(matrix, maxCost) << std::fixed << std::setprecision(3)
+                      << std::setw(18) << kuhnMunkresMs << std::setw(12) << solverMs << std::setprecision(1)
+                      << std::setw(9) << kuhnMunkresMs / solverMs << "x" << std::endl;
+        }
+    } catch (const std::exception& error) {
+        std::cerr << error.what() << std::endl;
+        return 1;
+    }
+    return 0;
+}
@@ -0,0 +1,58 @@
+// Copyright (C) 2021 Intel Corporation
+// SPDX-License-Identifier: Apache-2.0
+//
+
+#pragma once
+
+#include <algorithm>
+#include <chrono>
+#include <cstdlib>
+#include <iostream>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+#include <opencv2/core.hpp>
+
+namespace benchmark {
+
+/// Calls the function at least minRuns times and for at least minTime
+/// @returns median duration of a call in ms
+template <typename Function>
+double medianTimeMs(Function&& function, int minRuns = 5,
+                    std::chrono::milliseconds minTime = std::chrono::milliseconds(200)) {
+    using Clock = std::chrono::steady_clock;
+    std::vector<double> times;
+    const Clock::time_point endTime = Clock::now() + minTime;
+    while (static_cast<int>(times.size()) < minRuns || Clock::now() < endTime) {
+        const Clock::time_point start = Clock::now();
+        function();
+        times.push_back(std::chrono::duration<double, std::milli>(Clock::now() - start).count());
+    }
+    std::nth_element(times.begin(), times.begin() + times.size() / 2, times.end());
+    return times[times.size() / 2];
+}
+
+/// Reads a sequence of matrices recorded with cv::FileStorage (.yml, .xml or .json) under the given name
+inline std::vector<cv::Mat> readRecordedMats(const std::string& fileName, const std::string& name) {
+    cv::FileStorage fs(fileName, cv::FileStorage::READ);
+    if (!fs.isOpened()) {
+        throw std::runtime_error("Can't open " + fileName);
+    }
+    std::vector<cv::Mat> mats;
+    fs[name] >> mats;
+    if (mats.empty()) {
+        throw std::runtime_error("No \"" + name + "\" matrices in " + fileName);
+    }
+    return mats;
+}
+
+/// Self-checks report failures and exit with a non-zero code, so they can be run as tests
+inline void check(bool condition, const std::string& message) {
+    if (!condition) {
+        std::cerr << "FAILED: " << message << std::endl;
+        std::exit(EXIT_FAILURE);
+    }
+}
+
+}  // namespace benchmark
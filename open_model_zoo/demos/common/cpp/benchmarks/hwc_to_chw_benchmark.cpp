@@ -0,0 +1,175 @@
+// Copyright (C) 2021 Intel Corporation
+// SPDX-License-Identifier: Apache-2.0
+//
+
+// Compares hwcToChw with the per-element loops matToBlob and the multi-channel demos used before, on BGR images
+// of 300x300, 416x416 and 608x608, one by one and in batches of 8.
+// Usage: hwc_to_chw_benchmark
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <iomanip>
+#include <iostream>
+#include <random>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+#include <opencv2/core.hpp>
+
+#include <utils/hwc_to_chw.hpp>
+
+#include "benchmark_utils.hpp"
+
+namespace {
+const int batchSize = 8;
+// Mean and scale values of ImageNet models, given in RGB order
+const cv::Scalar means(123.675, 116.28, 103.53);
+const cv::Scalar scales(58.395, 57.12, 57.375);
+// x * (1 / scale) - mean / scale differs from (x - mean) / scale by rounding
+const float maxNormalizedError = 1e-5f;
+
+cv::Mat makeImage(int size, std::mt19937& generator) {
+    std::uniform_int_distribution<int> value(0, 255);
+    cv::Mat image(size, size, CV_8UC3);
+    for (int y = 0; y < image.rows; y++) {
+        uint8_t* row = image.ptr<uint8_t>(y);
+        for (int x = 0; x < image.cols * 3; x++) {
+            row[x] = static_cast<uint8_t>(value(generator));
+        }
+    }
+    return image;
+}
+
+// getMatValue of matToBlob before hwcToChw
+template <typename T>
+T getMatValue(const cv::Mat& mat, size_t h, size_t w, size_t c) {
+    switch (mat.type()) {
+        case CV_8UC1:  return (T)mat.at<uchar>(h, w);
+        case CV_8UC3:  return (T)mat.at<cv::Vec3b>(h, w)[c];
+        case CV_32FC1: return (T)mat.at<float>(h, w);
+        case CV_32FC3: return (T)mat.at<cv::Vec3f>(h, w)[c];
+    }
+    throw std::runtime_error("cv::Mat type is not recognized");
+}
+
+template <typename T>
+void legacyMatToBlob(const cv::Mat& mat, T* blobData, size_t batchOffset = 0) {
+    const size_t width = mat.cols;
+    const size_t height = mat.rows;
+    const size_t channels = mat.channels();
+    for (size_t c = 0; c < channels; c++)
+        for (size_t h = 0; h < height; h++)
+            for (size_t w = 0; w < width; w++)
+                blobData[batchOffset + c * width * height + h * width + w] = getMatValue<T>(mat, h, w, c);
+}
+
+// matToBlob after InputTransform converted the image to RGB floats with mean and scale applied
+void legacyNormalizedMatToBlob(const cv::Mat& mat, float* blobData) {
+    const size_t width = mat.cols;
+    const size_t height = mat.rows;
+    for (size_t c = 0; c < 3; c++)
+        for (size_t h = 0; h < height; h++)
+            for (size_t w = 0; w < width; w++)
+                blobData[c * width * height + h * width + w] = static_cast<float>(
+                    (getMatValue<float>(mat, h, w, 2 - c) - means[c]) / scales[c]);
+}
+
+// loadImgToIEGraph of the multi-channel demos before hwcToChw
+void legacyLoadImgToIEGraph(const cv::Mat& img, size_t batch, void* ieBuffer) {
+    const int channels = img.channels();
+    const int height = img.rows;
+    const int width = img.cols;
+
+    float* ieData = reinterpret_cast<float*>(ieBuffer);
+    int bOffset = static_cast<int>(batch) * channels * width * height;
+    for (int c = 0; c < channels; c++) {
+        int cOffset = c * width * height;
+        for (int w = 0; w < width; w++) {
+            for (int h = 0; h < height; h++) {
+                ieData[bOffset + cOffset + h * width + w] =
+                        static_cast<float>(img.at<cv::Vec3b>(h, w)[c]);
+            }
+        }
+    }
+}
+
+template <typename T>
+float maxError(const std::vector<T>& reference, const std::vector<T>& values) {
+    float error = 0;
+    for (size_t i = 0; i < reference.size(); i++) {
+        error = std::max(error, std::abs(static_cast<float>(reference[i]) - static_cast<float>(values[i])));
+    }
+    return error;
+}
+
+void printRow(const std::string& name, double legacyMs, double kernelMs) {
+    std::cout << std::left << std::setw(40) << name << std::right << std::fixed << std::setprecision(3)
+              << std::setw(14) << legacyMs << std::setw(14) << kernelMs << std::setprecision(1) << std::setw(9)
+              << legacyMs / kernelMs << "x" << std::endl;
+}
+}  // namespace
+
+int main() {
+    try {
+        std::mt19937 generator(0);
+        std::cout << std::left << std::setw(40) << "Conversion" << std::right << std::setw(14) << "Legacy, ms"
+                  << std::setw(14) << "Kernel, ms" << std::setw(10) << "Speedup" << std::endl;
+        for (int size : {300, 416, 608}) {
+            const std::string prefix = std::to_string(size) + "x" + std::to_string(size) + " ";
+            std::vector<cv::Mat> images;
+            for (int i = 0; i < batchSize; i++) {
+                images.push_back(makeImage(size, generator));
+            }
+            const cv::Mat& image = images.front();
+            const size_t imageSize = image.total() * image.channels();
+
+            std::vector<uint8_t> referenceU8(imageSize), valuesU8(imageSize);
+            legacyMatToBlob(image, referenceU8.data());
+            hwcToChw(image, valuesU8.data());
+            benchmark::check(referenceU8 == valuesU8, "U8 planes differ on " + prefix);
+            printRow(prefix + "U8 -> U8",
+                     benchmark::medianTimeMs([&] { legacyMatToBlob(image, referenceU8.data()); }),
+                     benchmark::medianTimeMs([&] { hwcToChw(image, valuesU8.data()); }));
+
+            std::vector<float> reference(imageSize), values(imageSize);
+            legacyMatToBlob(image, reference.data());
+            hwcToChw(image, values.data());
+            benchmark::check(reference == values, "FP32 planes differ on " + prefix);
+            printRow(prefix + "U8 -> FP32",
+                     benchmark::medianTimeMs([&] { legacyMatToBlob(image, reference.data()); }),
+                     benchmark::medianTimeMs([&] { hwcToChw(image, values.data()); }));
+
+            legacyLoadImgToIEGraph(image, 0, reference.data());
+            benchmark::check(reference == values, "multi-channel planes differ on " + prefix);
+            printRow(prefix + "U8 -> FP32, multi-channel loop",
+                     benchmark::medianTimeMs([&] { legacyLoadImgToIEGraph(image, 0, reference.data()); }),
+                     benchmark::medianTimeMs([&] { hwcToChw(image, values.data()); }));
+
+            legacyNormalizedMatToBlob(image, reference.data());
+            hwcToChw(image, values.data(), means, scales, true);
+            benchmark::check(maxError(reference, values) <= maxNormalizedError,
+                             "normalized planes differ on " + prefix);
+            printRow(prefix + "U8 -> FP32, mean/scale, RGB",
+                     benchmark::medianTimeMs([&] { legacyNormalizedMatToBlob(image, reference.data()); }),
+                     benchmark::medianTimeMs([&] { hwcToChw(image, values.data(), means, scales, true); }));
+
+            std::vector<float> batchReference(imageSize * batchSize), batchValues(imageSize * batchSize);
+            auto legacyBatch = [&] {
+                for (int i = 0; i < batchSize; i++) {
+                    legacyMatToBlob(images[i], batchReference.data(), i * imageSize);
+                }
+            };
+            legacyBatch();
+            hwcToChw(images, batchValues.data());
+            benchmark::check(batchReference == batchValues, "batch planes differ on " + prefix);
+            printRow(prefix + "8 x U8 -> FP32, batched", benchmark::medianTimeMs(legacyBatch),
+                     benchmark::medianTimeMs([&] { hwcToChw(images, batchValues.data()); }));
+        }
+    } catch (const std::exception& error) {
+        std::cerr << error.what() << std::endl;
+        return 1;
+    }
+    return 0;
+}
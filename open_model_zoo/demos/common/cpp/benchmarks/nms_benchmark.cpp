@@ -0,0 +1,193 @@
+// Copyright (C) 2021 Intel Corporation
+// SPDX-License-Identifier: Apache-2.0
+//
+
+// Compares the shared NMS module with the pairwise loops the detection models used before, on clusters of
+// boxes like the ones detectors output around objects.
+// Usage: nms_benchmark
+
+#include <algorithm>
+#include <cmath>
+#include <iomanip>
+#include <iostream>
+#include <numeric>
+#include <random>
+#include <string>
+#include <vector>
+
+#include <utils/nms.hpp>
+
+#include "benchmark_utils.hpp"
+
+namespace {
+const float iouThreshold = 0.5f;
+const float softNmsSigma = 0.5f;
+const float scoreThreshold = 0.3f;
+const unsigned int classesNum = 10;
+const size_t boxesPerObject = 16;
+// The pairwise loops are quadratic, larger inputs are timed with a single run
+const size_t singleRunBoxesNum = 10000;
+
+struct Boxes {
+    NmsBoxes boxes;
+    std::vector<float> scores;
+    std::vector<unsigned int> classIds;
+};
+
+// Jittered boxes around objects of a 1920x1080 image
+Boxes makeBoxes(size_t boxesNum, std::mt19937& generator) {
+    std::uniform_real_distribution<float> x(0, 1920), y(0, 1080), size(20, 200), jitter(-0.1f, 0.1f), score(0, 1);
+    std::uniform_int_distribution<unsigned int> classId(0, classesNum - 1);
+    Boxes result;
+    result.boxes.reserve(boxesNum);
+    while (result.scores.size() < boxesNum) {
+        const float centerX = x(generator), centerY = y(generator), width = size(generator), height = size(generator);
+        const unsigned int objectClass = classId(generator);
+        for (size_t i = 0; i < boxesPerObject && result.scores.size() < boxesNum; i++) {
+            const float left = centerX - width / 2 + jitter(generator) * width;
+            const float top = centerY - height / 2 + jitter(generator) * height;
+            result.boxes.push(left, top, left + width * (1 + jitter(generator)), top + height * (1 + jitter(generator)));
+            result.scores.push_back(score(generator));
+            result.classIds.push_back(objectClass);
+        }
+    }
+    return result;
+}
+
+// The sorted loop of the former nms<Anchor> template and the classic YOLO postprocessing
+std::vector<int> legacyNms(const NmsBoxes& boxes, const std::vector<float>& scores, const std::vector<int>& indices) {
+    std::vector<int> order = indices;
+    std::stable_sort(order.begin(), order.end(), [&scores](int o1, int o2) { return scores[o1] > scores[o2]; });
+    std::vector<int> keep;
+    for (size_t i = 0; i < order.size(); ++i) {
+        if (order[i] < 0) {
+            continue;
+        }
+        keep.push_back(order[i]);
+        for (size_t j = i + 1; j < order.size(); ++j) {
+            if (order[j] >= 0 && boxes.iou(order[i], order[j]) >= iouThreshold) {
+                order[j] = -1;
+            }
+        }
+    }
+    return keep;
+}
+
+std::vector<int> legacyBatchedNms(const NmsBoxes& boxes, const std::vector<float>& scores,
+                                  const std::vector<unsigned int>& classIds) {
+    std::vector<int> keep;
+    for (unsigned int cls = 0; cls < classesNum; cls++) {
+        std::vector<int> indices;
+        for (size_t i = 0; i < scores.size(); i++) {
+            if (classIds[i] == cls) {
+                indices.push_back(static_cast<int>(i));
+            }
+        }
+        const std::vector<int> classKeep = legacyNms(boxes, scores, indices);
+        keep.insert(keep.end(), classKeep.begin(), classKeep.end());
+    }
+    std::stable_sort(keep.begin(), keep.end(), [&scores](int o1, int o2) { return scores[o1] > scores[o2]; });
+    return keep;
+}
+
+// Soft-NMS which updates every remaining box after each selection
+std::vector<int> pairwiseSoftNms(const NmsBoxes& boxes, std::vector<float>& scores) {
+    std::vector<int> candidates;
+    for (size_t i = 0; i < scores.size(); ++i) {
+        if (scores[i] >= scoreThreshold) {
+            candidates.push_back(static_cast<int>(i));
+        }
+    }
+    std::vector<int> keep;
+    while (!candidates.empty()) {
+        auto best = std::max_element(candidates.begin(), candidates.end(),
+            [&scores](int o1, int o2) { return scores[o1] < scores[o2]; });
+        const int idx1 = *best;
+        keep.push_back(idx1);
+        candidates.erase(best);
+        std::vector<int> remaining;
+        for (int idx2 : candidates) {
+            const float overlap = boxes.iou(idx1, idx2);
+            scores[idx2] *= std::exp(-overlap * overlap / softNmsSigma);
+            if (scores[idx2] >= scoreThreshold) {
+                remaining.push_back(idx2);
+            }
+        }
+        candidates.swap(remaining);
+    }
+    return keep;
+}
+
+// Both lists hold the same boxes in descending score order
+bool sameBoxes(const std::vector<int>& keep, const std::vector<int>& referenceKeep, const std::vector<float>& scores) {
+    std::vector<int> sortedKeep = keep, sortedReferenceKeep = referenceKeep;
+    std::sort(sortedKeep.begin(), sortedKeep.end());
+    std::sort(sortedReferenceKeep.begin(), sortedReferenceKeep.end());
+    return sortedKeep == sortedReferenceKeep && std::is_sorted(keep.begin(), keep.end(),
+        [&scores](int o1, int o2) { return scores[o1] > scores[o2]; });
+}
+
+template <typename Function>
+double timeMs(size_t boxesNum, Function&& function) {
+    return boxesNum > singleRunBoxesNum ? benchmark::medianTimeMs(function, 1, std::chrono::milliseconds(0))
+                                        : benchmark::medianTimeMs(function);
+}
+
+void printRow(const std::string& name, size_t boxesNum, size_t keptNum, double referenceMs, double sharedMs) {
+    std::cout << std::left << std::setw(14) << name << std::right << std::setw(8) << boxesNum << std::setw(8)
+              << keptNum << std::fixed << std::setprecision(3) << std::setw(14) << referenceMs << std::setw(12)
+              << sharedMs << std::setprecision(1) << std::setw(9) << referenceMs / sharedMs << "x" << std::endl;
+}
+}  // namespace
+
+int main() {
+    try {
+        std::mt19937 generator(0);
+        std::cout << std::left << std::setw(14) << "Algorithm" << std::right << std::setw(8) << "Boxes"
+                  << std::setw(8) << "Kept" << std::setw(14) << "Pairwise, ms" << std::setw(12) << "Shared, ms"
+                  << std::setw(10) << "Speedup" << std::endl;
+        for (size_t boxesNum : {1000, 10000, 50000}) {
+            const Boxes input = makeBoxes(boxesNum, generator);
+            const NmsBoxes& boxes = input.boxes;
+            const std::string size = std::to_string(boxesNum) + " boxes";
+
+            std::vector<int> allIndices(boxesNum);
+            std::iota(allIndices.begin(), allIndices.end(), 0);
+            std::vector<int> referenceKeep = legacyNms(boxes, input.scores, allIndices);
+            std::vector<int> keep = nms(boxes, input.scores, iouThreshold);
+            benchmark::check(keep == referenceKeep, "nms differs from the pairwise loop on " + size);
+            printRow("nms", boxesNum, keep.size(),
+                     timeMs(boxesNum, [&] { legacyNms(boxes, input.scores, allIndices); }),
+                     timeMs(boxesNum, [&] { nms(boxes, input.scores, iouThreshold); }));
+
+            referenceKeep = legacyBatchedNms(boxes, input.scores, input.classIds);
+            keep = batchedNms(boxes, input.scores, input.classIds, iouThreshold);
+            // Classes are visited in a different order, so kept boxes with equal scores may be swapped
+            benchmark::check(sameBoxes(keep, referenceKeep, input.scores),
+                             "batchedNms differs from the pairwise loop on " + size);
+            printRow("batchedNms", boxesNum, keep.size(),
+                     timeMs(boxesNum, [&] { legacyBatchedNms(boxes, input.scores, input.classIds); }),
+                     timeMs(boxesNum, [&] { batchedNms(boxes, input.scores, input.classIds, iouThreshold); }));
+
+            std::vector<float> referenceScores = input.scores;
+            referenceKeep = pairwiseSoftNms(boxes, referenceScores);
+            std::vector<float> scores = input.scores;
+            keep = softNms(boxes, scores, softNmsSigma, scoreThreshold);
+            benchmark::check(keep == referenceKeep && scores == referenceScores,
+                             "softNms differs from the pairwise loop on " + size);
+            printRow("softNms", boxesNum, keep.size(),
+                     timeMs(boxesNum, [&] {
+                         scores = input.scores;
+                         pairwiseSoftNms(boxes, scores);
+                     }),
+                     timeMs(boxesNum, [&] {
+                         scores = input.scores;
+                         softNms(boxes, scores, softNmsSigma, scoreThreshold);
+                     }));
+        }
+    } catch (const std::exception& error) {
+        std::cerr << error.what() << std::endl;
+        return 1;
+    }
+    return 0;
+}
@@ -0,0 +1,460 @@
+// Copyright (C) 2021 Intel Corporation
+// SPDX-License-Identifier: Apache-2.0
+//
+
+// Compares the coarse-to-fine decoding of HPEOpenPose (-coarse_decoding) with the decoding of maps upsampled
+// with INTER_CUBIC:
+// - peaks found by findPeaksCoarseToFine on heat maps of the network resolution with peaks found by findPeaks
+//   on the upsampled heat maps;
+// - poses grouped by groupPeaksToPoses from these peaks and PAFs of the network resolution, which are sampled
+//   bilinearly, with poses grouped from the reference peaks and the upsampled PAFs.
+// Usage: openpose_decoder_benchmark [<maps.yml>]
+// The file holds keypoint heat maps and PAFs of the network resolution recorded with cv::FileStorage under
+// the names "native_heat_maps" and "native_pafs". Without it synthetic maps of crowds of different size are used.
+
+#include <algorithm>
+#include <cmath>
+#include <iomanip>
+#include <iostream>
+#include <random>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include <opencv2/core.hpp>
+#include <opencv2/imgproc.hpp>
+
+#include <models/openpose_decoder.h>
+
+#include "benchmark_utils.hpp"
+
+namespace {
+const int upsampleRatio = 4;
+const float confidenceThreshold = 0.1f;
+const float minPeaksDistance = 3.0f;
+
+// Tolerance of the coarse-to-fine search. Peaks are matched if they are closer than minPeaksDistance.
+// Peaks which appear only on ridges between maxima of the network resolution are missed, so the recall falls
+// with the density of keypoints: on the synthetic maps it is 1.0 up to 10 people and 0.964 for 150 people.
+// Found peaks had the same positions and scores as the reference ones
+const float minRecall = 0.95f;
+const float minPrecision = 0.99f;
+const float maxPositionError = 1.0f;
+const float maxScoreError = 1e-4f;
+
+const size_t keypointsNumber = 18;
+// Thresholds of HPEOpenPose
+const float midPointsScoreThreshold = 0.05f;
+const float foundMidPointsRatioThreshold = 0.8f;
+const int minJointsNumber = 3;
+const float minSubsetScore = 0.2f;
+
+// Tolerance of grouping with PAFs sampled bilinearly. Bilinear interpolation flattens PAFs across limbs, so
+// limb scores and hence pose scores are 5-7% lower than with INTER_CUBIC. Where limbs of different people
+// cross, the lower scores may connect other candidates, and a missed peak splits a pose into several ones. On
+// the synthetic maps poses of up to 5 people are the same, and 6-16% of keypoints of 10 and 20 people are
+// grouped differently
+const float maxPosesNumDifference = 0.15f;
+const float maxDifferentKeypoints = 0.2f;
+const float maxRelativePoseScoreError = 0.08f;
+
+// Keypoints of a standing person of unit height in the order of the network outputs, and limbs which PAFs
+// are output for, in the order of the PAF pairs
+const cv::Point2f skeleton[keypointsNumber] = {
+    {0.0f, 0.08f}, {0.0f, 0.18f}, {-0.1f, 0.18f}, {-0.13f, 0.35f}, {-0.14f, 0.5f}, {0.1f, 0.18f},
+    {0.13f, 0.35f}, {0.14f, 0.5f}, {-0.06f, 0.52f}, {-0.07f, 0.75f}, {-0.07f, 0.97f}, {0.06f, 0.52f},
+    {0.07f, 0.75f}, {0.07f, 0.97f}, {-0.03f, 0.05f}, {0.03f, 0.05f}, {-0.06f, 0.07f}, {0.06f, 0.07f}
+};
+const size_t limbsNumber = 19;
+const std::pair<int, int> limbs[limbsNumber] = {
+    {1, 8}, {8, 9}, {9, 10}, {1, 11}, {11, 12}, {12, 13}, {1, 2}, {2, 3}, {3, 4}, {2, 16},
+    {1, 5}, {5, 6}, {6, 7}, {5, 17}, {1, 0}, {0, 14}, {0, 15}, {14, 16}, {15, 17}
+};
+
+// A keypoint heat map of a crowd as a network with stride 8 outputs it for a 368x656 image
+cv::Mat makeCrowdHeatMap(int peopleNum, std::mt19937& generator) {
+    cv::Mat heatMap(46, 82, CV_32F);
+    std::uniform_real_distribution<float> x(0, static_cast<float>(heatMap.cols));
+    std::uniform_real_distribution<float> y(0, static_cast<float>(heatMap.rows));
+    std::uniform_real_distribution<float> confidence(0.2f, 1.0f);
+    std::normal_distribution<float> noise(0, 0.002f);
+    std::vector<std::pair<cv::Point2f, float>> keypoints;
+    for (int i = 0; i < peopleNum; i++) {
+        keypoints.emplace_back(cv::Point2f(x(generator), y(generator)), confidence(generator));
+    }
+    const float sigma = 0.9f;
+    for (int row = 0; row < heatMap.rows; row++) {
+        float* data = heatMap.ptr<float>(row);
+        for (int col = 0; col < heatMap.cols; col++) {
+            float value = noise(generator);
+            for (const auto& keypoint : keypoints) {
+                const float dx = col - keypoint.first.x;
+                const float dy = row - keypoint.first.y;
+                value += keypoint.second * std::exp(-(dx * dx + dy * dy) / (2 * sigma * sigma));
+            }
+            data[col] = value;
+        }
+    }
+    return heatMap;
+}
+
+// Keypoint heat maps and PAFs of a crowd of people of different height, which may overlap
+void makeSkeletonCrowdMaps(int peopleNum, std::mt19937& generator,
+                           std::vector<cv::Mat>& heatMaps, std::vector<cv::Mat>& pafs) {
+    const cv::Size size(82, 46);
+    std::uniform_real_distribution<float> height(10.0f, 30.0f);
+    std::uniform_real_distribution<float> unit(0.0f, 1.0f);
+    std::uniform_real_distribution<float> confidence(0.3f, 1.0f);
+    std::normal_distribution<float> jitter(0, 0.015f);
+    std::normal_distribution<float> noise(0, 0.002f);
+    heatMaps.clear();
+    for (size_t i = 0; i < keypointsNumber; i++) {
+        heatMaps.push_back(cv::Mat::zeros(size.height, size.width, CV_32F));
+    }
+    pafs.clear();
+    for (size_t i = 0; i < 2 * limbsNumber; i++) {
+        pafs.push_back(cv::Mat::zeros(size.height, size.width, CV_32F));
+    }
+
+    const float sigma = 0.9f;
+    const float limbWidth = 1.0f;
+    // Sums of weights of limbs which contribute to PAFs
+    std::vector<cv::Mat> limbWeights;
+    for (size_t limb = 0; limb < limbsNumber; limb++) {
+        limbWeights.push_back(cv::Mat::zeros(size.height, size.width, CV_32F));
+    }
+    for (int person = 0; person < peopleNum; person++) {
+        const float personHeight = height(generator);
+        const cv::Point2f origin(0.15f * personHeight + unit(generator) * (size.width - 0.3f * personHeight),
+                                 unit(generator) * std::max(size.height - personHeight, 1.0f));
+        std::vector<cv::Point2f> keypoints;
+        for (const auto& keypoint : skeleton) {
+            keypoints.push_back(origin + cv::Point2f(keypoint.x + jitter(generator),
+                                                     keypoint.y + jitter(generator)) * personHeight);
+        }
+        for (size_t id = 0; id < keypointsNumber; id++) {
+            const float score = confidence(generator);
+            for (int row = 0; row < size.height; row++) {
+                float* data = heatMaps[id].ptr<float>(row);
+                for (int col = 0; col < size.width; col++) {
+                    const cv::Point2f d = cv::Point2f(static_cast<float>(col), static_cast<float>(row))
+                        - keypoints[id];
+                    data[col] += score * std::exp(-(d.x * d.x + d.y * d.y) / (2 * sigma * sigma));
+                }
+            }
+        }
+        // A PAF is the direction of its limb near the segment between keypoints, directions of overlapping
+        // limbs are averaged
+        for (size_t limb = 0; limb < limbsNumber; limb++) {
+            const cv::Point2f a = keypoints[limbs[limb].first];
+            const cv::Point2f vec = keypoints[limbs[limb].second] - a;
+            const float length = static_cast<float>(cv::norm(vec));
+            const cv::Point2f direction = vec * (1.0f / length);
+            for (int row = 0; row < size.height; row++) {
+                float* dataX = pafs[2 * limb].ptr<float>(row);
+                float* dataY = pafs[2 * limb + 1].ptr<float>(row);
+                float* weights = limbWeights[limb].ptr<float>(row);
+                for (int col = 0; col < size.width; col++) {
+                    const cv::Point2f p = cv::Point2f(static_cast<float>(col), static_cast<float>(row)) - a;
+                    const float t = std::min(std::max(p.x * direction.x + p.y * direction.y, 0.0f), length);
+                    const cv::Point2f d = p - direction * t;
+                    const float weight = std::exp(-(d.x * d.x + d.y * d.y) / (2 * limbWidth * limbWidth));
+                    dataX[col] += weight * direction.x;
+                    dataY[col] += weight * direction.y;
+                    weights[col] += weight;
+                }
+            }
+        }
+    }
+    for (size_t limb = 0; limb < limbsNumber; limb++) {
+        for (int row = 0; row < size.height; row++) {
+            float* dataX = pafs[2 * limb].ptr<float>(row);
+            float* dataY = pafs[2 * limb + 1].ptr<float>(row);
+            const float* weights = limbWeights[limb].ptr<float>(row);
+            for (int col = 0; col < size.width; col++) {
+                const float norm = std::max(weights[col], 1.0f);
+                dataX[col] /= norm;
+                dataY[col] /= norm;
+            }
+        }
+    }
+    auto addNoise = [&](std::vector<cv::Mat>& maps) {
+        for (auto& map : maps) {
+            for (int row = 0; row < map.rows; row++) {
+                float* data = map.ptr<float>(row);
+                for (int col = 0; col < map.cols; col++) {
+                    data[col] += noise(generator);
+                }
+            }
+        }
+    };
+    addNoise(heatMaps);
+    addNoise(pafs);
+}
+
+// Same steps as HPEOpenPose::extractPoses, mapsUpsampleRatio is 1 if the maps are already upsampled
+std::vector<HumanPose> extractPoses(const std::vector<cv::Mat>& heatMaps, const std::vector<cv::Mat>& pafs,
+                                    int mapsUpsampleRatio) {
+    std::vector<std::vector<Peak>> peaks(heatMaps.size());
+    for (size_t i = 0; i < heatMaps.size(); i++) {
+        if (mapsUpsampleRatio > 1) {
+            findPeaksCoarseToFine(heatMaps, minPeaksDistance, peaks, static_cast<int>(i), confidenceThreshold,
+                                  mapsUpsampleRatio);
+        } else {
+            findPeaks(heatMaps, minPeaksDistance, peaks, static_cast<int>(i), confidenceThreshold);
+        }
+    }
+    int peaksBefore = 0;
+    for (size_t i = 1; i < peaks.size(); i++) {
+        peaksBefore += static_cast<int>(peaks[i - 1].size());
+        for (auto& peak : peaks[i]) {
+            peak.id += peaksBefore;
+        }
+    }
+    return groupPeaksToPoses(peaks, pafs, keypointsNumber, midPointsScoreThreshold, foundMidPointsRatioThreshold,
+                             minJointsNumber, minSubsetScore, mapsUpsampleRatio);
+}
+
+struct Comparison {
+    size_t referenceNum = 0;
+    size_t foundNum = 0;
+    size_t matchedNum = 0;
+    float maxPositionError = 0.0f;
+    float maxScoreError = 0.0f;
+};
+
+// Every reference peak is matched with the nearest unmatched found peak
+void compare(const std::vector<Peak>& reference, const std::vector<Peak>& found, Comparison& comparison) {
+    comparison.referenceNum += reference.size();
+    comparison.foundNum += found.size();
+    std::vector<bool> matched(found.size(), false);
+    for (const Peak& peak : reference) {
+        int nearest = -1;
+        float nearestDistance = minPeaksDistance;
+        for (size_t i = 0; i < found.size(); i++) {
+            const float distance = static_cast<float>(cv::norm(found[i].pos - peak.pos));
+            if (!matched[i] && distance < nearestDistance) {
+                nearest = static_cast<int>(i);
+                nearestDistance = distance;
+            }
+        }
+        if (nearest >= 0) {
+            matched[nearest] = true;
+            comparison.matchedNum++;
+            comparison.maxPositionError = std::max(comparison.maxPositionError, nearestDistance);
+            comparison.maxScoreError = std::max(comparison.maxScoreError, std::abs(found[nearest].score - peak.score));
+        }
+    }
+}
+
+struct PoseCase {
+    std::string name;
+    std::vector<cv::Mat> heatMaps;
+    std::vector<cv::Mat> pafs;
+};
+
+struct PoseComparison {
+    size_t referenceNum = 0;
+    size_t foundNum = 0;
+    size_t samePosesNum = 0;
+    size_t keypointsNum = 0;
+    size_t differentKeypointsNum = 0;
+    float maxRelativeScoreError = 0.0f;
+};
+
+bool isFound(const cv::Point2f& keypoint) {
+    return keypoint != cv::Point2f(-1.0f, -1.0f);
+}
+
+size_t countKeypoints(const HumanPose& pose) {
+    return static_cast<size_t>(std::count_if(pose.keypoints.begin(), pose.keypoints.end(), isFound));
+}
+
+// Every reference pose is matched with the unmatched found pose which has the most of its keypoints. Keypoints
+// which only one of matched poses has or which are displaced, and keypoints of unmatched poses are different
+void compare(const std::vector<HumanPose>& reference, const std::vector<HumanPose>& found,
+             PoseComparison& comparison) {
+    comparison.referenceNum += reference.size();
+    comparison.foundNum += found.size();
+    std::vector<bool> matched(found.size(), false);
+    for (const HumanPose& pose : reference) {
+        int best = -1;
+        size_t bestSameNum = 0;
+        for (size_t i = 0; i < found.size(); i++) {
+            size_t sameNum = 0;
+            for (size_t k = 0; k < pose.keypoints.size(); k++) {
+                if (isFound(pose.keypoints[k]) && isFound(found[i].keypoints[k])
+                        && cv::norm(found[i].keypoints[k] - pose.keypoints[k]) <= maxPositionError) {
+                    sameNum++;
+                }
+            }
+            if (!matched[i] && sameNum > bestSameNum) {
+                best = static_cast<int>(i);
+                bestSameNum = sameNum;
+            }
+        }
+        if (best < 0) {
+            comparison.keypointsNum += countKeypoints(pose);
+            comparison.differentKeypointsNum += countKeypoints(pose);
+            continue;
+        }
+        matched[best] = true;
+        size_t keypointsNum = 0;
+        for (size_t k = 0; k < pose.keypoints.size(); k++) {
+            if (isFound(pose.keypoints[k]) || isFound(found[best].keypoints[k])) {
+                keypointsNum++;
+            }
+        }
+        comparison.keypointsNum += keypointsNum;
+        comparison.differentKeypointsNum += keypointsNum - bestSameNum;
+        // Scores of poses which were grouped differently aren't comparable
+        if (bestSameNum == keypointsNum) {
+            comparison.samePosesNum++;
+            comparison.maxRelativeScoreError = std::max(comparison.maxRelativeScoreError,
+                                                        std::abs(found[best].score - pose.score) / pose.score);
+        }
+    }
+    for (size_t i = 0; i < found.size(); i++) {
+        if (!matched[i]) {
+            comparison.keypointsNum += countKeypoints(found[i]);
+            comparison.differentKeypointsNum += countKeypoints(found[i]);
+        }
+    }
+}
+}  // namespace
+
+int main(int argc, char* argv[]) {
+    try {
+        std::vector<std::pair<std::string, std::vector<cv::Mat>>> cases;
+        std::vector<PoseCase> poseCases;
+        if (argc > 1) {
+            cases.emplace_back(argv[1], benchmark::readRecordedMats(argv[1], "native_heat_maps"));
+            poseCases.push_back({argv[1], cases.back().second, benchmark::readRecordedMats(argv[1], "native_pafs")});
+        } else {
+            std::mt19937 generator(0);
+            for (int peopleNum : {1, 10, 50, 150}) {
+                std::vector<cv::Mat> heatMaps;
+                for (int i = 0; i < 18; i++) {
+                    heatMaps.push_back(makeCrowdHeatMap(peopleNum, generator));
+                }
+                cases.emplace_back(std::to_string(peopleNum) + " people", heatMaps);
+            }
+            for (int peopleNum : {1, 5, 10, 20}) {
+                PoseCase poseCase;
+                poseCase.name = std::to_string(peopleNum) + " people";
+                makeSkeletonCrowdMaps(peopleNum, generator, poseCase.heatMaps, poseCase.pafs);
+                poseCases.push_back(poseCase);
+            }
+        }
+
+        std::cout << std::left << std::setw(24) << "Heat maps" << std::right << std::setw(8) << "Peaks"
+                  << std::setw(9) << "Recall" << std::setw(11) << "Precision" << std::setw(9) << "Pos err"
+                  << std::setw(15) << "Upsampled, ms" << std::setw(20) << "Coarse-to-fine, ms" << std::setw(10)
+                  << "Speedup" << std::endl;
+        for (const auto& testCase : cases) {
+            const std::vector<cv::Mat>& heatMaps = testCase.second;
+            std::vector<cv::Mat> upsampledHeatMaps(heatMaps.size());
+            auto upsample = [&] {
+                for (size_t i = 0; i < heatMaps.size(); i++) {
+                    cv::resize(heatMaps[i], upsampledHeatMaps[i], cv::Size(), upsampleRatio, upsampleRatio,
+                               cv::INTER_CUBIC);
+                }
+            };
+            std::vector<std::vector<Peak>> referencePeaks, peaks;
+            auto findReferencePeaks = [&] {
+                upsample();
+                referencePeaks.assign(heatMaps.size(), {});
+                for (size_t i = 0; i < heatMaps.size(); i++) {
+                    findPeaks(upsampledHeatMaps, minPeaksDistance, referencePeaks, static_cast<int>(i),
+                              confidenceThreshold);
+                }
+            };
+            auto findCoarseToFinePeaks = [&] {
+                peaks.assign(heatMaps.size(), {});
+                for (size_t i = 0; i < heatMaps.size(); i++) {
+                    findPeaksCoarseToFine(heatMaps, minPeaksDistance, peaks, static_cast<int>(i),
+                                          confidenceThreshold, upsampleRatio);
+                }
+            };
+
+            findReferencePeaks();
+            findCoarseToFinePeaks();
+            Comparison comparison;
+            for (size_t i = 0; i < heatMaps.size(); i++) {
+                compare(referencePeaks[i], peaks[i], comparison);
+            }
+            const float recall = comparison.referenceNum
+                ? static_cast<float>(comparison.matchedNum) / comparison.referenceNum : 1.0f;
+            const float precision = comparison.foundNum
+                ? static_cast<float>(comparison.matchedNum) / comparison.foundNum : 1.0f;
+            benchmark::check(recall >= minRecall, "too few reference peaks are found on " + testCase.first);
+            benchmark::check(precision >= minPrecision, "too many extra peaks are found on " + testCase.first);
+            benchmark::check(comparison.maxPositionError <= maxPositionError,
+                             "peaks are displaced on " + testCase.first);
+            benchmark::check(comparison.maxScoreError <= maxScoreError,
+                             "peak scores differ on " + testCase.first);
+
+            const double referenceMs = benchmark::medianTimeMs(findReferencePeaks);
+            const double coarseToFineMs = benchmark::medianTimeMs(findCoarseToFinePeaks);
+            std::cout << std::left << std::setw(24) << testCase.first << std::right << std::setw(8)
+                      << comparison.referenceNum << std::fixed << std::setprecision(3) << std::setw(9) << recall
+                      << std::setw(11) << precision << std::setprecision(2) << std::setw(9)
+                      << comparison.maxPositionError << std::setprecision(3) << std::setw(15) << referenceMs
+                      << std::setw(20) << coarseToFineMs << std::setprecision(1) << std::setw(9)
+                      << referenceMs / coarseToFineMs << "x" << std::endl;
+        }
+
+        std::cout << std::endl << std::left << std::setw(24) << "Heat maps and PAFs" << std::right << std::setw(8)
+                  << "Poses" << std::setw(8) << "Found" << std::setw(7) << "Same" << std::setw(12)
+                  << "Diff kpts" << std::setw(12) << "Score err" << std::setw(15) << "Upsampled, ms"
+                  << std::setw(20) << "Coarse-to-fine, ms" << std::setw(10) << "Speedup" << std::endl;
+        for (const auto& poseCase : poseCases) {
+            std::vector<cv::Mat> upsampledHeatMaps(poseCase.heatMaps.size());
+            std::vector<cv::Mat> upsampledPafs(poseCase.pafs.size());
+            std::vector<HumanPose> referencePoses, poses;
+            // Maps are upsampled as HPEOpenPose::resizeFeatureMaps does
+            auto extractReferencePoses = [&] {
+                for (size_t i = 0; i < poseCase.heatMaps.size(); i++) {
+                    cv::resize(poseCase.heatMaps[i], upsampledHeatMaps[i], cv::Size(), upsampleRatio,
+                               upsampleRatio, cv::INTER_CUBIC);
+                }
+                for (size_t i = 0; i < poseCase.pafs.size(); i++) {
+                    cv::resize(poseCase.pafs[i], upsampledPafs[i], cv::Size(), upsampleRatio, upsampleRatio,
+                               cv::INTER_CUBIC);
+                }
+                referencePoses = extractPoses(upsampledHeatMaps, upsampledPafs, 1);
+            };
+            auto extractCoarseToFinePoses = [&] {
+                poses = extractPoses(poseCase.heatMaps, poseCase.pafs, upsampleRatio);
+            };
+
+            extractReferencePoses();
+            extractCoarseToFinePoses();
+            PoseComparison comparison;
+            compare(referencePoses, poses, comparison);
+            const float posesNumDifference = std::abs(static_cast<float>(comparison.foundNum)
+                - comparison.referenceNum) / std::max<size_t>(comparison.referenceNum, 1);
+            const float differentKeypoints = comparison.keypointsNum
+                ? static_cast<float>(comparison.differentKeypointsNum) / comparison.keypointsNum : 0.0f;
+            benchmark::check(posesNumDifference <= maxPosesNumDifference,
+                             "numbers of poses differ on " + poseCase.name);
+            benchmark::check(differentKeypoints <= maxDifferentKeypoints,
+                             "keypoints of poses differ on " + poseCase.name);
+            benchmark::check(comparison.maxRelativeScoreError <= maxRelativePoseScoreError,
+                             "pose scores differ on " + poseCase.name);
+
+            const double referenceMs = benchmark::medianTimeMs(extractReferencePoses);
+            const double coarseToFineMs = benchmark::medianTimeMs(extractCoarseToFinePoses);
+            std::cout << std::left << std::setw(24) << poseCase.name << std::right << std::setw(8)
+                      << comparison.referenceNum << std::setw(8) << comparison.foundNum << std::setw(7)
+                      << comparison.samePosesNum << std::fixed << std::setprecision(3) << std::setw(12)
+                      << differentKeypoints << std::setw(12) << comparison.maxRelativeScoreError << std::setw(15)
+                      << referenceMs << std::setw(20) << coarseToFineMs << std::setprecision(1) << std::setw(9)
+                      << referenceMs / coarseToFineMs << "x" << std::endl;
+        }
+    } catch (const std::exception& error) {
+        std::cerr << error.what() << std::endl;
+        return 1;
+    }
+    return 0;
+}
@@ -0,0 +1,146 @@
+// Copyright (C) 2021 Intel Corporation
+// SPDX-License-Identifier: Apache-2.0
+//
+
+// Compares findHeatMapPeaks with the per-pixel findPeaks loop it replaced in the OpenPose decoders.
+// Usage: peak_finder_benchmark [<heat_maps.yml>]
+// The file holds upsampled heat maps recorded with cv::FileStorage under the name "heat_maps". Without it
+// synthetic maps of crowds of different size are used.
+
+#include <cmath>
+#include <iomanip>
+#include <iostream>
+#include <random>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include <opencv2/core.hpp>
+
+#include <utils/peak_finder.hpp>
+
+#include "benchmark_utils.hpp"
+
+namespace {
+const float confidenceThreshold = 0.1f;
+const float minPeaksDistance = 3.0f;
+
+// The loop used by the decoders before. stable_sort makes the order of peaks with equal x the same as in
+// findHeatMapPeaks, std::sort left it unspecified
+void legacyFindPeaks(const cv::Mat& heatMap, float threshold, float minDistance, std::vector<cv::Point>& result) {
+    std::vector<cv::Point> peaks;
+    const float* heatMapData = heatMap.ptr<float>();
+    size_t heatMapStep = heatMap.step1();
+    auto value = [&](int x, int y) {
+        float val = heatMapData[y * heatMapStep + x];
+        return val >= threshold ? val : 0;
+    };
+    for (int y = -1; y < heatMap.rows + 1; y++) {
+        for (int x = -1; x < heatMap.cols + 1; x++) {
+            float val = (x >= 0 && y >= 0 && x < heatMap.cols && y < heatMap.rows) ? value(x, y) : 0;
+            float left_val = (y >= 0 && x < heatMap.cols - 1 && y < heatMap.rows) ? value(x + 1, y) : 0;
+            float right_val = (x > 0 && y >= 0 && y < heatMap.rows) ? value(x - 1, y) : 0;
+            float top_val = (x >= 0 && x < heatMap.cols && y < heatMap.rows - 1) ? value(x, y + 1) : 0;
+            float bottom_val = (x >= 0 && y > 0 && x < heatMap.cols) ? value(x, y - 1) : 0;
+            if (val > left_val && val > right_val && val > top_val && val > bottom_val) {
+                peaks.push_back(cv::Point(x, y));
+            }
+        }
+    }
+    std::stable_sort(peaks.begin(), peaks.end(), [](const cv::Point& a, const cv::Point& b) {
+        return a.x < b.x;
+    });
+    std::vector<bool> isActualPeak(peaks.size(), true);
+    result.clear();
+    for (size_t i = 0; i < peaks.size(); i++) {
+        if (isActualPeak[i]) {
+            for (size_t j = i + 1; j < peaks.size(); j++) {
+                if (std::sqrt((peaks[i].x - peaks[j].x) * (peaks[i].x - peaks[j].x) +
+                              (peaks[i].y - peaks[j].y) * (peaks[i].y - peaks[j].y)) < minDistance) {
+                    isActualPeak[j] = false;
+                }
+            }
+            result.push_back(peaks[i]);
+        }
+    }
+}
+
+// A keypoint heat map of a crowd upsampled 8 times from a 46x82 network output
+cv::Mat makeCrowdHeatMap(int peopleNum, std::mt19937& generator) {
+    cv::Mat heatMap(368, 656, CV_32F);
+    std::uniform_real_distribution<float> x(0, static_cast<float>(heatMap.cols));
+    std::uniform_real_distribution<float> y(0, static_cast<float>(heatMap.rows));
+    std::uniform_real_distribution<float> confidence(0.2f, 1.0f);
+    std::normal_distribution<float> noise(0, 0.002f);
+    std::vector<std::pair<cv::Point2f, float>> keypoints;
+    for (int i = 0; i < peopleNum; i++) {
+        keypoints.emplace_back(cv::Point2f(x(generator), y(generator)), confidence(generator));
+    }
+    const float sigma = 7.0f;
+    for (int row = 0; row < heatMap.rows; row++) {
+        float* data = heatMap.ptr<float>(row);
+        for (int col = 0; col < heatMap.cols; col++) {
+            float value = noise(generator);
+            for (const auto& keypoint : keypoints) {
+                const float dx = col - keypoint.first.x;
+                const float dy = row - keypoint.first.y;
+                value += keypoint.second * std::exp(-(dx * dx + dy * dy) / (2 * sigma * sigma));
+            }
+            data[col] = value;
+        }
+    }
+    return heatMap;
+}
+}  // namespace
+
+int main(int argc, char* argv[]) {
+    try {
+        std::vector<std::pair<std::string, std::vector<cv::Mat>>> cases;
+        if (argc > 1) {
+            cases.emplace_back(argv[1], benchmark::readRecordedMats(argv[1], "heat_maps"));
+        } else {
+            std::mt19937 generator(0);
+            for (int peopleNum : {1, 10, 50, 150}) {
+                std::vector<cv::Mat> heatMaps;
+                for (int i = 0; i < 4; i++) {
+                    heatMaps.push_back(makeCrowdHeatMap(peopleNum, generator));
+                }
+                cases.emplace_back(std::to_string(peopleNum) + " people", heatMaps);
+            }
+        }
+
+        std::cout << std::left << std::setw(24) << "Heat maps" << std::right << std::setw(12) << "Peaks/map"
+                  << std::setw(14) << "Legacy, ms" << std::setw(14) << "Shared, ms" << std::setw(10) << "Speedup"
+                  << std::endl;
+        for (const auto& testCase : cases) {
+            const std::vector<cv::Mat>& heatMaps = testCase.second;
+            size_t peaksNum = 0;
+            std::vector<cv::Point> legacyPeaks, peaks;
+            for (const cv::Mat& heatMap : heatMaps) {
+                legacyFindPeaks(heatMap, confidenceThreshold, minPeaksDistance, legacyPeaks);
+                findHeatMapPeaks(heatMap, confidenceThreshold, minPeaksDistance, peaks);
+                benchmark::check(peaks == legacyPeaks, "peaks differ from the legacy finder on " + testCase.first);
+                peaksNum += peaks.size();
+            }
+
+            const double legacyMs = benchmark::medianTimeMs([&] {
+                for (const cv::Mat& heatMap : heatMaps) {
+                    legacyFindPeaks(heatMap, confidenceThreshold, minPeaksDistance, legacyPeaks);
+                }
+            }) / heatMaps.size();
+            const double sharedMs = benchmark::medianTimeMs([&] {
+                for (const cv::Mat& heatMap : heatMaps) {
+                    findHeatMapPeaks(heatMap, confidenceThreshold, minPeaksDistance, peaks);
+                }
+            }) / heatMaps.size();
+            std::cout << std::left << std::setw(24) << testCase.first << std::right << std::fixed
+                      << std::setprecision(1) << std::setw(12) << static_cast<double>(peaksNum) / heatMaps.size()
+                      << std::setprecision(3) << std::setw(14) << legacyMs << std::setw(14) << sharedMs
+                      << std::setprecision(1) << std::setw(9) << legacyMs / sharedMs << "x" << std::endl;
+        }
+    } catch (const std::exception& error) {
+        std::cerr << error.what() << std::endl;
+        return 1;
+    }
+    return 0;
+}
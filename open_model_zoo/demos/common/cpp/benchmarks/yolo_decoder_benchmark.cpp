@@ -0,0 +1,279 @@
+// Copyright (C) 2021 Intel Corporation
+// SPDX-License-Identifier: Apache-2.0
+//
+
+// Compares decodeYoloRegion with the per-entry loop ModelYolo used before, on YOLOv4 and YOLOF outputs
+// for a 608x608 input.
+// Usage: yolo_decoder_benchmark [<yolo_outputs.yml>]
+// The file holds the three NCHW output blobs of YOLOv4 (1x255x76x76, 1x255x38x38 and 1x255x19x19) recorded with
+// cv::FileStorage under the name "yolo_outputs". Without it synthetic outputs are used.
+
+#include <algorithm>
+#include <cmath>
+#include <iomanip>
+#include <iostream>
+#include <random>
+#include <stdexcept>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include <opencv2/core.hpp>
+
+#include <models/yolo_decoder.h>
+
+#include "benchmark_utils.hpp"
+
+namespace {
+const int inputSize = 608;
+const float originalW = 1920;
+const float originalH = 1080;
+const int classesNum = 80;
+const std::vector<float> yoloV4Anchors = {12.0f, 16.0f, 19.0f, 36.0f, 40.0f, 28.0f, 36.0f, 75.0f, 76.0f, 55.0f,
+                                          72.0f, 146.0f, 142.0f, 110.0f, 192.0f, 243.0f, 459.0f, 401.0f};
+const std::vector<float> yolofAnchors = {16.0f, 16.0f, 32.0f, 32.0f, 64.0f, 64.0f,
+                                         128.0f, 128.0f, 256.0f, 256.0f, 512.0f, 512.0f};
+
+// Vectorized exp differs from std::exp by a few ulps, candidates closer than this to the threshold may differ
+const float maxConfidenceError = 1e-5f;
+const float maxBoxError = 1e-2f;
+
+struct Output {
+    YoloRegionLayout layout;
+    std::vector<float> data;
+};
+
+struct TestCase {
+    std::string name;
+    float confidenceThreshold;
+    std::vector<Output> outputs;
+};
+
+YoloRegionLayout makeLayout(int side, const std::vector<float>& anchors, bool isYolof) {
+    YoloRegionLayout layout;
+    layout.num = isYolof ? 6 : 3;
+    layout.classes = classesNum;
+    layout.coords = 4;
+    layout.anchors = anchors;
+    layout.sideW = side;
+    layout.sideH = side;
+    layout.scaleW = inputSize;
+    layout.scaleH = inputSize;
+    layout.hasObjectness = !isYolof;
+    layout.useSigmoid = true;
+    layout.isYolof = isYolof;
+    return layout;
+}
+
+// Raw logits of a region: background entries are unlikely, objects light up a few neighbouring locations
+// of one anchor
+std::vector<float> makeOutputData(const YoloRegionLayout& layout, int objectsNum, std::mt19937& generator) {
+    const int entriesNum = layout.sideW * layout.sideH;
+    const int objectness = layout.hasObjectness ? 1 : 0;
+    const int planesNum = layout.coords + objectness + layout.classes;
+    std::normal_distribution<float> box(0, 0.5f), background(-8, 2);
+    std::vector<float> data(layout.num * planesNum * entriesNum);
+    for (int n = 0; n < layout.num; n++) {
+        float* anchorData = data.data() + n * planesNum * entriesNum;
+        for (int plane = 0; plane < planesNum; plane++) {
+            for (int i = 0; i < entriesNum; i++) {
+                anchorData[plane * entriesNum + i] = plane < layout.coords ? box(generator) : background(generator);
+            }
+        }
+    }
+    std::uniform_int_distribution<int> anchor(0, layout.num - 1), location(0, entriesNum - 2), classId(0, classesNum - 1);
+    std::uniform_real_distribution<float> confidence(0, 4);
+    for (int i = 0; i < objectsNum; i++) {
+        float* anchorData = data.data() + anchor(generator) * planesNum * entriesNum;
+        const int objectLocation = location(generator);
+        const int objectClass = classId(generator);
+        for (int entry = objectLocation; entry < objectLocation + 2; entry++) {
+            if (layout.hasObjectness) {
+                anchorData[layout.coords * entriesNum + entry] = confidence(generator);
+            }
+            anchorData[(layout.coords + objectness + objectClass) * entriesNum + entry] = confidence(generator);
+        }
+    }
+    return data;
+}
+
+std::vector<Output> makeYoloV4Outputs(int objectsNum, std::mt19937& generator) {
+    std::vector<Output> outputs;
+    int mask = 0;
+    for (int side : {76, 38, 19}) {
+        Output output;
+        output.layout = makeLayout(side, std::vector<float>(yoloV4Anchors.begin() + mask * 6,
+                                                            yoloV4Anchors.begin() + mask * 6 + 6), false);
+        output.data = makeOutputData(output.layout, objectsNum / 3, generator);
+        outputs.push_back(output);
+        mask++;
+    }
+    return outputs;
+}
+
+std::vector<Output> readYoloV4Outputs(const std::string& fileName) {
+    std::vector<Output> outputs;
+    int mask = 0;
+    for (const cv::Mat& blob : benchmark::readRecordedMats(fileName, "yolo_outputs")) {
+        if (blob.dims != 4 || blob.type() != CV_32F || blob.size[1] != 3 * (5 + classesNum) || mask == 3) {
+            throw std::runtime_error(fileName + " doesn't hold YOLOv4 outputs");
+        }
+        Output output;
+        output.layout = makeLayout(blob.size[3], std::vector<float>(yoloV4Anchors.begin() + mask * 6,
+                                                                    yoloV4Anchors.begin() + mask * 6 + 6), false);
+        output.layout.sideH = blob.size[2];
+        const float* data = blob.ptr<float>();
+        output.data.assign(data, data + blob.total());
+        outputs.push_back(output);
+        mask++;
+    }
+    return outputs;
+}
+
+inline float sigmoid(float x) {
+    return 1.f / (1.f + exp(-x));
+}
+
+inline float linear(float x) {
+    return x;
+}
+
+inline float clamp(float value, float low, float high) {
+    return std::min(std::max(value, low), high);
+}
+
+int calculateEntryIndex(int totalCells, int lcoords, int lclasses, int location, int entry) {
+    int n = location / totalCells;
+    int loc = location % totalCells;
+    return (n * (lcoords + lclasses) + entry) * totalCells + loc;
+}
+
+// The loop of ModelYolo::parseYOLOOutput before decodeYoloRegion, without per-object label strings
+void legacyDecode(const float* output_blob, const YoloRegionLayout& region, float confidenceThreshold,
+                  YoloCandidates& candidates) {
+    const int sideW = region.sideW;
+    const int sideH = region.sideH;
+    const int isObjConf = region.hasObjectness ? 1 : 0;
+    auto entriesNum = sideW * sideH;
+    auto postprocessRawData = region.useSigmoid ? sigmoid : linear;
+    for (int i = 0; i < entriesNum; ++i) {
+        int row = i / sideW;
+        int col = i % sideW;
+        for (int n = 0; n < region.num; ++n) {
+            int obj_index = calculateEntryIndex(entriesNum, region.coords, region.classes + isObjConf, n * entriesNum + i, region.coords);
+            int box_index = calculateEntryIndex(entriesNum, region.coords, region.classes + isObjConf, n * entriesNum + i, 0);
+            float scale = isObjConf ? postprocessRawData(output_blob[obj_index]) : 1;
+            if (scale >= confidenceThreshold) {
+                float x, y;
+                if (region.isYolof) {
+                    x = ((float)col / sideW + output_blob[box_index + 0 * entriesNum] * region.anchors[2 * n] / region.scaleW) * originalW;
+                    y = ((float)row / sideH + output_blob[box_index + 1 * entriesNum] * region.anchors[2 * n + 1] / region.scaleH) * originalH;
+                } else {
+                    x = (float)(col + postprocessRawData(output_blob[box_index + 0 * entriesNum])) / sideW * originalW;
+                    y = (float)(row + postprocessRawData(output_blob[box_index + 1 * entriesNum])) / sideH * originalH;
+                }
+                float height = (float)std::exp(output_blob[box_index + 3 * entriesNum]) * region.anchors[2 * n + 1] * originalH / region.scaleH;
+                float width = (float)std::exp(output_blob[box_index + 2 * entriesNum]) * region.anchors[2 * n] * originalW / region.scaleW;
+                const float left = clamp(x - width / 2, 0.f, originalW);
+                const float top = clamp(y - height / 2, 0.f, originalH);
+                for (int j = 0; j < region.classes; ++j) {
+                    int class_index = calculateEntryIndex(entriesNum, region.coords, region.classes + isObjConf, n * entriesNum + i, region.coords + isObjConf + j);
+                    float prob = scale * postprocessRawData(output_blob[class_index]);
+                    if (prob >= confidenceThreshold) {
+                        candidates.push(left, top, clamp(width, 0.f, originalW - left),
+                                        clamp(height, 0.f, originalH - top), prob, j);
+                    }
+                }
+            }
+        }
+    }
+}
+
+// Every reference candidate is matched with an unmatched candidate of the same class with the nearest box.
+// Only candidates with confidence near the threshold may stay unmatched
+void compare(const YoloCandidates& reference, const YoloCandidates& candidates, float confidenceThreshold,
+             const std::string& name) {
+    std::vector<bool> matched(candidates.size(), false);
+    for (size_t i = 0; i < reference.size(); i++) {
+        int nearest = -1;
+        float nearestError = maxBoxError;
+        for (size_t j = 0; j < candidates.size(); j++) {
+            if (matched[j] || candidates.labelID[j] != reference.labelID[i]) {
+                continue;
+            }
+            const float error = std::max(std::max(std::abs(candidates.x[j] - reference.x[i]),
+                                                  std::abs(candidates.y[j] - reference.y[i])),
+                                         std::max(std::abs(candidates.width[j] - reference.width[i]),
+                                                  std::abs(candidates.height[j] - reference.height[i])));
+            if (error <= nearestError) {
+                nearest = static_cast<int>(j);
+                nearestError = error;
+            }
+        }
+        if (nearest < 0) {
+            benchmark::check(reference.confidence[i] < confidenceThreshold + maxConfidenceError,
+                             "a candidate is lost on " + name);
+            continue;
+        }
+        matched[nearest] = true;
+        benchmark::check(std::abs(candidates.confidence[nearest] - reference.confidence[i]) <= maxConfidenceError,
+                         "candidate confidence differs on " + name);
+    }
+    for (size_t j = 0; j < candidates.size(); j++) {
+        benchmark::check(matched[j] || candidates.confidence[j] < confidenceThreshold + maxConfidenceError,
+                         "an extra candidate is found on " + name);
+    }
+}
+}  // namespace
+
+int main(int argc, char* argv[]) {
+    try {
+        std::vector<TestCase> cases;
+        if (argc > 1) {
+            cases.push_back({argv[1], 0.5f, readYoloV4Outputs(argv[1])});
+        } else {
+            std::mt19937 generator(0);
+            cases.push_back({"YOLOv4, 30 objects, t=0.5", 0.5f, makeYoloV4Outputs(30, generator)});
+            cases.push_back({"YOLOv4, 300 objects, t=0.05", 0.05f, makeYoloV4Outputs(300, generator)});
+            Output yolof;
+            yolof.layout = makeLayout(19, yolofAnchors, true);
+            yolof.data = makeOutputData(yolof.layout, 30, generator);
+            cases.push_back({"YOLOF, 30 objects, t=0.5", 0.5f, {yolof}});
+        }
+
+        std::cout << std::left << std::setw(30) << "Outputs" << std::right << std::setw(12) << "Candidates"
+                  << std::setw(14) << "Legacy, ms" << std::setw(14) << "Shared, ms" << std::setw(10) << "Speedup"
+                  << std::endl;
+        for (const TestCase& testCase : cases) {
+            YoloCandidates reference, candidates;
+            YoloDecodingBuffers buffers;
+            auto decodeLegacy = [&] {
+                reference = YoloCandidates();
+                for (const Output& output : testCase.outputs) {
+                    legacyDecode(output.data.data(), output.layout, testCase.confidenceThreshold, reference);
+                }
+            };
+            auto decode = [&] {
+                candidates = YoloCandidates();
+                for (const Output& output : testCase.outputs) {
+                    decodeYoloRegion(output.data.data(), output.layout, testCase.confidenceThreshold, originalW,
+                                     originalH, buffers, candidates);
+                }
+            };
+            decodeLegacy();
+            decode();
+            compare(reference, candidates, testCase.confidenceThreshold, testCase.name);
+
+            const double legacyMs = benchmark::medianTimeMs(decodeLegacy);
+            const double sharedMs = benchmark::medianTimeMs(decode);
+            std::cout << std::left << std::setw(30) << testCase.name << std::right << std::setw(12)
+                      << candidates.size() << std::fixed << std::setprecision(3) << std::setw(14) << legacyMs
+                      << std::setw(14) << sharedMs << std::setprecision(1) << std::setw(9) << legacyMs / sharedMs
+                      << "x" << std::endl;
+        }
+    } catch (const std::exception& error) {
+        std::cerr << error.what() << std::endl;
+        return 1;
+    }
+    return 0;
+}
@@ -29,6 +29,7 @@ public:
     ClassificationModel(const std::string& modelFileName, size_t nTop, bool useAutoResize, const std::vector<std::string>& labels);
 
     std::unique_ptr<ResultBase> postprocess(InferenceResult& infResult) override;
+    bool isBatchingSupported() const override { return !useAutoResize; }
 
     static std::vector<std::string> loadLabels(const std::string& labelFilename);
 
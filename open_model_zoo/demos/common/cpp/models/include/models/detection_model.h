@@ -15,6 +15,7 @@
 */
 #pragma once
 #include "models/image_model.h"
+#include "models/results.h"
 
 class DetectionModel : public ImageModel {
 public:
@@ -32,7 +33,6 @@ public:
 
 protected:
     float confidenceThreshold;
-    std::vector<std::string> labels;
-
-    std::string getLabelName(int labelID) { return (size_t)labelID < labels.size() ? labels[labelID] : std::string("Label #") + std::to_string(labelID); }
+    /// Immutable once the model is loaded, results and detected objects point to it
+    std::shared_ptr<const LabelsTable> labels;
 };
@@ -35,6 +35,7 @@ public:
 
     ModelFaceBoxes(const std::string& modelFileName, float confidenceThreshold, bool useAutoResize, float boxIOUThreshold);
     std::unique_ptr<ResultBase> postprocess(InferenceResult& infResult) override;
+    bool isBatchingSupported() const override { return !useAutoResize; }
 
 protected:
     size_t maxProposalsCount;
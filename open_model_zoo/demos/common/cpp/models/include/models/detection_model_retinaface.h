@@ -44,6 +44,7 @@ public:
     /// @param boxIOUThreshold - threshold for NMS boxes filtering, varies in [0.0, 1.0] range.
     ModelRetinaFace(const std::string& model_name, float confidenceThreshold, bool useAutoResize, float boxIOUThreshold);
     std::unique_ptr<ResultBase> postprocess(InferenceResult& infResult) override;
+    bool isBatchingSupported() const override { return !useAutoResize; }
 
 protected:
     struct AnchorCfgLine {
@@ -49,6 +49,7 @@ public:
     /// @param boxIOUThreshold - threshold for NMS boxes filtering, varies in [0.0, 1.0] range.
     ModelRetinaFacePT(const std::string& modelFileName, float confidenceThreshold, bool useAutoResize, float boxIOUThreshold);
     std::unique_ptr<ResultBase> postprocess(InferenceResult& infResult) override;
+    bool isBatchingSupported() const override { return !useAutoResize; }
 
 protected:
     size_t landmarksNum;
@@ -17,6 +17,7 @@
 #pragma once
 #include <ngraph/ngraph.hpp>
 #include "detection_model.h"
+#include "yolo_decoder.h"
 
 class ModelYolo : public DetectionModel {
 protected:
@@ -33,7 +34,12 @@ protected:
         Region(int classes, int coords, const std::vector<float>& anchors, const std::vector<int64_t>& masks, int outputWidth, int outputHeight);
     };
 
+    using Candidates = YoloCandidates;
+    using DecodingBuffers = YoloDecodingBuffers;
+
 public:
+    static const int INIT_VECTOR_SIZE = 200;
+
     enum YoloVersion {
         YOLO_V1V2,
         YOLO_V3,
@@ -56,25 +62,29 @@ public:
     /// than actual classes number, default "Label #N" will be shown for missing items.
     /// @param anchors - vector of anchors coordinates. Required for YOLOv4, for other versions it may be omitted.
     /// @param masks - vector of masks values. Required for YOLOv4, for other versions it may be omitted.
+    /// @param softNmsSigma - if positive, overlapping boxes are filtered with gaussian soft-NMS with this sigma
+    /// instead of being removed at boxIOUThreshold. Their confidence decays, and boxes which confidence falls below
+    /// confidenceThreshold are removed.
     ModelYolo(const std::string& modelFileName, float confidenceThreshold, bool useAutoResize,
         bool useAdvancedPostprocessing = true, float boxIOUThreshold = 0.5, const std::vector<std::string>& labels = std::vector<std::string>(),
-        const std::vector<float>& anchors = std::vector<float>(), const std::vector<int64_t>& masks = std::vector<int64_t>());
+        const std::vector<float>& anchors = std::vector<float>(), const std::vector<int64_t>& masks = std::vector<int64_t>(),
+        float softNmsSigma = 0);
 
     std::unique_ptr<ResultBase> postprocess(InferenceResult& infResult) override;
+    bool isBatchingSupported() const override { return !useAutoResize; }
 
 protected:
     void prepareInputsOutputs(InferenceEngine::CNNNetwork& cnnNetwork) override;
 
+    /// Decodes region output into candidates with decodeYoloRegion
     void parseYOLOOutput(const std::string& output_name, const InferenceEngine::Blob::Ptr& blob,
         const unsigned long resized_im_h, const unsigned long resized_im_w, const unsigned long original_im_h,
-        const unsigned long original_im_w, std::vector<DetectedObject>& objects);
-
-    static int calculateEntryIndex(int entriesNum, int lcoords, int lclasses, int location, int entry);
-    static double intersectionOverUnion(const DetectedObject& o1, const DetectedObject& o2);
+        const unsigned long original_im_w, DecodingBuffers& buffers, Candidates& candidates);
 
     std::map<std::string, Region> regions;
     double boxIOUThreshold;
     bool useAdvancedPostprocessing;
+    float softNmsSigma;
     bool isObjConf = 1;
     YoloVersion yoloVersion;
     const std::vector<float> presetAnchors;
@@ -23,7 +23,11 @@ public:
     /// @param aspectRatio - the ratio of input width to its height.
     /// @param targetSize - the height used for network reshaping.
     /// @param confidenceThreshold - threshold to eliminate low-confidence keypoints.
-    HPEOpenPose(const std::string& modelFileName, double aspectRatio, int targetSize, float confidenceThreshold);
+    /// @param coarseToFine - if true, feature maps aren't upsampled as a whole. Peaks are searched near
+    /// maxima of heatmaps of the network resolution and pafs are sampled with bilinear interpolation.
+    /// This is much faster, keypoints may slightly differ.
+    HPEOpenPose(const std::string& modelFileName, double aspectRatio, int targetSize, float confidenceThreshold,
+                bool coarseToFine = false);
 
     std::unique_ptr<ResultBase> postprocess(InferenceResult& infResult) override;
 
@@ -47,6 +51,7 @@ protected:
     double aspectRatio;
     int targetSize;
     float confidenceThreshold;
+    bool coarseToFine;
 
     std::vector<HumanPose> extractPoses(const std::vector<cv::Mat>& heatMaps,
                                         const std::vector<cv::Mat>& pafs) const;
@@ -24,6 +24,8 @@ public:
     ImageModel(const std::string& modelFileName, bool useAutoResize);
 
     virtual std::shared_ptr<InternalModelData> preprocess(const InputData& inputData, InferenceEngine::InferRequest::Ptr& request) override;
+    virtual std::shared_ptr<InternalModelData> preprocessBatchItem(const InputData& inputData,
+        InferenceEngine::InferRequest::Ptr& request, size_t batchIndex) override;
 
 protected:
     bool useAutoResize;
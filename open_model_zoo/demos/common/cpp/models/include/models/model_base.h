@@ -29,6 +29,16 @@ public:
     virtual ~ModelBase() {}
 
     virtual std::shared_ptr<InternalModelData> preprocess(const InputData& inputData, InferenceEngine::InferRequest::Ptr& request) = 0;
+    /// Fills one item of batched network input
+    /// @param inputData - input data to be put into the request
+    /// @param request - request which input is filled
+    /// @param batchIndex - index of the item inside of the batch
+    /// @returns internal model data for this particular item
+    virtual std::shared_ptr<InternalModelData> preprocessBatchItem(const InputData& inputData,
+        InferenceEngine::InferRequest::Ptr& request, size_t batchIndex);
+    /// @returns true if model is able to fill separate items of batched input (see preprocessBatchItem)
+    /// and postprocess outputs of single batch item
+    virtual bool isBatchingSupported() const { return false; }
     virtual std::unique_ptr<ResultBase> postprocess(InferenceResult& infResult) = 0;
     virtual void onLoadCompleted(const std::vector<InferenceEngine::InferRequest::Ptr>& requests) {}
     const std::vector<std::string>& getOutputsNames() const { return outputsNames; }
@@ -42,10 +52,14 @@ public:
         this->inputTransform = InputTransform(reverseInputChannels, meanValues, scaleValues);
     }
 
-    void setBatchOne(InferenceEngine::CNNNetwork & cnnNetwork) {
+    /// Sets batch size the network will be reshaped to. Should be called before loadExecutableNetwork
+    void setBatchSize(size_t batchSize) { this->batchSize = batchSize; }
+    size_t getBatchSize() const { return batchSize; }
+
+    void setBatch(InferenceEngine::CNNNetwork & cnnNetwork) {
         auto shapes = cnnNetwork.getInputShapes();
         for (auto& shape : shapes)
-            shape.second[0] = 1;
+            shape.second[0] = batchSize;
         cnnNetwork.reshape(shapes);
     }
 
@@ -59,4 +73,5 @@ protected:
     InferenceEngine::ExecutableNetwork execNetwork;
     std::string modelFileName;
     CnnConfig cnnConfig = {};
+    size_t batchSize = 1;
 };
@@ -50,6 +50,16 @@ void findPeaks(const std::vector<cv::Mat>& heatMaps,
                std::vector<std::vector<Peak>>& allPeaks,
                int heatMapId, float confidenceThreshold);
 
+/// Finds nearly the same peaks as findPeaks on heat maps upsampled with INTER_CUBIC, but takes heat maps
+/// of the network resolution and interpolates them only in small windows around local maxima.
+/// Peak positions are in coordinates of the upsampled maps
+void findPeaksCoarseToFine(const std::vector<cv::Mat>& heatMaps,
+                           const float minPeaksDistance,
+                           std::vector<std::vector<Peak>>& allPeaks,
+                           int heatMapId, float confidenceThreshold, int upsampleRatio);
+
+/// @param pafsUpsampleRatio - if greater than 1, pafs have the network resolution and peaks are in
+/// coordinates of maps upsampled this number of times. Pafs are sampled with bilinear interpolation then
 std::vector<HumanPose> groupPeaksToPoses(
         const std::vector<std::vector<Peak>>& allPeaks,
         const std::vector<cv::Mat>& pafs,
@@ -57,4 +67,5 @@ std::vector<HumanPose> groupPeaksToPoses(
         const float midPointsScoreThreshold,
         const float foundMidPointsRatioThreshold,
         const int minJointsNumber,
-        const float minSubsetScore);
+        const float minSubsetScore,
+        const int pafsUpsampleRatio = 1);
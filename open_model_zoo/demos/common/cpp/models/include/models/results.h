@@ -74,21 +74,34 @@ struct ClassificationResult : public ResultBase {
     std::vector<Classification> topLabels;
 };
 
+/// Class names of a detection model. The table is filled once when the model is created and is shared
+/// by the model and all its results, so detected objects refer to it instead of copying label strings.
+using LabelsTable = std::vector<std::string>;
+
 struct DetectedObject : public cv::Rect2f {
     unsigned int labelID;
-    std::string label;
     float confidence;
+    /// Table of the model which produced this object. It stays valid while the model or the result is alive.
+    const LabelsTable* labels = nullptr;
+
+    /// @returns class name, or "Label #N" if the model has no name for this class
+    std::string getLabel() const {
+        return labels && labelID < labels->size() ? (*labels)[labelID] : "Label #" + std::to_string(labelID);
+    }
 };
 
 struct DetectionResult : public ResultBase {
-    DetectionResult(int64_t frameId = -1, const std::shared_ptr<MetaData>& metaData = nullptr) :
-        ResultBase(frameId, metaData) {}
+    DetectionResult(int64_t frameId = -1, const std::shared_ptr<MetaData>& metaData = nullptr,
+        const std::shared_ptr<const LabelsTable>& labels = nullptr) :
+        ResultBase(frameId, metaData), labels(labels) {}
     std::vector<DetectedObject> objects;
+    std::shared_ptr<const LabelsTable> labels;
 };
 
 struct RetinaFaceDetectionResult : public DetectionResult {
-    RetinaFaceDetectionResult(int64_t frameId = -1, const std::shared_ptr<MetaData>& metaData = nullptr) :
-        DetectionResult(frameId, metaData) {
+    RetinaFaceDetectionResult(int64_t frameId = -1, const std::shared_ptr<MetaData>& metaData = nullptr,
+        const std::shared_ptr<const LabelsTable>& labels = nullptr) :
+        DetectionResult(frameId, metaData, labels) {
     }
     std::vector<cv::Point2f> landmarks;
 };
@@ -99,6 +112,12 @@ struct ImageResult : public ResultBase {
     cv::Mat resultImage;
 };
 
+struct SegmentationResult : public ImageResult {
+    SegmentationResult(int64_t frameId = -1, const std::shared_ptr<MetaData>& metaData = nullptr) :
+        ImageResult(frameId, metaData) {}
+    cv::Mat colorMask;  // class of every pixel of resultImage painted with the model's color map, empty if it isn't set
+};
+
 struct HumanPose {
     std::vector<cv::Point2f> keypoints;
     float score;
@@ -27,7 +27,12 @@ public:
 
     static std::vector<std::string> loadLabels(const std::string& labelFilename);
 
+    /// Makes postprocess() paint the classes into SegmentationResult::colorMask along with computing them
+    /// @param colors - 256x1 or 1x256 CV_8UC3 table of class colors, as used by cv::applyColorMap()
+    void setColorMap(const cv::Mat& colors);
+
     std::unique_ptr<ResultBase> postprocess(InferenceResult& infResult) override;
+    bool isBatchingSupported() const override { return !useAutoResize; }
 
 protected:
     void prepareInputsOutputs(InferenceEngine::CNNNetwork & cnnNetwork) override;
@@ -35,4 +40,5 @@ protected:
     int outHeight = 0;
     int outWidth = 0;
     int outChannels = 0;
+    cv::Mat colorMap;
 };
@@ -0,0 +1,61 @@
+// Copyright (C) 2021 Intel Corporation
+// SPDX-License-Identifier: Apache-2.0
+//
+
+#pragma once
+
+#include <vector>
+
+#include <opencv2/core.hpp>
+
+/// Layout and decoding parameters of one YOLO region output. Each anchor occupies
+/// (coords + objectness + classes) consecutive planes of sideW * sideH values
+struct YoloRegionLayout {
+    int num = 0;
+    int classes = 0;
+    int coords = 0;
+    std::vector<float> anchors;  ///< width and height of every anchor
+    int sideW = 0;
+    int sideH = 0;
+    float scaleW = 0;  ///< anchors are divided by these values to get box sizes relative to the image
+    float scaleH = 0;
+    bool hasObjectness = true;
+    bool useSigmoid = false;  ///< activations are raw logits
+    bool isYolof = false;  ///< box centers are anchor-scaled offsets without activation
+};
+
+/// Detection candidates decoded from region outputs, stored as a structure of arrays
+struct YoloCandidates {
+    std::vector<float> x;
+    std::vector<float> y;
+    std::vector<float> width;
+    std::vector<float> height;
+    std::vector<float> confidence;
+    std::vector<unsigned int> labelID;
+
+    size_t size() const { return confidence.size(); }
+    void reserve(size_t capacity);
+    void push(float x, float y, float width, float height, float confidence, unsigned int labelID);
+};
+
+/// Scratch buffers reused between anchors and region outputs
+struct YoloDecodingBuffers {
+    std::vector<int> locations;
+    std::vector<float> x;
+    std::vector<float> y;
+    std::vector<float> width;
+    std::vector<float> height;
+    std::vector<float> scales;
+    std::vector<float> classThresholds;
+    std::vector<cv::Rect2f> boxes;
+    std::vector<int> hits;
+};
+
+/// Decodes a region output into candidates with confidence not below confidenceThreshold. Every anchor is
+/// processed plane by plane: objectness plane is thresholded first, and only surviving locations are looked up
+/// in class planes. Thresholds are converted to logit domain, so sigmoid is computed only for accepted class
+/// values. Box activations of surviving locations are computed with vectorized exp and sigmoid if CV_SIMD is on.
+/// @param data - NCHW output of the region, FP32
+/// @param originalW, originalH - size of the image boxes are scaled to
+void decodeYoloRegion(const float* data, const YoloRegionLayout& region, float confidenceThreshold,
+                      float originalW, float originalH, YoloDecodingBuffers& buffers, YoloCandidates& candidates);
@@ -20,7 +20,7 @@
 DetectionModel::DetectionModel(const std::string& modelFileName, float confidenceThreshold, bool useAutoResize, const std::vector<std::string>& labels) :
     ImageModel(modelFileName, useAutoResize),
     confidenceThreshold(confidenceThreshold),
-    labels(labels) {
+    labels(std::make_shared<const LabelsTable>(labels)) {
 }
 
 std::vector<std::string> DetectionModel::loadLabels(const std::string& labelFilename) {
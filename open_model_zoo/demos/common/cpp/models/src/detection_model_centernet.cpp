@@ -255,14 +255,14 @@ std::unique_ptr<ResultBase> ModelCenterNet::postprocess(InferenceResult& infResu
     transform(bboxes, sz, scale, centerX, centerY);
 
     // --------------------------- Create detection result objects ------------------------------------
-    DetectionResult* result = new DetectionResult(infResult.frameId, infResult.metaData);
+    DetectionResult* result = new DetectionResult(infResult.frameId, infResult.metaData, labels);
 
     result->objects.reserve(scores.size());
     for (size_t i = 0; i < scores.size(); ++i) {
         DetectedObject desc;
         desc.confidence = scores[i].second;
         desc.labelID = scores[i].first / chSize;
-        desc.label = getLabelName(desc.labelID);
+        desc.labels = labels.get();
         desc.x = clamp(bboxes[i].left, 0.f, (float)imgWidth);
         desc.y = clamp(bboxes[i].top, 0.f, (float)imgHeight);
         desc.width = clamp(bboxes[i].getWidth(), 0.f, (float)imgWidth);
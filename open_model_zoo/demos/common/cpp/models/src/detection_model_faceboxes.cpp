@@ -218,7 +218,7 @@ std::unique_ptr<ResultBase> ModelFaceBoxes::postprocess(InferenceResult& infResu
     std::vector<int> keep = nms(bboxes, scores.second, boxIOUThreshold);
 
     // --------------------------- Create detection result objects --------------------------------------------------------
-    DetectionResult* result = new DetectionResult(infResult.frameId, infResult.metaData);
+    DetectionResult* result = new DetectionResult(infResult.frameId, infResult.metaData, labels);
     auto imgWidth = infResult.internalModelData->asRef<InternalImageModelData>().inputImgWidth;
     auto imgHeight = infResult.internalModelData->asRef<InternalImageModelData>().inputImgHeight;
     float scaleX = static_cast<float>(netInputWidth) / imgWidth;
@@ -233,7 +233,7 @@ std::unique_ptr<ResultBase> ModelFaceBoxes::postprocess(InferenceResult& infResu
         desc.width = clamp(bboxes[i].getWidth() / scaleX, 0.f, (float)imgWidth);
         desc.height = clamp(bboxes[i].getHeight() / scaleY, 0.f, (float)imgHeight);
         desc.labelID =  0;
-        desc.label = labels[0];
+        desc.labels = labels.get();
 
         result->objects.push_back(desc);
     }
@@ -75,9 +75,7 @@ void ModelRetinaFace::prepareInputsOutputs(InferenceEngine::CNNNetwork& cnnNetwo
         }
         else if (output.first.find("type") != std::string::npos) {
             type = OT_MASKSCORES;
-            labels.clear();
-            labels.push_back("No Mask");
-            labels.push_back("Mask");
+            labels = std::make_shared<const LabelsTable>(LabelsTable{"No Mask", "Mask"});
             shouldDetectMasks = true;
             landmarkStd = 0.2f;
         }
@@ -316,7 +314,7 @@ std::unique_ptr<ResultBase> ModelRetinaFace::postprocess(InferenceResult& infRes
     auto keep = nms(bboxes, scores, boxIOUThreshold, !shouldDetectLandmarks);
 
     // --------------------------- Create detection result objects --------------------------------------------------------
-    RetinaFaceDetectionResult* result = new RetinaFaceDetectionResult(infResult.frameId, infResult.metaData);
+    RetinaFaceDetectionResult* result = new RetinaFaceDetectionResult(infResult.frameId, infResult.metaData, labels);
 
     auto imgWidth = infResult.internalModelData->asRef<InternalImageModelData>().inputImgWidth;
     auto imgHeight = infResult.internalModelData->asRef<InternalImageModelData>().inputImgHeight;
@@ -340,7 +338,7 @@ std::unique_ptr<ResultBase> ModelRetinaFace::postprocess(InferenceResult& infRes
         desc.height = clamp(bboxes[i].getHeight(), 0.f, (float)imgHeight);
         //--- Default label 0 - Face. If detecting masks then labels would be 0 - No Mask, 1 - Mask
         desc.labelID = shouldDetectMasks ? (masks[i] > maskThreshold) : 0;
-        desc.label = labels[desc.labelID];
+        desc.labels = labels.get();
         result->objects.push_back(desc);
 
         //--- Scaling landmarks coordinates
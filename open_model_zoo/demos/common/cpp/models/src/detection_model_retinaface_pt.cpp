@@ -211,7 +211,7 @@ std::unique_ptr<ResultBase> ModelRetinaFacePT::postprocess(InferenceResult& infR
     const auto& keptIndicies = nms(proposals, scores, boxIOUThreshold, !landmarksNum);
 
     // --------------------------- Create detection result objects --------------------------------------------------------
-    RetinaFaceDetectionResult* result = new RetinaFaceDetectionResult(infResult.frameId, infResult.metaData);
+    RetinaFaceDetectionResult* result = new RetinaFaceDetectionResult(infResult.frameId, infResult.metaData, labels);
 
     result->objects.reserve(keptIndicies.size());
     result->landmarks.reserve(keptIndicies.size() * landmarksNum);
@@ -226,7 +226,7 @@ std::unique_ptr<ResultBase> ModelRetinaFacePT::postprocess(InferenceResult& infR
         desc.height = proposals[i].getHeight();
 
         desc.labelID = 0;
-        desc.label = labels[desc.labelID];
+        desc.labels = labels.get();
         result->objects.push_back(desc);
 
         //--- Filtering landmarks coordinates
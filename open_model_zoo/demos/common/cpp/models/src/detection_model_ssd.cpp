@@ -47,7 +47,7 @@ std::unique_ptr<ResultBase> ModelSSD::postprocessSingleOutput(InferenceResult& i
     InferenceEngine::LockedMemory<const void> outputMapped = infResult.getFirstOutputBlob()->rmap();
     const float *detections = outputMapped.as<float*>();
 
-    DetectionResult* result = new DetectionResult(infResult.frameId, infResult.metaData);
+    DetectionResult* result = new DetectionResult(infResult.frameId, infResult.metaData, labels);
     auto retVal = std::unique_ptr<ResultBase>(result);
 
     const auto& internalData = infResult.internalModelData->asRef<InternalImageModelData>();
@@ -66,7 +66,7 @@ std::unique_ptr<ResultBase> ModelSSD::postprocessSingleOutput(InferenceResult& i
 
             desc.confidence = confidence;
             desc.labelID = static_cast<int>(detections[i * objectSize + 1]);
-            desc.label = getLabelName(desc.labelID);
+            desc.labels = labels.get();
 
             desc.x = clamp(detections[i * objectSize + 3] * internalData.inputImgWidth,
                 0.f, (float)internalData.inputImgWidth);
@@ -91,10 +91,10 @@ std::unique_ptr<ResultBase> ModelSSD::postprocessMultipleOutputs(InferenceResult
     }
 
     const float *boxes = mappedMemoryAreas[0].as<float*>();
-    const float *labels = mappedMemoryAreas[1].as<float*>();
+    const float *classes = mappedMemoryAreas[1].as<float*>();
     const float *scores = mappedMemoryAreas.size() > 2 ? mappedMemoryAreas[2].as<float*>() : nullptr;
 
-    DetectionResult* result = new DetectionResult(infResult.frameId, infResult.metaData);
+    DetectionResult* result = new DetectionResult(infResult.frameId, infResult.metaData, labels);
     auto retVal = std::unique_ptr<ResultBase>(result);
 
     const auto& internalData = infResult.internalModelData->asRef<InternalImageModelData>();
@@ -112,8 +112,8 @@ std::unique_ptr<ResultBase> ModelSSD::postprocessMultipleOutputs(InferenceResult
             DetectedObject desc;
 
             desc.confidence = confidence;
-            desc.labelID = static_cast<int>(labels[i]);
-            desc.label = getLabelName(desc.labelID);
+            desc.labelID = static_cast<int>(classes[i]);
+            desc.labels = labels.get();
 
             desc.x = clamp(boxes[i * objectSize] * widthScale,
                 0.f, (float)internalData.inputImgWidth);
@@ -17,7 +17,9 @@
 #include <ngraph/ngraph.hpp>
 #include "models/detection_model_yolo.h"
 #include <utils/common.hpp>
+#include <utils/nms.hpp>
 #include <iostream>
+#include <limits>
 
 std::vector<float> defaultAnchors[] = {
     // YOLOv1v2
@@ -51,20 +53,13 @@ const std::vector<int64_t> defaultMasks[] = {
     {0, 1, 2, 3, 4, 5}
 };
 
-static inline float sigmoid(float x) {
-    return 1.f / (1.f + exp(-x));
-}
-static inline float linear(float x) {
-    return x;
-}
-
-
 ModelYolo::ModelYolo(const std::string& modelFileName, float confidenceThreshold, bool useAutoResize,
     bool useAdvancedPostprocessing, float boxIOUThreshold, const std::vector<std::string>& labels,
-    const std::vector<float>& anchors, const std::vector<int64_t>& masks) :
+    const std::vector<float>& anchors, const std::vector<int64_t>& masks, float softNmsSigma) :
     DetectionModel(modelFileName, confidenceThreshold, useAutoResize, labels),
     boxIOUThreshold(boxIOUThreshold),
     useAdvancedPostprocessing(useAdvancedPostprocessing),
+    softNmsSigma(softNmsSigma),
     yoloVersion(YOLO_V3),
     presetAnchors(anchors),
     presetMasks(masks) {
@@ -181,45 +176,44 @@ void ModelYolo::prepareInputsOutputs(InferenceEngine::CNNNetwork& cnnNetwork) {
 }
 
 std::unique_ptr<ResultBase> ModelYolo::postprocess(InferenceResult& infResult) {
-    DetectionResult* result = new DetectionResult(infResult.frameId, infResult.metaData);
-    std::vector<DetectedObject> objects;
+    DetectionResult* result = new DetectionResult(infResult.frameId, infResult.metaData, labels);
 
     // Parsing outputs
     const auto& internalData = infResult.internalModelData->asRef<InternalImageModelData>();
 
+    DecodingBuffers buffers;
+    Candidates candidates;
+    candidates.reserve(INIT_VECTOR_SIZE);
     for (auto& output : infResult.outputsData) {
         this->parseYOLOOutput(output.first, output.second, netInputHeight, netInputWidth,
-            internalData.inputImgHeight, internalData.inputImgWidth, objects);
+            internalData.inputImgHeight, internalData.inputImgWidth, buffers, candidates);
     }
 
-    if (useAdvancedPostprocessing) {
-        // Advanced postprocessing
-        // Checking IOU threshold conformance
-        // For every i-th object we're finding all objects it intersects with, and comparing confidence
-        // If i-th object has greater confidence than all others, we include it into result
-        for (const auto& obj1 : objects) {
-            bool isGoodResult = true;
-            for (const auto& obj2 : objects) {
-                if (obj1.labelID == obj2.labelID && obj1.confidence < obj2.confidence && intersectionOverUnion(obj1, obj2) >= boxIOUThreshold) { // if obj1 is the same as obj2, condition expression will evaluate to false anyway
-                    isGoodResult = false;
-                    break;
-                }
-            }
-            if (isGoodResult) {
-                result->objects.push_back(obj1);
-            }
-        }
+    const auto boxes = NmsBoxes::fromRects(candidates.x.data(), candidates.y.data(),
+        candidates.width.data(), candidates.height.data(), candidates.size());
+    // Advanced postprocessing suppresses boxes within each class, classic one across all classes
+    std::vector<int> keep;
+    if (softNmsSigma > 0) {
+        keep = useAdvancedPostprocessing ?
+            batchedSoftNms(boxes, candidates.confidence, candidates.labelID, softNmsSigma, confidenceThreshold) :
+            softNms(boxes, candidates.confidence, softNmsSigma, confidenceThreshold);
     } else {
-        // Classic postprocessing
-        std::sort(objects.begin(), objects.end(), [](const DetectedObject& x, const DetectedObject& y) { return x.confidence > y.confidence; });
-        for (size_t i = 0; i < objects.size(); ++i) {
-            if (objects[i].confidence == 0)
-                continue;
-            for (size_t j = i + 1; j < objects.size(); ++j)
-                if (intersectionOverUnion(objects[i], objects[j]) >= boxIOUThreshold)
-                    objects[j].confidence = 0;
-            result->objects.push_back(objects[i]);
-        }
+        keep = useAdvancedPostprocessing ?
+            batchedNms(boxes, candidates.confidence, candidates.labelID, static_cast<float>(boxIOUThreshold)) :
+            nms(boxes, candidates.confidence, static_cast<float>(boxIOUThreshold));
+    }
+
+    result->objects.reserve(keep.size());
+    for (int idx : keep) {
+        DetectedObject obj;
+        obj.x = candidates.x[idx];
+        obj.y = candidates.y[idx];
+        obj.width = candidates.width[idx];
+        obj.height = candidates.height[idx];
+        obj.confidence = candidates.confidence[idx];
+        obj.labelID = candidates.labelID[idx];
+        obj.labels = labels.get();
+        result->objects.push_back(obj);
     }
 
     return std::unique_ptr<ResultBase>(result);
@@ -229,7 +223,7 @@ void ModelYolo::parseYOLOOutput(const std::string& output_name,
     const InferenceEngine::Blob::Ptr& blob, const unsigned long resized_im_h,
     const unsigned long resized_im_w, const unsigned long original_im_h,
     const unsigned long original_im_w,
-    std::vector<DetectedObject>& objects) {
+    DecodingBuffers& buffers, Candidates& candidates) {
 
     // --------------------------- Extracting layer parameters -------------------------------------
     auto it = regions.find(output_name);
@@ -260,70 +254,22 @@ void ModelYolo::parseYOLOOutput(const std::string& output_name,
         break;
     }
 
-    auto entriesNum = sideW * sideH;
-    const float* output_blob = blob->buffer().as<InferenceEngine::PrecisionTrait<InferenceEngine::Precision::FP32>::value_type*>();
+    YoloRegionLayout layout;
+    layout.num = region.num;
+    layout.classes = region.classes;
+    layout.coords = region.coords;
+    layout.anchors = region.anchors;
+    layout.sideW = sideW;
+    layout.sideH = sideH;
+    layout.scaleW = static_cast<float>(scaleW);
+    layout.scaleH = static_cast<float>(scaleH);
+    layout.hasObjectness = isObjConf;
+    layout.useSigmoid = yoloVersion == YOLO_V4 || yoloVersion == YOLO_V4_TINY || yoloVersion == YOLOF;
+    layout.isYolof = yoloVersion == YOLOF;
 
-    auto postprocessRawData = (yoloVersion == YOLO_V4 || yoloVersion == YOLO_V4_TINY || yoloVersion == YOLOF) ? sigmoid : linear;
-
-    // --------------------------- Parsing YOLO Region output -------------------------------------
-    for (int i = 0; i < entriesNum; ++i) {
-        int row = i / sideW;
-        int col = i % sideW;
-        for (int n = 0; n < region.num; ++n) {
-            //--- Getting region data from blob
-            int obj_index = calculateEntryIndex(entriesNum, region.coords, region.classes + isObjConf, n * entriesNum + i, region.coords);
-            int box_index = calculateEntryIndex(entriesNum, region.coords, region.classes + isObjConf, n * entriesNum + i, 0);
-            float scale = isObjConf ? postprocessRawData(output_blob[obj_index]) : 1;
-
-            //--- Preliminary check for confidence threshold conformance
-            if (scale >= confidenceThreshold){
-                //--- Calculating scaled region's coordinates
-                float x, y;
-                if (yoloVersion == YOLOF) {
-                    x = ((float)col / sideW + output_blob[box_index + 0 * entriesNum] * region.anchors[2 * n] / scaleW) * original_im_w;
-                    y = ((float)row / sideH + output_blob[box_index + 1 * entriesNum] * region.anchors[2 * n + 1] / scaleH) * original_im_h;
-                } else {
-                    x = (float)(col + postprocessRawData(output_blob[box_index + 0 * entriesNum])) / sideW * original_im_w;
-                    y = (float)(row + postprocessRawData(output_blob[box_index + 1 * entriesNum])) / sideH * original_im_h;
-                }
-                float height = (float)std::exp(output_blob[box_index + 3 * entriesNum]) * region.anchors[2 * n + 1] * original_im_h / scaleH;
-                float width = (float)std::exp(output_blob[box_index + 2 * entriesNum]) * region.anchors[2 * n] * original_im_w / scaleW;
-
-                DetectedObject obj;
-                obj.x = clamp(x-width/2, 0.f, (float)original_im_w);
-                obj.y = clamp(y-height/2, 0.f, (float)original_im_h);
-                obj.width = clamp(width, 0.f, (float)original_im_w - obj.x);
-                obj.height = clamp(height, 0.f, (float)original_im_h - obj.y);
-
-                for (int j = 0; j < region.classes; ++j) {
-                    int class_index = calculateEntryIndex(entriesNum, region.coords, region.classes + isObjConf, n * entriesNum + i, region.coords + isObjConf + j);
-                    float prob = scale * postprocessRawData(output_blob[class_index]);
-
-                    //--- Checking confidence threshold conformance and adding region to the list
-                    if (prob >= confidenceThreshold) {
-                        obj.confidence = prob;
-                        obj.labelID = j;
-                        obj.label = getLabelName(obj.labelID);
-                        objects.push_back(obj);
-                    }
-                }
-            }
-        }
-    }
-}
-
-int ModelYolo::calculateEntryIndex(int totalCells, int lcoords, int lclasses, int location, int entry) {
-    int n = location / totalCells;
-    int loc = location % totalCells;
-    return (n * (lcoords + lclasses) + entry) * totalCells + loc;
-}
-
-double ModelYolo::intersectionOverUnion(const DetectedObject& o1, const DetectedObject& o2) {
-    double overlappingWidth = fmin(o1.x + o1.width, o2.x + o2.width) - fmax(o1.x, o2.x);
-    double overlappingHeight = fmin(o1.y + o1.height, o2.y + o2.height) - fmax(o1.y, o2.y);
-    double intersectionArea = (overlappingWidth < 0 || overlappingHeight < 0) ? 0 : overlappingHeight * overlappingWidth;
-    double unionArea = o1.width * o1.height + o2.width * o2.height - intersectionArea;
-    return intersectionArea / unionArea;
+    const float* output_blob = blob->buffer().as<InferenceEngine::PrecisionTrait<InferenceEngine::Precision::FP32>::value_type*>();
+    decodeYoloRegion(output_blob, layout, confidenceThreshold, static_cast<float>(original_im_w),
+        static_cast<float>(original_im_h), buffers, candidates);
 }
 
 ModelYolo::Region::Region(const std::shared_ptr<ngraph::op::RegionYolo>& regionYolo) {
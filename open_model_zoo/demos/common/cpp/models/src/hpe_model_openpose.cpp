@@ -35,11 +35,13 @@ const float HPEOpenPose::midPointsScoreThreshold = 0.05f;
 const float HPEOpenPose::foundMidPointsRatioThreshold = 0.8f;
 const float HPEOpenPose::minSubsetScore = 0.2f;
 
-HPEOpenPose::HPEOpenPose(const std::string& modelFileName, double aspectRatio, int targetSize, float confidenceThreshold) :
+HPEOpenPose::HPEOpenPose(const std::string& modelFileName, double aspectRatio, int targetSize, float confidenceThreshold,
+                         bool coarseToFine) :
     ImageModel(modelFileName, false),
     aspectRatio(aspectRatio),
     targetSize(targetSize),
-    confidenceThreshold(confidenceThreshold) {
+    confidenceThreshold(confidenceThreshold),
+    coarseToFine(coarseToFine) {
 }
 
 void HPEOpenPose::prepareInputsOutputs(InferenceEngine::CNNNetwork& cnnNetwork) {
@@ -130,14 +132,18 @@ std::unique_ptr<ResultBase> HPEOpenPose::postprocess(InferenceResult& infResult)
         heatMaps[i] = cv::Mat(heatMapDims[2], heatMapDims[3], CV_32FC1,
                               heats + i * heatMapDims[2] * heatMapDims[3]);
     }
-    resizeFeatureMaps(heatMaps);
+    if (!coarseToFine) {
+        resizeFeatureMaps(heatMaps);
+    }
 
     std::vector<cv::Mat> pafs(outputDims[1]);
     for (size_t i = 0; i < pafs.size(); i++) {
         pafs[i] = cv::Mat(heatMapDims[2], heatMapDims[3], CV_32FC1,
                           predictions + i * heatMapDims[2] * heatMapDims[3]);
     }
-    resizeFeatureMaps(pafs);
+    if (!coarseToFine) {
+        resizeFeatureMaps(pafs);
+    }
 
     std::vector<HumanPose> poses = extractPoses(heatMaps, pafs);
 
@@ -169,15 +175,22 @@ void HPEOpenPose::resizeFeatureMaps(std::vector<cv::Mat>& featureMaps) const {
 class FindPeaksBody: public cv::ParallelLoopBody {
 public:
     FindPeaksBody(const std::vector<cv::Mat>& heatMaps, float minPeaksDistance,
-                  std::vector<std::vector<Peak> >& peaksFromHeatMap, float confidenceThreshold)
+                  std::vector<std::vector<Peak> >& peaksFromHeatMap, float confidenceThreshold,
+                  int upsampleRatio)
         : heatMaps(heatMaps),
           minPeaksDistance(minPeaksDistance),
           peaksFromHeatMap(peaksFromHeatMap),
-          confidenceThreshold(confidenceThreshold) {}
+          confidenceThreshold(confidenceThreshold),
+          upsampleRatio(upsampleRatio) {}
 
     void operator()(const cv::Range& range) const override {
         for (int i = range.start; i < range.end; i++) {
-            findPeaks(heatMaps, minPeaksDistance, peaksFromHeatMap, i, confidenceThreshold);
+            if (upsampleRatio > 1) {
+                findPeaksCoarseToFine(heatMaps, minPeaksDistance, peaksFromHeatMap, i, confidenceThreshold,
+                                      upsampleRatio);
+            } else {
+                findPeaks(heatMaps, minPeaksDistance, peaksFromHeatMap, i, confidenceThreshold);
+            }
         }
     }
 
@@ -186,13 +199,18 @@ private:
     float minPeaksDistance;
     std::vector<std::vector<Peak> >& peaksFromHeatMap;
     float confidenceThreshold;
+    int upsampleRatio;  // of maps which peaks are searched on, 1 if heatMaps are already upsampled
 };
 
 std::vector<HumanPose> HPEOpenPose::extractPoses(
         const std::vector<cv::Mat>& heatMaps,
         const std::vector<cv::Mat>& pafs) const {
     std::vector<std::vector<Peak>> peaksFromHeatMap(heatMaps.size());
-    FindPeaksBody findPeaksBody(heatMaps, minPeaksDistance, peaksFromHeatMap, confidenceThreshold);
+    // In the coarse-to-fine mode maps have the network resolution, but peaks are still found
+    // in coordinates of upsampled maps
+    const int mapsUpsampleRatio = coarseToFine ? upsampleRatio : 1;
+    FindPeaksBody findPeaksBody(heatMaps, minPeaksDistance, peaksFromHeatMap, confidenceThreshold,
+                                mapsUpsampleRatio);
     cv::parallel_for_(cv::Range(0, static_cast<int>(heatMaps.size())),
                       findPeaksBody);
     int peaksBefore = 0;
@@ -204,6 +222,6 @@ std::vector<HumanPose> HPEOpenPose::extractPoses(
     }
     std::vector<HumanPose> poses = groupPeaksToPoses(
                 peaksFromHeatMap, pafs, keypointsNumber, midPointsScoreThreshold,
-                foundMidPointsRatioThreshold, minJointsNumber, minSubsetScore);
+                foundMidPointsRatioThreshold, minJointsNumber, minSubsetScore, mapsUpsampleRatio);
     return poses;
 }
@@ -22,17 +22,24 @@ ImageModel::ImageModel(const std::string& modelFileName, bool useAutoResize) :
 }
 
 std::shared_ptr<InternalModelData> ImageModel::preprocess(const InputData& inputData, InferenceEngine::InferRequest::Ptr& request) {
-    const auto& origImg = inputData.asRef<ImageInputData>().inputImage;
-    const auto& img = inputTransform(origImg);
+    return preprocessBatchItem(inputData, request, 0);
+}
+
+std::shared_ptr<InternalModelData> ImageModel::preprocessBatchItem(const InputData& inputData,
+    InferenceEngine::InferRequest::Ptr& request, size_t batchIndex) {
+    const auto& img = inputData.asRef<ImageInputData>().inputImage;
 
     if (useAutoResize) {
+        if (batchIndex != 0) {
+            throw std::logic_error("Batched input is not supported together with auto resize");
+        }
         /* Just set input blob containing read image. Resize and layout conversionx will be done automatically */
-        request->SetBlob(inputsNames[0], wrapMat2Blob(img));
+        request->SetBlob(inputsNames[0], wrapMat2Blob(inputTransform(img)));
     }
     else {
-        /* Resize and copy data from the image to the input blob */
+        /* Resize and copy data from the image to the input blob, mean and scale values are applied on the fly */
         InferenceEngine::Blob::Ptr frameBlob = request->GetBlob(inputsNames[0]);
-        matToBlob(img, frameBlob);
+        inputTransform.fillBlob(img, frameBlob, static_cast<int>(batchIndex));
     }
     return std::make_shared<InternalImageModelData>(img.cols, img.rows);
 }
@@ -34,8 +34,8 @@ InferenceEngine::CNNNetwork ModelBase::prepareNetwork(InferenceEngine::Core& cor
     // --------------------------- Read IR Generated by ModelOptimizer (.xml and .bin files) ------------
     /** Read network model **/
     InferenceEngine::CNNNetwork cnnNetwork = core.ReadNetwork(modelFileName);
-    /** Set batch size to 1 **/
-    setBatchOne(cnnNetwork);
+    /** Set batch size (1 unless batching is requested) **/
+    setBatch(cnnNetwork);
 
     // -------------------------- Reading all outputs names and customizing I/O blobs (in inherited classes)
     prepareInputsOutputs(cnnNetwork);
@@ -49,3 +49,11 @@ InferenceEngine::ExecutableNetwork ModelBase::loadExecutableNetwork(const CnnCon
     logExecNetworkInfo(execNetwork, modelFileName, cnnConfig.deviceName);
     return execNetwork;
 }
+
+std::shared_ptr<InternalModelData> ModelBase::preprocessBatchItem(const InputData& inputData,
+    InferenceEngine::InferRequest::Ptr& request, size_t batchIndex) {
+    if (batchIndex != 0) {
+        throw std::logic_error("The model doesn't support batched input");
+    }
+    return preprocess(inputData, request);
+}
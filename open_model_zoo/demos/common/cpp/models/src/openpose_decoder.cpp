@@ -15,10 +15,12 @@
 */
 
 #include <algorithm>
+#include <cmath>
 #include <utility>
 #include <vector>
 
 #include <utils/common.hpp>
+#include <utils/peak_finder.hpp>
 #include "models/openpose_decoder.h"
 
 
@@ -45,75 +47,176 @@ void findPeaks(const std::vector<cv::Mat>& heatMaps,
                int heatMapId, float confidenceThreshold) {
     std::vector<cv::Point> peaks;
     const cv::Mat& heatMap = heatMaps[heatMapId];
-    const float* heatMapData = heatMap.ptr<float>();
-    size_t heatMapStep = heatMap.step1();
-    for (int y = -1; y < heatMap.rows + 1; y++) {
-        for (int x = -1; x < heatMap.cols + 1; x++) {
-            float val = 0;
-            if (x >= 0
-                    && y >= 0
-                    && x < heatMap.cols
-                    && y < heatMap.rows) {
-                val = heatMapData[y * heatMapStep + x];
-                val = val >= confidenceThreshold ? val : 0;
-            }
+    findHeatMapPeaks(heatMap, confidenceThreshold, minPeaksDistance, peaks);
+    std::vector<Peak>& peaksWithScoreAndID = allPeaks[heatMapId];
+    peaksWithScoreAndID.reserve(peaks.size());
+    for (size_t i = 0; i < peaks.size(); i++) {
+        peaksWithScoreAndID.push_back(Peak(static_cast<int>(i), peaks[i], heatMap.at<float>(peaks[i])));
+    }
+}
 
-            float left_val = 0;
-            if (y >= 0
-                    && x < (heatMap.cols - 1)
-                    && y < heatMap.rows) {
-                left_val = heatMapData[y * heatMapStep + x + 1];
-                left_val = left_val >= confidenceThreshold ? left_val : 0;
-            }
+namespace {
+// Same coefficients as cv::resize uses for INTER_CUBIC
+void getCubicCoeffs(float x, float* coeffs) {
+    const float A = -0.75f;
+    coeffs[0] = ((A * (x + 1) - 5 * A) * (x + 1) + 8 * A) * (x + 1) - 4 * A;
+    coeffs[1] = ((A + 2) * x - (A + 3)) * x * x + 1;
+    coeffs[2] = ((A + 2) * (1 - x) - (A + 3)) * (1 - x) * (1 - x) + 1;
+    coeffs[3] = 1.f - coeffs[0] - coeffs[1] - coeffs[2];
+}
 
-            float right_val = 0;
-            if (x > 0
-                    && y >= 0
-                    && y < heatMap.rows) {
-                right_val = heatMapData[y * heatMapStep + x - 1];
-                right_val = right_val >= confidenceThreshold ? right_val : 0;
-            }
+// Sum of absolute cubic coefficients at a half-pixel offset, the largest ratio of an interpolated
+// value to the largest of the samples in one dimension
+const float maxCubicGain = 1.375f;
 
-            float top_val = 0;
-            if (x >= 0
-                    && x < heatMap.cols
-                    && y < (heatMap.rows - 1)) {
-                top_val = heatMapData[(y + 1) * heatMapStep + x];
-                top_val = top_val >= confidenceThreshold ? top_val : 0;
-            }
+struct CubicTaps {
+    int indices[4];
+    float coeffs[4];
+};
+
+CubicTaps getCubicTaps(int upsampledPos, int size, int upsampleRatio) {
+    // Pixel centers are aligned and borders are replicated as in cv::resize
+    const float pos = static_cast<float>((upsampledPos + 0.5) / upsampleRatio - 0.5);
+    const int start = cvFloor(pos);
+    CubicTaps taps;
+    getCubicCoeffs(pos - start, taps.coeffs);
+    for (int k = 0; k < 4; k++) {
+        taps.indices[k] = std::min(std::max(start - 1 + k, 0), size - 1);
+    }
+    return taps;
+}
+
+float sampleCubic(const cv::Mat& map, int x, int y, int upsampleRatio) {
+    const CubicTaps tapsX = getCubicTaps(x, map.cols, upsampleRatio);
+    const CubicTaps tapsY = getCubicTaps(y, map.rows, upsampleRatio);
+    float value = 0.0f;
+    for (int i = 0; i < 4; i++) {
+        const float* row = map.ptr<float>(tapsY.indices[i]);
+        float rowValue = 0.0f;
+        for (int j = 0; j < 4; j++) {
+            rowValue += row[tapsX.indices[j]] * tapsX.coeffs[j];
+        }
+        value += rowValue * tapsY.coeffs[i];
+    }
+    return value;
+}
+
+float samplePaf(const cv::Mat& paf, const cv::Point2f& pos, int upsampleRatio) {
+    if (upsampleRatio == 1) {
+        return paf.at<float>(cv::Point(cvRound(pos.x), cvRound(pos.y)));
+    }
+    const float x = std::min(std::max((pos.x + 0.5f) / upsampleRatio - 0.5f, 0.0f), paf.cols - 1.0f);
+    const float y = std::min(std::max((pos.y + 0.5f) / upsampleRatio - 0.5f, 0.0f), paf.rows - 1.0f);
+    const int x0 = static_cast<int>(x);
+    const int y0 = static_cast<int>(y);
+    const int x1 = std::min(x0 + 1, paf.cols - 1);
+    const int y1 = std::min(y0 + 1, paf.rows - 1);
+    const float dx = x - x0;
+    const float dy = y - y0;
+    const float* row0 = paf.ptr<float>(y0);
+    const float* row1 = paf.ptr<float>(y1);
+    return (1 - dy) * ((1 - dx) * row0[x0] + dx * row0[x1]) + dy * ((1 - dx) * row1[x0] + dx * row1[x1]);
+}
+}  // namespace
+
+void findPeaksCoarseToFine(const std::vector<cv::Mat>& heatMaps,
+                           const float minPeaksDistance,
+                           std::vector<std::vector<Peak>>& allPeaks,
+                           int heatMapId, float confidenceThreshold, int upsampleRatio) {
+    const cv::Mat& heatMap = heatMaps[heatMapId];
+    const cv::Size upsampledSize(heatMap.cols * upsampleRatio, heatMap.rows * upsampleRatio);
+    // An upsampled value reaching the threshold has a sample at least this large in its 4x4 neighbourhood
+    const float candidateThreshold = confidenceThreshold / (maxCubicGain * maxCubicGain);
 
-            float bottom_val = 0;
-            if (x >= 0
-                    && y > 0
-                    && x < heatMap.cols) {
-                bottom_val = heatMapData[(y - 1) * heatMapStep + x];
-                bottom_val = bottom_val >= confidenceThreshold ? bottom_val : 0;
+    std::vector<cv::Point> candidates;
+    cv::Mat window;
+    cv::Mat rowsX;
+    std::vector<CubicTaps> tapsX, tapsY;
+    for (int y = 0; y < heatMap.rows; y++) {
+        const float* row = heatMap.ptr<float>(y);
+        const float* rowAbove = heatMap.ptr<float>(std::max(y - 1, 0));
+        const float* rowBelow = heatMap.ptr<float>(std::min(y + 1, heatMap.rows - 1));
+        for (int x = 0; x < heatMap.cols; x++) {
+            const float value = row[x];
+            if (value < candidateThreshold
+                    || (x > 0 && value < row[x - 1])
+                    || (x + 1 < heatMap.cols && value < row[x + 1])
+                    || value < rowAbove[x]
+                    || value < rowBelow[x]) {
+                continue;
             }
 
-            if ((val > left_val)
-                    && (val > right_val)
-                    && (val > top_val)
-                    && (val > bottom_val)) {
-                peaks.push_back(cv::Point(x, y));
+            // Upsampled pixels interpolated between the neighbours of the maximum, and a border
+            // of their own neighbours. Neighbours outside of the map are zeros
+            const cv::Rect area = cv::Rect((x - 1) * upsampleRatio, (y - 1) * upsampleRatio,
+                                           3 * upsampleRatio, 3 * upsampleRatio) & cv::Rect(cv::Point(), upsampledSize);
+            window.create(area.height + 2, area.width + 2, CV_32FC1);
+            window.setTo(0.0f);
+            const cv::Rect windowArea = cv::Rect(area.x - 1, area.y - 1, window.cols, window.rows)
+                & cv::Rect(cv::Point(), upsampledSize);
+            // The interpolation is separable, so rows of the heat map are interpolated along x first
+            tapsX.resize(windowArea.width);
+            for (int wx = 0; wx < windowArea.width; wx++) {
+                tapsX[wx] = getCubicTaps(windowArea.x + wx, heatMap.cols, upsampleRatio);
+            }
+            tapsY.resize(windowArea.height);
+            for (int wy = 0; wy < windowArea.height; wy++) {
+                tapsY[wy] = getCubicTaps(windowArea.y + wy, heatMap.rows, upsampleRatio);
+            }
+            const int firstRow = tapsY.front().indices[0];
+            rowsX.create(tapsY.back().indices[3] - firstRow + 1, windowArea.width, CV_32FC1);
+            for (int i = 0; i < rowsX.rows; i++) {
+                const float* heatMapRow = heatMap.ptr<float>(firstRow + i);
+                float* rowX = rowsX.ptr<float>(i);
+                for (int wx = 0; wx < windowArea.width; wx++) {
+                    const CubicTaps& taps = tapsX[wx];
+                    float value = 0.0f;
+                    for (int k = 0; k < 4; k++) {
+                        value += heatMapRow[taps.indices[k]] * taps.coeffs[k];
+                    }
+                    rowX[wx] = value;
+                }
+            }
+            for (int wy = 0; wy < windowArea.height; wy++) {
+                const CubicTaps& taps = tapsY[wy];
+                float* windowRow = window.ptr<float>(windowArea.y + wy - area.y + 1) + windowArea.x - area.x + 1;
+                for (int wx = 0; wx < windowArea.width; wx++) {
+                    float upsampledValue = 0.0f;
+                    for (int k = 0; k < 4; k++) {
+                        upsampledValue += rowsX.at<float>(taps.indices[k] - firstRow, wx) * taps.coeffs[k];
+                    }
+                    windowRow[wx] = upsampledValue >= confidenceThreshold ? upsampledValue : 0.0f;
+                }
+            }
+            for (int wy = 1; wy <= area.height; wy++) {
+                const float* windowRow = window.ptr<float>(wy);
+                const float* windowRowAbove = window.ptr<float>(wy - 1);
+                const float* windowRowBelow = window.ptr<float>(wy + 1);
+                for (int wx = 1; wx <= area.width; wx++) {
+                    const float upsampledValue = windowRow[wx];
+                    if (upsampledValue > windowRow[wx - 1]
+                            && upsampledValue > windowRow[wx + 1]
+                            && upsampledValue > windowRowAbove[wx]
+                            && upsampledValue > windowRowBelow[wx]) {
+                        candidates.emplace_back(area.x + wx - 1, area.y + wy - 1);
+                    }
+                }
             }
         }
     }
-    std::sort(peaks.begin(), peaks.end(), [](const cv::Point& a, const cv::Point& b) {
-        return a.x < b.x;
+
+    // Windows of adjacent maxima overlap
+    std::sort(candidates.begin(), candidates.end(), [](const cv::Point& a, const cv::Point& b) {
+        return a.x < b.x || (a.x == b.x && a.y < b.y);
     });
-    std::vector<bool> isActualPeak(peaks.size(), true);
-    int peakCounter = 0;
+    candidates.erase(std::unique(candidates.begin(), candidates.end()), candidates.end());
+    std::vector<cv::Point> peaks;
+    suppressClosePeaks(candidates, upsampledSize, minPeaksDistance, peaks);
     std::vector<Peak>& peaksWithScoreAndID = allPeaks[heatMapId];
+    peaksWithScoreAndID.reserve(peaks.size());
     for (size_t i = 0; i < peaks.size(); i++) {
-        if (isActualPeak[i]) {
-            for (size_t j = i + 1; j < peaks.size(); j++) {
-                if (sqrt((peaks[i].x - peaks[j].x) * (peaks[i].x - peaks[j].x) +
-                         (peaks[i].y - peaks[j].y) * (peaks[i].y - peaks[j].y)) < minPeaksDistance) {
-                    isActualPeak[j] = false;
-                }
-            }
-            peaksWithScoreAndID.push_back(Peak(peakCounter++, peaks[i], heatMap.at<float>(peaks[i])));
-        }
+        peaksWithScoreAndID.push_back(Peak(static_cast<int>(i), peaks[i],
+                                           sampleCubic(heatMap, peaks[i].x, peaks[i].y, upsampleRatio)));
     }
 }
 
@@ -123,7 +226,8 @@ std::vector<HumanPose> groupPeaksToPoses(const std::vector<std::vector<Peak>>& a
                                          const float midPointsScoreThreshold,
                                          const float foundMidPointsRatioThreshold,
                                          const int minJointsNumber,
-                                         const float minSubsetScore) {
+                                         const float minSubsetScore,
+                                         const int pafsUpsampleRatio) {
     static const std::pair<int, int> limbIdsHeatmap[] = {
         {2, 3}, {2, 6}, {3, 4}, {4, 5}, {6, 7}, {7, 8}, {2, 9}, {9, 10}, {10, 11}, {2, 12}, {12, 13}, {13, 14},
         {2, 1}, {1, 15}, {15, 17}, {1, 16}, {16, 18}, {3, 17}, {6, 18}
@@ -193,16 +297,16 @@ std::vector<HumanPose> groupPeaksToPoses(const std::vector<std::vector<Peak>>& a
         std::vector<TwoJointsConnection> tempJointConnections;
         for (size_t i = 0; i < nJointsA; i++) {
             for (size_t j = 0; j < nJointsB; j++) {
-                cv::Point2f pt = candA[i].pos * 0.5 + candB[j].pos * 0.5;
-                cv::Point mid = cv::Point(cvRound(pt.x), cvRound(pt.y));
+                cv::Point2f mid = candA[i].pos * 0.5 + candB[j].pos * 0.5;
                 cv::Point2f vec = candB[j].pos - candA[i].pos;
                 double norm_vec = cv::norm(vec);
                 if (norm_vec == 0) {
                     continue;
                 }
                 vec /= norm_vec;
-                float score = vec.x * scoreMid.first.at<float>(mid) + vec.y * scoreMid.second.at<float>(mid);
-                int height_n  = pafs[0].rows / 2;
+                float score = vec.x * samplePaf(scoreMid.first, mid, pafsUpsampleRatio)
+                    + vec.y * samplePaf(scoreMid.second, mid, pafsUpsampleRatio);
+                int height_n  = pafs[0].rows * pafsUpsampleRatio / 2;
                 float suc_ratio = 0.0f;
                 float mid_score = 0.0f;
                 const int mid_num = 10;
@@ -213,10 +317,10 @@ std::vector<HumanPose> groupPeaksToPoses(const std::vector<std::vector<Peak>>& a
                     cv::Size2f step((candB[j].pos.x - candA[i].pos.x)/(mid_num - 1),
                                     (candB[j].pos.y - candA[i].pos.y)/(mid_num - 1));
                     for (int n = 0; n < mid_num; n++) {
-                        cv::Point midPoint(cvRound(candA[i].pos.x + n * step.width),
-                                           cvRound(candA[i].pos.y + n * step.height));
-                        cv::Point2f pred(scoreMid.first.at<float>(midPoint),
-                                         scoreMid.second.at<float>(midPoint));
+                        cv::Point2f midPoint(candA[i].pos.x + n * step.width,
+                                             candA[i].pos.y + n * step.height);
+                        cv::Point2f pred(samplePaf(scoreMid.first, midPoint, pafsUpsampleRatio),
+                                         samplePaf(scoreMid.second, midPoint, pafsUpsampleRatio));
                         score = vec.x * pred.x + vec.y * pred.y;
                         if (score > midPointsScoreThreshold) {
                             p_sum += score;
@@ -17,6 +17,52 @@
 #include "models/segmentation_model.h"
 #include "utils/ocv_common.hpp"
 
+#include <algorithm>
+#include <opencv2/core/hal/intrin.hpp>
+
+namespace {
+// Finds the class of every pixel of a row. Class planes are swept one by one, so memory is read sequentially
+// and the running maximums of neighbouring pixels are updated with vector instructions
+void argmaxRow(const float* data, int channels, size_t planeSize, int width, float* maxProbs, int* classIds) {
+    std::copy(data, data + width, maxProbs);
+    std::fill(classIds, classIds + width, 0);
+    for (int chId = 1; chId < channels; ++chId) {
+        const float* probs = data + chId * planeSize;
+        int colId = 0;
+#if CV_SIMD
+        const cv::v_int32 chIds = cv::vx_setall_s32(chId);
+        for (; colId <= width - cv::v_float32::nlanes; colId += cv::v_float32::nlanes) {
+            const cv::v_float32 prob = cv::vx_load(probs + colId);
+            const cv::v_float32 maxProb = cv::vx_load(maxProbs + colId);
+            const cv::v_float32 isGreater = prob > maxProb;
+            cv::v_store(maxProbs + colId, cv::v_select(isGreater, prob, maxProb));
+            cv::v_store(classIds + colId,
+                cv::v_select(cv::v_reinterpret_as_s32(isGreater), chIds, cv::vx_load(classIds + colId)));
+        }
+#endif
+        for (; colId < width; ++colId) {
+            if (probs[colId] > maxProbs[colId]) {
+                maxProbs[colId] = probs[colId];
+                classIds[colId] = chId;
+            }
+        }
+    }
+#if CV_SIMD
+    cv::vx_cleanup();
+#endif
+}
+
+// Source index of every destination index, the same as cv::resize() with INTER_NEAREST
+std::vector<int> nearestOffsets(int srcSize, int dstSize) {
+    std::vector<int> offsets(dstSize);
+    const double scale = 1. / (static_cast<double>(dstSize) / srcSize);  // rounded exactly as cv::resize() does
+    for (int i = 0; i < dstSize; ++i) {
+        offsets[i] = std::min(cvFloor(i * scale), srcSize - 1);
+    }
+    return offsets;
+}
+}  // namespace
+
 SegmentationModel::SegmentationModel(const std::string& modelFileName, bool useAutoResize) :
     ImageModel(modelFileName, useAutoResize) {}
 
@@ -40,6 +86,13 @@ std::vector<std::string> SegmentationModel::loadLabels(const std::string & label
     return labelsList;
 }
 
+void SegmentationModel::setColorMap(const cv::Mat& colors) {
+    if (colors.type() != CV_8UC3 || colors.total() != 256) {
+        throw std::invalid_argument("Color map must be a CV_8UC3 table of 256 colors");
+    }
+    colorMap = colors.isContinuous() ? colors : colors.clone();
+}
+
 void SegmentationModel::prepareInputsOutputs(InferenceEngine::CNNNetwork& cnnNetwork)
 {
     // --------------------------- Configure input & output ---------------------------------------------
@@ -89,48 +142,61 @@ void SegmentationModel::prepareInputsOutputs(InferenceEngine::CNNNetwork& cnnNet
 }
 
 std::unique_ptr<ResultBase> SegmentationModel::postprocess(InferenceResult& infResult) {
-    ImageResult* result = new ImageResult(infResult.frameId, infResult.metaData);
-
     const auto& inputImgSize = infResult.internalModelData->asRef<InternalImageModelData>();
 
     InferenceEngine::MemoryBlob::Ptr blobPtr = infResult.getFirstOutputBlob();
+    const InferenceEngine::Precision precision = blobPtr->getTensorDesc().getPrecision();
+    const bool hasClassIds = outChannels == 1 && precision == InferenceEngine::Precision::I32;
+    if (!hasClassIds && precision != InferenceEngine::Precision::FP32) {
+        throw std::runtime_error("Unexpected output blob precision. Only FP32 and I32 class ids are supported.");
+    }
 
-    void* pData = blobPtr->rmap().as<void*>();
+    SegmentationResult* result = new SegmentationResult(infResult.frameId, infResult.metaData);
 
-    result->resultImage = cv::Mat(outHeight, outWidth, CV_8UC1);
+    const auto lockedMemory = blobPtr->rmap();
+    const void* pData = lockedMemory.as<const void*>();
 
-    if (outChannels == 1 && blobPtr->getTensorDesc().getPrecision() == InferenceEngine::Precision::I32)
-    {
-        cv::Mat predictions(outHeight, outWidth, CV_32SC1, pData);
-        predictions.convertTo(result->resultImage, CV_8UC1);
-    }
-    else if (blobPtr->getTensorDesc().getPrecision() == InferenceEngine::Precision::FP32)
-    {
-        float* ptr = reinterpret_cast<float*>(pData);
-        for (int rowId = 0; rowId < outHeight; ++rowId)
-        {
-            for (int colId = 0; colId < outWidth; ++colId)
-            {
-                int classId = 0;
-                float maxProb = -1.0f;
-                for (int chId = 0; chId < outChannels; ++chId)
-                {
-                    float prob = ptr[chId * outHeight * outWidth + rowId * outWidth + colId];
-                    if (prob > maxProb)
-                    {
-                        classId = chId;
-                        maxProb = prob;
-                    }
-                } // nChannels
-
-                result->resultImage.at<uint8_t>(rowId, colId) = classId;
-            } // width
-        } // height
+    // Classes are computed only for the rows and columns which the nearest neighbour upscale takes,
+    // then they are written to the full size result and are painted in the same pass
+    const cv::Size resultSize(inputImgSize.inputImgWidth, inputImgSize.inputImgHeight);
+    result->resultImage.create(resultSize, CV_8UC1);
+    if (!colorMap.empty()) {
+        result->colorMask.create(resultSize, CV_8UC3);
     }
-
-    cv::resize(result->resultImage, result->resultImage,
-        cv::Size(inputImgSize.inputImgWidth, inputImgSize.inputImgHeight),
-        0, 0, cv::INTER_NEAREST);
+    const std::vector<int> srcRows = nearestOffsets(outHeight, resultSize.height);
+    const std::vector<int> srcCols = nearestOffsets(outWidth, resultSize.width);
+    const size_t planeSize = static_cast<size_t>(outHeight) * outWidth;
+
+    cv::parallel_for_(cv::Range(0, resultSize.height), [&](const cv::Range& range) {
+        std::vector<float> maxProbs(outWidth);
+        std::vector<int> classIds(outWidth);
+        int prevSrcRow = -1;
+        for (int rowId = range.start; rowId < range.end; ++rowId) {
+            const int srcRow = srcRows[rowId];
+            if (srcRow != prevSrcRow) {
+                if (hasClassIds) {
+                    const int* ids = static_cast<const int*>(pData) + static_cast<size_t>(srcRow) * outWidth;
+                    std::copy(ids, ids + outWidth, classIds.begin());
+                } else {
+                    argmaxRow(static_cast<const float*>(pData) + static_cast<size_t>(srcRow) * outWidth,
+                        outChannels, planeSize, outWidth, maxProbs.data(), classIds.data());
+                }
+                prevSrcRow = srcRow;
+            }
+
+            uint8_t* classRow = result->resultImage.ptr<uint8_t>(rowId);
+            for (int colId = 0; colId < resultSize.width; ++colId) {
+                classRow[colId] = cv::saturate_cast<uint8_t>(classIds[srcCols[colId]]);
+            }
+            if (!colorMap.empty()) {
+                const cv::Vec3b* colors = colorMap.ptr<cv::Vec3b>();
+                cv::Vec3b* colorRow = result->colorMask.ptr<cv::Vec3b>(rowId);
+                for (int colId = 0; colId < resultSize.width; ++colId) {
+                    colorRow[colId] = colors[classRow[colId]];
+                }
+            }
+        }
+    });
 
     return std::unique_ptr<ResultBase>(result);
 }
@@ -0,0 +1,277 @@
+// Copyright (C) 2021 Intel Corporation
+// SPDX-License-Identifier: Apache-2.0
+//
+
+#include <algorithm>
+#include <cmath>
+#include <limits>
+#include <vector>
+
+#include <opencv2/core.hpp>
+#include <opencv2/core/hal/intrin.hpp>
+
+#include "models/yolo_decoder.h"
+
+namespace {
+// Inverse of sigmoid, sigmoid(x) >= p is equivalent to x >= logit(p)
+inline float logit(float p) {
+    if (p <= 0.f) {
+        return -std::numeric_limits<float>::infinity();
+    }
+    if (p >= 1.f) {
+        return std::numeric_limits<float>::infinity();
+    }
+    return std::log(p / (1.f - p));
+}
+
+inline float sigmoid(float x) {
+    return 1.f / (1.f + std::exp(-x));
+}
+
+inline float clamp(float value, float low, float high) {
+    return std::min(std::max(value, low), high);
+}
+
+#if CV_SIMD
+// Universal intrinsics of OpenCV 4.5 have no exp. This is the Cephes expf: exp(x) = 2^n * exp(r),
+// where n = round(x / ln2) and exp(r) for |r| <= ln2 / 2 is a polynomial. Relative error is below 2e-7
+inline cv::v_float32 vExp(const cv::v_float32& value) {
+    const cv::v_float32 x = cv::v_min(cv::v_max(value, cv::vx_setall_f32(-87.3f)), cv::vx_setall_f32(88.3f));
+    const cv::v_int32 n = cv::v_floor(cv::v_fma(x, cv::vx_setall_f32(1.44269504088896341f), cv::vx_setall_f32(0.5f)));
+    const cv::v_float32 fn = cv::v_cvt_f32(n);
+    // ln2 is split in two parts, so r is computed without losing precision
+    cv::v_float32 r = cv::v_fma(fn, cv::vx_setall_f32(-0.693359375f), x);
+    r = cv::v_fma(fn, cv::vx_setall_f32(2.12194440e-4f), r);
+
+    cv::v_float32 p = cv::vx_setall_f32(1.9875691500e-4f);
+    p = cv::v_fma(p, r, cv::vx_setall_f32(1.3981999507e-3f));
+    p = cv::v_fma(p, r, cv::vx_setall_f32(8.3334519073e-3f));
+    p = cv::v_fma(p, r, cv::vx_setall_f32(4.1665795894e-2f));
+    p = cv::v_fma(p, r, cv::vx_setall_f32(1.6666665459e-1f));
+    p = cv::v_fma(p, r, cv::vx_setall_f32(5.0000001201e-1f));
+    p = cv::v_fma(p * r, r, r + cv::vx_setall_f32(1.0f));
+
+    // 2^n is built from its exponent bits
+    const cv::v_float32 pow2n = cv::v_reinterpret_as_f32(cv::v_shl<23>(n + cv::vx_setall_s32(127)));
+    return p * pow2n;
+}
+#endif
+
+void expInPlace(std::vector<float>& values) {
+    float* data = values.data();
+    const int size = static_cast<int>(values.size());
+    int i = 0;
+#if CV_SIMD
+    for (; i <= size - cv::v_float32::nlanes; i += cv::v_float32::nlanes) {
+        cv::v_store(data + i, vExp(cv::vx_load(data + i)));
+    }
+#endif
+    for (; i < size; ++i) {
+        data[i] = std::exp(data[i]);
+    }
+}
+
+void sigmoidInPlace(std::vector<float>& values) {
+    float* data = values.data();
+    const int size = static_cast<int>(values.size());
+    int i = 0;
+#if CV_SIMD
+    const cv::v_float32 one = cv::vx_setall_f32(1.0f);
+    for (; i <= size - cv::v_float32::nlanes; i += cv::v_float32::nlanes) {
+        cv::v_store(data + i, one / (one + vExp(cv::vx_setzero_f32() - cv::vx_load(data + i))));
+    }
+#endif
+    for (; i < size; ++i) {
+        data[i] = sigmoid(data[i]);
+    }
+}
+
+// Appends positions of values which are not below the threshold
+void findAbove(const float* data, int size, float threshold, std::vector<int>& positions) {
+    int i = 0;
+#if CV_SIMD
+    const cv::v_float32 vThreshold = cv::vx_setall_f32(threshold);
+    for (; i <= size - cv::v_float32::nlanes; i += cv::v_float32::nlanes) {
+        int mask = cv::v_signmask(cv::vx_load(data + i) >= vThreshold);
+        while (mask) {
+            int lane = 0;
+            while (!(mask & (1 << lane))) {
+                lane++;
+            }
+            positions.push_back(i + lane);
+            mask &= mask - 1;
+        }
+    }
+#endif
+    for (; i < size; ++i) {
+        if (data[i] >= threshold) {
+            positions.push_back(i);
+        }
+    }
+}
+
+// Appends positions where values are not below thresholds given for every position
+void findAbove(const float* data, const float* thresholds, int size, std::vector<int>& positions) {
+    int i = 0;
+#if CV_SIMD
+    for (; i <= size - cv::v_float32::nlanes; i += cv::v_float32::nlanes) {
+        int mask = cv::v_signmask(cv::vx_load(data + i) >= cv::vx_load(thresholds + i));
+        while (mask) {
+            int lane = 0;
+            while (!(mask & (1 << lane))) {
+                lane++;
+            }
+            positions.push_back(i + lane);
+            mask &= mask - 1;
+        }
+    }
+#endif
+    for (; i < size; ++i) {
+        if (data[i] >= thresholds[i]) {
+            positions.push_back(i);
+        }
+    }
+}
+
+void gather(const float* plane, const std::vector<int>& locations, std::vector<float>& values) {
+    values.resize(locations.size());
+    for (size_t k = 0; k < locations.size(); ++k) {
+        values[k] = plane[locations[k]];
+    }
+}
+}  // namespace
+
+void YoloCandidates::reserve(size_t capacity) {
+    x.reserve(capacity);
+    y.reserve(capacity);
+    width.reserve(capacity);
+    height.reserve(capacity);
+    confidence.reserve(capacity);
+    labelID.reserve(capacity);
+}
+
+void YoloCandidates::push(float x, float y, float width, float height, float confidence, unsigned int labelID) {
+    this->x.push_back(x);
+    this->y.push_back(y);
+    this->width.push_back(width);
+    this->height.push_back(height);
+    this->confidence.push_back(confidence);
+    this->labelID.push_back(labelID);
+}
+
+void decodeYoloRegion(const float* data, const YoloRegionLayout& region, float confidenceThreshold,
+                      float originalW, float originalH, YoloDecodingBuffers& buffers, YoloCandidates& candidates) {
+    const int sideW = region.sideW;
+    const int sideH = region.sideH;
+    const int entriesNum = sideW * sideH;
+    const int objectness = region.hasObjectness ? 1 : 0;
+    // Raw values are compared against thresholds in the same domain, so rejected entries never go through sigmoid
+    const float objThreshold = region.useSigmoid ? logit(confidenceThreshold) : confidenceThreshold;
+    const int anchorStride = (region.coords + objectness + region.classes) * entriesNum;
+
+    auto& locations = buffers.locations;
+    auto& scales = buffers.scales;
+    auto& classThresholds = buffers.classThresholds;
+    auto& boxes = buffers.boxes;
+    auto& hits = buffers.hits;
+
+    for (int n = 0; n < region.num; ++n) {
+        const float* anchorData = data + n * anchorStride;
+        const float* objPlane = anchorData + region.coords * entriesNum;
+        const float* classPlanes = anchorData + (region.coords + objectness) * entriesNum;
+
+        //--- Objectness thresholding sweeps one contiguous plane
+        locations.clear();
+        if (region.hasObjectness) {
+            findAbove(objPlane, entriesNum, objThreshold, locations);
+        } else {
+            locations.resize(entriesNum);
+            for (int i = 0; i < entriesNum; ++i) {
+                locations[i] = i;
+            }
+        }
+        if (locations.empty()) {
+            continue;
+        }
+
+        //--- Activations of surviving locations are gathered and computed in vectors
+        const size_t candidatesNum = locations.size();
+        gather(anchorData, locations, buffers.x);
+        gather(anchorData + entriesNum, locations, buffers.y);
+        gather(anchorData + 2 * entriesNum, locations, buffers.width);
+        gather(anchorData + 3 * entriesNum, locations, buffers.height);
+        if (region.useSigmoid && !region.isYolof) {
+            sigmoidInPlace(buffers.x);
+            sigmoidInPlace(buffers.y);
+        }
+        expInPlace(buffers.width);
+        expInPlace(buffers.height);
+        if (region.hasObjectness) {
+            gather(objPlane, locations, scales);
+            if (region.useSigmoid) {
+                sigmoidInPlace(scales);
+            }
+        } else {
+            scales.assign(candidatesNum, 1.f);
+        }
+
+        //--- Calculating boxes and per-location class thresholds
+        classThresholds.resize(candidatesNum);
+        boxes.resize(candidatesNum);
+        const float anchorW = region.anchors[2 * n];
+        const float anchorH = region.anchors[2 * n + 1];
+        for (size_t k = 0; k < candidatesNum; ++k) {
+            const int i = locations[k];
+            const int row = i / sideW;
+            const int col = i - row * sideW;
+            const float scale = scales[k];
+            // scale * activation(classValue) >= threshold  <=>  classValue >= classThreshold
+            const float relativeThreshold = scale > 0.f ? confidenceThreshold / scale : std::numeric_limits<float>::infinity();
+            classThresholds[k] = region.useSigmoid ? logit(relativeThreshold) : relativeThreshold;
+
+            //--- Calculating scaled region's coordinates
+            float x, y;
+            if (region.isYolof) {
+                x = ((float)col / sideW + buffers.x[k] * anchorW / region.scaleW) * originalW;
+                y = ((float)row / sideH + buffers.y[k] * anchorH / region.scaleH) * originalH;
+            } else {
+                x = (col + buffers.x[k]) / sideW * originalW;
+                y = (row + buffers.y[k]) / sideH * originalH;
+            }
+            const float height = buffers.height[k] * anchorH * originalH / region.scaleH;
+            const float width = buffers.width[k] * anchorW * originalW / region.scaleW;
+
+            auto& box = boxes[k];
+            box.x = clamp(x - width / 2, 0.f, originalW);
+            box.y = clamp(y - height / 2, 0.f, originalH);
+            box.width = clamp(width, 0.f, originalW - box.x);
+            box.height = clamp(height, 0.f, originalH - box.y);
+        }
+
+        //--- Class planes are visited one after another. If every location survived, a class plane is compared
+        // with the thresholds in vectors, otherwise only candidate locations are read
+        const bool isDense = candidatesNum == static_cast<size_t>(entriesNum);
+        for (int j = 0; j < region.classes; ++j) {
+            const float* classPlane = classPlanes + j * entriesNum;
+            hits.clear();
+            if (isDense) {
+                findAbove(classPlane, classThresholds.data(), entriesNum, hits);
+            } else {
+                for (size_t k = 0; k < candidatesNum; ++k) {
+                    if (classPlane[locations[k]] >= classThresholds[k]) {
+                        hits.push_back(static_cast<int>(k));
+                    }
+                }
+            }
+            //--- Checking confidence threshold conformance and adding region to the list
+            for (int k : hits) {
+                const float value = classPlane[locations[k]];
+                const float prob = scales[k] * (region.useSigmoid ? sigmoid(value) : value);
+                if (prob >= confidenceThreshold) {
+                    const auto& box = boxes[k];
+                    candidates.push(box.x, box.y, box.width, box.height, prob, j);
+                }
+            }
+        }
+    }
+}
@@ -15,26 +15,66 @@
 */
 
 #pragma once
+#include <atomic>
 #include <string>
 #include <deque>
 #include <map>
+#include <chrono>
 #include <condition_variable>
+#include <thread>
+#include <unordered_map>
+#include <vector>
 #include "utils/config_factory.h"
 #include "pipelines/requests_pool.h"
 #include "models/results.h"
 #include "models/model_base.h"
 #include <utils/performance_metrics.hpp>
 
+/// Parameters of dynamic batching in AsyncPipeline
+struct BatchingParams {
+    /// Maximum number of frames packed into one infer request. Value 1 disables batching
+    size_t batchSize = 1;
+    /// Maximum time the first frame of an incomplete batch waits for other frames.
+    /// Deadline is checked on every submitData and waitForData call.
+    std::chrono::milliseconds maxWaitTime = std::chrono::milliseconds(30);
+};
+
+/// Parameters of the postprocessing stage of AsyncPipeline
+struct PostprocessingParams {
+    /// Number of threads which postprocess inferred frames in background, so getResult() just takes finished results
+    /// and the main loop can keep the device busy. Value 0 makes getResult() postprocess on the calling thread.
+    /// Several threads call model's postprocess() for different frames concurrently
+    size_t threadsNum = 0;
+    /// Maximum number of inferred frames which wait for postprocessing, are being postprocessed or wait for getResult().
+    /// Submission of new frames is paused when it is reached
+    size_t maxQueueSize = 8;
+};
+
 /// This is base class for asynchronous pipeline
 /// Derived classes should add functions for data submission and output processing
 class AsyncPipeline {
 public:
+    /// Defines who owns output blobs passed to model postprocessing
+    enum class OutputsOwnership {
+        /// Outputs are copied into separate blobs in completion callback and request is returned to the pool immediately
+        Copy,
+        /// Outputs are borrowed from infer request without copying. Request stays in use until getResult
+        /// finishes postprocessing, so completed but not yet extracted results reduce number of requests available for inference
+        Borrow
+    };
+
     /// Loads model and performs required initialization
     /// @param modelInstance pointer to model object. Object it points to should not be destroyed manually after passing pointer to this function.
     /// @param cnnConfig - fine tuning configuration for CNN model
     /// @param engine - reference to InferenceEngine::Core instance to use.
     /// If it is omitted, new instance of InferenceEngine::Core will be created inside.
-    AsyncPipeline(std::unique_ptr<ModelBase>&& modelInstance, const CnnConfig& cnnConfig, InferenceEngine::Core& core);
+    /// @param outputsOwnership - defines whether output blobs are copied or borrowed from infer requests
+    /// @param batching - batching parameters. If batch size is greater than 1, submitted frames are accumulated
+    /// and inferred together, but results are still returned per frame. Model should support batching.
+    /// @param postprocessing - parameters of background postprocessing
+    AsyncPipeline(std::unique_ptr<ModelBase>&& modelInstance, const CnnConfig& cnnConfig, InferenceEngine::Core& core,
+        OutputsOwnership outputsOwnership = OutputsOwnership::Copy, const BatchingParams& batching = BatchingParams(),
+        const PostprocessingParams& postprocessing = PostprocessingParams());
     virtual ~AsyncPipeline();
 
     /// Waits until either output data becomes available or pipeline allows to submit more input data.
@@ -42,13 +82,17 @@ public:
     /// ready (so results can be extracted in the same order as they were submitted). Otherwise, function will return if any result is ready.
     void waitForData(bool shouldKeepOrder = true);
 
-    /// @returns true if there's available infer requests in the pool
+    /// @returns true if there's available infer requests in the pool (or a batch being accumulated has free slots)
     /// and next frame can be submitted for processing, false otherwise.
-    bool isReadyToProcess() { return requestsPool->isIdleRequestAvailable(); }
+    /// With background postprocessing it also requires the postprocessing queue not to be full.
+    bool isReadyToProcess() {
+        return (pendingBatch.request || requestsPool->isIdleRequestAvailable()) &&
+            postprocessingQueueSize < postprocessing.maxQueueSize;
+    }
 
-    /// Waits for all currently submitted requests to be completed.
-    ///
-    void waitForTotalCompletion() { if (requestsPool) requestsPool->waitForTotalCompletion(); }
+    /// Starts inference of incomplete batch (if any) and waits for all currently submitted requests to be completed.
+    /// With background postprocessing it also waits until all inferred frames are postprocessed.
+    void waitForTotalCompletion();
 
     /// Submits data to the network for inference
     /// @param inputData - input data to be submitted
@@ -63,9 +107,20 @@ public:
     /// ready (so results can be extracted in the same order as they were submitted). Otherwise, function will return if any result is ready.
     virtual std::unique_ptr<ResultBase> getResult(bool shouldKeepOrder = true);
 
-    PerformanceMetrics getInferenceMetircs(){ return inferenceMetrics;}
-    PerformanceMetrics getPreprocessMetrics(){ return preprocessMetrics;}
-    PerformanceMetrics getPostprocessMetrics() { return postprocessMetrics;}
+    const PerformanceMetrics& getInferenceMetircs() const { return inferenceMetrics; }
+    const PerformanceMetrics& getPreprocessMetrics() const { return preprocessMetrics; }
+    const PerformanceMetrics& getPostprocessMetrics() const { return postprocessMetrics; }
+
+    /// Depth of a queue between pipeline stages, sampled every time inference of a frame is completed
+    struct QueueMetrics {
+        double averageDepth;
+        size_t maxDepth;
+    };
+    /// @returns statistics of inferred frames waiting for postprocessing
+    QueueMetrics getPostprocessQueueMetrics() const;
+    /// @returns statistics of postprocessed results waiting for getResult(). Always empty without background postprocessing
+    QueueMetrics getResultsQueueMetrics() const;
+    void logQueueMetrics() const;
 
 protected:
     /// Returns processed result, if available
@@ -74,14 +129,83 @@ protected:
     /// @returns InferenceResult with processed information or empty InferenceResult (with negative frameID) if there's no any results yet.
     virtual InferenceResult getInferenceResult(bool shouldKeepOrder);
 
+    /// Returns request which outputs were borrowed by result with given frame ID back to the pool.
+    /// Does nothing if outputs of this frame were copied. In batching mode request is returned
+    /// when all frames of the batch are released.
+    /// @param frameId - frame ID of the result which was processed
+    void releaseBorrowedRequest(int64_t frameId);
+
+    /// Starts inference of the batch being accumulated
+    void startPendingBatch();
+
+    /// Runs model postprocessing and returns borrowed request, if any
+    std::unique_ptr<ResultBase> postprocess(InferenceResult& infResult);
+
+    /// Body of background postprocessing threads
+    void postprocessingLoop();
+
+    /// @returns true if result which getResult() may return is ready. Must be called under the lock
+    bool isResultReady(bool shouldKeepOrder) const;
+
+    /// Returns output blob for particular item of the batch (copied or borrowed depending on outputsOwnership)
+    InferenceEngine::MemoryBlob::Ptr getBatchItemOutput(const InferenceEngine::MemoryBlob::Ptr& blob, size_t batchIndex);
+
+    struct BatchItem {
+        int64_t frameId;
+        std::shared_ptr<MetaData> metaData;
+        std::shared_ptr<InternalModelData> internalModelData;
+        std::chrono::steady_clock::time_point startTime;
+    };
+
+    /// Frames already put into the request which is not started yet. Accessed only by the submitting thread
+    struct PendingBatch {
+        InferenceEngine::InferRequest::Ptr request;
+        std::vector<BatchItem> items;
+    };
+
+    /// Returns request to the pool when the last result borrowing its outputs is released
+    struct BorrowedRequest {
+        BorrowedRequest(RequestsPool& pool, const InferenceEngine::InferRequest::Ptr& request) :
+            pool(pool), request(request) {}
+        ~BorrowedRequest() { pool.setRequestIdle(request); }
+
+        RequestsPool& pool;
+        InferenceEngine::InferRequest::Ptr request;
+    };
+
+    struct QueueDepthCounter {
+        size_t samplesNum = 0;
+        size_t depthSum = 0;
+        size_t maxDepth = 0;
+
+        void add(size_t depth);
+        QueueMetrics get() const;
+    };
+
     std::unique_ptr<RequestsPool> requestsPool;
-    std::unordered_map<int64_t, InferenceResult> completedInferenceResults;
+    /// Ordered by frame ID, so background postprocessing takes the oldest frames first
+    std::map<int64_t, InferenceResult> completedInferenceResults;
+    std::unordered_map<int64_t, std::unique_ptr<ResultBase>> postprocessedResults;
+    std::unordered_map<int64_t, std::shared_ptr<BorrowedRequest>> borrowedRequests;
+    OutputsOwnership outputsOwnership;
+    BatchingParams batching;
+    PendingBatch pendingBatch;
 
     InferenceEngine::ExecutableNetwork execNetwork;
 
-    std::mutex mtx;
+    mutable std::mutex mtx;
     std::condition_variable condVar;
 
+    PostprocessingParams postprocessing;
+    std::vector<std::thread> postprocessingThreads;
+    std::condition_variable postprocessingCondVar;
+    size_t busyPostprocessingThreads = 0;
+    bool stopPostprocessing = false;
+    /// Frames inferred but not taken by getResult() yet, counted only with background postprocessing
+    std::atomic<size_t> postprocessingQueueSize = {0};
+    QueueDepthCounter postprocessQueueDepth;
+    QueueDepthCounter resultsQueueDepth;
+
     int64_t inputFrameId = 0;
     int64_t outputFrameId = 0;
 
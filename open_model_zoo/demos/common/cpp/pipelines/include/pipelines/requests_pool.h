@@ -16,15 +16,18 @@
 
 #pragma once
 
-#include <map>
 #include <atomic>
+#include <memory>
+#include <unordered_map>
+#include <vector>
 #include <opencv2/core.hpp>
 #include <inference_engine.hpp>
-#include <map>
+#include <utils/bounded_queue.hpp>
 
 
 /// This is class storing requests pool for asynchronous pipeline
-///
+/// Idle requests are kept in a lock-free ring of request indices, so acquiring and releasing a request
+/// doesn't serialize submitting and callback threads on a mutex.
 class RequestsPool {
 public:
     RequestsPool(InferenceEngine::ExecutableNetwork& execNetwork, unsigned int size);
@@ -44,8 +47,8 @@ public:
     /// @returns number of requests in use
     size_t getInUseRequestsCount();
 
-    /// Returns number of requests in use. This function is thread safe.
-    /// @returns number of requests in use
+    /// Checks whether there are idle requests in the pool. This function is thread safe.
+    /// @returns true if at least one request is idle
     bool isIdleRequestAvailable();
 
     /// Waits for completion of every non-idle requests in pool.
@@ -58,7 +61,9 @@ public:
     std::vector<InferenceEngine::InferRequest::Ptr> getInferRequestsList();
 
 private:
-    std::map<InferenceEngine::InferRequest::Ptr, bool> requests;
-    size_t numRequestsInUse;
-    std::mutex mtx;
+    std::vector<InferenceEngine::InferRequest::Ptr> requests;
+    std::unordered_map<InferenceEngine::InferRequest*, size_t> requestIndices;
+    std::unique_ptr<std::atomic<bool>[]> inUse;
+    BoundedMPMCQueue<size_t> idleRequests;
+    std::atomic<size_t> numRequestsInUse;
 };
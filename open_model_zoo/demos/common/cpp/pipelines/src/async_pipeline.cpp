@@ -15,11 +15,55 @@
 */
 
 #include "pipelines/async_pipeline.h"
+#include <algorithm>
+#include <iomanip>
 #include <utils/common.hpp>
 #include <utils/slog.hpp>
 
-AsyncPipeline::AsyncPipeline(std::unique_ptr<ModelBase>&& modelInstance, const CnnConfig& cnnConfig, InferenceEngine::Core& core) :
+namespace {
+template <typename T>
+InferenceEngine::MemoryBlob::Ptr sliceBlob(const InferenceEngine::MemoryBlob::Ptr& blob,
+    size_t batchIndex, size_t batchSize, bool shouldCopy) {
+    const auto& desc = blob->getTensorDesc();
+    auto dims = desc.getDims();
+    if (dims.empty() || dims[0] != batchSize) {
+        throw std::logic_error("Output batch dimension doesn't match batch size of the network");
+    }
+    dims[0] = 1;
+    InferenceEngine::TensorDesc itemDesc(desc.getPrecision(), dims, desc.getLayout());
+
+    size_t itemSize = blob->size() / batchSize;
+    // Host memory of the request stays valid after unmapping, so the pointer can be kept by borrowed blob
+    T* itemData = blob->rwmap().as<T*>() + batchIndex * itemSize;
+    if (!shouldCopy) {
+        return InferenceEngine::make_shared_blob<T>(itemDesc, itemData, itemSize);
+    }
+
+    auto itemBlob = InferenceEngine::make_shared_blob<T>(itemDesc);
+    itemBlob->allocate();
+    std::copy(itemData, itemData + itemSize, itemBlob->wmap().template as<T*>());
+    return itemBlob;
+}
+}  // namespace
+
+AsyncPipeline::AsyncPipeline(std::unique_ptr<ModelBase>&& modelInstance, const CnnConfig& cnnConfig, InferenceEngine::Core& core,
+    OutputsOwnership outputsOwnership, const BatchingParams& batching, const PostprocessingParams& postprocessing) :
+    outputsOwnership(outputsOwnership),
+    batching(batching),
+    postprocessing(postprocessing),
     model(std::move(modelInstance)) {
+    if (batching.batchSize == 0) {
+        throw std::invalid_argument("Batch size should be positive");
+    }
+    if (postprocessing.threadsNum > 0 && postprocessing.maxQueueSize == 0) {
+        throw std::invalid_argument("Postprocessing queue size should be positive");
+    }
+    if (batching.batchSize > 1) {
+        if (!model->isBatchingSupported()) {
+            throw std::logic_error("The model doesn't support batching (automatic resize of input may prevent it)");
+        }
+        model->setBatchSize(batching.batchSize);
+    }
     execNetwork = model->loadExecutableNetwork(cnnConfig, core);
     // --------------------------- Create infer requests ------------------------------------------------
     unsigned int nireq = cnnConfig.maxAsyncRequests;
@@ -33,16 +77,67 @@ AsyncPipeline::AsyncPipeline(std::unique_ptr<ModelBase>&& modelInstance, const C
         }
     }
     slog::info << "\tNumber of network inference requests: " << nireq << slog::endl;
+    if (batching.batchSize > 1) {
+        slog::info << "\tBatch size: " << batching.batchSize << ", max batch waiting time: "
+            << batching.maxWaitTime.count() << " ms" << slog::endl;
+    }
     requestsPool.reset(new RequestsPool(execNetwork, nireq));
     // --------------------------- Call onLoadCompleted to complete initialization of model -------------
     model->onLoadCompleted(requestsPool->getInferRequestsList());
+
+    if (postprocessing.threadsNum > 0) {
+        slog::info << "\tNumber of postprocessing threads: " << postprocessing.threadsNum << slog::endl;
+    }
+    for (size_t i = 0; i < postprocessing.threadsNum; i++) {
+        postprocessingThreads.emplace_back(&AsyncPipeline::postprocessingLoop, this);
+    }
 }
 
 AsyncPipeline::~AsyncPipeline() {
     waitForTotalCompletion();
+    {
+        const std::lock_guard<std::mutex> lock(mtx);
+        stopPostprocessing = true;
+    }
+    postprocessingCondVar.notify_all();
+    for (auto& thread : postprocessingThreads) {
+        thread.join();
+    }
+}
+
+void AsyncPipeline::waitForTotalCompletion() {
+    if (pendingBatch.request) {
+        startPendingBatch();
+    }
+    if (requestsPool) {
+        requestsPool->waitForTotalCompletion();
+    }
+    if (!postprocessingThreads.empty()) {
+        std::unique_lock<std::mutex> lock(mtx);
+        condVar.wait(lock, [&]() {
+            return callbackException != nullptr ||
+                (completedInferenceResults.empty() && busyPostprocessingThreads == 0);
+        });
+    }
+}
+
+bool AsyncPipeline::isResultReady(bool shouldKeepOrder) const {
+    if (!postprocessingThreads.empty()) {
+        return shouldKeepOrder ?
+            postprocessedResults.find(outputFrameId) != postprocessedResults.end() :
+            !postprocessedResults.empty();
+    }
+    return shouldKeepOrder ?
+        completedInferenceResults.find(outputFrameId) != completedInferenceResults.end() :
+        !completedInferenceResults.empty();
 }
 
 void AsyncPipeline::waitForData(bool shouldKeepOrder) {
+    if (pendingBatch.request &&
+        std::chrono::steady_clock::now() - pendingBatch.items.front().startTime >= batching.maxWaitTime) {
+        startPendingBatch();
+    }
+
     std::unique_lock<std::mutex> lock(mtx);
 
     condVar.wait(
@@ -50,10 +145,8 @@ void AsyncPipeline::waitForData(bool shouldKeepOrder) {
         [&]()
         {
             return callbackException != nullptr ||
-                   requestsPool->isIdleRequestAvailable() ||
-                   (shouldKeepOrder ?
-                       completedInferenceResults.find(outputFrameId) != completedInferenceResults.end() :
-                       !completedInferenceResults.empty());
+                   isReadyToProcess() ||
+                   isResultReady(shouldKeepOrder);
         });
 
     if (callbackException) {
@@ -64,73 +157,254 @@ void AsyncPipeline::waitForData(bool shouldKeepOrder) {
 int64_t AsyncPipeline::submitData(const InputData& inputData, const std::shared_ptr<MetaData>& metaData) {
     auto frameID = inputFrameId;
 
-    auto request = requestsPool->getIdleRequest();
-    if (!request)
-        return -1;
+    if (!pendingBatch.request) {
+        pendingBatch.request = requestsPool->getIdleRequest();
+        if (!pendingBatch.request)
+            return -1;
+    }
 
     auto startTime = std::chrono::steady_clock::now();
-    auto internalModelData = model->preprocess(inputData, request);
+    // Models which override preprocess() may not support batching, so preprocessBatchItem is used in batching mode only
+    auto internalModelData = batching.batchSize == 1 ?
+        model->preprocess(inputData, pendingBatch.request) :
+        model->preprocessBatchItem(inputData, pendingBatch.request, pendingBatch.items.size());
     preprocessMetrics.update(startTime);
 
+    pendingBatch.items.push_back({frameID, metaData, internalModelData, startTime});
+
+    inputFrameId++;
+    if (inputFrameId < 0)
+        inputFrameId = 0;
+
+    if (pendingBatch.items.size() == batching.batchSize ||
+        std::chrono::steady_clock::now() - pendingBatch.items.front().startTime >= batching.maxWaitTime) {
+        startPendingBatch();
+    }
+
+    return frameID;
+}
+
+void AsyncPipeline::startPendingBatch() {
+    auto request = std::move(pendingBatch.request);
+    auto items = std::move(pendingBatch.items);
+    pendingBatch = PendingBatch();
+
+    // Slots of incomplete batch keep data of previous frames, their outputs are just ignored
     request->SetCompletionCallback(
-        [this, frameID, request, internalModelData, metaData, startTime]() {
-            {
-                const std::lock_guard<std::mutex> lock(mtx);
-                inferenceMetrics.update(startTime);
-                try {
-                    InferenceResult result;
-
-                    result.frameId = frameID;
-                    result.metaData = std::move(metaData);
-                    result.internalModelData = std::move(internalModelData);
-
-                    for (const auto& outName : model->getOutputsNames()) {
-                        auto blobPtr = request->GetBlob(outName);
-
-                        if (InferenceEngine::Precision::I32 == blobPtr->getTensorDesc().getPrecision()) {
-                            result.outputsData.emplace(outName,
-                                std::make_shared<InferenceEngine::TBlob<int>>(*InferenceEngine::as<InferenceEngine::TBlob<int>>(blobPtr)));
-                        }
-                        else {
-                            result.outputsData.emplace(outName,
-                                std::make_shared<InferenceEngine::TBlob<float>>(*InferenceEngine::as<InferenceEngine::TBlob<float>>(blobPtr)));
-                        }
+        [this, request, items]() {
+            try {
+                std::vector<InferenceResult> results(items.size());
+                for (size_t i = 0; i < items.size(); i++) {
+                    results[i].frameId = items[i].frameId;
+                    results[i].metaData = items[i].metaData;
+                    results[i].internalModelData = items[i].internalModelData;
+                }
+
+                {
+                    // Inference time is taken before the outputs are copied, so it doesn't include the copy
+                    const std::lock_guard<std::mutex> lock(mtx);
+                    for (const auto& item : items) {
+                        inferenceMetrics.update(item.startTime);
                     }
+                }
 
-                    completedInferenceResults.emplace(frameID, result);
-                    requestsPool->setRequestIdle(request);
+                // Outputs are copied (if required) without holding the lock, so other callbacks and
+                // getResult() calls are not blocked by memory copying
+                for (const auto& outName : model->getOutputsNames()) {
+                    auto blobPtr = InferenceEngine::as<InferenceEngine::MemoryBlob>(request->GetBlob(outName));
+                    for (size_t i = 0; i < items.size(); i++) {
+                        results[i].outputsData.emplace(outName, getBatchItemOutput(blobPtr, i));
+                    }
+                }
+
+                const std::lock_guard<std::mutex> lock(mtx);
+                for (size_t i = 0; i < items.size(); i++) {
+                    completedInferenceResults.emplace(items[i].frameId, std::move(results[i]));
+                    postprocessQueueDepth.add(completedInferenceResults.size());
+                    resultsQueueDepth.add(postprocessedResults.size());
                 }
-                catch (...) {
-                    if (!callbackException) {
-                        callbackException = std::current_exception();
+                if (!postprocessingThreads.empty()) {
+                    postprocessingQueueSize += items.size();
+                    postprocessingCondVar.notify_all();
+                }
+                if (outputsOwnership == OutputsOwnership::Borrow) {
+                    // Request is returned to the pool by getResult() after postprocessing of all frames of the batch
+                    auto borrowedRequest = std::make_shared<BorrowedRequest>(*requestsPool, request);
+                    for (const auto& item : items) {
+                        borrowedRequests.emplace(item.frameId, borrowedRequest);
                     }
                 }
+                else {
+                    requestsPool->setRequestIdle(request);
+                }
+            }
+            catch (...) {
+                const std::lock_guard<std::mutex> lock(mtx);
+                if (!callbackException) {
+                    callbackException = std::current_exception();
+                }
             }
             condVar.notify_one();
     });
 
-    inputFrameId++;
-    if (inputFrameId < 0)
-        inputFrameId = 0;
-
     request->StartAsync();
+}
 
-    return frameID;
+InferenceEngine::MemoryBlob::Ptr AsyncPipeline::getBatchItemOutput(const InferenceEngine::MemoryBlob::Ptr& blob,
+    size_t batchIndex) {
+    bool shouldCopy = outputsOwnership == OutputsOwnership::Copy;
+    if (batching.batchSize == 1) {
+        if (!shouldCopy) {
+            return blob;
+        }
+        if (InferenceEngine::Precision::I32 == blob->getTensorDesc().getPrecision()) {
+            return std::make_shared<InferenceEngine::TBlob<int>>(*InferenceEngine::as<InferenceEngine::TBlob<int>>(blob));
+        }
+        else {
+            return std::make_shared<InferenceEngine::TBlob<float>>(*InferenceEngine::as<InferenceEngine::TBlob<float>>(blob));
+        }
+    }
+
+    if (InferenceEngine::Precision::I32 == blob->getTensorDesc().getPrecision()) {
+        return sliceBlob<int>(blob, batchIndex, batching.batchSize, shouldCopy);
+    }
+    else {
+        return sliceBlob<float>(blob, batchIndex, batching.batchSize, shouldCopy);
+    }
 }
 
 std::unique_ptr<ResultBase> AsyncPipeline::getResult(bool shouldKeepOrder) {
+    if (!postprocessingThreads.empty()) {
+        std::unique_ptr<ResultBase> result;
+        {
+            const std::lock_guard<std::mutex> lock(mtx);
+            if (callbackException) {
+                std::rethrow_exception(callbackException);
+            }
+            auto it = shouldKeepOrder ? postprocessedResults.find(outputFrameId) : postprocessedResults.begin();
+            if (it == postprocessedResults.end()) {
+                return std::unique_ptr<ResultBase>();
+            }
+            result = std::move(it->second);
+            postprocessedResults.erase(it);
+        }
+        postprocessingQueueSize--;
+        outputFrameId = result->frameId + 1;
+        if (outputFrameId < 0) {
+            outputFrameId = 0;
+        }
+        return result;
+    }
+
     auto infResult = AsyncPipeline::getInferenceResult(shouldKeepOrder);
     if (infResult.IsEmpty()) {
         return std::unique_ptr<ResultBase>();
     }
     auto startTime = std::chrono::steady_clock::now();
-    auto result = model->postprocess(infResult);
+    std::unique_ptr<ResultBase> result = postprocess(infResult);
     postprocessMetrics.update(startTime);
+    return result;
+}
+
+std::unique_ptr<ResultBase> AsyncPipeline::postprocess(InferenceResult& infResult) {
+    std::unique_ptr<ResultBase> result;
+    try {
+        result = model->postprocess(infResult);
+    }
+    catch (...) {
+        releaseBorrowedRequest(infResult.frameId);
+        throw;
+    }
+    releaseBorrowedRequest(infResult.frameId);
 
     *result = static_cast<ResultBase&>(infResult);
     return result;
 }
 
+void AsyncPipeline::postprocessingLoop() {
+    std::unique_lock<std::mutex> lock(mtx);
+    while (true) {
+        postprocessingCondVar.wait(lock, [&]() {
+            return stopPostprocessing || !completedInferenceResults.empty();
+        });
+        if (completedInferenceResults.empty()) {
+            return;
+        }
+        InferenceResult infResult = std::move(completedInferenceResults.begin()->second);
+        completedInferenceResults.erase(completedInferenceResults.begin());
+        busyPostprocessingThreads++;
+        lock.unlock();
+
+        auto startTime = std::chrono::steady_clock::now();
+        std::unique_ptr<ResultBase> result;
+        std::exception_ptr exception;
+        try {
+            result = postprocess(infResult);
+        }
+        catch (...) {
+            exception = std::current_exception();
+        }
+
+        lock.lock();
+        busyPostprocessingThreads--;
+        if (exception) {
+            if (!callbackException) {
+                callbackException = exception;
+            }
+        }
+        else {
+            postprocessMetrics.update(startTime);
+            const int64_t frameId = result->frameId;
+            postprocessedResults.emplace(frameId, std::move(result));
+        }
+        condVar.notify_all();
+    }
+}
+
+void AsyncPipeline::QueueDepthCounter::add(size_t depth) {
+    samplesNum++;
+    depthSum += depth;
+    maxDepth = std::max(maxDepth, depth);
+}
+
+AsyncPipeline::QueueMetrics AsyncPipeline::QueueDepthCounter::get() const {
+    return {samplesNum > 0 ? static_cast<double>(depthSum) / samplesNum : 0.0, maxDepth};
+}
+
+AsyncPipeline::QueueMetrics AsyncPipeline::getPostprocessQueueMetrics() const {
+    const std::lock_guard<std::mutex> lock(mtx);
+    return postprocessQueueDepth.get();
+}
+
+AsyncPipeline::QueueMetrics AsyncPipeline::getResultsQueueMetrics() const {
+    const std::lock_guard<std::mutex> lock(mtx);
+    return resultsQueueDepth.get();
+}
+
+void AsyncPipeline::logQueueMetrics() const {
+    const QueueMetrics postprocessQueue = getPostprocessQueueMetrics();
+    const QueueMetrics resultsQueue = getResultsQueueMetrics();
+    slog::info << "\tPostprocessing queue depth: average " << std::fixed << std::setprecision(1)
+        << postprocessQueue.averageDepth << ", max " << postprocessQueue.maxDepth << slog::endl;
+    if (!postprocessingThreads.empty()) {
+        slog::info << "\tResults queue depth: average " << resultsQueue.averageDepth
+            << ", max " << resultsQueue.maxDepth << slog::endl;
+    }
+}
+
+void AsyncPipeline::releaseBorrowedRequest(int64_t frameId) {
+    if (outputsOwnership != OutputsOwnership::Borrow) {
+        return;
+    }
+
+    {
+        // Request is returned to the pool by BorrowedRequest destructor after the last frame sharing it is released
+        const std::lock_guard<std::mutex> lock(mtx);
+        borrowedRequests.erase(frameId);
+    }
+    condVar.notify_one();
+}
+
 InferenceResult AsyncPipeline::getInferenceResult(bool shouldKeepOrder) {
     InferenceResult retVal;
     {
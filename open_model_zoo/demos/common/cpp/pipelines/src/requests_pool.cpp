@@ -17,66 +17,62 @@
 #include "pipelines/requests_pool.h"
 
 RequestsPool::RequestsPool(InferenceEngine::ExecutableNetwork& execNetwork, unsigned int size) :
+    inUse(new std::atomic<bool>[size]),
+    idleRequests(size),
     numRequestsInUse(0) {
+    requests.reserve(size);
     for (unsigned int infReqId = 0; infReqId < size; ++infReqId) {
-        requests.emplace(std::make_shared<InferenceEngine::InferRequest>(execNetwork.CreateInferRequest()), false);
+        requests.push_back(std::make_shared<InferenceEngine::InferRequest>(execNetwork.CreateInferRequest()));
+        requestIndices.emplace(requests.back().get(), infReqId);
+        inUse[infReqId].store(false);
+        idleRequests.tryPush(infReqId);
     }
 }
 
 RequestsPool::~RequestsPool() {
     // Setting empty callback to free resources allocated for previously assigned lambdas
-    for (auto& pair : requests) {
-        pair.first->SetCompletionCallback([]{});
+    for (auto& request : requests) {
+        request->SetCompletionCallback([]{});
     }
 }
 
 InferenceEngine::InferRequest::Ptr RequestsPool::getIdleRequest() {
-    std::lock_guard<std::mutex> lock(mtx);
-
-    const auto& it = std::find_if(requests.begin(), requests.end(), [](std::pair<const InferenceEngine::InferRequest::Ptr, bool>& x) {return !x.second; });
-    if (it == requests.end()) {
+    size_t idx;
+    if (!idleRequests.tryPop(idx)) {
         return InferenceEngine::InferRequest::Ptr();
     }
-    else {
-        it->second = true;
-        numRequestsInUse++;
-        return it->first;
-    }
+    inUse[idx].store(true);
+    numRequestsInUse++;
+    return requests[idx];
 }
 
 void RequestsPool::setRequestIdle(const InferenceEngine::InferRequest::Ptr& request) {
-    std::lock_guard<std::mutex> lock(mtx);
-    this->requests.at(request) = false;
+    size_t idx = requestIndices.at(request.get());
+    inUse[idx].store(false);
+    // Ring capacity is not less than number of requests, so pushing back an index never fails.
+    // Index is pushed before the counter is decremented, so isIdleRequestAvailable() never reports
+    // a request which can't be popped yet.
+    idleRequests.tryPush(idx);
     numRequestsInUse--;
 }
 
 size_t RequestsPool::getInUseRequestsCount() {
-    std::lock_guard<std::mutex> lock(mtx);
-    return numRequestsInUse;
+    return numRequestsInUse.load();
 }
 
 bool RequestsPool::isIdleRequestAvailable() {
-    std::lock_guard<std::mutex> lock(mtx);
-    return numRequestsInUse < requests.size();
+    return numRequestsInUse.load() < requests.size();
 }
 
 void RequestsPool::waitForTotalCompletion() {
-    // Do not synchronize here to avoid deadlock (despite synchronization in other functions)
-    // Request status will be changed to idle in callback,
-    // upon completion of request we're waiting for. Synchronization is applied there
-    for (auto& pair : requests) {
-        if (pair.second) {
-            pair.first->Wait(InferenceEngine::InferRequest::WaitMode::RESULT_READY);
+    // Request status will be changed to idle in callback, upon completion of request we're waiting for
+    for (size_t i = 0; i < requests.size(); ++i) {
+        if (inUse[i].load()) {
+            requests[i]->Wait(InferenceEngine::InferRequest::WaitMode::RESULT_READY);
         }
     }
 }
 
 std::vector<InferenceEngine::InferRequest::Ptr> RequestsPool::getInferRequestsList() {
-    std::lock_guard<std::mutex> lock(mtx);
-    std::vector<InferenceEngine::InferRequest::Ptr> retVal;
-    retVal.reserve(requests.size());
-    for (auto& pair : requests) {
-        retVal.push_back(pair.first);
-    }
-    return retVal;
+    return requests;
 }
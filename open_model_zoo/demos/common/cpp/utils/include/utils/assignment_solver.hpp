@@ -0,0 +1,82 @@
+// Copyright (C) 2021 Intel Corporation
+// SPDX-License-Identifier: Apache-2.0
+//
+
+#pragma once
+
+#include "opencv2/core.hpp"
+
+#include <limits>
+#include <vector>
+
+
+///
+/// \brief The AssignmentSolver class
+///
+/// Solves rectangular assignment problems with shortest augmenting paths
+/// (Jonker-Volgenant method). Pairs with dissimilarity not below max_cost are
+/// gated out: they are never stored and a row may stay unassigned instead, as
+/// if it had a private column with dissimilarity max_cost. Rows and columns
+/// linked by the remaining pairs are split into connected components which are
+/// solved separately. Memory is kept between calls, so one solver object
+/// should be reused from frame to frame.
+///
+class AssignmentSolver {
+public:
+    ///
+    /// \brief Initializes the solver.
+    /// \param[in] max_cost Pairs with dissimilarity greater or equal to max_cost
+    /// are never assigned. With the default value every row gets a column
+    /// while there are enough of them, as in KuhnMunkres.
+    ///
+    explicit AssignmentSolver(float max_cost = std::numeric_limits<float>::infinity());
+
+    ///
+    /// \brief Solves the assignment problem for given dissimilarity matrix.
+    /// \param dissimilarity_matrix CV_32F dissimilarity matrix of any shape.
+    /// Non-finite values mark impossible pairs.
+    /// \return Optimal column index for each row, -1 if the row has no column.
+    ///
+    std::vector<size_t> Solve(const cv::Mat &dissimilarity_matrix);
+
+private:
+    struct Edge {
+        int col;
+        float cost;
+    };
+
+    float max_cost_;
+
+    // Candidate pairs of every row in CSR layout
+    std::vector<int> row_begins_;
+    std::vector<Edge> edges_;
+
+    // Connected components of rows and columns
+    std::vector<int> parents_;
+    std::vector<int> row_roots_;
+    std::vector<int> component_rows_;
+
+    // Columns are real ones followed by a private column of every row if gating is enabled
+    std::vector<double> u_;
+    std::vector<double> v_;
+    std::vector<int> col4row_;
+    std::vector<int> row4col_;
+    std::vector<double> shortest_;
+    std::vector<int> path_;
+    std::vector<int> reached_cols_;
+    std::vector<int> pending_cols_;
+    std::vector<int> scanned_rows_;
+    std::vector<int> scanned_cols_;
+    std::vector<char> is_col_scanned_;
+
+    int rows_;
+    int cols_;
+    bool gated_;
+    bool transposed_;
+
+    void BuildEdges(const cv::Mat &dissimilarity_matrix);
+    void SplitComponents();
+    int FindRoot(int node);
+    void SolveComponent(size_t begin, size_t end);
+    bool Augment(int cur_row);
+};
@@ -0,0 +1,63 @@
+// Copyright (C) 2021 Intel Corporation
+// SPDX-License-Identifier: Apache-2.0
+//
+
+/**
+ * @brief a header file with a pooling allocator for frame buffers
+ * @file frame_pool.hpp
+ */
+
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <mutex>
+#include <unordered_map>
+#include <vector>
+
+#include <opencv2/core.hpp>
+
+/// cv::MatAllocator which keeps buffers of released Mats and hands them out again to Mats of the same byte size.
+/// Buffers return to the pool when the last Mat referencing them is released, so frames going through capture,
+/// preprocessing and rendering stop hitting the system allocator once the pipeline reaches a steady state.
+/// Buffers smaller than minPooledSize are allocated as usual, so small temporary Mats don't contend on the pool.
+class FramePool : public cv::MatAllocator {
+public:
+    struct Counters {
+        uint64_t allocations;  // buffers requested from the system allocator
+        uint64_t reuses;  // buffers taken from the pool
+        uint64_t releases;  // buffers returned to the system allocator
+        size_t pooledBytes;  // size of buffers kept in the pool
+    };
+
+    FramePool(size_t minPooledSize = 64 * 1024, size_t maxPooledBytes = 512 * 1024 * 1024);
+    ~FramePool() override;
+
+    /// @returns the pool shared by the whole process. It is never destroyed, so Mats may outlive main()
+    static FramePool& getInstance();
+    /// Makes the shared pool the default allocator for all Mats which don't set their allocator explicitly
+    static void enable();
+
+    Counters getCounters() const;
+    void logCounters() const;
+    /// Frees all buffers kept in the pool
+    void trim();
+
+    cv::UMatData* allocate(int dims, const int* sizes, int type, void* data, size_t* step,
+        cv::AccessFlag flags, cv::UMatUsageFlags usageFlags) const override;
+    bool allocate(cv::UMatData* data, cv::AccessFlag accessFlags, cv::UMatUsageFlags usageFlags) const override;
+    void deallocate(cv::UMatData* data) const override;
+
+private:
+    const size_t minPooledSize;
+    const size_t maxPooledBytes;
+
+    mutable std::mutex mtx;
+    mutable std::unordered_map<size_t, std::vector<uchar*>> freeBuffers;
+    mutable size_t pooledBytes;
+
+    mutable std::atomic<uint64_t> allocations;
+    mutable std::atomic<uint64_t> reuses;
+    mutable std::atomic<uint64_t> releases;
+};
@@ -0,0 +1,52 @@
+// Copyright (C) 2021 Intel Corporation
+// SPDX-License-Identifier: Apache-2.0
+//
+
+/**
+ * @brief a header file with conversions of interleaved images to planar network inputs
+ * @file hwc_to_chw.hpp
+ */
+
+#pragma once
+
+#include <cstdint>
+#include <vector>
+
+#include <opencv2/core.hpp>
+
+/**
+ * @brief Splits an interleaved (HWC) 8-bit image into consecutive planes (CHW).
+ * 1- and 3-channel images are split row by row with universal intrinsics straight into the destination buffer.
+ * @param src - image with 8-bit depth
+ * @param dst - buffer for src.total() * src.channels() values
+ */
+void hwcToChw(const cv::Mat& src, uint8_t* dst);
+
+/**
+ * @brief Splits an interleaved (HWC) image into consecutive float planes (CHW).
+ * Each value is transformed as (value - means[c]) / scales[c] during the conversion, so the normalized image
+ * is never materialized. 8-bit 1- and 3-channel images are widened to float and scaled in vectors.
+ * @param src - image of any depth
+ * @param dst - buffer for src.total() * src.channels() values
+ * @param means - values subtracted from every output plane
+ * @param scales - values every output plane is divided by after mean subtraction
+ * @param reverseChannels - if true, channels of 3-channel images are written in reverse order (BGR to RGB),
+ * means and scales are given for the output order
+ */
+void hwcToChw(const cv::Mat& src, float* dst,
+    const cv::Scalar& means = cv::Scalar::all(0), const cv::Scalar& scales = cv::Scalar::all(1),
+    bool reverseChannels = false);
+
+/**
+ * @brief Converts a batch of images of the same size and type, image i is written at dst + i * image.total() *
+ * image.channels(). Images are converted in parallel.
+ */
+void hwcToChw(const std::vector<cv::Mat>& images, uint8_t* dst);
+
+/**
+ * @brief Converts a batch of images of the same size and type to float planes, as hwcToChw does for one image.
+ * Image i is written at dst + i * image.total() * image.channels(). Images are converted in parallel.
+ */
+void hwcToChw(const std::vector<cv::Mat>& images, float* dst,
+    const cv::Scalar& means = cv::Scalar::all(0), const cv::Scalar& scales = cv::Scalar::all(1),
+    bool reverseChannels = false);
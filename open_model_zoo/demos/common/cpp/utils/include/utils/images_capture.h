@@ -2,6 +2,7 @@
 // SPDX-License-Identifier: Apache-2.0
 //
 
+#include <limits>
 #include <memory>
 #include <string>
 
@@ -32,7 +33,13 @@ protected:
 // } catch (const std::out_of_range&) {
 //     return cv::VideoCapture(input);
 // }
+//
+// If prefetchSize is positive, videos, cameras and image directories are read ahead on background threads into
+// a ring of prefetchSize frames, so decoding overlaps with processing of previous frames. Images of a directory are
+// decoded by decodingThreadsNum threads and are still returned in order. Cameras keep only the latest frames:
+// if the ring is full, the oldest frame is dropped. By default read() decodes on the caller's thread.
 std::unique_ptr<ImagesCapture> openImagesCapture(const std::string &input,
     bool loop, size_t initialImageId=0,  // Non camera options
     size_t readLengthLimit=std::numeric_limits<size_t>::max(),  // General option
-    cv::Size cameraResolution={1280, 720});
+    cv::Size cameraResolution={1280, 720},
+    size_t prefetchSize=0, size_t decodingThreadsNum=2);
@@ -0,0 +1,67 @@
+// Copyright (C) 2021 Intel Corporation
+// SPDX-License-Identifier: Apache-2.0
+//
+
+/**
+ * @brief a header file with a fixed-memory latency histogram
+ * @file latency_histogram.hpp
+ */
+
+#pragma once
+
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <vector>
+
+/// Log-linear (HDR-style) histogram of durations. Values are counted in microseconds: every power-of-two range
+/// is split into SUB_BUCKETS_HALF linear buckets, so any recorded value is reported with relative error below 1/64.
+/// Memory is allocated once, recording is a lock-free atomic increment and may run concurrently with snapshots.
+class LatencyHistogram {
+public:
+    /// Plain copy of histogram counters. Snapshots of different histograms or of different time intervals
+    /// of the same histogram can be merged and subtracted.
+    struct Snapshot {
+        std::vector<uint64_t> counts;
+        uint64_t totalCount = 0;
+        uint64_t totalMicroseconds = 0;
+
+        void merge(const Snapshot& other);
+        /// Removes counts of an earlier snapshot of the same histogram, leaving values recorded since then
+        void subtract(const Snapshot& earlier);
+
+        /// @param percentile - value in [0, 100] range
+        /// @returns upper bound of the bucket containing the given percentile, in milliseconds, or NaN if empty
+        double getPercentile(double percentile) const;
+        /// @returns mean value in milliseconds, or NaN if empty
+        double getMean() const;
+        /// @returns upper bound of the highest non-empty bucket in milliseconds, or NaN if empty
+        double getMax() const;
+    };
+
+    LatencyHistogram();
+    LatencyHistogram(const LatencyHistogram& other);
+    LatencyHistogram& operator=(const LatencyHistogram& other);
+
+    void record(std::chrono::steady_clock::duration value);
+    Snapshot getSnapshot() const;
+
+private:
+    // 128 linear buckets for [0, 128) us, then 64 buckets per power of two up to 2^36 us (about 19 hours)
+    static const int SUB_BUCKETS_BITS = 7;
+    static const uint64_t SUB_BUCKETS = uint64_t(1) << SUB_BUCKETS_BITS;
+    static const uint64_t SUB_BUCKETS_HALF = SUB_BUCKETS / 2;
+    static const int MAX_VALUE_BITS = 36;
+    static const size_t BUCKETS_COUNT = SUB_BUCKETS + (MAX_VALUE_BITS - SUB_BUCKETS_BITS) * SUB_BUCKETS_HALF;
+
+    static size_t getBucketIndex(uint64_t microseconds);
+    static uint64_t getBucketUpperBound(size_t index);
+
+    void copyFrom(const LatencyHistogram& other);
+
+    std::unique_ptr<std::atomic<uint64_t>[]> counts;
+    std::atomic<uint64_t> totalCount;
+    std::atomic<uint64_t> totalMicroseconds;
+};
@@ -16,46 +16,67 @@
 
 #pragma once
 
-#include "opencv2/core.hpp"
+#include <cstddef>
 #include <vector>
 
+/// Boxes prepared for suppression. Corner coordinates and areas are stored as separate arrays,
+/// so overlap computations don't touch unrelated fields of detection structures.
+struct NmsBoxes {
+    std::vector<float> left;
+    std::vector<float> top;
+    std::vector<float> right;
+    std::vector<float> bottom;
+    std::vector<float> areas;
+
+    /// Collects boxes from any structure with left, top, right and bottom fields
+    /// @param includeBoundaries - if true, boundary pixels are counted in box areas
+    template <typename Anchor>
+    static NmsBoxes fromAnchors(const std::vector<Anchor>& boxes, bool includeBoundaries = false) {
+        NmsBoxes result;
+        result.reserve(boxes.size());
+        for (const auto& box : boxes) {
+            result.push(box.left, box.top, box.right, box.bottom, includeBoundaries);
+        }
+        return result;
+    }
+
+    /// Collects boxes given as separate arrays of top-left corners and sizes
+    static NmsBoxes fromRects(const float* x, const float* y, const float* width, const float* height, size_t count);
+
+    size_t size() const { return areas.size(); }
+    void reserve(size_t capacity);
+    void push(float left, float top, float right, float bottom, bool includeBoundaries = false);
+
+    /// @returns intersection over union of boxes i and j
+    float iou(size_t i, size_t j) const;
+};
+
+/// Greedy non-maximum suppression. Candidates are visited in descending score order and every kept box
+/// suppresses remaining boxes overlapping it by at least thresh. Boxes with negative scores are ignored.
+/// Large inputs are processed with a uniform grid, so only spatially close boxes are compared.
+/// @param maxKeep - if positive, suppression stops as soon as this number of boxes is kept
+/// @returns indices of kept boxes in descending score order
+std::vector<int> nms(const NmsBoxes& boxes, const std::vector<float>& scores, float thresh, size_t maxKeep = 0);
+
+/// Per-class greedy non-maximum suppression: boxes of different classes never suppress each other
+/// @returns indices of kept boxes in descending score order
+std::vector<int> batchedNms(const NmsBoxes& boxes, const std::vector<float>& scores,
+                            const std::vector<unsigned int>& classIds, float thresh, size_t maxKeep = 0);
+
+/// Soft-NMS with gaussian decay: instead of being removed, overlapping boxes get their scores
+/// multiplied by exp(-iou^2 / sigma). Scores are updated in place.
+/// Large inputs are processed with a uniform grid, so only overlapping boxes are updated.
+/// @param scoreThreshold - boxes which score falls below this value are dropped
+/// @returns indices of kept boxes in the order they were selected, which is descending order of updated scores
+std::vector<int> softNms(const NmsBoxes& boxes, std::vector<float>& scores, float sigma, float scoreThreshold);
+
+/// Per-class soft-NMS: boxes of different classes never decay each other's scores
+/// @returns indices of kept boxes in descending order of updated scores
+std::vector<int> batchedSoftNms(const NmsBoxes& boxes, std::vector<float>& scores,
+                                const std::vector<unsigned int>& classIds, float sigma, float scoreThreshold);
 
 template <typename Anchor>
 std::vector<int> nms(const std::vector<Anchor>& boxes, const std::vector<float>& scores,
                      const float thresh, bool includeBoundaries=false) {
-    std::vector<float> areas(boxes.size());
-    for (size_t i = 0; i < boxes.size(); ++i) {
-        areas[i] = (boxes[i].right - boxes[i].left + includeBoundaries) * (boxes[i].bottom - boxes[i].top + includeBoundaries);
-    }
-    std::vector<int> order(scores.size());
-    std::iota(order.begin(), order.end(), 0);
-    std::sort(order.begin(), order.end(), [&scores](int o1, int o2) { return scores[o1] > scores[o2]; });
-
-    size_t ordersNum = 0;
-    for (; ordersNum < order.size() && scores[order[ordersNum]] >= 0; ordersNum++);
-
-    std::vector<int> keep;
-    bool shouldContinue = true;
-    for (size_t i = 0; shouldContinue && i < ordersNum; ++i) {
-        auto idx1 = order[i];
-        if (idx1 >= 0) {
-            keep.push_back(idx1);
-            shouldContinue = false;
-            for (size_t j = i + 1; j < ordersNum; ++j) {
-                auto idx2 = order[j];
-                if (idx2 >= 0) {
-                    shouldContinue = true;
-                    auto overlappingWidth = std::fminf(boxes[idx1].right, boxes[idx2].right) - std::fmaxf(boxes[idx1].left, boxes[idx2].left);
-                    auto overlappingHeight = std::fminf(boxes[idx1].bottom, boxes[idx2].bottom) - std::fmaxf(boxes[idx1].top, boxes[idx2].top);
-                    auto intersection = overlappingWidth > 0 && overlappingHeight > 0 ? overlappingWidth * overlappingHeight : 0;
-                    auto overlap = intersection / (areas[idx1] + areas[idx2] - intersection);
-
-                    if (overlap >= thresh) {
-                        order[j] = -1;
-                    }
-                }
-            }
-        }
-    }
-    return keep;
+    return nms(NmsBoxes::fromAnchors(boxes, includeBoundaries), scores, thresh);
 }
@@ -12,23 +12,10 @@
 #include <opencv2/opencv.hpp>
 
 #include "utils/common.hpp"
+#include "utils/hwc_to_chw.hpp"
 #include "utils/shared_blob_allocator.h"
 
 
-/**
-* @brief Get cv::Mat value in the correct format.
-*/
-template <typename T>
-static const T getMatValue(const cv::Mat& mat, size_t h, size_t w, size_t c) {
-    switch (mat.type()) {
-        case CV_8UC1:  return (T)mat.at<uchar>(h, w);
-        case CV_8UC3:  return (T)mat.at<cv::Vec3b>(h, w)[c];
-        case CV_32FC1: return (T)mat.at<float>(h, w);
-        case CV_32FC3: return (T)mat.at<cv::Vec3f>(h, w)[c];
-    }
-    throw std::runtime_error("cv::Mat type is not recognized");
-};
-
 /**
 * @brief Sets image data stored in cv::Mat object to a given Blob object.
 * @param mat - given cv::Mat object with an image data.
@@ -46,7 +33,7 @@ static UNUSED void matToBlob(const cv::Mat& mat, const InferenceEngine::Blob::Pt
     if (channels != 1 && channels != 3) {
         throw std::runtime_error("Unsupported number of channels");
     }
-    int batchOffset = batchIndex * width * height * channels;
+    size_t batchOffset = batchIndex * width * height * channels;
 
     cv::Mat resizedMat(mat);
     if (static_cast<int>(width) != mat.size().width || static_cast<int>(height) != mat.size().height) {
@@ -55,23 +42,48 @@ static UNUSED void matToBlob(const cv::Mat& mat, const InferenceEngine::Blob::Pt
 
     InferenceEngine::LockedMemory<void> blobMapped = InferenceEngine::as<InferenceEngine::MemoryBlob>(blob)->wmap();
     if (blob->getTensorDesc().getPrecision() == InferenceEngine::Precision::FP32) {
-        float_t* blobData = blobMapped.as<float_t*>();
-        for (size_t c = 0; c < channels; c++)
-            for (size_t h = 0; h < height; h++)
-                for (size_t w = 0; w < width; w++)
-                    blobData[batchOffset + c * width * height + h * width + w] =
-                        getMatValue<float_t>(resizedMat, h, w, c);
+        hwcToChw(resizedMat, blobMapped.as<float_t*>() + batchOffset);
     }
     else {
-        uint8_t* blobData = blobMapped.as<uint8_t*>();
-        if ((resizedMat.type() & CV_MAT_DEPTH_MASK) == CV_32F) {
-            throw std::runtime_error("Conversion of cv::Mat from float_t to uint8_t is forbidden");
+        hwcToChw(resizedMat, blobMapped.as<uint8_t*>() + batchOffset);
+    }
+}
+
+/**
+* @brief Sets images stored in cv::Mat objects to a given Blob object, image i goes to batch index i.
+* Images are resized to the blob size and converted in parallel.
+* @param mats - given cv::Mat objects with image data, not more than the blob batch size.
+* @param blob - Blob object which to be filled by image data.
+*/
+static UNUSED void matToBlob(const std::vector<cv::Mat>& mats, const InferenceEngine::Blob::Ptr& blob) {
+    InferenceEngine::SizeVector blobSize = blob->getTensorDesc().getDims();
+    const size_t width = blobSize[3];
+    const size_t height = blobSize[2];
+    const size_t channels = blobSize[1];
+    if (mats.size() > blobSize[0]) {
+        throw std::runtime_error("The number of images exceeds the batch size");
+    }
+    if (channels != 1 && channels != 3) {
+        throw std::runtime_error("Unsupported number of channels");
+    }
+
+    std::vector<cv::Mat> resizedMats(mats.size());
+    for (size_t i = 0; i < mats.size(); i++) {
+        if (static_cast<size_t>(mats[i].channels()) != channels) {
+            throw std::runtime_error("The number of channels for net input and image must match");
+        }
+        resizedMats[i] = mats[i];
+        if (static_cast<int>(width) != mats[i].cols || static_cast<int>(height) != mats[i].rows) {
+            cv::resize(mats[i], resizedMats[i], cv::Size(width, height));
         }
-        for (size_t c = 0; c < channels; c++)
-            for (size_t h = 0; h < height; h++)
-                for (size_t w = 0; w < width; w++)
-                    blobData[batchOffset + c * width * height + h * width + w] =
-                        getMatValue<uint8_t>(resizedMat, h, w, c);
+    }
+
+    InferenceEngine::LockedMemory<void> blobMapped = InferenceEngine::as<InferenceEngine::MemoryBlob>(blob)->wmap();
+    if (blob->getTensorDesc().getPrecision() == InferenceEngine::Precision::FP32) {
+        hwcToChw(resizedMats, blobMapped.as<float_t*>());
+    }
+    else {
+        hwcToChw(resizedMats, blobMapped.as<uint8_t*>());
     }
 }
 
@@ -234,6 +246,33 @@ public:
         return (result - means) / stdScales;
     }
 
+    /// Resizes the image to the blob size and writes it into the blob. Mean and scale values are applied
+    /// while the image is converted to the planar layout, so no intermediate float image is created.
+    void fillBlob(const cv::Mat& image, const InferenceEngine::Blob::Ptr& blob, int batchIndex = 0) const {
+        if (isTrivial) {
+            matToBlob(image, blob, batchIndex);
+            return;
+        }
+        if (blob->getTensorDesc().getPrecision() != InferenceEngine::Precision::FP32) {
+            throw std::runtime_error("Conversion of cv::Mat from float_t to uint8_t is forbidden");
+        }
+        InferenceEngine::SizeVector blobSize = blob->getTensorDesc().getDims();
+        const size_t width = blobSize[3];
+        const size_t height = blobSize[2];
+        const size_t channels = blobSize[1];
+        if (static_cast<size_t>(image.channels()) != channels) {
+            throw std::runtime_error("The number of channels for net input and image must match");
+        }
+
+        cv::Mat resizedImage(image);
+        if (static_cast<int>(width) != image.cols || static_cast<int>(height) != image.rows) {
+            cv::resize(image, resizedImage, cv::Size(width, height));
+        }
+        InferenceEngine::LockedMemory<void> blobMapped = InferenceEngine::as<InferenceEngine::MemoryBlob>(blob)->wmap();
+        hwcToChw(resizedImage, blobMapped.as<float_t*>() + batchIndex * width * height * channels,
+            means, stdScales, reverseInputChannels);
+    }
+
 private:
     bool reverseInputChannels;
     bool isTrivial;
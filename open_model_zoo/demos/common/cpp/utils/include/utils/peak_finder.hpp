@@ -0,0 +1,144 @@
+// Copyright (C) 2021 Intel Corporation
+// SPDX-License-Identifier: Apache-2.0
+//
+
+#pragma once
+
+#include <algorithm>
+#include <cmath>
+#include <vector>
+
+#include <opencv2/core.hpp>
+#include <opencv2/core/hal/intrin.hpp>
+
+// The header is self-contained, so modules which don't link the utils library (e.g. Python extensions)
+// can use it too
+
+namespace peak_finder_detail {
+inline void thresholdRow(const float* src, float* dst, int cols, float threshold) {
+    int x = 0;
+#if CV_SIMD
+    const cv::v_float32 vThreshold = cv::vx_setall_f32(threshold);
+    const cv::v_float32 vZero = cv::vx_setzero_f32();
+    for (; x <= cols - cv::v_float32::nlanes; x += cv::v_float32::nlanes) {
+        const cv::v_float32 value = cv::vx_load(src + x);
+        cv::v_store(dst + x, cv::v_select(value >= vThreshold, value, vZero));
+    }
+#endif
+    for (; x < cols; x++) {
+        dst[x] = src[x] >= threshold ? src[x] : 0.0f;
+    }
+}
+
+// Rows have one zero element on each side, so every pixel has four neighbours
+inline void findRowMaxima(const float* above, const float* row, const float* below, int cols, int y,
+                          std::vector<cv::Point>& peaks) {
+    int x = 0;
+#if CV_SIMD
+    for (; x <= cols - cv::v_float32::nlanes; x += cv::v_float32::nlanes) {
+        const cv::v_float32 value = cv::vx_load(row + x + 1);
+        const cv::v_float32 isPeak = (value > cv::vx_load(row + x)) & (value > cv::vx_load(row + x + 2))
+            & (value > cv::vx_load(above + x + 1)) & (value > cv::vx_load(below + x + 1));
+        int mask = cv::v_signmask(isPeak);
+        while (mask) {
+            int lane = 0;
+            while (!(mask & (1 << lane))) {
+                lane++;
+            }
+            peaks.emplace_back(x + lane, y);
+            mask &= mask - 1;
+        }
+    }
+#endif
+    for (; x < cols; x++) {
+        const float value = row[x + 1];
+        if (value > row[x] && value > row[x + 2] && value > above[x + 1] && value > below[x + 1]) {
+            peaks.emplace_back(x, y);
+        }
+    }
+}
+}  // namespace peak_finder_detail
+
+/// Greedy min-distance suppression. Candidates are visited ordered by x, then by y, and every kept peak
+/// suppresses the following ones closer than minDistance. Kept peaks are bucketed in a uniform grid,
+/// so only peaks from adjacent cells are compared.
+/// @param candidates - positions inside a map of mapSize, reordered in place
+/// @param peaks - receives positions of kept peaks in the visiting order
+inline void suppressClosePeaks(std::vector<cv::Point>& candidates, cv::Size mapSize, float minDistance,
+                               std::vector<cv::Point>& peaks) {
+    peaks.clear();
+    std::sort(candidates.begin(), candidates.end(), [](const cv::Point& a, const cv::Point& b) {
+        return a.x < b.x || (a.x == b.x && a.y < b.y);
+    });
+    if (!(minDistance > 0)) {
+        peaks = candidates;
+        return;
+    }
+
+    // Peaks closer than minDistance lie in the same or in adjacent cells
+    const int cellSize = std::max(1, static_cast<int>(std::ceil(minDistance)));
+    const int gridCols = (mapSize.width + cellSize - 1) / cellSize;
+    const int gridRows = (mapSize.height + cellSize - 1) / cellSize;
+    std::vector<int> cellHeads(gridCols * gridRows, -1);
+    std::vector<int> nextInCell;
+    nextInCell.reserve(candidates.size());
+    const double minDistanceSquared = static_cast<double>(minDistance) * minDistance;
+    for (const cv::Point& candidate : candidates) {
+        const int cellX = candidate.x / cellSize;
+        const int cellY = candidate.y / cellSize;
+        bool isSuppressed = false;
+        for (int gy = std::max(cellY - 1, 0); gy <= std::min(cellY + 1, gridRows - 1) && !isSuppressed; gy++) {
+            for (int gx = std::max(cellX - 1, 0); gx <= std::min(cellX + 1, gridCols - 1) && !isSuppressed; gx++) {
+                for (int i = cellHeads[gy * gridCols + gx]; i >= 0; i = nextInCell[i]) {
+                    const int dx = peaks[i].x - candidate.x;
+                    const int dy = peaks[i].y - candidate.y;
+                    if (dx * dx + dy * dy < minDistanceSquared) {
+                        isSuppressed = true;
+                        break;
+                    }
+                }
+            }
+        }
+        if (!isSuppressed) {
+            int& head = cellHeads[cellY * gridCols + cellX];
+            nextInCell.push_back(head);
+            head = static_cast<int>(peaks.size());
+            peaks.push_back(candidate);
+        }
+    }
+}
+
+/// Finds local maxima of a CV_32F heat map and suppresses them with suppressClosePeaks. Values below
+/// threshold are treated as zeros, and so are pixels outside the map; a peak is strictly greater than
+/// its four neighbours.
+/// @param peaks - receives positions of kept peaks ordered by x, then by y
+inline void findHeatMapPeaks(const cv::Mat& heatMap, float threshold, float minDistance,
+                             std::vector<cv::Point>& peaks) {
+    CV_Assert(heatMap.type() == CV_32F);
+    peaks.clear();
+    const int rows = heatMap.rows;
+    const int cols = heatMap.cols;
+    if (rows == 0 || cols == 0) {
+        return;
+    }
+
+    // Three rolling padded rows: above, current and below
+    const int paddedCols = cols + 2;
+    std::vector<float> buffer(3 * paddedCols, 0.0f);
+    float* above = buffer.data();
+    float* row = above + paddedCols;
+    float* below = row + paddedCols;
+    peak_finder_detail::thresholdRow(heatMap.ptr<float>(0), row + 1, cols, threshold);
+    std::vector<cv::Point> candidates;
+    for (int y = 0; y < rows; y++) {
+        if (y + 1 < rows) {
+            peak_finder_detail::thresholdRow(heatMap.ptr<float>(y + 1), below + 1, cols, threshold);
+        } else {
+            std::fill(below + 1, below + 1 + cols, 0.0f);
+        }
+        peak_finder_detail::findRowMaxima(above, row, below, cols, y, candidates);
+        std::swap(above, row);
+        std::swap(row, below);
+    }
+    suppressClosePeaks(candidates, heatMap.size(), minDistance, peaks);
+}
@@ -10,10 +10,14 @@
 #pragma once
 
 #include <chrono>
+#include <fstream>
 #include <iostream>
 #include <sstream>
 #include <iomanip>
+#include <string>
+#include <vector>
 
+#include "utils/latency_histogram.hpp"
 #include "utils/ocv_common.hpp"
 
 class PerformanceMetrics {
@@ -60,6 +64,8 @@ public:
 
     Metrics getLast() const;
     Metrics getTotal() const;
+    /// @returns distribution of all latencies recorded so far. Safe to call while another thread calls update()
+    LatencyHistogram::Snapshot getLatencyHistogram() const { return latencyHistogram.getSnapshot(); }
     void logTotal() const;
 
 private:
@@ -85,8 +91,41 @@ private:
     Statistic lastMovingStatistic;
     Statistic currentMovingStatistic;
     Statistic totalStatistic;
+    LatencyHistogram latencyHistogram;
     TimePoint lastUpdateTime;
     bool firstFrameProcessed;
 };
 
+/// Periodically appends latency distributions of named stages to a file, one JSON object per line.
+/// Every line describes latencies recorded since the previous line.
+class LatencyHistogramWriter {
+public:
+    LatencyHistogramWriter(const std::string& fileName,
+        PerformanceMetrics::Duration interval = std::chrono::seconds(1));
+
+    /// @param metrics - stage metrics, must outlive the writer
+    void addStage(const std::string& name, const PerformanceMetrics& metrics);
+    /// Writes a line if the interval has passed since the previous one
+    void update();
+    /// Writes a line regardless of the interval
+    void flush();
+
+private:
+    struct Stage {
+        std::string name;
+        const PerformanceMetrics* metrics;
+        LatencyHistogram::Snapshot lastSnapshot;
+    };
+
+    std::ofstream outputFile;
+    PerformanceMetrics::Duration interval;
+    PerformanceMetrics::TimePoint startTime;
+    PerformanceMetrics::TimePoint lastWriteTime;
+    std::vector<Stage> stages;
+};
+
 void logLatencyPerStage(double readLat, double preprocLat, double inferLat, double postprocLat, double renderLat);
+/// Logs mean latencies of every stage together with their 50th, 90th, 99th and 99.9th percentiles
+void logLatencyPerStage(const PerformanceMetrics& readMetrics, const PerformanceMetrics& preprocMetrics,
+    const PerformanceMetrics& inferMetrics, const PerformanceMetrics& postprocMetrics,
+    const PerformanceMetrics& renderMetrics);
@@ -0,0 +1,84 @@
+// Copyright (C) 2021 Intel Corporation
+// SPDX-License-Identifier: Apache-2.0
+//
+
+/**
+ * @brief a header file with asynchronous batched inference of image crops for second-stage networks
+ * @file roi_infer_queue.hpp
+ */
+
+#pragma once
+
+#include <chrono>
+#include <condition_variable>
+#include <cstddef>
+#include <deque>
+#include <exception>
+#include <functional>
+#include <mutex>
+#include <string>
+#include <vector>
+
+#include <inference_engine.hpp>
+#include <opencv2/core.hpp>
+
+/// Runs a second-stage network (classifier, reidentification, etc.) on crops produced by a first-stage detector.
+/// Crops are packed into the batch of an idle infer request, and the request is started once the batch is full
+/// or flush() is called, so a batch may collect crops of several frames. Several requests are in flight at once,
+/// and results of every crop are handed to its own reader from the inference callback.
+/// push() and flush() must be called from one thread; readers are called from inference callback threads.
+class RoiInferQueue {
+public:
+    /// Reads outputs of one crop from the request, batchIndex is the position of the crop in the batch
+    using ResultReader = std::function<void(InferenceEngine::InferRequest& request, size_t batchIndex)>;
+
+    /// @param network - network with a single input, its batch size is the number of crops inferred at once
+    /// @param requestsNum - number of infer requests running in parallel
+    /// @param dynamicBatch - if true, a partially filled batch is inferred with InferRequest::SetBatch,
+    /// otherwise unused slots keep data of previous crops and their outputs are ignored
+    RoiInferQueue(InferenceEngine::ExecutableNetwork& network, size_t requestsNum, bool dynamicBatch = false);
+    ~RoiInferQueue();
+
+    /// Copies the resized crop into the batch being filled. Blocks while all requests are busy
+    void push(const cv::Mat& roi, ResultReader reader);
+    /// Infers the blob as the network input, e.g. an ROI blob which is resized by the plugin.
+    /// The blob occupies a whole request, so the network batch size must be 1. The request gets its own input blob
+    /// back when a crop is pushed to it next time, so both kinds of push may be used with one queue
+    void push(const InferenceEngine::Blob::Ptr& roiBlob, ResultReader reader);
+    /// Starts the partially filled batch, if any
+    void flush();
+    /// Starts the partially filled batch and waits until readers of all pushed crops are called.
+    /// Rethrows an exception thrown by a reader. Each exception is rethrown once, either here or from push()
+    void waitAll();
+
+    size_t getBatchSize() const { return batchSize; }
+    /// @returns inference time of the last completed request divided by the number of crops in it, in ms
+    double getLastTimePerRoi() const;
+
+private:
+    struct Slot {
+        InferenceEngine::InferRequest request;
+        InferenceEngine::Blob::Ptr inputBlob;
+        bool roiBlobSet = false;  // inputBlob is replaced by a blob given to push()
+        std::vector<ResultReader> readers;
+        std::chrono::steady_clock::time_point startTime;
+    };
+
+    Slot& getFillingSlot();
+    void start();
+    void onCompleted(size_t slotIndex);
+    void rethrowIfFailed();
+
+    std::string inputName;
+    size_t batchSize;
+    bool dynamicBatch;
+
+    std::vector<Slot> slots;
+    size_t fillingSlot;  // slot whose batch is being filled, slots.size() if there is none
+    std::deque<size_t> idleSlots;
+
+    mutable std::mutex mtx;
+    std::condition_variable condVar;
+    std::exception_ptr readerException;
+    double lastTimePerRoi;
+};
@@ -6,7 +6,10 @@
 
 #include <algorithm>
 #include <atomic>
+#include <chrono>
 #include <condition_variable>
+#include <deque>
+#include <exception>
 #include <list>
 #include <memory>
 #include <mutex>
@@ -56,38 +59,134 @@ struct HigherPriority {
     }
 };
 
+/// Tasks of the same priority kept in FIFO lanes. Lanes are visited from the highest priority
+class PriorityLanes {
+public:
+    void push(std::shared_ptr<Task>&& task, bool toFront = false) {
+        const float priority = task->priority;
+        auto it = std::find_if(lanes.begin(), lanes.end(), [priority](const Lane& lane){return lane.first <= priority;});
+        if (lanes.end() == it || it->first != priority) {
+            it = lanes.emplace(it, priority, std::deque<std::shared_ptr<Task>>{});
+        }
+        if (toFront) {
+            it->second.push_front(std::move(task));
+        } else {
+            it->second.push_back(std::move(task));
+        }
+    }
+    bool tryPop(std::shared_ptr<Task>& task) {
+        for (Lane& lane : lanes) {
+            if (!lane.second.empty()) {
+                task = std::move(lane.second.front());
+                lane.second.pop_front();
+                return true;
+            }
+        }
+        return false;
+    }
+
+private:
+    using Lane = std::pair<float, std::deque<std::shared_ptr<Task>>>;
+    std::vector<Lane> lanes;  // sorted by descending priority, there are only a few distinct priorities
+};
+
+/// Work-stealing executor. Every thread owns a queue of priority lanes: tasks pushed from a worker thread go to its
+/// own queue and idle threads steal from the others, so threads don't contend on a single lock.
+/// Priorities order tasks within a queue only: a thread runs tasks of its own queue before it steals, so it may run
+/// a lower priority task while another queue holds a higher priority one.
+/// A task which is not ready is parked instead of being rescanned in a loop. Parked tasks are returned to the queues
+/// when another task completes (or a new one arrives), because that is what changes the state isReady() depends on.
+/// State changed outside of the worker's tasks (inference callbacks, time) is reported with notify() and notifyAt(),
+/// idle threads sleep until something is pushed or notified.
 class Worker {
 public:
     explicit Worker(unsigned threadNum):
-        threadPool(threadNum), running{false} {}
+        threadPool(threadNum), queues(threadNum + 1), running{false}, nextQueue{0}, stateEpoch{0}, wakeEpoch{0},
+        notifyTime{std::chrono::steady_clock::time_point::max()} {}
     ~Worker() {
         stop();
     }
     void runThreads() {
         running = true;
-        for (std::thread& t : threadPool) {
-            t = std::thread(&Worker::threadFunc, this);
+        for (size_t i = 0; i < threadPool.size(); ++i) {
+            threadPool[i] = std::thread(&Worker::threadLoop, this, i);
         }
     }
+    /// Returns parked tasks to the queues. Call it after changing state isReady() of parked tasks may depend on
+    /// outside of the worker's tasks, for example after an inference callback released an infer request
+    void notify() {
+        ++stateEpoch;
+        requeueParked(nextQueue++ % queues.size());
+    }
+    /// Calls notify() at the given time, for tasks which become ready after a timeout. Only the earliest pending
+    /// time is kept
+    void notifyAt(std::chrono::steady_clock::time_point time) {
+        {
+            std::lock_guard<std::mutex> lock{sleepMutex};
+            if (time >= notifyTime) {
+                return;
+            }
+            notifyTime = time;
+            ++wakeEpoch;
+        }
+        // A sleeping thread has to wait for the new time
+        sleepCondVar.notify_one();
+    }
     void push(std::shared_ptr<Task> task) {
-        tasksMutex.lock();
-        tasks.insert(task);
-        tasksMutex.unlock();
-        tasksCondVar.notify_one();
+        const std::pair<const Worker*, size_t>& current = currentQueue();
+        const size_t index = this == current.first ? current.second : nextQueue++ % queues.size();
+        {
+            std::lock_guard<std::mutex> lock{queues[index].mutex};
+            queues[index].tasks.push(std::move(task));
+        }
+        wake(false);
     }
+    /// Runs tasks in the calling thread until stop()
     void threadFunc() {
+        threadLoop(threadPool.size());
+    }
+    void stop() {
+        running = false;
+        wake(true);
+    }
+    void join() {
+        for (auto& t : threadPool) {
+            t.join();
+        }
+        if (nullptr != currentException) {
+            std::rethrow_exception(currentException);
+        }
+    }
+
+private:
+    struct TaskQueue {
+        std::mutex mutex;
+        PriorityLanes tasks;
+    };
+
+    static std::pair<const Worker*, size_t>& currentQueue() {
+        static thread_local std::pair<const Worker*, size_t> current{nullptr, 0};
+        return current;
+    }
+
+    void threadLoop(size_t index) {
+        currentQueue() = {this, index};
         while (running) {
-            std::unique_lock<std::mutex> lk(tasksMutex);
-            while (running && tasks.empty()) {
-                tasksCondVar.wait(lk);
+            const uint64_t epoch = getWakeEpoch();
+            std::shared_ptr<Task> task;
+            if (!tryPop(index, task)) {
+                waitForWork(index, epoch);
+                continue;
             }
             try {
-                auto it = std::find_if(tasks.begin(), tasks.end(), [](const std::shared_ptr<Task>& task){return task->isReady();});
-                if (tasks.end() != it) {
-                    const std::shared_ptr<Task> task = std::move(*it);
-                    tasks.erase(it);
-                    lk.unlock();
+                const uint64_t checkedEpoch = stateEpoch;
+                if (task->isReady()) {
                     task->process();
+                    task.reset();  // released resources may be what parked tasks wait for
+                    ++stateEpoch;
+                    requeueParked(index);
+                } else {
+                    park(index, std::move(task), checkedEpoch);
                 }
             } catch (...) {
                 std::lock_guard<std::mutex> lock{exceptionMutex};
@@ -97,26 +196,99 @@ public:
                 }
             }
         }
+        currentQueue() = {nullptr, 0};
     }
-    void stop() {
-        running = false;
-        tasksCondVar.notify_all();
+
+    bool tryPop(size_t index, std::shared_ptr<Task>& task) {
+        // Own queue first, then steal
+        for (size_t i = 0; i < queues.size(); ++i) {
+            TaskQueue& queue = queues[(index + i) % queues.size()];
+            std::lock_guard<std::mutex> lock{queue.mutex};
+            if (queue.tasks.tryPop(task)) {
+                return true;
+            }
+        }
+        return false;
     }
-    void join() {
-        for (auto& t : threadPool) {
-            t.join();
+
+    void park(size_t index, std::shared_ptr<Task>&& task, uint64_t checkedEpoch) {
+        {
+            std::lock_guard<std::mutex> lock{parkedMutex};
+            // A task completed after isReady() was checked, its requeue may have already passed, so check again
+            if (stateEpoch == checkedEpoch) {
+                parked.push_back(std::move(task));
+                return;
+            }
         }
-        if (nullptr != currentException) {
-            std::rethrow_exception(currentException);
+        std::lock_guard<std::mutex> lock{queues[index].mutex};
+        queues[index].tasks.push(std::move(task));
+    }
+
+    void requeueParked(size_t index) {
+        std::vector<std::shared_ptr<Task>> woken;
+        {
+            std::lock_guard<std::mutex> lock{parkedMutex};
+            woken.swap(parked);
+        }
+        if (woken.empty()) {
+            return;
+        }
+        // Parked tasks waited longer than the queued ones, so they go first in the order of their frames
+        std::sort(woken.begin(), woken.end(), HigherPriority{});
+        {
+            std::lock_guard<std::mutex> lock{queues[index].mutex};
+            for (auto it = woken.rbegin(); it != woken.rend(); ++it) {
+                queues[index].tasks.push(std::move(*it), true);
+            }
+        }
+        wake(woken.size() > 1);
+    }
+
+    uint64_t getWakeEpoch() {
+        std::lock_guard<std::mutex> lock{sleepMutex};
+        return wakeEpoch;
+    }
+
+    void wake(bool all) {
+        {
+            std::lock_guard<std::mutex> lock{sleepMutex};
+            ++wakeEpoch;
+        }
+        if (all) {
+            sleepCondVar.notify_all();
+        } else {
+            sleepCondVar.notify_one();
+        }
+    }
+
+    void waitForWork(size_t index, uint64_t epoch) {
+        std::unique_lock<std::mutex> lock{sleepMutex};
+        // Anything pushed or notified after the epoch was read changes it, so the wakeup can't be lost
+        auto woken = [this, epoch]{return !running || wakeEpoch != epoch;};
+        if (std::chrono::steady_clock::time_point::max() == notifyTime) {
+            sleepCondVar.wait(lock, woken);
+        } else if (!sleepCondVar.wait_until(lock, notifyTime, woken)) {
+            notifyTime = std::chrono::steady_clock::time_point::max();
+            lock.unlock();
+            ++stateEpoch;
+            requeueParked(index);
         }
     }
 
-private:
-    std::condition_variable tasksCondVar;
-    std::set<std::shared_ptr<Task>, HigherPriority> tasks;
-    std::mutex tasksMutex;
     std::vector<std::thread> threadPool;
+    std::vector<TaskQueue> queues;  // one per thread from threadPool and one for threadFunc() caller
     std::atomic<bool> running;
+    std::atomic<size_t> nextQueue;  // round robin for tasks pushed from outside of the worker
+
+    std::vector<std::shared_ptr<Task>> parked;
+    std::mutex parkedMutex;
+    std::atomic<uint64_t> stateEpoch;  // incremented when a task is processed or parked tasks are notified
+
+    std::condition_variable sleepCondVar;
+    std::mutex sleepMutex;
+    uint64_t wakeEpoch;
+    std::chrono::steady_clock::time_point notifyTime;  // time requested with notifyAt(), max() if there is none
+
     std::exception_ptr currentException;
     std::mutex exceptionMutex;
 };
@@ -127,6 +299,18 @@ void tryPush(const std::weak_ptr<Worker>& worker, std::shared_ptr<Task>&& task)
     } catch (const std::bad_weak_ptr&) {}
 }
 
+void tryNotify(const std::weak_ptr<Worker>& worker) {
+    try {
+        std::shared_ptr<Worker>(worker)->notify();
+    } catch (const std::bad_weak_ptr&) {}
+}
+
+void tryNotifyAt(const std::weak_ptr<Worker>& worker, std::chrono::steady_clock::time_point time) {
+    try {
+        std::shared_ptr<Worker>(worker)->notifyAt(time);
+    } catch (const std::bad_weak_ptr&) {}
+}
+
 template <class C> class ConcurrentContainer {
 public:
     C container;
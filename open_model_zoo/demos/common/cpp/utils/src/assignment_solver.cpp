@@ -0,0 +1,234 @@
+// Copyright (C) 2021 Intel Corporation
+// SPDX-License-Identifier: Apache-2.0
+//
+
+#include <algorithm>
+#include <cmath>
+#include <limits>
+#include <utility>
+#include <vector>
+
+#include <utils/assignment_solver.hpp>
+
+namespace {
+constexpr double kInf = std::numeric_limits<double>::infinity();
+}  // namespace
+
+AssignmentSolver::AssignmentSolver(float max_cost)
+    : max_cost_(max_cost), rows_(), cols_(), gated_(), transposed_() {}
+
+std::vector<size_t> AssignmentSolver::Solve(const cv::Mat& dissimilarity_matrix) {
+    CV_Assert(dissimilarity_matrix.type() == CV_32F);
+
+    BuildEdges(dissimilarity_matrix);
+    SplitComponents();
+
+    const int total_cols = cols_ + (gated_ ? rows_ : 0);
+    u_.assign(rows_, 0.0);
+    v_.assign(total_cols, 0.0);
+    col4row_.assign(rows_, -1);
+    row4col_.assign(total_cols, -1);
+    shortest_.assign(total_cols, kInf);
+    path_.assign(total_cols, -1);
+    is_col_scanned_.assign(total_cols, 0);
+
+    for (size_t begin = 0; begin < component_rows_.size();) {
+        const int root = row_roots_[component_rows_[begin]];
+        size_t end = begin + 1;
+        while (end < component_rows_.size() && row_roots_[component_rows_[end]] == root) {
+            end++;
+        }
+        SolveComponent(begin, end);
+        begin = end;
+    }
+
+    std::vector<size_t> results(dissimilarity_matrix.rows, -1);
+    for (int row = 0; row < rows_; row++) {
+        const int col = col4row_[row];
+        if (col < 0 || col >= cols_) {
+            continue;
+        }
+        if (transposed_) {
+            results[col] = row;
+        } else {
+            results[row] = col;
+        }
+    }
+    return results;
+}
+
+void AssignmentSolver::BuildEdges(const cv::Mat& dissimilarity_matrix) {
+    gated_ = std::isfinite(max_cost_);
+    // Without gating every row must get a column, so the smaller side is matched to the larger one
+    transposed_ = !gated_ && dissimilarity_matrix.rows > dissimilarity_matrix.cols;
+    rows_ = transposed_ ? dissimilarity_matrix.cols : dissimilarity_matrix.rows;
+    cols_ = transposed_ ? dissimilarity_matrix.rows : dissimilarity_matrix.cols;
+
+    row_begins_.assign(rows_ + 1, 0);
+    edges_.clear();
+    float min_cost = gated_ ? max_cost_ : 0.f;
+    for (int row = 0; row < rows_; row++) {
+        row_begins_[row] = static_cast<int>(edges_.size());
+        for (int col = 0; col < cols_; col++) {
+            const float cost = transposed_ ? dissimilarity_matrix.at<float>(col, row)
+                                           : dissimilarity_matrix.at<float>(row, col);
+            if (std::isfinite(cost) && cost < max_cost_) {
+                edges_.push_back({col, cost});
+                min_cost = std::min(min_cost, cost);
+            }
+        }
+        if (gated_) {
+            edges_.push_back({cols_ + row, max_cost_});
+        }
+    }
+    row_begins_[rows_] = static_cast<int>(edges_.size());
+
+    // Shortest path search needs non-negative reduced costs at zero duals. Every row is matched
+    // to exactly one column, so shifting all costs does not change the optimal assignment
+    if (min_cost < 0) {
+        for (auto& edge : edges_) {
+            edge.cost -= min_cost;
+        }
+    }
+}
+
+int AssignmentSolver::FindRoot(int node) {
+    while (parents_[node] != node) {
+        parents_[node] = parents_[parents_[node]];
+        node = parents_[node];
+    }
+    return node;
+}
+
+void AssignmentSolver::SplitComponents() {
+    // Rows are nodes [0, rows_), columns are nodes [rows_, rows_ + cols_). Private columns
+    // of gated rows never link rows together, so they are left out
+    parents_.resize(rows_ + cols_);
+    for (size_t node = 0; node < parents_.size(); node++) {
+        parents_[node] = static_cast<int>(node);
+    }
+    for (int row = 0; row < rows_; row++) {
+        for (int e = row_begins_[row]; e < row_begins_[row + 1]; e++) {
+            if (edges_[e].col >= cols_) {
+                continue;
+            }
+            const int row_root = FindRoot(row);
+            const int col_root = FindRoot(rows_ + edges_[e].col);
+            if (row_root != col_root) {
+                parents_[col_root] = row_root;
+            }
+        }
+    }
+
+    row_roots_.resize(rows_);
+    component_rows_.resize(rows_);
+    for (int row = 0; row < rows_; row++) {
+        row_roots_[row] = FindRoot(row);
+        component_rows_[row] = row;
+    }
+    std::stable_sort(component_rows_.begin(), component_rows_.end(),
+                     [this](int a, int b) { return row_roots_[a] < row_roots_[b]; });
+}
+
+void AssignmentSolver::SolveComponent(size_t begin, size_t end) {
+    if (end - begin == 1) {
+        // No other row competes for the columns of a single row
+        const int row = component_rows_[begin];
+        int best = -1;
+        for (int e = row_begins_[row]; e < row_begins_[row + 1]; e++) {
+            if (best < 0 || edges_[e].cost < edges_[best].cost) {
+                best = e;
+            }
+        }
+        if (best >= 0) {
+            col4row_[row] = edges_[best].col;
+            row4col_[edges_[best].col] = row;
+        }
+        return;
+    }
+
+    for (size_t i = begin; i < end; i++) {
+        Augment(component_rows_[i]);
+    }
+}
+
+bool AssignmentSolver::Augment(int cur_row) {
+    reached_cols_.clear();
+    pending_cols_.clear();
+    scanned_rows_.clear();
+    scanned_cols_.clear();
+
+    double min_val = 0;
+    int row = cur_row;
+    int sink = -1;
+    while (sink < 0) {
+        scanned_rows_.push_back(row);
+        for (int e = row_begins_[row]; e < row_begins_[row + 1]; e++) {
+            const int col = edges_[e].col;
+            if (is_col_scanned_[col]) {
+                continue;
+            }
+            const double reduced_cost = min_val + edges_[e].cost - u_[row] - v_[col];
+            if (reduced_cost < shortest_[col]) {
+                if (shortest_[col] == kInf) {
+                    reached_cols_.push_back(col);
+                    pending_cols_.push_back(col);
+                }
+                path_[col] = row;
+                shortest_[col] = reduced_cost;
+            }
+        }
+
+        // Ties are resolved in favor of free columns to finish the search earlier
+        size_t best = pending_cols_.size();
+        double lowest = kInf;
+        for (size_t k = 0; k < pending_cols_.size(); k++) {
+            const int col = pending_cols_[k];
+            if (shortest_[col] < lowest || (shortest_[col] == lowest && row4col_[col] < 0)) {
+                lowest = shortest_[col];
+                best = k;
+            }
+        }
+        if (best == pending_cols_.size()) {
+            break;
+        }
+
+        const int col = pending_cols_[best];
+        pending_cols_[best] = pending_cols_.back();
+        pending_cols_.pop_back();
+        min_val = lowest;
+        is_col_scanned_[col] = 1;
+        scanned_cols_.push_back(col);
+        if (row4col_[col] < 0) {
+            sink = col;
+        } else {
+            row = row4col_[col];
+        }
+    }
+
+    if (sink >= 0) {
+        u_[cur_row] += min_val;
+        for (size_t k = 1; k < scanned_rows_.size(); k++) {
+            const int scanned_row = scanned_rows_[k];
+            u_[scanned_row] += min_val - shortest_[col4row_[scanned_row]];
+        }
+        for (int col : scanned_cols_) {
+            v_[col] -= min_val - shortest_[col];
+        }
+
+        for (int col = sink;;) {
+            const int prev_row = path_[col];
+            row4col_[col] = prev_row;
+            std::swap(col4row_[prev_row], col);
+            if (prev_row == cur_row) {
+                break;
+            }
+        }
+    }
+
+    for (int col : reached_cols_) {
+        shortest_[col] = kInf;
+        is_col_scanned_[col] = 0;
+    }
+    return sink >= 0;
+}
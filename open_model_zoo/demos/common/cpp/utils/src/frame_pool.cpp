@@ -0,0 +1,127 @@
+// Copyright (C) 2021 Intel Corporation
+// SPDX-License-Identifier: Apache-2.0
+//
+
+#include "utils/frame_pool.hpp"
+
+#include "utils/slog.hpp"
+
+FramePool::FramePool(size_t minPooledSize, size_t maxPooledBytes)
+    : minPooledSize(minPooledSize)
+    , maxPooledBytes(maxPooledBytes)
+    , pooledBytes(0)
+    , allocations(0)
+    , reuses(0)
+    , releases(0) {}
+
+FramePool::~FramePool() {
+    trim();
+}
+
+FramePool& FramePool::getInstance() {
+    static FramePool* instance = new FramePool();
+    return *instance;
+}
+
+void FramePool::enable() {
+    cv::Mat::setDefaultAllocator(&getInstance());
+}
+
+FramePool::Counters FramePool::getCounters() const {
+    Counters counters;
+    counters.allocations = allocations.load();
+    counters.reuses = reuses.load();
+    counters.releases = releases.load();
+    std::lock_guard<std::mutex> lock(mtx);
+    counters.pooledBytes = pooledBytes;
+    return counters;
+}
+
+void FramePool::logCounters() const {
+    Counters counters = getCounters();
+    slog::info << "\tFrame pool: " << counters.allocations << " allocations, " << counters.reuses << " reuses, "
+        << counters.releases << " releases, " << counters.pooledBytes / (1024 * 1024) << " MB pooled" << slog::endl;
+}
+
+void FramePool::trim() {
+    std::lock_guard<std::mutex> lock(mtx);
+    for (auto& sizeBuffers : freeBuffers) {
+        for (uchar* buffer : sizeBuffers.second) {
+            cv::fastFree(buffer);
+            ++releases;
+        }
+    }
+    freeBuffers.clear();
+    pooledBytes = 0;
+}
+
+cv::UMatData* FramePool::allocate(int dims, const int* sizes, int type, void* data0, size_t* step,
+        cv::AccessFlag /*flags*/, cv::UMatUsageFlags /*usageFlags*/) const {
+    // Same layout as in OpenCV's default allocator
+    size_t total = CV_ELEM_SIZE(type);
+    for (int i = dims - 1; i >= 0; i--) {
+        if (step) {
+            if (data0 && step[i] != CV_AUTOSTEP) {
+                total = step[i];
+            } else {
+                step[i] = total;
+            }
+        }
+        total *= sizes[i];
+    }
+
+    uchar* data = static_cast<uchar*>(data0);
+    if (!data) {
+        if (total >= minPooledSize) {
+            std::lock_guard<std::mutex> lock(mtx);
+            auto it = freeBuffers.find(total);
+            if (it != freeBuffers.end() && !it->second.empty()) {
+                data = it->second.back();
+                it->second.pop_back();
+                pooledBytes -= total;
+                ++reuses;
+            }
+        }
+        if (!data) {
+            data = static_cast<uchar*>(cv::fastMalloc(total));
+            ++allocations;
+        }
+    }
+
+    cv::UMatData* u = new cv::UMatData(this);
+    u->data = u->origdata = data;
+    u->size = total;
+    if (data0) {
+        u->flags |= cv::UMatData::USER_ALLOCATED;
+    }
+    return u;
+}
+
+bool FramePool::allocate(cv::UMatData* u, cv::AccessFlag /*accessFlags*/, cv::UMatUsageFlags /*usageFlags*/) const {
+    return u != nullptr;
+}
+
+void FramePool::deallocate(cv::UMatData* u) const {
+    if (!u) {
+        return;
+    }
+    CV_Assert(u->urefcount == 0);
+    CV_Assert(u->refcount == 0);
+    if (!(u->flags & cv::UMatData::USER_ALLOCATED)) {
+        bool pooled = false;
+        if (u->size >= minPooledSize) {
+            std::lock_guard<std::mutex> lock(mtx);
+            if (pooledBytes + u->size <= maxPooledBytes) {
+                freeBuffers[u->size].push_back(u->origdata);
+                pooledBytes += u->size;
+                pooled = true;
+            }
+        }
+        if (!pooled) {
+            cv::fastFree(u->origdata);
+            ++releases;
+        }
+        u->origdata = nullptr;
+    }
+    delete u;
+}
@@ -0,0 +1,203 @@
+// Copyright (C) 2021 Intel Corporation
+// SPDX-License-Identifier: Apache-2.0
+//
+
+#include "utils/hwc_to_chw.hpp"
+
+#include <cstring>
+#include <stdexcept>
+#include <utility>
+#include <vector>
+
+#include <opencv2/core/hal/intrin.hpp>
+
+namespace {
+std::vector<cv::Mat> wrapPlanes(const cv::Mat& src, void* dst, int planeType, size_t elementSize) {
+    std::vector<cv::Mat> planes;
+    const size_t planeBytes = src.total() * elementSize;
+    for (int c = 0; c < src.channels(); ++c) {
+        planes.emplace_back(src.rows, src.cols, planeType, static_cast<uint8_t*>(dst) + c * planeBytes);
+    }
+    return planes;
+}
+
+void splitRowU8C3(const uint8_t* src, int width, uint8_t* dst0, uint8_t* dst1, uint8_t* dst2) {
+    int x = 0;
+#if CV_SIMD
+    for (; x <= width - cv::v_uint8::nlanes; x += cv::v_uint8::nlanes) {
+        cv::v_uint8 b, g, r;
+        cv::v_load_deinterleave(src + 3 * x, b, g, r);
+        cv::v_store(dst0 + x, b);
+        cv::v_store(dst1 + x, g);
+        cv::v_store(dst2 + x, r);
+    }
+#endif
+    for (; x < width; ++x) {
+        dst0[x] = src[3 * x];
+        dst1[x] = src[3 * x + 1];
+        dst2[x] = src[3 * x + 2];
+    }
+}
+
+#if CV_SIMD
+// Widens 8-bit lanes to four float vectors and stores value * alpha + beta
+inline void storeScaled(float* dst, const cv::v_uint8& value, const cv::v_float32& alpha, const cv::v_float32& beta) {
+    cv::v_uint16 low, high;
+    cv::v_expand(value, low, high);
+    cv::v_uint32 values[4];
+    cv::v_expand(low, values[0], values[1]);
+    cv::v_expand(high, values[2], values[3]);
+    for (int i = 0; i < 4; ++i) {
+        const cv::v_float32 converted = cv::v_cvt_f32(cv::v_reinterpret_as_s32(values[i]));
+        cv::v_store(dst + i * cv::v_float32::nlanes, cv::v_fma(converted, alpha, beta));
+    }
+}
+#endif
+
+void scaleRowU8C1(const uint8_t* src, int width, float* dst, float alpha, float beta) {
+    int x = 0;
+#if CV_SIMD
+    const cv::v_float32 vAlpha = cv::vx_setall_f32(alpha);
+    const cv::v_float32 vBeta = cv::vx_setall_f32(beta);
+    for (; x <= width - cv::v_uint8::nlanes; x += cv::v_uint8::nlanes) {
+        storeScaled(dst + x, cv::vx_load(src + x), vAlpha, vBeta);
+    }
+#endif
+    for (; x < width; ++x) {
+        dst[x] = src[x] * alpha + beta;
+    }
+}
+
+// dst[c] receives source channel c, alpha[c] and beta[c] are given in the same order
+void splitScaleRowU8C3(const uint8_t* src, int width, float* const dst[3], const float alpha[3], const float beta[3]) {
+    int x = 0;
+#if CV_SIMD
+    const cv::v_float32 vAlpha[3] = {cv::vx_setall_f32(alpha[0]), cv::vx_setall_f32(alpha[1]), cv::vx_setall_f32(alpha[2])};
+    const cv::v_float32 vBeta[3] = {cv::vx_setall_f32(beta[0]), cv::vx_setall_f32(beta[1]), cv::vx_setall_f32(beta[2])};
+    for (; x <= width - cv::v_uint8::nlanes; x += cv::v_uint8::nlanes) {
+        cv::v_uint8 channels[3];
+        cv::v_load_deinterleave(src + 3 * x, channels[0], channels[1], channels[2]);
+        for (int c = 0; c < 3; ++c) {
+            storeScaled(dst[c] + x, channels[c], vAlpha[c], vBeta[c]);
+        }
+    }
+#endif
+    float* const dst0 = dst[0];
+    float* const dst1 = dst[1];
+    float* const dst2 = dst[2];
+    for (; x < width; ++x) {
+        dst0[x] = src[3 * x] * alpha[0] + beta[0];
+        dst1[x] = src[3 * x + 1] * alpha[1] + beta[1];
+        dst2[x] = src[3 * x + 2] * alpha[2] + beta[2];
+    }
+}
+
+void checkBatch(const std::vector<cv::Mat>& images) {
+    for (const cv::Mat& image : images) {
+        if (image.size() != images.front().size() || image.type() != images.front().type()) {
+            throw std::runtime_error("Images of a batch must have the same size and type");
+        }
+    }
+}
+}  // namespace
+
+void hwcToChw(const cv::Mat& src, uint8_t* dst) {
+    if (src.depth() != CV_8U) {
+        throw std::runtime_error("Conversion of cv::Mat from float_t to uint8_t is forbidden");
+    }
+    const int planeSize = src.rows * src.cols;
+    if (src.channels() == 1) {
+        for (int y = 0; y < src.rows; ++y) {
+            std::memcpy(dst + y * src.cols, src.ptr<uint8_t>(y), src.cols);
+        }
+    } else if (src.channels() == 3) {
+        for (int y = 0; y < src.rows; ++y) {
+            const int offset = y * src.cols;
+            splitRowU8C3(src.ptr<uint8_t>(y), src.cols, dst + offset, dst + planeSize + offset,
+                dst + 2 * planeSize + offset);
+        }
+    } else {
+        std::vector<cv::Mat> planes = wrapPlanes(src, dst, CV_8UC1, sizeof(uint8_t));
+        // Destination planes already have the right size and type, so split writes into the buffer
+        cv::split(src, planes.data());
+    }
+}
+
+void hwcToChw(const cv::Mat& src, float* dst, const cv::Scalar& means, const cv::Scalar& scales,
+        bool reverseChannels) {
+    const int channels = src.channels();
+    if (channels > 4) {
+        throw std::runtime_error("Unsupported number of channels");
+    }
+    const bool reverse = reverseChannels && channels == 3;
+
+    if (src.depth() == CV_8U && (channels == 1 || channels == 3)) {
+        // (x - mean) / scale is applied as x * alpha + beta, coefficients are kept in source channel order
+        float alpha[3], beta[3];
+        float* planes[3];
+        const int planeSize = src.rows * src.cols;
+        for (int c = 0; c < channels; ++c) {
+            const int outputChannel = reverse ? channels - 1 - c : c;
+            alpha[c] = static_cast<float>(1.0 / scales[outputChannel]);
+            beta[c] = static_cast<float>(-means[outputChannel] / scales[outputChannel]);
+            planes[c] = dst + outputChannel * planeSize;
+        }
+        for (int y = 0; y < src.rows; ++y) {
+            const int offset = y * src.cols;
+            if (channels == 1) {
+                scaleRowU8C1(src.ptr<uint8_t>(y), src.cols, planes[0] + offset, alpha[0], beta[0]);
+            } else {
+                float* const rowPlanes[3] = {planes[0] + offset, planes[1] + offset, planes[2] + offset};
+                splitScaleRowU8C3(src.ptr<uint8_t>(y), src.cols, rowPlanes, alpha, beta);
+            }
+        }
+        return;
+    }
+
+    std::vector<cv::Mat> dstPlanes = wrapPlanes(src, dst, CV_32FC1, sizeof(float));
+    bool isIdentity = true;
+    for (int c = 0; c < channels; ++c) {
+        isIdentity = isIdentity && means[c] == 0 && scales[c] == 1;
+    }
+    if (src.depth() == CV_32F && isIdentity) {
+        if (reverse) {
+            std::swap(dstPlanes[0], dstPlanes[2]);
+        }
+        cv::split(src, dstPlanes.data());
+        return;
+    }
+
+    std::vector<cv::Mat> srcPlanes;
+    cv::split(src, srcPlanes);
+    for (int c = 0; c < channels; ++c) {
+        const cv::Mat& srcPlane = srcPlanes[reverse ? channels - 1 - c : c];
+        srcPlane.convertTo(dstPlanes[c], CV_32F, 1.0 / scales[c], -means[c] / scales[c]);
+    }
+}
+
+void hwcToChw(const std::vector<cv::Mat>& images, uint8_t* dst) {
+    if (images.empty()) {
+        return;
+    }
+    checkBatch(images);
+    const size_t imageSize = images.front().total() * images.front().channels();
+    cv::parallel_for_(cv::Range(0, static_cast<int>(images.size())), [&](const cv::Range& range) {
+        for (int i = range.start; i < range.end; ++i) {
+            hwcToChw(images[i], dst + i * imageSize);
+        }
+    });
+}
+
+void hwcToChw(const std::vector<cv::Mat>& images, float* dst, const cv::Scalar& means, const cv::Scalar& scales,
+        bool reverseChannels) {
+    if (images.empty()) {
+        return;
+    }
+    checkBatch(images);
+    const size_t imageSize = images.front().total() * images.front().channels();
+    cv::parallel_for_(cv::Range(0, static_cast<int>(images.size())), [&](const cv::Range& range) {
+        for (int i = range.start; i < range.end; ++i) {
+            hwcToChw(images[i], dst + i * imageSize, means, scales, reverseChannels);
+        }
+    });
+}
@@ -12,10 +12,17 @@
 
 #include <opencv2/imgcodecs.hpp>
 
+#include <algorithm>
+#include <condition_variable>
+#include <exception>
+#include <functional>
 #include <stdexcept>
 #include <string>
 #include <memory>
+#include <mutex>
 #include <fstream>
+#include <thread>
+#include <vector>
 
 class InvalidInput : public std::runtime_error {
 public:
@@ -65,71 +72,99 @@ public:
 class DirReader : public ImagesCapture {
     std::vector<std::string> names;
     size_t fileId;
-    size_t nextImgId;
+    size_t nextImgId;  // Images of the current pass which are decoded or being decoded
+    size_t decodingNum;
+    bool passDecoded;
     const size_t initialImageId;
     const size_t readLengthLimit;
     const std::string input;
+    std::mutex mtx;
+    std::condition_variable decodedCondVar;
 
 public:
     DirReader(const std::string &input, bool loop, size_t initialImageId, size_t readLengthLimit) : ImagesCapture{loop},
-            fileId{0}, nextImgId{0}, initialImageId{initialImageId}, readLengthLimit{readLengthLimit}, input{input} {
+            fileId{initialImageId}, nextImgId{0}, decodingNum{0}, passDecoded{false}, initialImageId{initialImageId},
+            readLengthLimit{readLengthLimit}, input{input} {
         DIR *dir = opendir(input.c_str());
         if (!dir)
             throw InvalidInput("Can't find the dir by " + input);
         while (struct dirent *ent = readdir(dir))
-            if (strcmp(ent->d_name, ".") && strcmp(ent->d_name, ".."))
-                names.emplace_back(ent->d_name);
+            if (strcmp(ent->d_name, ".") && strcmp(ent->d_name, "..")) {
+                // Only file signature is checked, so images are not decoded just to be skipped
+                if (cv::haveImageReader(input + '/' + ent->d_name))
+                    names.emplace_back(ent->d_name);
+            }
         closedir(dir);
         if (names.empty())
-            throw OpenError("The dir " + input + " is empty");
+            throw OpenError("The dir " + input + " doesn't contain images");
         sort(names.begin(), names.end());
-        size_t readImgs = 0;
-        while (fileId < names.size()) {
-            cv::Mat img = cv::imread(input + '/' + names[fileId]);
-            if (img.data) {
-                ++readImgs;
-                if (readImgs - 1 >= initialImageId) return;
-            }
-            ++fileId;
-        }
-        throw OpenError("Can't read the first image from " + input);
+        if (initialImageId >= names.size())
+            throw OpenError("Can't read the first image from " + input);
     }
 
     double fps() const override {return 1.0;}
 
     std::string getType() const override {return "DIR";}
 
+    /// Picks the next image without decoding it, so images may be decoded concurrently. Every picked path must be
+    /// passed to decode(). Only decoded images count against readLengthLimit, so at the end of a pass it waits for
+    /// the images being decoded. The reading stops after a pass where no image was decoded even if loop is set.
+    bool nextImagePath(std::string& path) {
+        std::unique_lock<std::mutex> lock{mtx};
+        if (fileId >= names.size() || nextImgId >= readLengthLimit) {
+            decodedCondVar.wait(lock, [this] {return decodingNum == 0;});
+            if (fileId >= names.size() || nextImgId >= readLengthLimit) {
+                if (!loop || !passDecoded)
+                    return false;
+                fileId = initialImageId;
+                nextImgId = 0;
+                passDecoded = false;
+            }
+        }
+        path = input + '/' + names[fileId];
+        ++fileId;
+        ++nextImgId;
+        ++decodingNum;
+        return true;
+    }
+
+    /// Decodes a path given by nextImagePath(). Returns an empty image if the file can't be decoded
+    cv::Mat decode(const std::string& path) {
+        cv::Mat img;
+        try {
+            img = cv::imread(path);
+        } catch (...) {
+            imageDecoded(false);
+            throw;
+        }
+        imageDecoded(img.data != nullptr);
+        return img;
+    }
+
     cv::Mat read() override {
         auto startTime = std::chrono::steady_clock::now();
 
-        while (fileId < names.size() && nextImgId < readLengthLimit) {
-            cv::Mat img = cv::imread(input + '/' + names[fileId]);
-            ++fileId;
+        std::string path;
+        while (nextImagePath(path)) {
+            cv::Mat img = decode(path);
             if (img.data) {
-                ++nextImgId;
                 readerMetrics.update(startTime);
                 return img;
             }
         }
-
-        if (loop) {
-            fileId = 0;
-            size_t readImgs = 0;
-            while (fileId < names.size()) {
-                cv::Mat img = cv::imread(input + '/' + names[fileId]);
-                ++fileId;
-                if (img.data) {
-                    ++readImgs;
-                    if (readImgs - 1 >= initialImageId) {
-                        nextImgId = 1;
-                        readerMetrics.update(startTime);
-                        return img;
-                    }
-                }
-            }
-        }
         return cv::Mat{};
     }
+
+private:
+    void imageDecoded(bool success) {
+        std::lock_guard<std::mutex> lock{mtx};
+        --decodingNum;
+        if (success)
+            passDecoded = true;
+        else
+            --nextImgId;  // The image which failed to decode frees its place in the pass
+        decodedCondVar.notify_all();
+    }
 };
 
 class VideoCapWrapper : public ImagesCapture {
@@ -227,23 +262,197 @@ public:
     }
 };
 
+// Reads frames ahead on background threads into a bounded ring. Frames are fetched from the source one
+// by one, but the returned tasks which decode them may run concurrently. Sequence numbers keep the source order.
+class PrefetchingCapture : public ImagesCapture {
+public:
+    using DecodeTask = std::function<cv::Mat()>;
+    // Returns false when the source is over
+    using TaskSource = std::function<bool(DecodeTask&)>;
+
+    // dropOldFrames lets a single reading thread overwrite the oldest frame instead of waiting for a free slot
+    PrefetchingCapture(std::unique_ptr<ImagesCapture> source, TaskSource nextTask, size_t bufferSize,
+            size_t threadsNum, bool dropOldFrames)
+            : ImagesCapture{source->loop}, source{std::move(source)}, nextTask{std::move(nextTask)},
+            ring(bufferSize), filled(bufferSize, false), dropOldFrames{dropOldFrames} {
+        if (dropOldFrames)
+            threadsNum = 1;
+        activeWorkers = threadsNum;
+        for (size_t i = 0; i < threadsNum; ++i)
+            workers.emplace_back(&PrefetchingCapture::prefetch, this);
+    }
+
+    ~PrefetchingCapture() override {
+        {
+            std::lock_guard<std::mutex> lock{mtx};
+            stopped = true;
+        }
+        spaceCondVar.notify_all();
+        for (auto& worker : workers)
+            worker.join();
+    }
+
+    double fps() const override {return source->fps();}
+
+    std::string getType() const override {return source->getType();}
+
+    cv::Mat read() override {
+        auto startTime = std::chrono::steady_clock::now();
+
+        std::unique_lock<std::mutex> lock{mtx};
+        for (;;) {
+            frameCondVar.wait(lock, [this] {
+                return filled[readSeq % ring.size()] || workerException || readSeq >= endSeq || !activeWorkers;
+            });
+            if (workerException)
+                std::rethrow_exception(workerException);
+            if (!filled[readSeq % ring.size()])
+                return cv::Mat{};
+
+            size_t slot = readSeq % ring.size();
+            cv::Mat img = std::move(ring[slot]);
+            ring[slot] = cv::Mat{};
+            filled[slot] = false;
+            ++readSeq;
+            spaceCondVar.notify_all();
+            // Images which failed to decode are skipped
+            if (img.data) {
+                // Metrics show only the time the caller waited for a frame which wasn't prefetched yet
+                readerMetrics.update(startTime);
+                return img;
+            }
+        }
+    }
+
+private:
+    void prefetch() {
+        try {
+            for (;;) {
+                std::unique_lock<std::mutex> sourceLock{sourceMtx};
+                size_t seq;
+                {
+                    std::unique_lock<std::mutex> lock{mtx};
+                    // Only the thread holding sourceMtx modifies nextSeq and endSeq
+                    spaceCondVar.wait(lock, [this] {
+                        return stopped || dropOldFrames || nextSeq < readSeq + ring.size();
+                    });
+                    if (stopped || nextSeq == endSeq)
+                        break;
+                    seq = nextSeq;
+                }
+                DecodeTask task;
+                bool hasTask = nextTask(task);
+                {
+                    std::lock_guard<std::mutex> lock{mtx};
+                    if (hasTask)
+                        nextSeq = seq + 1;
+                    else
+                        endSeq = seq;
+                    frameCondVar.notify_all();
+                }
+                if (!hasTask)
+                    break;
+                sourceLock.unlock();
+
+                cv::Mat img = task();
+
+                std::lock_guard<std::mutex> lock{mtx};
+                if (seq >= readSeq + ring.size()) {
+                    // Live source outran the consumer, the oldest frame is replaced with the newest one
+                    ring[readSeq % ring.size()] = cv::Mat{};
+                    filled[readSeq % ring.size()] = false;
+                    ++readSeq;
+                }
+                ring[seq % ring.size()] = std::move(img);
+                filled[seq % ring.size()] = true;
+                frameCondVar.notify_all();
+            }
+        } catch (...) {
+            std::lock_guard<std::mutex> lock{mtx};
+            if (!workerException)
+                workerException = std::current_exception();
+        }
+        std::lock_guard<std::mutex> lock{mtx};
+        --activeWorkers;
+        frameCondVar.notify_all();
+        spaceCondVar.notify_all();
+    }
+
+    std::unique_ptr<ImagesCapture> source;
+    TaskSource nextTask;
+    std::mutex sourceMtx;
+
+    std::mutex mtx;
+    std::condition_variable frameCondVar;
+    std::condition_variable spaceCondVar;
+    std::vector<cv::Mat> ring;
+    std::vector<bool> filled;
+    size_t readSeq = 0;
+    size_t nextSeq = 0;
+    size_t endSeq = std::numeric_limits<size_t>::max();
+    size_t activeWorkers = 0;
+    bool stopped = false;
+    const bool dropOldFrames;
+    std::exception_ptr workerException;
+    std::vector<std::thread> workers;
+};
+
+namespace {
+std::unique_ptr<ImagesCapture> prefetch(DirReader* reader, size_t prefetchSize, size_t decodingThreadsNum) {
+    auto nextTask = [reader](PrefetchingCapture::DecodeTask& task) {
+        std::string path;
+        if (!reader->nextImagePath(path))
+            return false;
+        task = [reader, path] { return reader->decode(path); };
+        return true;
+    };
+    return std::unique_ptr<ImagesCapture>(new PrefetchingCapture{std::unique_ptr<ImagesCapture>(reader), nextTask,
+        prefetchSize, std::max<size_t>(decodingThreadsNum, 1), false});
+}
+
+std::unique_ptr<ImagesCapture> prefetch(ImagesCapture* reader, size_t prefetchSize, bool dropOldFrames) {
+    auto nextTask = [reader](PrefetchingCapture::DecodeTask& task) {
+        cv::Mat img = reader->read();
+        if (!img.data)
+            return false;
+        task = [img] { return img; };
+        return true;
+    };
+    return std::unique_ptr<ImagesCapture>(new PrefetchingCapture{std::unique_ptr<ImagesCapture>(reader), nextTask,
+        prefetchSize, 1, dropOldFrames});
+}
+}  // namespace
+
 std::unique_ptr<ImagesCapture> openImagesCapture(const std::string &input, bool loop, size_t initialImageId,
-        size_t readLengthLimit, cv::Size cameraResolution) {
+        size_t readLengthLimit, cv::Size cameraResolution, size_t prefetchSize, size_t decodingThreadsNum) {
     if (readLengthLimit == 0) throw std::runtime_error{"Read length limit must be positive"};
     std::vector<std::string> invalidInputs, openErrors;
     try { return std::unique_ptr<ImagesCapture>(new ImreadWrapper{input, loop}); }
     catch (const InvalidInput& e) { invalidInputs.push_back(e.what()); }
     catch (const OpenError& e) { openErrors.push_back(e.what()); }
 
-    try { return std::unique_ptr<ImagesCapture>(new DirReader{input, loop, initialImageId, readLengthLimit}); }
+    try {
+        std::unique_ptr<DirReader> reader{new DirReader{input, loop, initialImageId, readLengthLimit}};
+        if (prefetchSize == 0) return std::move(reader);
+        return prefetch(reader.release(), prefetchSize, decodingThreadsNum);
+    }
     catch (const InvalidInput& e) { invalidInputs.push_back(e.what()); }
     catch (const OpenError& e) { openErrors.push_back(e.what()); }
 
-    try { return std::unique_ptr<ImagesCapture>(new VideoCapWrapper{input, loop, initialImageId, readLengthLimit}); }
+    try {
+        std::unique_ptr<ImagesCapture> reader{new VideoCapWrapper{input, loop, initialImageId, readLengthLimit}};
+        if (prefetchSize == 0) return reader;
+        return prefetch(reader.release(), prefetchSize, false);
+    }
     catch (const InvalidInput& e) { invalidInputs.push_back(e.what()); }
     catch (const OpenError& e) { openErrors.push_back(e.what()); }
 
-    try { return std::unique_ptr<ImagesCapture>(new CameraCapWrapper{input, loop, readLengthLimit, cameraResolution}); }
+    try {
+        std::unique_ptr<ImagesCapture> reader{
+            new CameraCapWrapper{input, loop, readLengthLimit, cameraResolution}};
+        if (prefetchSize == 0) return reader;
+        return prefetch(reader.release(), prefetchSize, true);
+    }
     catch (const InvalidInput& e) { invalidInputs.push_back(e.what()); }
     catch (const OpenError& e) { openErrors.push_back(e.what()); }
 
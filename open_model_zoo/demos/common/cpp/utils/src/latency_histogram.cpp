@@ -0,0 +1,137 @@
+// Copyright (C) 2021 Intel Corporation
+// SPDX-License-Identifier: Apache-2.0
+//
+
+#include "utils/latency_histogram.hpp"
+
+#include <cmath>
+#include <limits>
+
+namespace {
+const double MICROSECONDS_IN_MILLISECOND = 1000.0;
+}  // namespace
+
+LatencyHistogram::LatencyHistogram()
+    : counts(new std::atomic<uint64_t>[BUCKETS_COUNT])
+    , totalCount(0)
+    , totalMicroseconds(0) {
+    for (size_t i = 0; i < BUCKETS_COUNT; ++i) {
+        counts[i].store(0, std::memory_order_relaxed);
+    }
+}
+
+LatencyHistogram::LatencyHistogram(const LatencyHistogram& other)
+    : counts(new std::atomic<uint64_t>[BUCKETS_COUNT]) {
+    copyFrom(other);
+}
+
+LatencyHistogram& LatencyHistogram::operator=(const LatencyHistogram& other) {
+    if (this != &other) {
+        copyFrom(other);
+    }
+    return *this;
+}
+
+void LatencyHistogram::copyFrom(const LatencyHistogram& other) {
+    for (size_t i = 0; i < BUCKETS_COUNT; ++i) {
+        counts[i].store(other.counts[i].load(std::memory_order_relaxed), std::memory_order_relaxed);
+    }
+    totalCount.store(other.totalCount.load(std::memory_order_relaxed), std::memory_order_relaxed);
+    totalMicroseconds.store(other.totalMicroseconds.load(std::memory_order_relaxed), std::memory_order_relaxed);
+}
+
+size_t LatencyHistogram::getBucketIndex(uint64_t microseconds) {
+    const uint64_t maxValue = (uint64_t(1) << MAX_VALUE_BITS) - 1;
+    if (microseconds > maxValue) {
+        microseconds = maxValue;
+    }
+    if (microseconds < SUB_BUCKETS) {
+        return static_cast<size_t>(microseconds);
+    }
+    // Value is shifted so that it keeps SUB_BUCKETS_BITS significant bits, the highest of which is always set
+    int shift = 0;
+    while ((microseconds >> shift) >= SUB_BUCKETS) {
+        ++shift;
+    }
+    uint64_t subBucket = (microseconds >> shift) - SUB_BUCKETS_HALF;
+    return static_cast<size_t>(SUB_BUCKETS + (shift - 1) * SUB_BUCKETS_HALF + subBucket);
+}
+
+uint64_t LatencyHistogram::getBucketUpperBound(size_t index) {
+    if (index < SUB_BUCKETS) {
+        return index;
+    }
+    int shift = static_cast<int>((index - SUB_BUCKETS) / SUB_BUCKETS_HALF) + 1;
+    uint64_t subBucket = (index - SUB_BUCKETS) % SUB_BUCKETS_HALF + SUB_BUCKETS_HALF;
+    return ((subBucket + 1) << shift) - 1;
+}
+
+void LatencyHistogram::record(std::chrono::steady_clock::duration value) {
+    auto microseconds = std::chrono::duration_cast<std::chrono::microseconds>(value).count();
+    uint64_t clamped = microseconds > 0 ? static_cast<uint64_t>(microseconds) : 0;
+    counts[getBucketIndex(clamped)].fetch_add(1, std::memory_order_relaxed);
+    totalMicroseconds.fetch_add(clamped, std::memory_order_relaxed);
+    totalCount.fetch_add(1, std::memory_order_relaxed);
+}
+
+LatencyHistogram::Snapshot LatencyHistogram::getSnapshot() const {
+    Snapshot snapshot;
+    snapshot.counts.resize(BUCKETS_COUNT);
+    // Total count is derived from buckets, so it stays consistent with them while other threads record values
+    for (size_t i = 0; i < BUCKETS_COUNT; ++i) {
+        snapshot.counts[i] = counts[i].load(std::memory_order_relaxed);
+        snapshot.totalCount += snapshot.counts[i];
+    }
+    snapshot.totalMicroseconds = totalMicroseconds.load(std::memory_order_relaxed);
+    return snapshot;
+}
+
+void LatencyHistogram::Snapshot::merge(const Snapshot& other) {
+    if (counts.size() < other.counts.size()) {
+        counts.resize(other.counts.size());
+    }
+    for (size_t i = 0; i < other.counts.size(); ++i) {
+        counts[i] += other.counts[i];
+    }
+    totalCount += other.totalCount;
+    totalMicroseconds += other.totalMicroseconds;
+}
+
+void LatencyHistogram::Snapshot::subtract(const Snapshot& earlier) {
+    for (size_t i = 0; i < earlier.counts.size() && i < counts.size(); ++i) {
+        counts[i] -= earlier.counts[i];
+    }
+    totalCount -= earlier.totalCount;
+    totalMicroseconds -= earlier.totalMicroseconds;
+}
+
+double LatencyHistogram::Snapshot::getPercentile(double percentile) const {
+    if (totalCount == 0) {
+        return std::numeric_limits<double>::quiet_NaN();
+    }
+    uint64_t rank = static_cast<uint64_t>(std::ceil(percentile / 100.0 * totalCount));
+    rank = rank == 0 ? 1 : rank;
+    uint64_t accumulated = 0;
+    for (size_t i = 0; i < counts.size(); ++i) {
+        accumulated += counts[i];
+        if (accumulated >= rank) {
+            return getBucketUpperBound(i) / MICROSECONDS_IN_MILLISECOND;
+        }
+    }
+    return getMax();
+}
+
+double LatencyHistogram::Snapshot::getMean() const {
+    return totalCount != 0
+        ? static_cast<double>(totalMicroseconds) / totalCount / MICROSECONDS_IN_MILLISECOND
+        : std::numeric_limits<double>::quiet_NaN();
+}
+
+double LatencyHistogram::Snapshot::getMax() const {
+    for (size_t i = counts.size(); i > 0; --i) {
+        if (counts[i - 1] != 0) {
+            return getBucketUpperBound(i - 1) / MICROSECONDS_IN_MILLISECOND;
+        }
+    }
+    return std::numeric_limits<double>::quiet_NaN();
+}
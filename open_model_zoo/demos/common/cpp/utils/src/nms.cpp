@@ -0,0 +1,320 @@
+// Copyright (C) 2021 Intel Corporation
+// SPDX-License-Identifier: Apache-2.0
+//
+
+#include <algorithm>
+#include <cmath>
+#include <limits>
+#include <numeric>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+#include <utils/nms.hpp>
+
+namespace {
+// Below this number of candidates plain pairwise suppression is faster than building a grid
+const size_t GRID_MIN_CANDIDATES = 512;
+const int GRID_MAX_CELLS_PER_SIDE = 128;
+
+std::vector<int> sortedCandidates(const std::vector<float>& scores, const std::vector<int>& indices) {
+    std::vector<int> order;
+    order.reserve(indices.size());
+    for (int idx : indices) {
+        if (scores[idx] >= 0) {
+            order.push_back(idx);
+        }
+    }
+    std::stable_sort(order.begin(), order.end(), [&scores](int o1, int o2) { return scores[o1] > scores[o2]; });
+    return order;
+}
+
+void suppressPlain(const NmsBoxes& boxes, const std::vector<int>& order, float thresh, size_t maxKeep,
+                   std::vector<int>& keep) {
+    std::vector<char> suppressed(order.size(), 0);
+    size_t kept = 0;
+    for (size_t i = 0; i < order.size(); ++i) {
+        if (suppressed[i]) {
+            continue;
+        }
+        int idx1 = order[i];
+        keep.push_back(idx1);
+        if (maxKeep && ++kept == maxKeep) {
+            break;
+        }
+        for (size_t j = i + 1; j < order.size(); ++j) {
+            if (!suppressed[j] && boxes.iou(idx1, order[j]) >= thresh) {
+                suppressed[j] = 1;
+            }
+        }
+    }
+}
+
+// Uniform grid over candidate boxes. Boxes overlapping by a positive IoU share at least one cell,
+// so a box needs to be compared only with boxes registered in the cells it covers
+class BoxGrid {
+public:
+    // Ranks are registered in increasing order, so every cell list is sorted by rank
+    BoxGrid(const NmsBoxes& boxes, const std::vector<int>& order) : boxes(boxes) {
+        minX = std::numeric_limits<float>::max();
+        minY = std::numeric_limits<float>::max();
+        float maxX = std::numeric_limits<float>::lowest();
+        float maxY = std::numeric_limits<float>::lowest();
+        double sumW = 0;
+        double sumH = 0;
+        for (int idx : order) {
+            minX = std::min(minX, boxes.left[idx]);
+            minY = std::min(minY, boxes.top[idx]);
+            maxX = std::max(maxX, boxes.right[idx]);
+            maxY = std::max(maxY, boxes.bottom[idx]);
+            sumW += boxes.right[idx] - boxes.left[idx];
+            sumH += boxes.bottom[idx] - boxes.top[idx];
+        }
+        // Cell size follows average box size, so a typical box covers a few cells
+        cellW = std::max(static_cast<float>(sumW / order.size()), (maxX - minX) / GRID_MAX_CELLS_PER_SIDE);
+        cellH = std::max(static_cast<float>(sumH / order.size()), (maxY - minY) / GRID_MAX_CELLS_PER_SIDE);
+        cellW = std::max(cellW, 1e-6f);
+        cellH = std::max(cellH, 1e-6f);
+        cols = std::min(static_cast<int>((maxX - minX) / cellW) + 1, GRID_MAX_CELLS_PER_SIDE);
+        rows = std::min(static_cast<int>((maxY - minY) / cellH) + 1, GRID_MAX_CELLS_PER_SIDE);
+
+        cells.resize(rows * cols);
+        for (size_t rank = 0; rank < order.size(); ++rank) {
+            forEachCell(order[rank], [rank](std::vector<int>& cell) { cell.push_back(static_cast<int>(rank)); });
+        }
+    }
+
+    template <typename Function>
+    void forEachCell(int idx, Function function) {
+        const int c0 = std::min(static_cast<int>((boxes.left[idx] - minX) / cellW), cols - 1);
+        const int c1 = std::min(static_cast<int>((boxes.right[idx] - minX) / cellW), cols - 1);
+        const int r0 = std::min(static_cast<int>((boxes.top[idx] - minY) / cellH), rows - 1);
+        const int r1 = std::min(static_cast<int>((boxes.bottom[idx] - minY) / cellH), rows - 1);
+        for (int r = r0; r <= r1; ++r) {
+            for (int c = c0; c <= c1; ++c) {
+                function(cells[r * cols + c]);
+            }
+        }
+    }
+
+private:
+    const NmsBoxes& boxes;
+    float minX, minY, cellW, cellH;
+    int cols, rows;
+    std::vector<std::vector<int>> cells;
+};
+
+void suppressGrid(const NmsBoxes& boxes, const std::vector<int>& order, float thresh, size_t maxKeep,
+                  std::vector<int>& keep) {
+    BoxGrid grid(boxes, order);
+    std::vector<char> suppressed(order.size(), 0);
+    size_t kept = 0;
+    for (size_t rank = 0; rank < order.size(); ++rank) {
+        if (suppressed[rank]) {
+            continue;
+        }
+        int idx1 = order[rank];
+        keep.push_back(idx1);
+        if (maxKeep && ++kept == maxKeep) {
+            break;
+        }
+        // Lower-ranked boxes are after the rank of the kept box in every cell list
+        grid.forEachCell(idx1, [&](const std::vector<int>& cell) {
+            for (auto it = std::upper_bound(cell.begin(), cell.end(), static_cast<int>(rank)); it != cell.end(); ++it) {
+                if (!suppressed[*it] && boxes.iou(idx1, order[*it]) >= thresh) {
+                    suppressed[*it] = 1;
+                }
+            }
+        });
+    }
+}
+
+void suppress(const NmsBoxes& boxes, const std::vector<int>& order, float thresh, size_t maxKeep,
+              std::vector<int>& keep) {
+    // Non-positive threshold lets non-overlapping boxes suppress each other, grid can't help there
+    if (order.size() >= GRID_MIN_CANDIDATES && thresh > 0) {
+        suppressGrid(boxes, order, thresh, maxKeep, keep);
+    } else {
+        suppressPlain(boxes, order, thresh, maxKeep, keep);
+    }
+}
+
+std::vector<int> allIndices(size_t size) {
+    std::vector<int> indices(size);
+    std::iota(indices.begin(), indices.end(), 0);
+    return indices;
+}
+
+std::vector<int> candidatesAbove(const std::vector<float>& scores, float scoreThreshold,
+                                 const std::vector<int>& indices) {
+    std::vector<int> candidates;
+    candidates.reserve(indices.size());
+    for (int idx : indices) {
+        if (scores[idx] >= scoreThreshold) {
+            candidates.push_back(idx);
+        }
+    }
+    return candidates;
+}
+
+void softSuppressPlain(const NmsBoxes& boxes, std::vector<float>& scores, std::vector<int> candidates,
+                       float sigma, float scoreThreshold, std::vector<int>& keep) {
+    while (!candidates.empty()) {
+        auto best = std::max_element(candidates.begin(), candidates.end(),
+            [&scores](int o1, int o2) { return scores[o1] < scores[o2]; });
+        int idx1 = *best;
+        keep.push_back(idx1);
+        *best = candidates.back();
+        candidates.pop_back();
+
+        size_t remaining = 0;
+        for (size_t j = 0; j < candidates.size(); ++j) {
+            int idx2 = candidates[j];
+            float overlap = boxes.iou(idx1, idx2);
+            scores[idx2] *= std::exp(-overlap * overlap / sigma);
+            if (scores[idx2] >= scoreThreshold) {
+                candidates[remaining++] = idx2;
+            }
+        }
+        candidates.resize(remaining);
+    }
+}
+
+// Only boxes sharing a grid cell with the selected box decay. The best box is taken from a heap whose entries
+// may hold outdated scores: scores only decrease, so an outdated entry is pushed back with the current score
+void softSuppressGrid(const NmsBoxes& boxes, std::vector<float>& scores, const std::vector<int>& candidates,
+                      float sigma, float scoreThreshold, std::vector<int>& keep) {
+    BoxGrid grid(boxes, candidates);
+    std::vector<std::pair<float, int>> heap;
+    heap.reserve(candidates.size());
+    for (size_t rank = 0; rank < candidates.size(); ++rank) {
+        heap.emplace_back(scores[candidates[rank]], static_cast<int>(rank));
+    }
+    std::make_heap(heap.begin(), heap.end());
+    std::vector<char> removed(candidates.size(), 0);
+    std::vector<int> visitedBy(candidates.size(), -1);  // the last selected rank which decayed the box
+
+    while (!heap.empty()) {
+        std::pop_heap(heap.begin(), heap.end());
+        const std::pair<float, int> entry = heap.back();
+        heap.pop_back();
+        const int rank1 = entry.second;
+        const int idx1 = candidates[rank1];
+        if (removed[rank1]) {
+            continue;
+        }
+        if (entry.first != scores[idx1]) {
+            heap.emplace_back(scores[idx1], rank1);
+            std::push_heap(heap.begin(), heap.end());
+            continue;
+        }
+        keep.push_back(idx1);
+        removed[rank1] = 1;
+
+        grid.forEachCell(idx1, [&](const std::vector<int>& cell) {
+            for (int rank2 : cell) {
+                if (removed[rank2] || visitedBy[rank2] == rank1) {
+                    continue;
+                }
+                visitedBy[rank2] = rank1;
+                const int idx2 = candidates[rank2];
+                float overlap = boxes.iou(idx1, idx2);
+                scores[idx2] *= std::exp(-overlap * overlap / sigma);
+                if (scores[idx2] < scoreThreshold) {
+                    removed[rank2] = 1;
+                }
+            }
+        });
+    }
+}
+
+void softSuppress(const NmsBoxes& boxes, std::vector<float>& scores, const std::vector<int>& candidates,
+                  float sigma, float scoreThreshold, std::vector<int>& keep) {
+    if (candidates.size() >= GRID_MIN_CANDIDATES) {
+        softSuppressGrid(boxes, scores, candidates, sigma, scoreThreshold, keep);
+    } else {
+        softSuppressPlain(boxes, scores, candidates, sigma, scoreThreshold, keep);
+    }
+}
+}  // namespace
+
+NmsBoxes NmsBoxes::fromRects(const float* x, const float* y, const float* width, const float* height, size_t count) {
+    NmsBoxes result;
+    result.reserve(count);
+    for (size_t i = 0; i < count; ++i) {
+        result.push(x[i], y[i], x[i] + width[i], y[i] + height[i]);
+    }
+    return result;
+}
+
+void NmsBoxes::reserve(size_t capacity) {
+    left.reserve(capacity);
+    top.reserve(capacity);
+    right.reserve(capacity);
+    bottom.reserve(capacity);
+    areas.reserve(capacity);
+}
+
+void NmsBoxes::push(float left, float top, float right, float bottom, bool includeBoundaries) {
+    this->left.push_back(left);
+    this->top.push_back(top);
+    this->right.push_back(right);
+    this->bottom.push_back(bottom);
+    areas.push_back((right - left + includeBoundaries) * (bottom - top + includeBoundaries));
+}
+
+float NmsBoxes::iou(size_t i, size_t j) const {
+    float overlappingWidth = std::fmin(right[i], right[j]) - std::fmax(left[i], left[j]);
+    float overlappingHeight = std::fmin(bottom[i], bottom[j]) - std::fmax(top[i], top[j]);
+    float intersection = overlappingWidth > 0 && overlappingHeight > 0 ? overlappingWidth * overlappingHeight : 0;
+    return intersection / (areas[i] + areas[j] - intersection);
+}
+
+std::vector<int> nms(const NmsBoxes& boxes, const std::vector<float>& scores, float thresh, size_t maxKeep) {
+    std::vector<int> indices(scores.size());
+    std::iota(indices.begin(), indices.end(), 0);
+
+    std::vector<int> keep;
+    suppress(boxes, sortedCandidates(scores, indices), thresh, maxKeep, keep);
+    return keep;
+}
+
+std::vector<int> batchedNms(const NmsBoxes& boxes, const std::vector<float>& scores,
+                            const std::vector<unsigned int>& classIds, float thresh, size_t maxKeep) {
+    std::unordered_map<unsigned int, std::vector<int>> classIndices;
+    for (size_t i = 0; i < scores.size(); ++i) {
+        classIndices[classIds[i]].push_back(static_cast<int>(i));
+    }
+
+    std::vector<int> keep;
+    for (const auto& cls : classIndices) {
+        suppress(boxes, sortedCandidates(scores, cls.second), thresh, maxKeep, keep);
+    }
+    std::stable_sort(keep.begin(), keep.end(), [&scores](int o1, int o2) { return scores[o1] > scores[o2]; });
+    if (maxKeep && keep.size() > maxKeep) {
+        keep.resize(maxKeep);
+    }
+    return keep;
+}
+
+std::vector<int> softNms(const NmsBoxes& boxes, std::vector<float>& scores, float sigma, float scoreThreshold) {
+    std::vector<int> keep;
+    softSuppress(boxes, scores, candidatesAbove(scores, scoreThreshold, allIndices(scores.size())), sigma,
+                 scoreThreshold, keep);
+    return keep;
+}
+
+std::vector<int> batchedSoftNms(const NmsBoxes& boxes, std::vector<float>& scores,
+                                const std::vector<unsigned int>& classIds, float sigma, float scoreThreshold) {
+    std::unordered_map<unsigned int, std::vector<int>> classIndices;
+    for (size_t i = 0; i < scores.size(); ++i) {
+        classIndices[classIds[i]].push_back(static_cast<int>(i));
+    }
+
+    std::vector<int> keep;
+    for (const auto& cls : classIndices) {
+        softSuppress(boxes, scores, candidatesAbove(scores, scoreThreshold, cls.second), sigma, scoreThreshold, keep);
+    }
+    std::stable_sort(keep.begin(), keep.end(), [&scores](int o1, int o2) { return scores[o1] > scores[o2]; });
+    return keep;
+}
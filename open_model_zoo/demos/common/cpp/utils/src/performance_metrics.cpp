@@ -4,7 +4,9 @@
 
 #include "utils/performance_metrics.hpp"
 
+#include <cmath>
 #include <limits>
+#include <stdexcept>
 
 // timeWindow defines the length of the timespan over which the 'current fps' value is calculated
 PerformanceMetrics::PerformanceMetrics(Duration timeWindow)
@@ -33,6 +35,7 @@ void PerformanceMetrics::update(TimePoint lastRequestStartTime) {
     }
 
     currentMovingStatistic.latency += currentTime - lastRequestStartTime;
+    latencyHistogram.record(currentTime - lastRequestStartTime);
     currentMovingStatistic.period = currentTime - lastUpdateTime;
     currentMovingStatistic.frameCount++;
 
@@ -102,6 +105,75 @@ void PerformanceMetrics::logTotal() const {
 
     slog::info << "\tLatency: " << std::fixed << std::setprecision(1) << metrics.latency << " ms" << slog::endl;
     slog::info << "\tFPS: " << metrics.fps << slog::endl;
+
+    LatencyHistogram::Snapshot histogram = getLatencyHistogram();
+    slog::info << "\tLatency percentiles: p50 " << histogram.getPercentile(50) << " ms, p90 "
+        << histogram.getPercentile(90) << " ms, p99 " << histogram.getPercentile(99) << " ms, p99.9 "
+        << histogram.getPercentile(99.9) << " ms" << slog::endl;
+}
+
+namespace {
+void writeJsonNumber(std::ostream& out, double value) {
+    if (std::isnan(value)) {
+        out << "null";
+    } else {
+        out << value;
+    }
+}
+
+void logStagePercentiles(const std::string& stageName, const PerformanceMetrics& metrics) {
+    LatencyHistogram::Snapshot histogram = metrics.getLatencyHistogram();
+    slog::info << "\t" << stageName << ":\t" << histogram.getMean() << " ms (p50 " << histogram.getPercentile(50)
+        << ", p90 " << histogram.getPercentile(90) << ", p99 " << histogram.getPercentile(99)
+        << ", p99.9 " << histogram.getPercentile(99.9) << " ms)" << slog::endl;
+}
+}  // namespace
+
+LatencyHistogramWriter::LatencyHistogramWriter(const std::string& fileName, PerformanceMetrics::Duration interval)
+    : outputFile(fileName, std::ios::app)
+    , interval(interval)
+    , startTime(PerformanceMetrics::Clock::now())
+    , lastWriteTime(startTime) {
+    if (!outputFile.is_open()) {
+        throw std::runtime_error("Can't open latency log file: " + fileName);
+    }
+    outputFile << std::fixed << std::setprecision(3);
+}
+
+void LatencyHistogramWriter::addStage(const std::string& name, const PerformanceMetrics& metrics) {
+    stages.push_back({name, &metrics, metrics.getLatencyHistogram()});
+}
+
+void LatencyHistogramWriter::update() {
+    if (PerformanceMetrics::Clock::now() - lastWriteTime >= interval) {
+        flush();
+    }
+}
+
+void LatencyHistogramWriter::flush() {
+    lastWriteTime = PerformanceMetrics::Clock::now();
+    outputFile << "{\"time_s\": " << std::chrono::duration_cast<PerformanceMetrics::Sec>(lastWriteTime - startTime).count();
+    for (auto& stage : stages) {
+        LatencyHistogram::Snapshot current = stage.metrics->getLatencyHistogram();
+        LatencyHistogram::Snapshot recent = current;
+        recent.subtract(stage.lastSnapshot);
+        stage.lastSnapshot = std::move(current);
+
+        outputFile << ", \"" << stage.name << "\": {\"count\": " << recent.totalCount << ", \"mean_ms\": ";
+        writeJsonNumber(outputFile, recent.getMean());
+        outputFile << ", \"p50_ms\": ";
+        writeJsonNumber(outputFile, recent.getPercentile(50));
+        outputFile << ", \"p90_ms\": ";
+        writeJsonNumber(outputFile, recent.getPercentile(90));
+        outputFile << ", \"p99_ms\": ";
+        writeJsonNumber(outputFile, recent.getPercentile(99));
+        outputFile << ", \"p99.9_ms\": ";
+        writeJsonNumber(outputFile, recent.getPercentile(99.9));
+        outputFile << ", \"max_ms\": ";
+        writeJsonNumber(outputFile, recent.getMax());
+        outputFile << "}";
+    }
+    outputFile << "}" << std::endl;
 }
 
 void logLatencyPerStage(double readLat, double preprocLat, double inferLat, double postprocLat, double renderLat) {
@@ -112,3 +184,14 @@ void logLatencyPerStage(double readLat, double preprocLat, double inferLat, doub
     slog::info << "\tPostprocessing:\t" << postprocLat << " ms" << slog::endl;
     slog::info << "\tRendering:\t" << renderLat << " ms" << slog::endl;
 }
+
+void logLatencyPerStage(const PerformanceMetrics& readMetrics, const PerformanceMetrics& preprocMetrics,
+    const PerformanceMetrics& inferMetrics, const PerformanceMetrics& postprocMetrics,
+    const PerformanceMetrics& renderMetrics) {
+    slog::info << std::fixed << std::setprecision(1);
+    logStagePercentiles("Decoding", readMetrics);
+    logStagePercentiles("Preprocessing", preprocMetrics);
+    logStagePercentiles("Inference", inferMetrics);
+    logStagePercentiles("Postprocessing", postprocMetrics);
+    logStagePercentiles("Rendering", renderMetrics);
+}
@@ -0,0 +1,140 @@
+// Copyright (C) 2021 Intel Corporation
+// SPDX-License-Identifier: Apache-2.0
+//
+
+#include "utils/roi_infer_queue.hpp"
+
+#include <stdexcept>
+#include <string>
+#include <utility>
+
+#include "utils/ocv_common.hpp"
+
+RoiInferQueue::RoiInferQueue(InferenceEngine::ExecutableNetwork& network, size_t requestsNum, bool dynamicBatch)
+    : dynamicBatch(dynamicBatch)
+    , slots(requestsNum)
+    , fillingSlot(requestsNum)
+    , lastTimePerRoi(0) {
+    if (requestsNum == 0) {
+        throw std::invalid_argument("RoiInferQueue requires at least one infer request");
+    }
+    InferenceEngine::ConstInputsDataMap inputs = network.GetInputsInfo();
+    if (inputs.size() != 1) {
+        throw std::logic_error("RoiInferQueue supports only networks with a single input");
+    }
+    inputName = inputs.begin()->first;
+    batchSize = inputs.begin()->second->getTensorDesc().getDims()[0];
+
+    for (size_t i = 0; i < slots.size(); ++i) {
+        slots[i].request = network.CreateInferRequest();
+        slots[i].inputBlob = slots[i].request.GetBlob(inputName);
+        slots[i].readers.reserve(batchSize);
+        slots[i].request.SetCompletionCallback([this, i]{ onCompleted(i); });
+        idleSlots.push_back(i);
+    }
+}
+
+RoiInferQueue::~RoiInferQueue() {
+    try {
+        waitAll();
+    } catch (...) {}
+    for (Slot& slot : slots) {
+        slot.request.SetCompletionCallback([]{});
+    }
+}
+
+RoiInferQueue::Slot& RoiInferQueue::getFillingSlot() {
+    if (fillingSlot == slots.size()) {
+        std::unique_lock<std::mutex> lock(mtx);
+        condVar.wait(lock, [this]{ return !idleSlots.empty() || readerException; });
+        rethrowIfFailed();
+        fillingSlot = idleSlots.front();
+        idleSlots.pop_front();
+    }
+    return slots[fillingSlot];
+}
+
+void RoiInferQueue::push(const cv::Mat& roi, ResultReader reader) {
+    Slot& slot = getFillingSlot();
+    if (slot.roiBlobSet) {
+        slot.request.SetBlob(inputName, slot.inputBlob);
+        slot.roiBlobSet = false;
+    }
+    matToBlob(roi, slot.inputBlob, static_cast<int>(slot.readers.size()));
+    slot.readers.push_back(std::move(reader));
+    if (slot.readers.size() == batchSize) {
+        start();
+    }
+}
+
+void RoiInferQueue::push(const InferenceEngine::Blob::Ptr& roiBlob, ResultReader reader) {
+    if (batchSize != 1) {
+        throw std::logic_error("ROI blobs can be inferred only by a network with batch size 1");
+    }
+    Slot& slot = getFillingSlot();
+    slot.request.SetBlob(inputName, roiBlob);
+    slot.roiBlobSet = true;
+    slot.readers.push_back(std::move(reader));
+    start();
+}
+
+void RoiInferQueue::flush() {
+    if (fillingSlot != slots.size()) {
+        start();
+    }
+}
+
+void RoiInferQueue::waitAll() {
+    flush();
+    std::unique_lock<std::mutex> lock(mtx);
+    condVar.wait(lock, [this]{ return idleSlots.size() == slots.size(); });
+    rethrowIfFailed();
+}
+
+double RoiInferQueue::getLastTimePerRoi() const {
+    std::lock_guard<std::mutex> lock(mtx);
+    return lastTimePerRoi;
+}
+
+void RoiInferQueue::start() {
+    Slot& slot = slots[fillingSlot];
+    fillingSlot = slots.size();
+    if (dynamicBatch) {
+        slot.request.SetBatch(static_cast<int>(slot.readers.size()));
+    }
+    slot.startTime = std::chrono::steady_clock::now();
+    slot.request.StartAsync();
+}
+
+void RoiInferQueue::onCompleted(size_t slotIndex) {
+    Slot& slot = slots[slotIndex];
+    const std::chrono::duration<double, std::milli> inferTime = std::chrono::steady_clock::now() - slot.startTime;
+    std::exception_ptr exception;
+    try {
+        for (size_t i = 0; i < slot.readers.size(); ++i) {
+            slot.readers[i](slot.request, i);
+        }
+    } catch (...) {
+        exception = std::current_exception();
+    }
+    const size_t roisNum = slot.readers.size();
+    // Readers may hold the frames their results go to, so they are released before the slot is reused
+    slot.readers.clear();
+    {
+        std::lock_guard<std::mutex> lock(mtx);
+        if (exception && !readerException) {
+            readerException = exception;
+        }
+        lastTimePerRoi = inferTime.count() / roisNum;
+        idleSlots.push_back(slotIndex);
+    }
+    condVar.notify_all();
+}
+
+void RoiInferQueue::rethrowIfFailed() {
+    if (readerException) {
+        std::exception_ptr exception = readerException;
+        readerException = nullptr;
+        std::rethrow_exception(exception);
+    }
+}
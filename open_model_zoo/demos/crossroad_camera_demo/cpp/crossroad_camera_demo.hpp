@@ -43,6 +43,11 @@ static const char utilization_monitors_message[] = "Optional. List of monitors t
 static const char person_label_message[] = "Optional. The integer index of the objects' category corresponding to persons "
                                            "(as it is returned from the detection network, may vary from one network to another). "
                                            "The default value is 1.";
+static const char nireq_message[] = "Optional. Number of infer requests for each of Person Attributes Recognition and "
+                                    "Person Reidentification networks. The default value is 2.";
+static const char batch_size_message[] = "Optional. Batch size for Person Attributes Recognition and Person Reidentification "
+                                         "networks, crops of several frames may share one batch. Ignored with -auto_resize. "
+                                         "The default value is 4.";
 
 
 DEFINE_bool(h, false, help_message);
@@ -61,6 +66,8 @@ DEFINE_bool(no_show, false, no_show_message);
 DEFINE_bool(auto_resize, false, input_resizable_message);
 DEFINE_string(u, "", utilization_monitors_message);
 DEFINE_int32(person_label, 1, person_label_message);
+DEFINE_uint32(nireq, 2, nireq_message);
+DEFINE_uint32(b, 4, batch_size_message);
 
 
 /**
@@ -92,4 +99,6 @@ static void showUsage() {
     std::cout << "    -auto_resize                 " << input_resizable_message << std::endl;
     std::cout << "    -u                           " << utilization_monitors_message << std::endl;
     std::cout << "    -person_label                " << person_label_message << std::endl;
+    std::cout << "    -nireq \"<integer>\"           " << nireq_message << std::endl;
+    std::cout << "    -b \"<integer>\"               " << batch_size_message << std::endl;
 }
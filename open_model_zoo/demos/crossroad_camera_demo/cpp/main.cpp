@@ -8,6 +8,9 @@
 * \example crossroad_camera_demo/main.cpp
 */
 #include <gflags/gflags.h>
+#include <atomic>
+#include <condition_variable>
+#include <deque>
 #include <functional>
 #include <iostream>
 #include <fstream>
@@ -17,6 +20,7 @@
 #include <algorithm>
 #include <iterator>
 #include <map>
+#include <mutex>
 #include <string>
 #include <vector>
 #include <set>
@@ -27,6 +31,7 @@
 #include <utils/images_capture.h>
 #include <utils/ocv_common.hpp>
 #include <utils/performance_metrics.hpp>
+#include <utils/roi_infer_queue.hpp>
 #include <utils/slog.hpp>
 #include "crossroad_camera_demo.hpp"
 
@@ -48,6 +53,14 @@ bool ParseAndCheckCommandLine(int argc, char *argv[]) {
         throw std::logic_error("Parameter -m is not set");
     }
 
+    if (FLAGS_nireq == 0) {
+        throw std::logic_error("Parameter -nireq must be positive");
+    }
+
+    if (FLAGS_b == 0) {
+        throw std::logic_error("Parameter -b must be positive");
+    }
+
     return true;
 }
 
@@ -280,7 +293,7 @@ struct PersonAttribsDetection : BaseDetection {
         return centers.at<cv::Vec3b>(freqArgmax);
     }
 
-    AttributesAndColorPoints GetPersonAttributes() {
+    AttributesAndColorPoints GetPersonAttributes(InferenceEngine::InferRequest& request, size_t batchIndex) {
         static const char *const attributeStringsFor7Attributes[] = {
                 "is male", "has_bag", "has hat", "has longsleeves", "has longpants", "has longhair", "has coat_jacket"
         };
@@ -309,7 +322,7 @@ struct PersonAttribsDetection : BaseDetection {
 
         InferenceEngine::LockedMemory<const void> attribsBlobMapped =
             InferenceEngine::as<InferenceEngine::MemoryBlob>(attribsBlob)->rmap();
-        auto outputAttrValues = attribsBlobMapped.as<float*>();
+        auto outputAttrValues = attribsBlobMapped.as<float*>() + batchIndex * numOfAttrChannels;
         for (size_t i = 0; i < numOfAttrChannels; i++) {
             returnValue.attributes_strings.push_back(attributeStrings[i]);
             returnValue.attributes_indicators.push_back(outputAttrValues[i] > 0.5);
@@ -332,10 +345,10 @@ struct PersonAttribsDetection : BaseDetection {
 
             InferenceEngine::LockedMemory<const void> topColorPointBlobMapped =
                 InferenceEngine::as<InferenceEngine::MemoryBlob>(topColorPointBlob)->rmap();
-            auto outputTCPointValues = topColorPointBlobMapped.as<float*>();
+            auto outputTCPointValues = topColorPointBlobMapped.as<float*>() + batchIndex * numOfTCPointChannels;
             InferenceEngine::LockedMemory<const void> bottomColorPointBlobMapped =
                 InferenceEngine::as<InferenceEngine::MemoryBlob>(bottomColorPointBlob)->rmap();
-            auto outputBCPointValues = bottomColorPointBlobMapped.as<float*>();
+            auto outputBCPointValues = bottomColorPointBlobMapped.as<float*>() + batchIndex * numOfBCPointChannels;
 
             returnValue.top_color_point.x = outputTCPointValues[0];
             returnValue.top_color_point.y = outputTCPointValues[1];
@@ -354,8 +367,8 @@ struct PersonAttribsDetection : BaseDetection {
     InferenceEngine::CNNNetwork read(const InferenceEngine::Core& ie) override {
         /** Read network model **/
         auto network = ie.ReadNetwork(FLAGS_m_pa);
-        /** Extract model name and load it's weights **/
-        network.setBatchSize(1);
+        /** Crops are batched unless they are given as ROI blobs **/
+        network.setBatchSize(FLAGS_auto_resize ? 1 : FLAGS_b);
         // -----------------------------------------------------------------------------------------------------
 
         /** Person Attribs network should have one input two outputs **/
@@ -420,13 +433,13 @@ struct PersonReIdentification : BaseDetection {
         return size;
     }
 
-    std::vector<float> getReidVec() {
+    std::vector<float> getReidVec(InferenceEngine::InferRequest& request, size_t batchIndex) {
         InferenceEngine::Blob::Ptr attribsBlob = request.GetBlob(outputName);
 
         auto numOfChannels = attribsBlob->getTensorDesc().getDims().at(1);
         InferenceEngine::LockedMemory<const void> attribsBlobMapped =
             InferenceEngine::as<InferenceEngine::MemoryBlob>(attribsBlob)->rmap();
-        auto outputValues = attribsBlobMapped.as<float*>();
+        auto outputValues = attribsBlobMapped.as<float*>() + batchIndex * numOfChannels;
         return std::vector<float>(outputValues, outputValues + numOfChannels);
     }
 
@@ -457,7 +470,7 @@ struct PersonReIdentification : BaseDetection {
     InferenceEngine::CNNNetwork read(const InferenceEngine::Core& ie) override {
         /** Read network model **/
         auto network = ie.ReadNetwork(FLAGS_m_reid);
-        network.setBatchSize(1);
+        network.setBatchSize(FLAGS_auto_resize ? 1 : FLAGS_b);
         /** Person Reidentification network should have 1 input and one output **/
         // ---------------------------Check inputs ------------------------------------------------------
         InferenceEngine::InputsDataMap inputInfo(network.getInputsInfo());
@@ -487,6 +500,23 @@ struct PersonReIdentification : BaseDetection {
     }
 };
 
+struct PersonResults {
+    cv::Rect location;
+    cv::Mat crop;
+    PersonAttribsDetection::AttributesAndColorPoints attributes;
+    std::vector<float> reIdVector;
+};
+
+// Frame which waits for results of the second-stage networks. Results are written by inference callbacks,
+// each into its own person's slot, and are read after pendingRois drops to zero
+struct PendingFrame {
+    cv::Mat frame;
+    std::chrono::steady_clock::time_point startTime;
+    std::chrono::duration<double, std::ratio<1, 1000>> detection;
+    std::vector<PersonResults> persons;
+    std::atomic<size_t> pendingRois{0};
+};
+
 struct Load {
     BaseDetection& detector;
     explicit Load(BaseDetection& detector) : detector(detector) { }
@@ -566,8 +596,30 @@ int main(int argc, char *argv[]) {
         InferenceEngine::Blob::Ptr frameBlob;  // Blob to be used to keep processed frame data
         InferenceEngine::ROI cropRoi;  // cropped image coordinates
         InferenceEngine::Blob::Ptr roiBlob;  // This blob contains data from cropped image (vehicle or license plate)
-        cv::Mat person;  // Mat object containing person data cropped by openCV
 
+        // Crops of a frame may wait in a partially filled batch for crops of the next frames, so several frames are kept
+        // pending, and partial batches are started only when there are too many of them
+        const size_t maxPendingFrames = std::max<size_t>(FLAGS_auto_resize ? 1 : FLAGS_b, FLAGS_nireq);
+        std::deque<std::shared_ptr<PendingFrame>> pendingFrames;
+        std::mutex pendingFramesMutex;
+        std::condition_variable pendingFramesCondVar;
+        auto onRoiInferred = [&pendingFramesMutex, &pendingFramesCondVar](PendingFrame& pendingFrame) {
+            if (--pendingFrame.pendingRois == 0) {
+                // Taking the mutex makes sure the main thread either sees the counter or waits for the notification
+                std::lock_guard<std::mutex> lock(pendingFramesMutex);
+            }
+            pendingFramesCondVar.notify_one();
+        };
+
+        /** Crops of several frames are inferred by the second-stage networks at once **/
+        std::unique_ptr<RoiInferQueue> personAttribsQueue;
+        if (personAttribs.enabled()) {
+            personAttribsQueue.reset(new RoiInferQueue(personAttribs.net, FLAGS_nireq));
+        }
+        std::unique_ptr<RoiInferQueue> personReIdQueue;
+        if (personReId.enabled()) {
+            personReIdQueue.reset(new RoiInferQueue(personReId.net, FLAGS_nireq));
+        }
         /** Start inference & calc performance **/
         typedef std::chrono::duration<double, std::ratio<1, 1000>> ms;
 
@@ -588,192 +640,127 @@ int main(int argc, char *argv[]) {
 
         bool shouldHandleTopBottomColors = personAttribs.HasTopBottomColor();
 
-        do {
-            if (FLAGS_auto_resize) {
-                // just wrap Mat object with Blob::Ptr without additional memory allocation
-                frameBlob = wrapMat2Blob(frame);
-                personDetection.setRoiBlob(frameBlob);
-            } else {
-                personDetection.enqueue(frame);
-            }
-            // --------------------------- Run Person detection inference --------------------------------------
-            auto t0 = std::chrono::high_resolution_clock::now();
-            personDetection.submitRequest();
-            personDetection.wait();
-            auto t1 = std::chrono::high_resolution_clock::now();
-            ms detection = std::chrono::duration_cast<ms>(t1 - t0);
-            // parse inference results internally (e.g. apply a threshold, etc)
-            personDetection.fetchResults();
-            // -------------------------------------------------------------------------------------------------
-
-            // --------------------------- Process the results down to the pipeline ----------------------------
-            ms personAttribsNetworkTime(0), personReIdNetworktime(0);
-            int personAttribsInferred = 0,  personReIdInferred = 0;
-            for (auto && result : personDetection.results) {
-                if (result.label == FLAGS_person_label) {  // person
-                    if (FLAGS_auto_resize) {
-                        cropRoi.posX = (result.location.x < 0) ? 0 : result.location.x;
-                        cropRoi.posY = (result.location.y < 0) ? 0 : result.location.y;
-                        cropRoi.sizeX = std::min((size_t) result.location.width, frame.cols - cropRoi.posX);
-                        cropRoi.sizeY = std::min((size_t) result.location.height, frame.rows - cropRoi.posY);
-                        roiBlob = make_shared_blob(frameBlob, cropRoi);
-                    } else {
-                        // To crop ROI manually and allocate required memory (cv::Mat) again
-                        auto clippedRect = result.location & cv::Rect(0, 0, frame.cols, frame.rows);
-                        person = frame(clippedRect);
-                    }
+        // Draws results of the frame whose crops are all inferred, returns false if the demo should stop
+        auto renderFrame = [&](PendingFrame& pendingFrame) {
+            cv::Mat& frame = pendingFrame.frame;
+            for (auto && personResults : pendingFrame.persons) {
+                const cv::Rect& location = personResults.location;
+                const cv::Mat& person = personResults.crop;
+                PersonAttribsDetection::AttributesAndColorPoints& resPersAttrAndColor = personResults.attributes;
+                if (!resPersAttrAndColor.attributes_strings.empty() && shouldHandleTopBottomColors) {
+                    cv::Point top_color_p;
+                    cv::Point bottom_color_p;
 
-                    PersonAttribsDetection::AttributesAndColorPoints resPersAttrAndColor;
-                    if (personAttribs.enabled()) {
-                        // --------------------------- Run Person Attributes Recognition -----------------------
-                        if (FLAGS_auto_resize) {
-                            personAttribs.setRoiBlob(roiBlob);
-                        } else {
-                            personAttribs.enqueue(person);
-                        }
-
-                        t0 = std::chrono::high_resolution_clock::now();
-                        personAttribs.submitRequest();
-                        personAttribs.wait();
-                        t1 = std::chrono::high_resolution_clock::now();
-                        personAttribsNetworkTime += std::chrono::duration_cast<ms>(t1 - t0);
-                        personAttribsInferred++;
-                        // --------------------------- Process outputs -----------------------------------------
+                    top_color_p.x = static_cast<int>(resPersAttrAndColor.top_color_point.x) * person.cols;
+                    top_color_p.y = static_cast<int>(resPersAttrAndColor.top_color_point.y) * person.rows;
 
-                        resPersAttrAndColor = personAttribs.GetPersonAttributes();
+                    bottom_color_p.x = static_cast<int>(resPersAttrAndColor.bottom_color_point.x) * person.cols;
+                    bottom_color_p.y = static_cast<int>(resPersAttrAndColor.bottom_color_point.y) * person.rows;
 
-                        if (shouldHandleTopBottomColors) {
-                            cv::Point top_color_p;
-                            cv::Point bottom_color_p;
 
-                            top_color_p.x = static_cast<int>(resPersAttrAndColor.top_color_point.x) * person.cols;
-                            top_color_p.y = static_cast<int>(resPersAttrAndColor.top_color_point.y) * person.rows;
+                    cv::Rect person_rect(0, 0, person.cols, person.rows);
 
-                            bottom_color_p.x = static_cast<int>(resPersAttrAndColor.bottom_color_point.x) * person.cols;
-                            bottom_color_p.y = static_cast<int>(resPersAttrAndColor.bottom_color_point.y) * person.rows;
+                    // Define area around top color's location
+                    cv::Rect tc_rect;
+                    tc_rect.x = top_color_p.x - person.cols / 6;
+                    tc_rect.y = top_color_p.y - person.rows / 10;
+                    tc_rect.height = 2 * person.rows / 8;
+                    tc_rect.width = 2 * person.cols / 6;
 
+                    tc_rect = tc_rect & person_rect;
 
-                            cv::Rect person_rect(0, 0, person.cols, person.rows);
+                    // Define area around bottom color's location
+                    cv::Rect bc_rect;
+                    bc_rect.x = bottom_color_p.x - person.cols / 6;
+                    bc_rect.y = bottom_color_p.y - person.rows / 10;
+                    bc_rect.height =  2 * person.rows / 8;
+                    bc_rect.width = 2 * person.cols / 6;
 
-                            // Define area around top color's location
-                            cv::Rect tc_rect;
-                            tc_rect.x = top_color_p.x - person.cols / 6;
-                            tc_rect.y = top_color_p.y - person.rows / 10;
-                            tc_rect.height = 2 * person.rows / 8;
-                            tc_rect.width = 2 * person.cols / 6;
+                    bc_rect = bc_rect & person_rect;
 
-                            tc_rect = tc_rect & person_rect;
-
-                            // Define area around bottom color's location
-                            cv::Rect bc_rect;
-                            bc_rect.x = bottom_color_p.x - person.cols / 6;
-                            bc_rect.y = bottom_color_p.y - person.rows / 10;
-                            bc_rect.height =  2 * person.rows / 8;
-                            bc_rect.width = 2 * person.cols / 6;
+                    resPersAttrAndColor.top_color = PersonAttribsDetection::GetAvgColor(person(tc_rect));
+                    resPersAttrAndColor.bottom_color = PersonAttribsDetection::GetAvgColor(person(bc_rect));
+                }
 
-                            bc_rect = bc_rect & person_rect;
+                std::string resPersReid = "";
+                if (!personResults.reIdVector.empty()) {
+                    /* Check cosine similarity with all previously detected persons.
+                       If it's new person it is added to the global Reid vector and
+                       new global ID is assigned to the person. Otherwise, ID of
+                       matched person is assigned to it. Frames come in order, so IDs
+                       are assigned the same way as with synchronous inference. */
+                    auto foundId = personReId.findMatchingPerson(personResults.reIdVector);
+                    resPersReid = "REID: " + std::to_string(foundId);
+                }
 
-                            resPersAttrAndColor.top_color = PersonAttribsDetection::GetAvgColor(person(tc_rect));
-                            resPersAttrAndColor.bottom_color = PersonAttribsDetection::GetAvgColor(person(bc_rect));
-                        }
+                // --------------------------- Process outputs -----------------------------------------
+                if (!resPersAttrAndColor.attributes_strings.empty()) {
+                    cv::Rect image_area(0, 0, frame.cols, frame.rows);
+                    cv::Rect tc_label(location.x + location.width, location.y,
+                                      location.width / 4, location.height / 2);
+                    cv::Rect bc_label(location.x + location.width, location.y + location.height / 2,
+                                        location.width / 4, location.height / 2);
+
+                    if (shouldHandleTopBottomColors) {
+                        frame(tc_label & image_area) = resPersAttrAndColor.top_color;
+                        frame(bc_label & image_area) = resPersAttrAndColor.bottom_color;
                     }
 
-                    std::string resPersReid = "";
-                    if (personReId.enabled()) {
-                        // --------------------------- Run Person Reidentification -----------------------------
-                        if (FLAGS_auto_resize) {
-                            personReId.setRoiBlob(roiBlob);
+                    for (size_t i = 0; i < resPersAttrAndColor.attributes_strings.size(); ++i) {
+                        cv::Scalar color;
+                        if (resPersAttrAndColor.attributes_indicators[i]) {
+                            color = cv::Scalar(0, 200, 0); // has attribute
                         } else {
-                            personReId.enqueue(person);
+                            color = cv::Scalar(0, 0, 255); // doesn't have attribute
                         }
-
-                        t0 = std::chrono::high_resolution_clock::now();
-                        personReId.submitRequest();
-                        personReId.wait();
-                        t1 = std::chrono::high_resolution_clock::now();
-
-                        personReIdNetworktime += std::chrono::duration_cast<ms>(t1 - t0);
-                        personReIdInferred++;
-
-                        auto reIdVector = personReId.getReidVec();
-
-                        /* Check cosine similarity with all previously detected persons.
-                           If it's new person it is added to the global Reid vector and
-                           new global ID is assigned to the person. Otherwise, ID of
-                           matched person is assigned to it. */
-                        auto foundId = personReId.findMatchingPerson(reIdVector);
-                        resPersReid = "REID: " + std::to_string(foundId);
+                        putHighlightedText(frame,
+                                resPersAttrAndColor.attributes_strings[i],
+                                cv::Point2f(static_cast<float>(location.x + 5 * location.width / 4),
+                                            static_cast<float>(location.y + 15 + 15 * i)),
+                                cv::FONT_HERSHEY_COMPLEX_SMALL,
+                                0.5,
+                                color, 1);
                     }
 
-                    // --------------------------- Process outputs -----------------------------------------
-                    if (!resPersAttrAndColor.attributes_strings.empty()) {
-                        cv::Rect image_area(0, 0, frame.cols, frame.rows);
-                        cv::Rect tc_label(result.location.x + result.location.width, result.location.y,
-                                          result.location.width / 4, result.location.height / 2);
-                        cv::Rect bc_label(result.location.x + result.location.width, result.location.y + result.location.height / 2,
-                                            result.location.width / 4, result.location.height / 2);
-
+                    if (FLAGS_r) {
+                        std::string output_attribute_string;
+                        for (size_t i = 0; i < resPersAttrAndColor.attributes_strings.size(); ++i)
+                            if (resPersAttrAndColor.attributes_indicators[i])
+                                output_attribute_string += resPersAttrAndColor.attributes_strings[i] + ",";
+                        slog::debug << "Person Attributes results: " << output_attribute_string << slog::endl;
                         if (shouldHandleTopBottomColors) {
-                            frame(tc_label & image_area) = resPersAttrAndColor.top_color;
-                            frame(bc_label & image_area) = resPersAttrAndColor.bottom_color;
-                        }
-
-                        for (size_t i = 0; i < resPersAttrAndColor.attributes_strings.size(); ++i) {
-                            cv::Scalar color;
-                            if (resPersAttrAndColor.attributes_indicators[i]) {
-                                color = cv::Scalar(0, 200, 0); // has attribute
-                            } else {
-                                color = cv::Scalar(0, 0, 255); // doesn't have attribute
-                            }
-                            putHighlightedText(frame,
-                                    resPersAttrAndColor.attributes_strings[i],
-                                    cv::Point2f(static_cast<float>(result.location.x + 5 * result.location.width / 4),
-                                                static_cast<float>(result.location.y + 15 + 15 * i)),
-                                    cv::FONT_HERSHEY_COMPLEX_SMALL,
-                                    0.5,
-                                    color, 1);
-                        }
-
-                        if (FLAGS_r) {
-                            std::string output_attribute_string;
-                            for (size_t i = 0; i < resPersAttrAndColor.attributes_strings.size(); ++i)
-                                if (resPersAttrAndColor.attributes_indicators[i])
-                                    output_attribute_string += resPersAttrAndColor.attributes_strings[i] + ",";
-                            slog::debug << "Person Attributes results: " << output_attribute_string << slog::endl;
-                            if (shouldHandleTopBottomColors) {
-                                slog::debug << "Person top color: " << resPersAttrAndColor.top_color << slog::endl;
-                                slog::debug << "Person bottom color: " << resPersAttrAndColor.bottom_color << slog::endl;
-                            }
+                            slog::debug << "Person top color: " << resPersAttrAndColor.top_color << slog::endl;
+                            slog::debug << "Person bottom color: " << resPersAttrAndColor.bottom_color << slog::endl;
                         }
                     }
-                    if (!resPersReid.empty()) {
-                        putHighlightedText(frame,
-                                    resPersReid,
-                                    cv::Point2f(static_cast<float>(result.location.x), static_cast<float>(result.location.y + 30)),
-                                    cv::FONT_HERSHEY_COMPLEX_SMALL,
-                                    0.55,
-                                    cv::Scalar(250, 10, 10), 1);
-
-                        if (FLAGS_r) {
-                            slog::debug << "Person Re-Identification results: " << resPersReid << slog::endl;
-                        }
+                }
+                if (!resPersReid.empty()) {
+                    putHighlightedText(frame,
+                                resPersReid,
+                                cv::Point2f(static_cast<float>(location.x), static_cast<float>(location.y + 30)),
+                                cv::FONT_HERSHEY_COMPLEX_SMALL,
+                                0.55,
+                                cv::Scalar(250, 10, 10), 1);
+
+                    if (FLAGS_r) {
+                        slog::debug << "Person Re-Identification results: " << resPersReid << slog::endl;
                     }
-                    cv::rectangle(frame, result.location, cv::Scalar(0, 255, 0), 1);
                 }
+                cv::rectangle(frame, location, cv::Scalar(0, 255, 0), 1);
             }
 
             presenter.drawGraphs(frame);
-            metrics.update(startTime);
+            metrics.update(pendingFrame.startTime);
             // --------------------------- Execution statistics ------------------------------------------------
             std::ostringstream out;
-            out << "Detection time : " << std::fixed << std::setprecision(2) << detection.count()
-                << " ms (" << 1000.f / detection.count() << " fps)";
+            out << "Detection time : " << std::fixed << std::setprecision(2) << pendingFrame.detection.count()
+                << " ms (" << 1000.f / pendingFrame.detection.count() << " fps)";
 
             putHighlightedText(frame, out.str(), cv::Point2f(0, 20), cv::FONT_HERSHEY_COMPLEX_SMALL, 0.8, { 200, 10, 10 }, 2);
 
-            if (personDetection.results.size()) {
-                if (personAttribs.enabled() && personAttribsInferred) {
-                    float average_time = static_cast<float>(personAttribsNetworkTime.count() / personAttribsInferred);
+            if (!pendingFrame.persons.empty()) {
+                if (personAttribsQueue) {
+                    float average_time = static_cast<float>(personAttribsQueue->getLastTimePerRoi());
                     out.str("");
                     out << "Attributes Recognition time: " << std::fixed << std::setprecision(2) << average_time
                         << " ms (" << 1000.f / average_time << " fps)";
@@ -782,8 +769,8 @@ int main(int argc, char *argv[]) {
                         slog::debug << out.str() << slog::endl;
                     }
                 }
-                if (personReId.enabled() && personReIdInferred) {
-                    float average_time = static_cast<float>(personReIdNetworktime.count() / personReIdInferred);
+                if (personReIdQueue) {
+                    float average_time = static_cast<float>(personReIdQueue->getLastTimePerRoi());
                     out.str("");
                     out << "Re-Identification time: " << std::fixed << std::setprecision(2) << average_time
                         << " ms (" << 1000.f / average_time << " fps)";
@@ -801,12 +788,130 @@ int main(int argc, char *argv[]) {
                 cv::imshow("Detection results", frame);
                 const int key = cv::waitKey(1);
                 if (27 == key)  // Esc
-                    break;
+                    return false;
                 presenter.handleKey(key);
             }
+            return true;
+        };
+
+        // Renders pending frames in order, the oldest frame is waited for if more than maxLeft frames are pending
+        auto renderPendingFrames = [&](size_t maxLeft) {
+            while (!pendingFrames.empty()) {
+                PendingFrame& oldest = *pendingFrames.front();
+                if (oldest.pendingRois != 0) {
+                    if (pendingFrames.size() <= maxLeft) {
+                        return true;
+                    }
+                    // Partially filled batches may hold crops of the oldest frame
+                    if (personAttribsQueue) personAttribsQueue->flush();
+                    if (personReIdQueue) personReIdQueue->flush();
+                    std::unique_lock<std::mutex> lock(pendingFramesMutex);
+                    pendingFramesCondVar.wait(lock, [&oldest]{ return oldest.pendingRois == 0; });
+                }
+                const bool keepRunning = renderFrame(oldest);
+                pendingFrames.pop_front();
+                if (!keepRunning) {
+                    return false;
+                }
+            }
+            return true;
+        };
+
+        bool keepRunning = true;
+        do {
+            if (FLAGS_auto_resize) {
+                // just wrap Mat object with Blob::Ptr without additional memory allocation
+                frameBlob = wrapMat2Blob(frame);
+                personDetection.setRoiBlob(frameBlob);
+            } else {
+                personDetection.enqueue(frame);
+            }
+            // --------------------------- Run Person detection inference --------------------------------------
+            auto t0 = std::chrono::high_resolution_clock::now();
+            personDetection.submitRequest();
+            personDetection.wait();
+            auto t1 = std::chrono::high_resolution_clock::now();
+            // parse inference results internally (e.g. apply a threshold, etc)
+            personDetection.fetchResults();
+            // -------------------------------------------------------------------------------------------------
+
+            // --------------------------- Process the results down to the pipeline ----------------------------
+            std::shared_ptr<PendingFrame> pendingFrame = std::make_shared<PendingFrame>();
+            pendingFrame->frame = frame;
+            pendingFrame->startTime = startTime;
+            pendingFrame->detection = std::chrono::duration_cast<ms>(t1 - t0);
+            for (auto && result : personDetection.results) {
+                if (result.label == FLAGS_person_label) {  // person
+                    PersonResults personResults;
+                    personResults.location = result.location;
+                    personResults.crop = frame(result.location & cv::Rect(0, 0, frame.cols, frame.rows));
+                    pendingFrame->persons.push_back(personResults);
+                }
+            }
+            const size_t networksNum = (personAttribsQueue ? 1 : 0) + (personReIdQueue ? 1 : 0);
+            pendingFrame->pendingRois = pendingFrame->persons.size() * networksNum;
+            pendingFrames.push_back(pendingFrame);
+
+            for (size_t personIndex = 0; personIndex < pendingFrame->persons.size(); ++personIndex) {
+                const PersonResults& personResults = pendingFrame->persons[personIndex];
+                if (FLAGS_auto_resize) {
+                    const cv::Rect& location = personResults.location;
+                    cropRoi.posX = (location.x < 0) ? 0 : location.x;
+                    cropRoi.posY = (location.y < 0) ? 0 : location.y;
+                    cropRoi.sizeX = std::min((size_t) location.width, frame.cols - cropRoi.posX);
+                    cropRoi.sizeY = std::min((size_t) location.height, frame.rows - cropRoi.posY);
+                    roiBlob = make_shared_blob(frameBlob, cropRoi);
+                }
+
+                if (personAttribsQueue) {
+                    // --------------------------- Run Person Attributes Recognition -----------------------
+                    RoiInferQueue::ResultReader reader = [pendingFrame, personIndex, &personAttribs, &onRoiInferred]
+                            (InferenceEngine::InferRequest& request, size_t batchIndex) {
+                        try {
+                            pendingFrame->persons[personIndex].attributes = personAttribs.GetPersonAttributes(request, batchIndex);
+                        } catch (...) {
+                            onRoiInferred(*pendingFrame);
+                            throw;
+                        }
+                        onRoiInferred(*pendingFrame);
+                    };
+                    if (FLAGS_auto_resize) {
+                        personAttribsQueue->push(roiBlob, reader);
+                    } else {
+                        personAttribsQueue->push(personResults.crop, reader);
+                    }
+                }
+
+                if (personReIdQueue) {
+                    // --------------------------- Run Person Reidentification -----------------------------
+                    RoiInferQueue::ResultReader reader = [pendingFrame, personIndex, &personReId, &onRoiInferred]
+                            (InferenceEngine::InferRequest& request, size_t batchIndex) {
+                        try {
+                            pendingFrame->persons[personIndex].reIdVector = personReId.getReidVec(request, batchIndex);
+                        } catch (...) {
+                            onRoiInferred(*pendingFrame);
+                            throw;
+                        }
+                        onRoiInferred(*pendingFrame);
+                    };
+                    if (FLAGS_auto_resize) {
+                        personReIdQueue->push(roiBlob, reader);
+                    } else {
+                        personReIdQueue->push(personResults.crop, reader);
+                    }
+                }
+            }
+
+            keepRunning = renderPendingFrames(maxPendingFrames);
             startTime = std::chrono::steady_clock::now();
             frame = cap->read();
-        } while (frame.data);
+        } while (keepRunning && frame.data);
+
+        if (keepRunning) {
+            renderPendingFrames(0);
+        }
+        if (personAttribsQueue) personAttribsQueue->waitAll();
+        if (personReIdQueue) personReIdQueue->waitAll();
 
         slog::info << "Metrics report:" << slog::endl;
         metrics.logTotal();
@@ -51,8 +51,12 @@ static const char custom_cldnn_message[] = "Required for GPU custom kernels. "
 static const char custom_cpu_library_message[] = "Required for CPU custom layers. "
 "Absolute path to a shared library with the kernel implementations.";
 static const char thresh_output_message[] = "Optional. Probability threshold for poses filtering.";
+static const char coarse_decoding_message[] = "Optional. For 'openpose' models, upsample feature maps only around "
+"keypoint candidates instead of upsampling them as a whole. Decoding is much faster, keypoints may slightly differ.";
 static const char nireq_message[] = "Optional. Number of infer requests. If this option is omitted, number of infer requests is determined automatically.";
 static const char num_threads_message[] = "Optional. Number of threads.";
+static const char postproc_threads_message[] = "Optional. Number of threads postprocessing inference results in background. "
+"0 postprocesses them in the main loop. Default value is 0.";
 static const char num_streams_message[] = "Optional. Number of streams to use for inference on the CPU or/and GPU in "
 "throughput mode (for HETERO and MULTI device cases use format "
 "<device1>:<nstreams1>,<device2>:<nstreams2> or just <nstreams>)";
@@ -69,8 +73,10 @@ DEFINE_string(d, "CPU", target_device_message);
 DEFINE_string(c, "", custom_cldnn_message);
 DEFINE_string(l, "", custom_cpu_library_message);
 DEFINE_double(t, 0.1, thresh_output_message);
+DEFINE_bool(coarse_decoding, false, coarse_decoding_message);
 DEFINE_uint32(nireq, 0, nireq_message);
 DEFINE_uint32(nthreads, 0, num_threads_message);
+DEFINE_uint32(postproc_threads, 0, postproc_threads_message);
 DEFINE_string(nstreams, "", num_streams_message);
 DEFINE_bool(no_show, false, no_show_message);
 DEFINE_string(u, "", utilization_monitors_message);
@@ -96,8 +102,10 @@ static void showUsage() {
     std::cout << "      -c \"<absolute_path>\"    " << custom_cldnn_message << std::endl;
     std::cout << "    -d \"<device>\"             " << target_device_message << std::endl;
     std::cout << "    -t                        " << thresh_output_message << std::endl;
+    std::cout << "    -coarse_decoding          " << coarse_decoding_message << std::endl;
     std::cout << "    -nireq \"<integer>\"        " << nireq_message << std::endl;
     std::cout << "    -nthreads \"<integer>\"     " << num_threads_message << std::endl;
+    std::cout << "    -postproc_threads \"<integer>\" " << postproc_threads_message << std::endl;
     std::cout << "    -nstreams                 " << num_streams_message << std::endl;
     std::cout << "    -loop                     " << loop_message << std::endl;
     std::cout << "    -no_show                  " << no_show_message << std::endl;
@@ -216,7 +224,8 @@ int main(int argc, char *argv[]) {
         }
 
         //------------------------------- Preparing Input ------------------------------------------------------
-        auto cap = openImagesCapture(FLAGS_i, FLAGS_loop);
+        // Frames are decoded ahead on background threads while the pipeline runs inference
+        auto cap = openImagesCapture(FLAGS_i, FLAGS_loop, 0, std::numeric_limits<size_t>::max(), {1280, 720}, 4);
         auto startTime = std::chrono::steady_clock::now();
         cv::Mat curr_frame = cap->read();
         if (curr_frame.empty()) {
@@ -246,7 +255,7 @@ int main(int argc, char *argv[]) {
         double aspectRatio = curr_frame.cols / static_cast<double>(curr_frame.rows);
         std::unique_ptr<ModelBase> model;
         if (FLAGS_at == "openpose") {
-            model.reset(new HPEOpenPose(FLAGS_m, aspectRatio, FLAGS_tsize, (float)FLAGS_t));
+            model.reset(new HPEOpenPose(FLAGS_m, aspectRatio, FLAGS_tsize, (float)FLAGS_t, FLAGS_coarse_decoding));
         }
         else if (FLAGS_at == "ae") {
             model.reset(new HpeAssociativeEmbedding(FLAGS_m, aspectRatio, FLAGS_tsize, (float)FLAGS_t));
@@ -263,9 +272,11 @@ int main(int argc, char *argv[]) {
         slog::info << *InferenceEngine::GetInferenceEngineVersion() << slog::endl;
 
         InferenceEngine::Core core;
+        PostprocessingParams postprocessing;
+        postprocessing.threadsNum = FLAGS_postproc_threads;
         AsyncPipeline pipeline(std::move(model),
             ConfigFactory::getUserConfig(FLAGS_d, FLAGS_l, FLAGS_c, FLAGS_nireq, FLAGS_nstreams, FLAGS_nthreads),
-            core);
+            core, AsyncPipeline::OutputsOwnership::Copy, BatchingParams(), postprocessing);
         Presenter presenter(FLAGS_u);
 
         int64_t frameNum = pipeline.submitData(ImageInputData(curr_frame),
@@ -343,9 +354,9 @@ int main(int argc, char *argv[]) {
 
         slog::info << "Metrics report:" << slog::endl;
         metrics.logTotal();
-        logLatencyPerStage(cap->getMetrics().getTotal().latency, pipeline.getPreprocessMetrics().getTotal().latency,
-            pipeline.getInferenceMetircs().getTotal().latency, pipeline.getPostprocessMetrics().getTotal().latency,
-            renderMetrics.getTotal().latency);
+        logLatencyPerStage(cap->getMetrics(), pipeline.getPreprocessMetrics(),
+            pipeline.getInferenceMetircs(), pipeline.getPostprocessMetrics(), renderMetrics);
+        pipeline.logQueueMetrics();
 
         slog::info << presenter.reportMeans() << slog::endl;
     }
@@ -163,7 +163,8 @@ int main(int argc, char *argv[]) {
         }
 
         //------------------------------- Preparing Input ------------------------------------------------------
-        auto cap = openImagesCapture(FLAGS_i, FLAGS_loop);
+        // Frames are decoded ahead on background threads while the pipeline runs inference
+        auto cap = openImagesCapture(FLAGS_i, FLAGS_loop, 0, std::numeric_limits<size_t>::max(), {1280, 720}, 4);
         cv::Mat curr_frame;
 
         auto startTime = std::chrono::steady_clock::now();
@@ -350,9 +351,8 @@ int main(int argc, char *argv[]) {
 
         slog::info << "Metrics report:" << slog::endl;
         metrics.logTotal();
-        logLatencyPerStage(cap->getMetrics().getTotal().latency, pipeline.getPreprocessMetrics().getTotal().latency,
-            pipeline.getInferenceMetircs().getTotal().latency, pipeline.getPostprocessMetrics().getTotal().latency,
-            renderMetrics.getTotal().latency);
+        logLatencyPerStage(cap->getMetrics(), pipeline.getPreprocessMetrics(),
+            pipeline.getInferenceMetircs(), pipeline.getPostprocessMetrics(), renderMetrics);
         slog::info << presenter.reportMeans() << slog::endl;
 
     }
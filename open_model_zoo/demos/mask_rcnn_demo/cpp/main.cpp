@@ -165,9 +165,7 @@ int main(int argc, char *argv[]) {
 
             /** Fill first input tensor with images. First b channel, then g and r channels **/
             if (inputInfoItem.second->getTensorDesc().getDims().size() == 4) {
-                /** Iterate over all input images **/
-                for (size_t image_id = 0; image_id < images.size(); ++image_id)
-                    matToBlob(images[image_id], input, image_id);
+                matToBlob(images, input);
             }
 
             /** Fill second input tensor with image info **/
@@ -11,16 +11,28 @@
 #include <array>
 #include <cassert>
 #include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <exception>
 #include <functional>
 #include <limits>
+#include <map>
 #include <memory>
 #include <stdexcept>
 #include <sstream>
 #include <thread>
 #include <type_traits>
+#include <unordered_map>
 #include <vector>
 #include <utility>
 
+#include <utils/frame_pool.hpp>
+
+#ifdef USE_TBB
+#include "threading.hpp"
+#endif
+
 #ifdef USE_LIBVA
 #include <dlfcn.h>
 
@@ -878,6 +890,202 @@ struct Decoder::HwContext {
 
 #endif
 
+// Decodes frames on a fixed set of threads, or in the shared TBB arena in TBB builds. Frames of a stream
+// may be decoded in parallel, results are reordered and the callbacks of a stream are called one at a time
+struct Decoder::PoolContext {
+    using clock = std::chrono::high_resolution_clock;
+
+    struct Task {
+        const void* data;
+        size_t size;
+        unsigned width;
+        unsigned height;
+        const void* stream;
+        uint64_t seq;
+        clock::time_point start_time;
+        callback_t callback;
+    };
+
+    struct Result {
+        cv::Mat img;
+        clock::time_point start_time;
+        callback_t callback;
+    };
+
+    struct StreamState {
+        uint64_t next_seq = 0;
+        uint64_t next_delivery = 0;
+        bool delivering = false;
+        std::map<uint64_t, Result> ready;
+        std::exception_ptr error;  // thrown by decoding or by a callback, rethrown by the next enqueue()
+    };
+
+    const Decoder& decoder;
+    const size_t max_in_flight;
+
+    std::mutex mutex;
+    std::condition_variable has_space;
+    std::unordered_map<const void*, StreamState> streams;
+    size_t in_flight = 0;
+    PerfTimer perf_timer_decode;
+
+#ifndef USE_TBB
+    std::condition_variable has_task;
+    std::deque<Task> tasks;
+    bool stopped = false;
+    std::vector<std::thread> workers;
+#endif
+
+    PoolContext(const Decoder& d, const Settings& settings):
+        decoder(d),
+        max_in_flight(std::max<size_t>(settings.num_buffers, 1)),
+        perf_timer_decode(settings.collect_stats ? PerfTimer::DefaultIterationsCount : 0) {
+#ifndef USE_TBB
+        size_t threads_num = settings.num_threads;
+        if (0 == threads_num) {
+            threads_num = std::max(std::thread::hardware_concurrency(), 1u);
+        }
+        workers.reserve(threads_num);
+        for (size_t i = 0; i < threads_num; ++i) {
+            workers.emplace_back(&PoolContext::work, this);
+        }
+#endif
+    }
+
+    ~PoolContext() {
+        {
+            std::unique_lock<std::mutex> lock(mutex);
+            // Callbacks of enqueued frames are delivered, callers may wait for them
+            has_space.wait(lock, [&]() { return 0 == in_flight; });
+#ifndef USE_TBB
+            stopped = true;
+#endif
+        }
+#ifndef USE_TBB
+        has_task.notify_all();
+        for (auto& worker : workers) {
+            worker.join();
+        }
+#endif
+    }
+
+    void enqueue(const void* data, size_t size, unsigned width, unsigned height,
+                 const void* stream, callback_t callback) {
+        Task task;
+        {
+            std::unique_lock<std::mutex> lock(mutex);
+            has_space.wait(lock, [&]() { return in_flight < max_in_flight; });
+            StreamState& state = streams[stream];
+            if (state.error) {
+                std::exception_ptr error = state.error;
+                state.error = nullptr;
+                std::rethrow_exception(error);
+            }
+            ++in_flight;
+            const uint64_t seq = state.next_seq++;
+            task = Task{data, size, width, height, stream, seq, clock::now(), std::move(callback)};
+#ifndef USE_TBB
+            tasks.push_back(std::move(task));
+#endif
+        }
+#ifdef USE_TBB
+        // Decoding shares the arena with the rest of the demo instead of adding threads
+        get_tbb_arena().enqueue([this, task]() mutable { process(std::move(task)); });
+#else
+        has_task.notify_one();
+#endif
+    }
+
+#ifndef USE_TBB
+    void work() {
+        std::unique_lock<std::mutex> lock(mutex);
+        while (true) {
+            has_task.wait(lock, [&]() { return !tasks.empty() || stopped; });
+            if (tasks.empty()) {
+                return;
+            }
+            Task task = std::move(tasks.front());
+            tasks.pop_front();
+
+            lock.unlock();
+            process(std::move(task));
+            lock.lock();
+        }
+    }
+#endif
+
+    void process(Task task) {
+        cv::Mat img;
+        std::exception_ptr error;
+        try {
+            img = decoder.decode_sw(task.data, task.size, task.width, task.height);
+        } catch (const cv::Exception&) {
+            // An empty image reports the corrupted frame to the callback
+        } catch (...) {
+            // The callback still gets an empty image, so the stream doesn't wait for the frame forever
+            error = std::current_exception();
+        }
+        std::unique_lock<std::mutex> lock(mutex);
+
+        StreamState& state = streams[task.stream];
+        if (error && !state.error) {
+            state.error = error;
+        }
+        state.ready.emplace(task.seq, Result{std::move(img), task.start_time, std::move(task.callback)});
+        if (!state.delivering) {
+            deliver(state, lock);
+        }
+    }
+
+    // The thread which finds the next frame of a stream delivers all consecutive ready frames of it
+    void deliver(StreamState& state, std::unique_lock<std::mutex>& lock) {
+        state.delivering = true;
+        while (!state.ready.empty() && state.ready.begin()->first == state.next_delivery) {
+            Result result = std::move(state.ready.begin()->second);
+            state.ready.erase(state.ready.begin());
+            if (perf_timer_decode.enabled()) {
+                perf_timer_decode.addValue(clock::now() - result.start_time);
+            }
+
+            lock.unlock();
+            std::exception_ptr error;
+            try {
+                result.callback(std::move(result.img));
+            } catch (...) {
+                error = std::current_exception();
+            }
+            result.callback = nullptr;  // release captured resources outside the lock
+            lock.lock();
+
+            if (error && !state.error) {
+                state.error = error;
+            }
+            ++state.next_delivery;
+            --in_flight;
+            has_space.notify_all();
+        }
+        state.delivering = false;
+        has_space.notify_all();
+    }
+
+    void close(const void* stream) {
+        std::unique_lock<std::mutex> lock(mutex);
+        auto it = streams.find(stream);
+        if (it == streams.end()) {
+            return;
+        }
+        // Frames in flight refer to the state
+        has_space.wait(lock, [&]() {
+            return it->second.next_delivery == it->second.next_seq && !it->second.delivering;
+        });
+        streams.erase(it);
+    }
+
+    float getLatency() const {
+        return perf_timer_decode.getValue();
+    }
+};
+
 Decoder::Decoder(const Settings& s):
     settings(s) {
     if (Mode::Hw == settings.mode) {
@@ -887,6 +1095,9 @@ Decoder::Decoder(const Settings& s):
         throw std::logic_error("Hardware decoding is not supported");
 #endif
     }
+    if (Mode::Async == settings.mode) {
+        pool_context.reset(new PoolContext(*this, settings));
+    }
 }
 
 Decoder::~Decoder() {
@@ -898,13 +1109,62 @@ Decoder::Stats Decoder::getStats() const {
         return {hw_context->getLatency()};
     }
 #endif
+    if (nullptr != pool_context) {
+        Stats stats;
+        stats.decoding_latency = pool_context->getLatency();
+        return stats;
+    }
     return {};
 }
 
+cv::Mat Decoder::decode_sw(const void* data, size_t size, unsigned width, unsigned height) const {
+    const cv::Mat buf(1, static_cast<int>(size), CV_8UC1, const_cast<void*>(data));
+    const cv::Size output_size(static_cast<int>(settings.output_width), static_cast<int>(settings.output_height));
+    const bool resize = output_size.area() > 0;
+
+    // libjpeg scales while doing IDCT, which is much cheaper than decoding the full frame and
+    // resizing it. Reduce as much as possible without getting smaller than the output
+    static const std::pair<unsigned, int> reductions[] = {
+        {8, cv::IMREAD_REDUCED_COLOR_8}, {4, cv::IMREAD_REDUCED_COLOR_4}, {2, cv::IMREAD_REDUCED_COLOR_2}};
+    int flags = cv::IMREAD_COLOR;
+    for (const auto& reduction : reductions) {
+        if (resize && width / reduction.first >= settings.output_width
+                && height / reduction.first >= settings.output_height) {
+            flags = reduction.second;
+            break;
+        }
+    }
+
+    // Frames are decoded and resized into pooled buffers, which return to the pool when consumers release them
+    cv::Mat decoded;
+    decoded.allocator = &FramePool::getInstance();
+    cv::imdecode(buf, flags, &decoded);
+    if (!resize || decoded.empty() || decoded.size() == output_size) {
+        return decoded;
+    }
+    cv::Mat resized;
+    resized.allocator = &FramePool::getInstance();
+    cv::resize(decoded, resized, output_size, 0, 0, cv::INTER_AREA);
+    return resized;
+}
+
+void Decoder::closeStream(const void* stream) {
+    if (nullptr != pool_context) {
+        pool_context->close(stream);
+    }
+}
+
+void Decoder::decode_async(const void* data, size_t size, unsigned width,
+                           unsigned height, const void* stream, callback_t callback) {
+    assert(nullptr != pool_context);
+    pool_context->enqueue(data, size, width, height, stream, std::move(callback));
+}
+
 #ifdef USE_LIBVA
 void Decoder::decode_hw(const void* data, size_t size, unsigned width,
                         unsigned height, callback_t callback) {
     assert(nullptr != hw_context);
+    std::lock_guard<std::mutex> lock(hw_mutex);
     hw_context->decode(data, size, width, height, std::move(callback));
 }
 #endif
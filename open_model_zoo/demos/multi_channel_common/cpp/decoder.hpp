@@ -7,15 +7,12 @@
 #include <cassert>
 #include <functional>
 #include <memory>
+#include <mutex>
 #include <type_traits>
 #include <utility>
 
 #include <opencv2/opencv.hpp>
 
-#ifdef USE_TBB
-#include "threading.hpp"
-#endif
-
 class Decoder final {
 public:
     enum class Mode {
@@ -26,9 +23,14 @@ public:
 
     struct Settings {
         Mode mode = Mode::Immediate;
+        // Decoded frames are resized to this size, 0 keeps the size of the stream.
+        // Software decoding of JPEG skips detail lost by the resize with reduced IDCT
         unsigned output_width = 0;
         unsigned output_height = 0;
+        // Async mode: at most this number of frames of all streams are decoded or wait for the delivery
         unsigned num_buffers = 1;
+        // Async mode: decoding threads, 0 - one per hardware thread. TBB builds decode in the shared arena instead
+        unsigned num_threads = 0;
         bool collect_stats = false;
     };
 
@@ -43,9 +45,16 @@ public:
 
     Stats getStats() const;
 
+    /// Decodes a JPEG frame and passes the result to the callback, an empty Mat if decoding failed.
+    /// Async mode calls callbacks on decoding threads, callbacks of the same stream are called
+    /// one at a time in the order of decode() calls. decode() blocks while the decoder has num_buffers
+    /// frames in flight, data must stay valid until the callback is called.
+    /// Decoder is thread-safe, different streams may be decoded from different threads.
+    /// In Async mode, an exception thrown while decoding a frame or by its callback
+    /// is rethrown by the next decode() of the same stream
     template<typename F>
     void decode(const void* data, size_t size, unsigned width, unsigned height,
-                F&& callback) {
+                F&& callback, const void* stream = nullptr) {
         assert(nullptr != data);
         assert(size > 0);
         assert(width > 0);
@@ -53,33 +62,13 @@ public:
 
         auto mode = settings.mode;
         if (Mode::Immediate == mode) {
-            auto img = cv::imdecode(
-            {static_cast<const char*>(data),
-             static_cast<int>(size)},
-                           cv::IMREAD_COLOR);
-            callback(std::move(img));
+            callback(decode_sw(data, size, width, height));
         } else if (Mode::Async == mode) {
-#ifdef USE_TBB
-            auto decode = [data, size, c = std::move(callback), this]() mutable {
-                auto img = cv::imdecode(
-                {static_cast<const char*>(data),
-                 static_cast<int>(size)},
-                            cv::IMREAD_COLOR);
-                c(std::move(img));
-            };
-            auto& arena = get_tbb_arena();
-            arena.enqueue(std::move(decode));
-#else
-            throw std::logic_error("Async decoding is not supported");
-#endif
+            decode_async(data, size, width, height, stream, make_copyable(std::move(callback)));
         } else if (Mode::Hw == mode) {
 #ifdef USE_LIBVA
-            auto decode = [data, size, c = std::move(callback), this]
-                          (cv::Mat&& img) mutable {
-                c(std::move(img));
-            };
             decode_hw(data, size, width, height,
-                      make_copyable(std::move(decode)));
+                      make_copyable(std::move(callback)));
 #else
             assert(false);
 #endif
@@ -88,10 +77,13 @@ public:
         }
     }
 
+    /// Waits for frames of the stream which are in flight and releases its state.
+    /// An exception which wasn't rethrown by decode() yet is dropped
+    void closeStream(const void* stream);
+
 private:
     const Settings settings;
-#ifdef USE_LIBVA
-    struct HwContext;
+
     template<typename T>
     struct MoveHack {
         union {
@@ -121,7 +113,18 @@ private:
 
     using callback_t = std::function<void(cv::Mat&&)>;
 
+    cv::Mat decode_sw(const void* data, size_t size, unsigned width, unsigned height) const;
+
+    struct PoolContext;
+    std::unique_ptr<PoolContext> pool_context;
+
+    void decode_async(const void* data, size_t size, unsigned width,
+                      unsigned height, const void* stream, callback_t callback);
+
+#ifdef USE_LIBVA
+    struct HwContext;
     std::unique_ptr<HwContext> hw_context;
+    std::mutex hw_mutex;
 
     void decode_hw(const void* data, size_t size, unsigned width,
                    unsigned height, callback_t callback);
@@ -9,6 +9,8 @@
 #include <utility>
 #include <vector>
 
+#include <utils/hwc_to_chw.hpp>
+
 #include "graph.hpp"
 #include "threading.hpp"
 
@@ -16,28 +18,6 @@
 #include <tbb/parallel_for.h>
 #endif
 
-namespace {
-
-void loadImgToIEGraph(const cv::Mat& img, size_t batch, void* ieBuffer) {
-    const int channels = img.channels();
-    const int height = img.rows;
-    const int width = img.cols;
-
-    float* ieData = reinterpret_cast<float*>(ieBuffer);
-    int bOffset = static_cast<int>(batch) * channels * width * height;
-    for (int c = 0; c < channels; c++) {
-        int cOffset = c * width * height;
-        for (int w = 0; w < width; w++) {
-            for (int h = 0; h < height; h++) {
-                ieData[bOffset + cOffset + h * width + w] =
-                        static_cast<float>(img.at<cv::Vec3b>(h, w)[c]);
-            }
-        }
-    }
-}
-
-}  // namespace
-
 void IEGraph::initNetwork(const std::string& deviceName) {
     auto cnnNetwork = ie.ReadNetwork(modelPath);
 
@@ -85,113 +65,236 @@ void IEGraph::initNetwork(const std::string& deviceName) {
         outputDataBlobNames.push_back(i.first);
     }
 
+    batchRequests.resize(maxRequests);
     for (size_t i = 0; i < maxRequests; ++i) {
-        auto req = std::make_shared<InferenceEngine::InferRequest>(executableNetwork.CreateInferRequest());
-        availableRequests.push(req);
+        batchRequests[i].req = std::make_shared<InferenceEngine::InferRequest>(executableNetwork.CreateInferRequest());
     }
 
     if (postLoad != nullptr)
         postLoad(outputDataBlobNames, cnnNetwork);
 
-    availableRequests.front()->StartAsync();
-    availableRequests.front()->Wait(InferenceEngine::InferRequest::WaitMode::RESULT_READY);
+    batchRequests.front().req->StartAsync();
+    batchRequests.front().req->Wait(InferenceEngine::InferRequest::WaitMode::RESULT_READY);
+
+    for (size_t i = 0; i < maxRequests; ++i) {
+        batchRequests[i].req->SetCompletionCallback([this, i]{ onRequestCompleted(i); });
+        availableRequests.push(i);
+    }
 }
 
-void IEGraph::start(GetterFunc getterFunc, PostprocessingFunc postprocessingFunc) {
+void IEGraph::start(GetterFunc getterFunc, PostprocessingFunc postprocessingFunc, std::vector<SinkFunc> sinks,
+                    cv::Size displayFrameSize) {
     assert(nullptr != getterFunc);
     assert(nullptr != postprocessingFunc);
     assert(nullptr == getter);
+    assert(!sinks.empty());
     getter = std::move(getterFunc);
     postprocessing = std::move(postprocessingFunc);
-    getterThread = std::thread([&]() {
-        std::vector<std::shared_ptr<VideoFrame>> vframes;
-        std::vector<cv::Mat> imgsToProc(batchSize);
-        while (!terminate) {
-            vframes.clear();
-            size_t b = 0;
-            while (b != batchSize) {
-                VideoFrame vframe;
-                if (getter(vframe)) {
-                    vframes.push_back(std::make_shared<VideoFrame>(vframe));
-                    ++b;
-                } else {
-                    terminate = true;
-                    break;
-                }
+    frameSize = displayFrameSize;
+
+    for (auto& sink : sinks) {
+        channels.emplace_back(new Channel);
+        channels.back()->sink = std::move(sink);
+    }
+    batcherStopped = false;
+    batcherThread = std::thread(&IEGraph::assembleBatches, this);
+    for (size_t i = 0; i < channels.size(); ++i) {
+        channels[i]->feederThread = std::thread(&IEGraph::feedChannel, this, i);
+    }
+}
+
+void IEGraph::feedChannel(size_t channel) {
+    auto& frames = channels[channel]->frames;
+    while (!inputStopped) {
+        auto vframe = std::make_shared<VideoFrame>();
+        if (!getter(channel, *vframe)) {
+            // when one of the channels is out of frames, the whole input is stopped
+            stop();
+            break;
+        }
+        vframe->sourceIdx = channel;
+        if (!frames.tryPush(vframe)) {
+            // The queue is full. The batcher takes the lock to notify only when there are waiters, and
+            // the waiter is counted before the queue is checked again, so the notification is not lost
+            std::unique_lock<std::mutex> lock(mtx);
+            ++spaceWaiters;
+            std::atomic_thread_fence(std::memory_order_seq_cst);
+            condVarQueuesSpace.wait(lock, [&]() {
+                return inputStopped || frames.tryPush(vframe);
+            });
+            --spaceWaiters;
+            if (inputStopped) {
+                break;
             }
+        }
+        ++pendingFrames;
+        if (batcherWaiting) {
+            // The batcher sets the flag and checks pendingFrames under the lock, so once the lock is taken
+            // the batcher either waits or has seen the frame
+            { std::lock_guard<std::mutex> lock(mtx); }
+            condVarFrames.notify_one();
+        }
+    }
+}
 
-            InferenceEngine::InferRequest::Ptr req;
-            {
-                std::unique_lock<std::mutex> lock(mtxAvalableRequests);
-                condVarAvailableRequests.wait(lock, [&]() {
-                    return !availableRequests.empty() || terminate;
-                });
-                if (terminate) {
-                    break;
+bool IEGraph::collectBatch(std::vector<std::shared_ptr<VideoFrame>>& vframes) {
+    std::chrono::steady_clock::time_point deadline;
+    while (vframes.size() < batchSize) {
+        // Channels are visited round robin starting from the next one every time, so a fast channel
+        // can't take the whole batch
+        std::ptrdiff_t popped = 0;
+        for (size_t i = 0; i < channels.size() && vframes.size() < batchSize; ++i) {
+            std::shared_ptr<VideoFrame> vframe;
+            if (channels[(firstChannel + i) % channels.size()]->frames.tryPop(vframe)) {
+                if (vframes.empty()) {
+                    deadline = std::chrono::steady_clock::now() + maxWaitTime;
                 }
-                req = std::move(availableRequests.front());
-                availableRequests.pop();
+                vframes.push_back(std::move(vframe));
+                ++popped;
+            }
+        }
+        firstChannel = (firstChannel + 1) % channels.size();
+
+        if (popped > 0) {
+            pendingFrames -= popped;
+            std::atomic_thread_fence(std::memory_order_seq_cst);
+            if (spaceWaiters > 0) {
+                { std::lock_guard<std::mutex> lock(mtx); }
+                condVarQueuesSpace.notify_all();
             }
+            continue;
+        }
+        std::unique_lock<std::mutex> lock(mtx);
+        batcherWaiting = true;
+        auto isReady = [&]() { return pendingFrames > 0 || inputStopped; };
+        bool ready = true;
+        if (vframes.empty()) {
+            condVarFrames.wait(lock, isReady);
+        } else {
+            ready = condVarFrames.wait_until(lock, deadline, isReady);
+        }
+        batcherWaiting = false;
+        if (!ready || inputStopped) {
+            break;  // submit incomplete batch or stop
+        }
+    }
+    return !vframes.empty() && !inputStopped;
+}
 
-            auto inputBlob = req->GetBlob(inputDataBlobName);
-            imgsToProc.resize(batchSize);
-            for (size_t i = 0; i < batchSize; i++) {
-                if (imgsToProc[i].empty()) {
-                    auto& dims = inputBlob->getTensorDesc().getDims();
-                    assert(4 == dims.size());
-                    auto height = static_cast<int>(dims[2]);
-                    auto width  = static_cast<int>(dims[3]);
-                    imgsToProc[i] = cv::Mat(height, width, CV_8UC3);
-                }
+void IEGraph::assembleBatches() {
+    while (!inputStopped) {
+        size_t requestIdx;
+        {
+            std::unique_lock<std::mutex> lock(mtx);
+            condVarAvailableRequests.wait(lock, [&]() {
+                return !availableRequests.empty() || inputStopped;
+            });
+            if (availableRequests.empty()) {
+                break;
             }
+            requestIdx = availableRequests.front();
+            availableRequests.pop();
+        }
 
-            auto preprocess = [&]() {
-                InferenceEngine::LockedMemory<void> buff = InferenceEngine::as<
-                    InferenceEngine::MemoryBlob>(inputBlob)->wmap();
-                float* inputPtr = static_cast<float*>(buff);
-                auto loopBody = [&](size_t i) {
-                    cv::resize(vframes[i]->frame,
-                               imgsToProc[i],
-                               imgsToProc[i].size());
-                    loadImgToIEGraph(imgsToProc[i], i, inputPtr);
-                };
+        // Frames are taken only when there is a request for them, so they are as fresh as possible
+        auto& vframes = batchRequests[requestIdx].vfPtrVec;
+        if (!collectBatch(vframes)) {
+            vframes.clear();
+            std::lock_guard<std::mutex> lock(mtx);
+            availableRequests.push(requestIdx);
+            break;
+        }
+        startRequest(requestIdx);
+    }
+    {
+        std::lock_guard<std::mutex> lock(mtx);
+        batcherStopped = true;
+    }
+    condVarStopped.notify_all();
+}
+
+void IEGraph::startRequest(size_t requestIdx) {
+    auto& batchRequest = batchRequests[requestIdx];
+    auto inputBlob = batchRequest.req->GetBlob(inputDataBlobName);
+    auto& dims = inputBlob->getTensorDesc().getDims();
+    assert(4 == dims.size());
+    const cv::Size inputSize(static_cast<int>(dims[3]), static_cast<int>(dims[2]));
+    imgsToProc.resize(batchSize);
+
+    // Slots of incomplete batch keep data of previous frames, their outputs are just ignored
+    auto preprocess = [&]() {
+        InferenceEngine::LockedMemory<void> buff = InferenceEngine::as<
+            InferenceEngine::MemoryBlob>(inputBlob)->wmap();
+        float* inputPtr = static_cast<float*>(buff);
+        auto loopBody = [&](size_t i) {
+            cv::resize(batchRequest.vfPtrVec[i]->frame, imgsToProc[i], inputSize);
+        };
 #ifdef USE_TBB
-                run_in_arena([&](){
-                    tbb::parallel_for<size_t>(0, batchSize, loopBody);
-                });
+        run_in_arena([&](){
+            tbb::parallel_for<size_t>(0, batchRequest.vfPtrVec.size(), loopBody);
+        });
 #else
-                for (size_t i = 0; i < batchSize; i++) {
-                    loopBody(i);
-                }
+        for (size_t i = 0; i < batchRequest.vfPtrVec.size(); i++) {
+            loopBody(i);
+        }
 #endif
-            };
+        hwcToChw(std::vector<cv::Mat>(imgsToProc.begin(), imgsToProc.begin() + batchRequest.vfPtrVec.size()),
+            inputPtr);
+    };
+
+    if (perfTimerInfer.enabled()) {
+        {
+            ScopedTimer st(perfTimerPreprocess);
+            preprocess();
+        }
+        batchRequest.startTime = std::chrono::high_resolution_clock::now();
+    } else {
+        preprocess();
+    }
+    {
+        std::lock_guard<std::mutex> lock(mtx);
+        ++busyRequestsNum;
+    }
+    batchRequest.req->StartAsync();
+}
 
-            if (perfTimerInfer.enabled()) {
-                {
-                    ScopedTimer st(perfTimerPreprocess);
-                    preprocess();
-                }
-                auto startTime = std::chrono::high_resolution_clock::now();
-                req->StartAsync();
-                std::unique_lock<std::mutex> lock(mtxBusyRequests);
-                busyBatchRequests.push({std::move(vframes), std::move(req), startTime});
-            } else {
-                preprocess();
-                req->StartAsync();
-                std::unique_lock<std::mutex> lock(mtxBusyRequests);
-                busyBatchRequests.push({std::move(vframes), std::move(req),
-                                    std::chrono::high_resolution_clock::time_point()});
+void IEGraph::onRequestCompleted(size_t requestIdx) {
+    auto& batchRequest = batchRequests[requestIdx];
+    try {
+        auto detections = postprocessing(batchRequest.req, outputDataBlobNames, frameSize);
+        if (perfTimerInfer.enabled()) {
+            auto endTime = std::chrono::high_resolution_clock::now();
+            std::lock_guard<std::mutex> lock(mtx);
+            perfTimerInfer.addValue(endTime - batchRequest.startTime);
+        }
+        for (size_t i = 0; i < batchRequest.vfPtrVec.size() && i < detections.size(); i++) {
+            auto& vframe = batchRequest.vfPtrVec[i];
+            vframe->detections = std::move(detections[i]);
+            channels[vframe->sourceIdx]->sink(std::move(vframe));
+        }
+    } catch (...) {
+        {
+            std::lock_guard<std::mutex> lock(mtx);
+            if (!callbackException) {
+                callbackException = std::current_exception();
             }
-            condVarBusyRequests.notify_one();
         }
-        condVarBusyRequests.notify_one(); // notify that there will be no new InferRequests
-    });
+        stop();
+    }
+    batchRequest.vfPtrVec.clear();
+
+    std::lock_guard<std::mutex> lock(mtx);
+    availableRequests.push(requestIdx);
+    --busyRequestsNum;
+    // Notified under the lock, because the graph may be destroyed right after the last request is released
+    condVarAvailableRequests.notify_one();
+    condVarStopped.notify_all();
 }
 
 IEGraph::IEGraph(const InitParams& p):
     perfTimerPreprocess(p.collectStats ? PerfTimer::DefaultIterationsCount : 0),
     perfTimerInfer(p.collectStats ? PerfTimer::DefaultIterationsCount : 0),
-    confidenceThreshold(0.5f), batchSize(p.batchSize),
+    confidenceThreshold(0.5f), batchSize(p.batchSize), maxWaitTime(p.maxWaitTime),
     modelPath(p.modelPath),
     cpuExtensionPath(p.cpuExtPath), cldnnConfigPath(p.cldnnConfigPath),
     maxRequests(p.maxRequests) {
@@ -201,55 +304,37 @@ IEGraph::IEGraph(const InitParams& p):
     initNetwork(p.deviceName);
 }
 
-bool IEGraph::isRunning() {
-    std::lock_guard<std::mutex> lock(mtxBusyRequests);
-    return !terminate || !busyBatchRequests.empty();
-}
-
-InferenceEngine::SizeVector IEGraph::getInputDims() const {
-    assert(!availableRequests.empty());
-    auto inputBlob = availableRequests.front()->GetBlob(inputDataBlobName);
-    return inputBlob->getTensorDesc().getDims();
-}
-
-std::vector<std::shared_ptr<VideoFrame>> IEGraph::getBatchData(cv::Size frameSize) {
-    std::vector<std::shared_ptr<VideoFrame>> vframes;
-    InferenceEngine::InferRequest::Ptr req;
-    std::chrono::high_resolution_clock::time_point startTime;
+void IEGraph::stop() {
     {
-        std::unique_lock<std::mutex> lock(mtxBusyRequests);
-        condVarBusyRequests.wait(lock, [&]() {
-            // wait until the pipeline is stopped or there are new InferRequests
-            return terminate || !busyBatchRequests.empty();
-        });
-        if (busyBatchRequests.empty()) {
-            return {}; // woke up because of termination, so leave if nothing to preces
-        }
-        vframes = std::move(busyBatchRequests.front().vfPtrVec);
-        req = std::move(busyBatchRequests.front().req);
-        startTime = std::move(busyBatchRequests.front().startTime);
-        busyBatchRequests.pop();
+        std::lock_guard<std::mutex> lock(mtx);
+        inputStopped = true;
     }
+    condVarAvailableRequests.notify_all();
+    condVarFrames.notify_all();
+    condVarQueuesSpace.notify_all();
+    condVarStopped.notify_all();
+}
 
-    if (nullptr != req && InferenceEngine::OK == req->Wait(InferenceEngine::InferRequest::WaitMode::RESULT_READY)) {
-        auto detections = postprocessing(req, outputDataBlobNames, frameSize);
-        for (decltype(detections.size()) i = 0; i < detections.size(); i ++) {
-            vframes[i]->detections = std::move(detections[i]);
-        }
-        if (perfTimerInfer.enabled()) {
-            auto endTime = std::chrono::high_resolution_clock::now();
-            perfTimerInfer.addValue(endTime - startTime);
-        }
-    }
+bool IEGraph::isRunning() {
+    std::lock_guard<std::mutex> lock(mtx);
+    return !batcherStopped || busyRequestsNum != 0;
+}
 
-    if (nullptr != req) {
-        std::unique_lock<std::mutex> lock(mtxAvalableRequests);
-        availableRequests.push(std::move(req));
-        lock.unlock();
-        condVarAvailableRequests.notify_one();
+bool IEGraph::waitFor(std::chrono::milliseconds timeout) {
+    std::unique_lock<std::mutex> lock(mtx);
+    condVarStopped.wait_for(lock, timeout, [&]() {
+        return (batcherStopped && busyRequestsNum == 0) || callbackException;
+    });
+    if (callbackException) {
+        std::rethrow_exception(callbackException);
     }
+    return !batcherStopped || busyRequestsNum != 0;
+}
 
-    return vframes;
+InferenceEngine::SizeVector IEGraph::getInputDims() const {
+    assert(!batchRequests.empty());
+    auto inputBlob = batchRequests.front().req->GetBlob(inputDataBlobName);
+    return inputBlob->getTensorDesc().getDims();
 }
 
 unsigned int IEGraph::getBatchSize() const {
@@ -261,28 +346,22 @@ void IEGraph::setDetectionConfidence(float conf) {
 }
 
 IEGraph::~IEGraph() {
-    terminate = true;
-    {
-        std::unique_lock<std::mutex> lock(mtxAvalableRequests);
-        bool ready = false;
-        while (!ready) {
-            std::unique_lock<std::mutex> lock(mtxBusyRequests);
-            if (!busyBatchRequests.empty()) {
-                auto& req = busyBatchRequests.front().req;
-                if (nullptr != req) {
-                    req->Wait(InferenceEngine::InferRequest::WaitMode::RESULT_READY);
-                    availableRequests.push(std::move(req));
-                }
-                busyBatchRequests.pop();
-            }
-            if (availableRequests.size() == maxRequests) {
-                ready = true;
-            }
+    stop();
+    // A reader may be blocked by its source for a while, it stops after the current frame
+    for (auto& channel : channels) {
+        if (channel->feederThread.joinable()) {
+            channel->feederThread.join();
         }
-        condVarAvailableRequests.notify_one();
     }
-    if (getterThread.joinable()) {
-        getterThread.join();
+    if (batcherThread.joinable()) {
+        batcherThread.join();
+    }
+    {
+        std::unique_lock<std::mutex> lock(mtx);
+        condVarStopped.wait(lock, [&]() { return busyRequestsNum == 0; });
+    }
+    for (auto& batchRequest : batchRequests) {
+        batchRequest.req->SetCompletionCallback([]{});
     }
 }
 
@@ -14,10 +14,13 @@
 #include <atomic>
 #include <string>
 #include <memory>
+#include <exception>
+#include <cstddef>
 
 #include <inference_engine.hpp>
 
 #include <utils/common.hpp>
+#include <utils/bounded_queue.hpp>
 #include <utils/slog.hpp>
 #include "perf_timer.hpp"
 #include "input.hpp"
@@ -27,6 +30,14 @@ void loadImageToIEGraph(cv::Mat img, void* ie_buffer);
 class VideoFrame;
 
 class IEGraph{
+public:
+    /// Blocks until the next frame of the channel is read, returns false if there are no more frames
+    using GetterFunc = std::function<bool(std::size_t channel, VideoFrame&)>;
+    using PostprocessingFunc = std::function<std::vector<Detections>(InferenceEngine::InferRequest::Ptr, const std::vector<std::string>&, cv::Size)>;
+    using PostLoadFunc = std::function<void (const std::vector<std::string>&, InferenceEngine::CNNNetwork&)>;
+    /// Receives inferred frames of one channel, it is called from inference callback threads
+    using SinkFunc = std::function<void(std::shared_ptr<VideoFrame>)>;
+
 private:
     PerfTimer perfTimerPreprocess;
     PerfTimer perfTimerInfer;
@@ -34,6 +45,7 @@ private:
     float confidenceThreshold;
 
     std::size_t batchSize;
+    std::chrono::milliseconds maxWaitTime;
 
     std::string modelPath;
     std::string cpuExtensionPath;
@@ -45,37 +57,67 @@ private:
     std::string deviceName;
 
     InferenceEngine::Core ie;
-    std::queue<InferenceEngine::InferRequest::Ptr> availableRequests;
 
     struct BatchRequestDesc {
         std::vector<std::shared_ptr<VideoFrame>> vfPtrVec;
         InferenceEngine::InferRequest::Ptr req;
         std::chrono::high_resolution_clock::time_point startTime;
     };
-    std::queue<BatchRequestDesc> busyBatchRequests;
+    std::vector<BatchRequestDesc> batchRequests;
+    std::queue<std::size_t> availableRequests;
 
     std::size_t maxRequests = 0;
 
-    std::atomic_bool terminate = {false};
-    std::mutex mtxAvalableRequests;
-    std::mutex mtxBusyRequests;
+    // Readers of a channel block while its queue is full, so a short queue keeps queued frames fresh
+    static constexpr std::size_t framesQueueSize = 2;
+    struct Channel {
+        Channel(): frames(framesQueueSize) {}
+
+        BoundedMPMCQueue<std::shared_ptr<VideoFrame>> frames;
+        SinkFunc sink;
+        std::thread feederThread;
+    };
+    std::vector<std::unique_ptr<Channel>> channels;
+
+    // Used by the batcher thread only
+    std::size_t firstChannel = 0;
+    std::vector<cv::Mat> imgsToProc;
+
+    // Readers push and the batcher pops frames without the lock. The mutex is taken only to sleep when there
+    // are no frames or no space in a queue, and to wake the sleeping side
+    std::atomic<std::ptrdiff_t> pendingFrames = {0};  // pushed to channel queues and not popped yet
+    std::atomic_bool batcherWaiting = {false};
+    std::atomic<std::size_t> spaceWaiters = {0};  // readers waiting for space in their queues
+
+    // Other conditions are guarded by the mutex
+    std::atomic_bool inputStopped = {false};
+    bool batcherStopped = true;
+    std::size_t busyRequestsNum = 0;
+    std::exception_ptr callbackException;
+    mutable std::mutex mtx;
     std::condition_variable condVarAvailableRequests;
-    std::condition_variable condVarBusyRequests;
+    std::condition_variable condVarFrames;
+    std::condition_variable condVarQueuesSpace;
+    std::condition_variable condVarStopped;
 
-    using GetterFunc = std::function<bool(VideoFrame&)>;
     GetterFunc getter;
-    using PostprocessingFunc = std::function<std::vector<Detections>(InferenceEngine::InferRequest::Ptr, const std::vector<std::string>&, cv::Size)>;
     PostprocessingFunc postprocessing;
-    using PostLoadFunc = std::function<void (const std::vector<std::string>&, InferenceEngine::CNNNetwork&)>;
     PostLoadFunc postLoad;
-    std::thread getterThread;
+    cv::Size frameSize;
+    std::thread batcherThread;
 
     void initNetwork(const std::string& deviceName);
+    void feedChannel(std::size_t channel);
+    void assembleBatches();
+    bool collectBatch(std::vector<std::shared_ptr<VideoFrame>>& vframes);
+    void startRequest(std::size_t requestIdx);
+    void onRequestCompleted(std::size_t requestIdx);
 
 public:
     struct InitParams {
         std::size_t batchSize = 1;
         std::size_t maxRequests = 5;
+        std::chrono::milliseconds maxWaitTime = std::chrono::milliseconds(30);
         bool collectStats = false;
         std::string modelPath;
         std::string cpuExtPath;
@@ -86,13 +128,25 @@ public:
 
     explicit IEGraph(const InitParams& p);
 
-    void start(GetterFunc getterFunc, PostprocessingFunc postprocessingFunc);
+    /// Starts reading every channel in its own thread. Frames are batched across channels as they arrive:
+    /// a batch is submitted once it is full or maxWaitTime after its first frame was taken, so one slow
+    /// channel does not stall the others. Inferred frames are handed to sinks[channel]
+    /// @param frameSize - size of the displayed frame which is passed to postprocessingFunc
+    void start(GetterFunc getterFunc, PostprocessingFunc postprocessingFunc, std::vector<SinkFunc> sinks,
+               cv::Size frameSize);
+
+    /// Stops reading the input, frames which are already being inferred are still delivered to sinks.
+    /// Frames which are read but not batched yet are released without inference
+    void stop();
 
     bool isRunning();
 
-    InferenceEngine::SizeVector getInputDims() const;
+    /// Blocks until all inferred frames are delivered after the input was stopped or the timeout expires.
+    /// Rethrows an exception thrown by postprocessing or a sink
+    /// @returns true if the graph is still running
+    bool waitFor(std::chrono::milliseconds timeout);
 
-    std::vector<std::shared_ptr<VideoFrame>> getBatchData(cv::Size windowSize);
+    InferenceEngine::SizeVector getInputDims() const;
 
     unsigned int getBatchSize() const;
 
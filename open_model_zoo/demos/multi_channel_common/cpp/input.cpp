@@ -15,10 +15,12 @@
 #include <utils/args_helper.hpp>
 #include <utils/images_capture.h>
 #include <utils/performance_metrics.hpp>
+#include <utils/slog.hpp>
 
 #include "perf_timer.hpp"
 
 #include "decoder.hpp"
+#include "shm_ring.hpp"
 #include "threading.hpp"
 
 #ifdef USE_NATIVE_CAMERA_API
@@ -47,6 +49,9 @@ public:
     virtual float getAvgReadTime() const = 0;
 
     virtual ~VideoSource();
+
+    // Channels duplicating a source read it from their own threads, sources aren't safe to read concurrently
+    std::mutex readMutex;
 };
 
 VideoSource::~VideoSource() {}
@@ -187,10 +192,10 @@ public:
                     {
                         const auto timestamp = std::chrono::steady_clock::now();
                         is_decoding = true;
-                        std::unique_lock<std::mutex> lock(parent.decode_mutex);
                         parent.decoder.decode(stream.frame.ptr, stream.frame.length, stream.frame.width, stream.frame.height,
                             [this, timestamp](cv::Mat&& img) mutable {
                             bool success = !img.empty();
+                            std::lock_guard<std::mutex> lock(mutex);
                             frameQueue.push({ success, {std::move(img), timestamp} });
                             if (perfTimer.enabled()) {
                                 auto prev = lastFrameTime;
@@ -203,7 +208,7 @@ public:
                             }
                             is_decoding = false;
                             condVar.notify_one();
-                        });
+                        }, this);
                         stream.advance_frame();
                     }
 
@@ -223,6 +228,7 @@ public:
         if (workThread.joinable()) {
             workThread.join();
         }
+        parent.decoder.closeStream(this);
     }
 
     bool read(VideoFrame& frame) override {
@@ -359,7 +365,8 @@ VideoSourceNative::VideoSourceNative(VideoSources& p, mcam::controller& ctrl,
 }
 
 VideoSourceNative::~VideoSourceNative() {
-    // nothing
+    // Frames being decoded push to frameQueue
+    parent.decoder.closeStream(this);
 }
 
 void VideoSourceNative::start() {
@@ -383,8 +390,6 @@ void VideoSourceNative::frameHandler(mcam::camera::frame_status status,
             auto data = frame.data();
             auto size = frame.size();
 
-            std::unique_lock<std::mutex> lock(parent.decode_mutex);
-
             parent.decoder.decode(
                         data, size, settings.width, settings.height,
             [this, fr = std::move(frame), timestamp](cv::Mat&& img) mutable {
@@ -401,7 +406,7 @@ void VideoSourceNative::frameHandler(mcam::camera::frame_status status,
 
                     lastFrameTime = current;
                 }
-            });
+            }, this);
         }
     }
 }
@@ -543,20 +548,60 @@ bool GeneralCaptureSource::read(VideoFrame& frame) {
     return read(frame.frame, frame.timestamp);
 }
 
+// Frames are decoded by another process (see shm_producer) and are used in place while the demo holds them,
+// or copied out of shared memory once if the ring isn't writable for leases.
+// A slow consumer skips frames instead of making the producer wait. Reads are serialized by getFrame()
+class VideoSourceShm : public VideoSource {
+    PerfTimer perfTimer;
+    ShmRingReader ring;
+    std::atomic_bool running = {true};
+
+public:
+    VideoSourceShm(bool collectStats, const std::string& name):
+        perfTimer(collectStats ? PerfTimer::DefaultIterationsCount : 0),
+        ring(name, true) {
+        if (!ring.isZeroCopy()) {
+            slog::warn << "Shared memory ring " << name << " isn't writable, its frames are copied" << slog::endl;
+        }
+    }
+
+    void start() override {}
+
+    bool isRunning() const override {
+        return running;
+    }
+
+    bool read(VideoFrame& frame) override {
+        bool res;
+        if (perfTimer.enabled()) {
+            ScopedTimer st(perfTimer);
+            res = ring.read(frame.frame, frame.timestamp);
+        } else {
+            res = ring.read(frame.frame, frame.timestamp);
+        }
+        if (!res) {
+            running = false;
+        }
+        return res;
+    }
+
+    float getAvgReadTime() const override {
+        return perfTimer.getValue();
+    }
+};
+
 namespace {
 Decoder::Settings makeDecoderSettings(bool collectStats, std::size_t queueSize,
                                       unsigned width, unsigned height) {
     Decoder::Settings ret = {};
 #if defined(USE_LIBVA)
     ret.mode = Decoder::Mode::Hw;
+#else
+    ret.mode = Decoder::Mode::Async;
+#endif
     ret.num_buffers = static_cast<unsigned>(queueSize);
     ret.output_width = width;
     ret.output_height = height;
-#elif defined(USE_TBB)
-    ret.mode = Decoder::Mode::Async;
-#else
-    ret.mode = Decoder::Mode::Immediate;
-#endif
     ret.collect_stats = collectStats;
     return ret;
 }
@@ -586,6 +631,13 @@ bool VideoSources::isRunning() const {
 }
 
 void VideoSources::openVideo(const std::string& source, bool native, bool loopVideo) {
+    const std::string shmPrefix = "shm:";
+    if (source.compare(0, shmPrefix.size(), shmPrefix) == 0) {
+        if (loopVideo)
+            throw std::runtime_error("Looping is not supported for shared memory inputs, loop them in the producer");
+        inputs.emplace_back(new VideoSourceShm(collectStats, source.substr(shmPrefix.size())));
+        return;
+    }
 #ifdef USE_NATIVE_CAMERA_API
     if (native) {
         std::string dev;
@@ -635,6 +687,7 @@ void VideoSources::start() {
 bool VideoSources::getFrame(size_t index, VideoFrame& frame) {
     if (inputs.size() > 0) {
         if (index < inputs.size()) {
+            std::lock_guard<std::mutex> lock(inputs[index]->readMutex);
             return inputs[index]->read(frame);
         }
     }
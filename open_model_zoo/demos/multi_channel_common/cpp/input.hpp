@@ -60,8 +60,6 @@ private:
     mcam::controller controller;
 #endif
 
-    std::mutex decode_mutex;  // hardware decoding enqueue lock
-
     std::vector<std::unique_ptr<VideoSource>> inputs;
     const bool isAsync;
     const bool collectStats;
@@ -94,6 +92,7 @@ public:
 
     virtual bool isRunning() const;
 
+    /// Can be called from several threads, reads of the same source are serialized
     bool getFrame(size_t index, VideoFrame& frame);
 
     struct Stats {
@@ -10,7 +10,8 @@
 
 static const char help_message[] = "Print a usage message";
 static const char input_message[] = "Required. A comma separated list of inputs to process. Each input must be a "
-    "single image, a folder of images or anything that cv::VideoCapture can process.";
+    "single image, a folder of images, anything that cv::VideoCapture can process or shm:<name> of a shared memory "
+    "frame ring written by multi_channel_shm_producer.";
 static const char loop_message[] = "Optional. Enable reading the inputs in a loop.";
 static const char duplication_channel_number_message[] = "Optional. Multiply the inputs by the given factor."
     " For example, if only one input is provided, but -duplicate_num is set to 2, the demo will split real input across channels,"
@@ -26,6 +27,8 @@ static const char custom_cpu_library_message[] = "Required for CPU custom layers
 static const char no_show_message[] = "Optional. Don't show output.";
 static const char batch_size[] = "Optional. Batch size for processing (the number of frames processed per infer request)";
 static const char num_infer_requests[] = "Optional. Number of infer requests";
+static const char batch_wait_message[] = "Optional. Maximum time in msec the first frame of a batch waits for frames of other channels "
+                                         "before incomplete batch is submitted";
 static const char input_queue_size[] = "Optional. Frame queue size for input channels";
 static const char fps_sampling_period[] = "Optional. FPS measurement sampling period between timepoints in msec";
 static const char num_sampling_periods[] = "Optional. Number of sampling periods";
@@ -44,6 +47,7 @@ DEFINE_string(l, "", custom_cpu_library_message);
 DEFINE_bool(no_show, false, no_show_message);
 DEFINE_uint32(bs, 1, batch_size);
 DEFINE_uint32(nireq, 5, num_infer_requests);
+DEFINE_uint32(batch_wait, 30, batch_wait_message);
 DEFINE_uint32(n_iqs, 5, input_queue_size);
 DEFINE_uint32(fps_sp, 1000, fps_sampling_period);
 DEFINE_uint32(n_sp, 10, num_sampling_periods);
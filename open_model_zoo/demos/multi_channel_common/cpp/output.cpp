@@ -2,6 +2,7 @@
 // SPDX-License-Identifier: Apache-2.0
 //
 
+#include <algorithm>
 #include <memory>
 #include <vector>
 #include <utility>
@@ -69,3 +70,40 @@ bool AsyncOutput::isAlive() const {
 AsyncOutput::Stats AsyncOutput::getStats() const {
     return Stats{perfTimer.getValue()};
 }
+
+FrameGrouper::FrameGrouper(size_t channelsNum, SendFunc sendFunc):
+    sendFunc(std::move(sendFunc)),
+    isInGroup(channelsNum, false),
+    lastTimestamps(channelsNum, PerformanceMetrics::TimePoint::min()) {}
+
+std::vector<IEGraph::SinkFunc> FrameGrouper::getSinks() {
+    return std::vector<IEGraph::SinkFunc>(isInGroup.size(), [this](std::shared_ptr<VideoFrame> frame) {
+        push(std::move(frame));
+    });
+}
+
+void FrameGrouper::push(std::shared_ptr<VideoFrame> frame) {
+    std::vector<std::shared_ptr<VideoFrame>> completedGroup;
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        const size_t channel = frame->sourceIdx;
+        if (frame->timestamp < lastTimestamps[channel]) {
+            return;
+        }
+        lastTimestamps[channel] = frame->timestamp;
+
+        if (isInGroup[channel]) {
+            completedGroup.swap(group);
+            std::fill(isInGroup.begin(), isInGroup.end(), false);
+        }
+        isInGroup[channel] = true;
+        group.push_back(std::move(frame));
+        if (completedGroup.empty() && group.size() == isInGroup.size()) {
+            completedGroup.swap(group);
+            std::fill(isInGroup.begin(), isInGroup.end(), false);
+        }
+    }
+    if (!completedGroup.empty()) {
+        sendFunc(std::move(completedGroup));
+    }
+}
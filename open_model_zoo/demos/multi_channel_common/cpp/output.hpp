@@ -42,6 +42,28 @@ private:
     PerfTimer perfTimer;
 };
 
+/// Groups inferred frames of all channels for AsyncOutput. Channels deliver frames at their own pace, so a group
+/// is sent once it has a frame of every channel or one of its channels delivers the next frame. A slow channel
+/// just misses some groups. Frames which are delivered after a newer frame of the same channel are dropped, and so
+/// is the incomplete group left when the grouper is destroyed
+class FrameGrouper {
+public:
+    using SendFunc = std::function<void(std::vector<std::shared_ptr<VideoFrame>>&&)>;
+
+    FrameGrouper(size_t channelsNum, SendFunc sendFunc);
+    /// Sinks for IEGraph::start, they must not be called after the grouper is destroyed
+    std::vector<IEGraph::SinkFunc> getSinks();
+
+private:
+    void push(std::shared_ptr<VideoFrame> frame);
+
+    SendFunc sendFunc;
+    std::vector<std::shared_ptr<VideoFrame>> group;
+    std::vector<bool> isInGroup;
+    std::vector<PerformanceMetrics::TimePoint> lastTimestamps;
+    std::mutex mutex;
+};
+
 template<class StreamType, class EndlType>
 void writeStats(StreamType& stream, EndlType endl, const VideoSources::Stats& inputStat,
     const IEGraph::Stats& inferStat, const AsyncOutput::Stats& outputStat) {
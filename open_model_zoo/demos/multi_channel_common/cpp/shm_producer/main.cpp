@@ -0,0 +1,137 @@
+// Copyright (C) 2021 Intel Corporation
+// SPDX-License-Identifier: Apache-2.0
+//
+
+/**
+* \brief Decodes an input once and publishes its frames to a shared memory ring,
+* which multi-channel demos read with -i shm:<name>
+* \file multi_channel_common/cpp/shm_producer/main.cpp
+*/
+#include <algorithm>
+#include <chrono>
+#include <csignal>
+#include <iostream>
+#include <memory>
+#include <string>
+#include <thread>
+
+#include <gflags/gflags.h>
+#include <opencv2/core.hpp>
+
+#include <utils/images_capture.h>
+#include <utils/slog.hpp>
+
+#include "shm_ring.hpp"
+
+namespace {
+const char help_message[] = "Print a usage message";
+const char input_message[] = "Required. An input to decode. It must be a single image, a folder of images "
+                             "or anything that cv::VideoCapture can process.";
+const char output_message[] = "Required. Name of the shared memory object to write, e.g. /cam0. "
+                              "Demos read it with -i shm:<name>";
+const char loop_message[] = "Optional. Enable reading the input in a loop.";
+const char slots_message[] = "Optional. Number of frames kept in shared memory. Frames held by zero-copy "
+                             "consumers aren't overwritten, so it must exceed the number of frames they hold";
+
+DEFINE_bool(h, false, help_message);
+DEFINE_string(i, "", input_message);
+DEFINE_string(o, "", output_message);
+DEFINE_bool(loop, false, loop_message);
+DEFINE_uint32(slots, 16, slots_message);
+
+volatile std::sig_atomic_t interrupted = 0;
+
+void onInterrupt(int) {
+    interrupted = 1;
+}
+
+void showUsage() {
+    std::cout << std::endl;
+    std::cout << "multi_channel_shm_producer [OPTION]" << std::endl;
+    std::cout << "Options:" << std::endl;
+    std::cout << std::endl;
+    std::cout << "    -h                           " << help_message << std::endl;
+    std::cout << "    -i                           " << input_message << std::endl;
+    std::cout << "    -o                           " << output_message << std::endl;
+    std::cout << "    -loop                        " << loop_message << std::endl;
+    std::cout << "    -slots                       " << slots_message << std::endl;
+}
+
+bool ParseAndCheckCommandLine(int argc, char *argv[]) {
+    gflags::ParseCommandLineNonHelpFlags(&argc, &argv, true);
+    if (FLAGS_h) {
+        showUsage();
+        return false;
+    }
+
+    if (FLAGS_i.empty()) {
+        throw std::logic_error("Parameter -i is not set");
+    }
+    if (FLAGS_o.empty()) {
+        throw std::logic_error("Parameter -o is not set");
+    }
+    if (FLAGS_slots < 2) {
+        throw std::logic_error("Parameter -slots must be at least 2");
+    }
+    return true;
+}
+}  // namespace
+
+int main(int argc, char* argv[]) {
+    try {
+        if (!ParseAndCheckCommandLine(argc, argv)) {
+            return 0;
+        }
+
+        std::unique_ptr<ImagesCapture> cap = openImagesCapture(FLAGS_i, FLAGS_loop);
+        cv::Mat frame = cap->read();
+        if (frame.empty()) {
+            throw std::runtime_error("Can't read an image from " + FLAGS_i);
+        }
+
+        std::signal(SIGINT, onInterrupt);
+        std::signal(SIGTERM, onInterrupt);
+
+        // Cameras deliver frames in real time, other inputs are paced to their frame rate
+        // so consumers see the same timing as with the input itself
+        std::chrono::steady_clock::duration framePeriod = std::chrono::steady_clock::duration::zero();
+        if (cap->getType() != "CAMERA" && cap->fps() > 0) {
+            framePeriod = std::chrono::duration_cast<std::chrono::steady_clock::duration>(
+                std::chrono::duration<double>(1.0 / cap->fps()));
+        }
+
+        ShmRingWriter ring(FLAGS_o, FLAGS_slots, frame.size(), frame.type());
+        slog::info << "Writing " << frame.cols << "x" << frame.rows << " frames of " << FLAGS_i
+                   << " to " << FLAGS_o << slog::endl;
+
+        std::size_t framesNum = 0;
+        std::size_t droppedNum = 0;
+        auto nextFrameTime = std::chrono::steady_clock::now();
+        while (!frame.empty() && !interrupted) {
+            std::this_thread::sleep_until(nextFrameTime);
+            const auto timestamp = std::chrono::steady_clock::now();
+            if (ring.write(frame, timestamp)) {
+                framesNum++;
+            } else {
+                droppedNum++;
+            }
+            nextFrameTime = std::max(nextFrameTime + framePeriod, timestamp);
+            frame = cap->read();
+        }
+        slog::info << "Wrote " << framesNum << " frames" << slog::endl;
+        if (droppedNum > 0) {
+            slog::warn << "Dropped " << droppedNum << " frames because consumers held all slots, increase -slots"
+                       << slog::endl;
+        }
+    }
+    catch (const std::exception& error) {
+        slog::err << error.what() << slog::endl;
+        return 1;
+    }
+    catch (...) {
+        slog::err << "Unknown/internal exception happened." << slog::endl;
+        return 1;
+    }
+
+    return 0;
+}
@@ -0,0 +1,390 @@
+// Copyright (C) 2021 Intel Corporation
+// SPDX-License-Identifier: Apache-2.0
+//
+
+#include "shm_ring.hpp"
+
+#include <atomic>
+#include <cerrno>
+#include <cstring>
+#include <memory>
+#include <stdexcept>
+#include <thread>
+
+#include <opencv2/imgproc.hpp>
+
+#ifndef _WIN32
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+static_assert(ATOMIC_LLONG_LOCK_FREE == 2, "Shared memory ring requires lock-free 64-bit atomics");
+static_assert(ATOMIC_INT_LOCK_FREE == 2, "Shared memory ring requires lock-free 32-bit atomics");
+
+namespace {
+constexpr std::uint64_t kMagic = 0x32474e49524d4853ull;  // "SHMRING2"
+constexpr std::size_t kAlignment = 64;
+// Readers can't sleep on a condition variable in a read-only mapping, so they poll
+constexpr std::chrono::milliseconds kPollingPeriod(1);
+
+std::size_t alignUp(std::size_t value, std::size_t alignment = kAlignment) {
+    return (value + alignment - 1) / alignment * alignment;
+}
+
+std::int64_t toNanoseconds(std::chrono::steady_clock::time_point timestamp) {
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(timestamp.time_since_epoch()).count();
+}
+
+#ifndef _WIN32
+std::runtime_error systemError(const std::string& what, const std::string& name) {
+    return std::runtime_error(what + " " + name + ": " + std::strerror(errno));
+}
+#endif
+}  // namespace
+
+// The layout is shared by processes, so it has only fixed-size fields.
+// Steady clock is system-wide, timestamps of different processes are comparable.
+// The object is the header, the lease table and the slots. The lease table starts and ends on page boundaries,
+// so zero-copy readers map it writable and the rest of the object read-only
+struct ShmRingHeader {
+    std::atomic<std::uint64_t> magic;  // set last, when the geometry is written
+    std::uint64_t slotsNum;
+    std::uint64_t leasesOffset;  // of the table of std::atomic<std::uint32_t> slot leases
+    std::uint64_t leasesSize;
+    std::uint64_t slotsOffset;
+    std::uint64_t slotStride;
+    std::uint64_t dataOffset;  // of the first frame from the slot beginning
+    std::uint64_t step;
+    std::int32_t rows;
+    std::int32_t cols;
+    std::int32_t type;
+    std::atomic<std::uint64_t> publishedSeq;  // of the newest complete frame, 0 if there is none
+    std::atomic<std::uint32_t> finished;
+};
+
+struct ShmSlotHeader {
+    std::atomic<std::uint64_t> seq;  // 0 while the frame is being written
+    std::int64_t timestampNs;
+};
+
+struct ShmRingMapping {
+    void* data = nullptr;
+    std::size_t size = 0;
+    std::atomic<std::uint32_t>* leases = nullptr;  // mapped writable in zero-copy mode only
+    std::size_t leasesSize = 0;
+
+    ~ShmRingMapping();
+};
+
+namespace {
+const ShmSlotHeader* getSlot(const ShmRingHeader* header, std::uint64_t seq) {
+    return reinterpret_cast<const ShmSlotHeader*>(reinterpret_cast<const char*>(header)
+        + header->slotsOffset + (seq % header->slotsNum) * header->slotStride);
+}
+
+ShmSlotHeader* getSlot(ShmRingHeader* header, std::uint64_t seq) {
+    return const_cast<ShmSlotHeader*>(getSlot(static_cast<const ShmRingHeader*>(header), seq));
+}
+
+// A zero-copy frame holds the lease of its slot and the mapping
+struct ShmLease {
+    std::shared_ptr<ShmRingMapping> mapping;
+    std::atomic<std::uint32_t>* counter;
+
+    ~ShmLease() {
+        counter->fetch_sub(1, std::memory_order_release);
+    }
+};
+
+// Releases the lease when the last cv::Mat referencing a zero-copy frame is released. Frames are never allocated
+// by it: a Mat which is reallocated uses its own or the default allocator
+class ShmLeaseAllocator : public cv::MatAllocator {
+public:
+    cv::UMatData* allocate(int, const int*, int, void*, size_t*, cv::AccessFlag, cv::UMatUsageFlags) const override {
+        return nullptr;
+    }
+    bool allocate(cv::UMatData*, cv::AccessFlag, cv::UMatUsageFlags) const override {
+        return false;
+    }
+    void deallocate(cv::UMatData* u) const override {
+        if (!u) {
+            return;
+        }
+        delete static_cast<ShmLease*>(u->userdata);
+        delete u;
+    }
+
+    // Never destroyed, so frames may outlive main()
+    static ShmLeaseAllocator& getInstance() {
+        static ShmLeaseAllocator* instance = new ShmLeaseAllocator();
+        return *instance;
+    }
+};
+
+cv::Mat wrapLeased(const ShmRingHeader* header, const ShmSlotHeader* slot, std::unique_ptr<ShmLease> lease) {
+    uchar* data = const_cast<uchar*>(reinterpret_cast<const uchar*>(slot) + header->dataOffset);
+    cv::Mat frame(header->rows, header->cols, header->type, data, header->step);
+    cv::UMatData* u = new cv::UMatData(&ShmLeaseAllocator::getInstance());
+    u->data = u->origdata = data;
+    u->size = header->step * header->rows;
+    u->flags |= cv::UMatData::USER_ALLOCATED;
+    u->userdata = lease.release();
+    u->refcount = 1;
+    frame.u = u;
+    return frame;
+}
+}  // namespace
+
+#ifndef _WIN32
+
+ShmRingMapping::~ShmRingMapping() {
+    if (leases) {
+        munmap(leases, leasesSize);
+    }
+    if (data) {
+        munmap(data, size);
+    }
+}
+
+ShmRingWriter::ShmRingWriter(const std::string& name, std::size_t slotsNum, cv::Size frameSize, int frameType)
+        : name(name), mapping(MAP_FAILED), mappingSize(0), header(nullptr) {
+    if (slotsNum < 2) {
+        throw std::invalid_argument("Shared memory ring needs at least 2 slots");
+    }
+    const std::size_t pageSize = static_cast<std::size_t>(sysconf(_SC_PAGESIZE));
+    const std::size_t step = static_cast<std::size_t>(frameSize.width) * CV_ELEM_SIZE(frameType);
+    const std::size_t dataOffset = alignUp(sizeof(ShmSlotHeader));
+    const std::size_t slotStride = alignUp(dataOffset + step * frameSize.height);
+    const std::size_t leasesOffset = alignUp(sizeof(ShmRingHeader), pageSize);
+    const std::size_t leasesSize = alignUp(slotsNum * sizeof(std::atomic<std::uint32_t>), pageSize);
+    const std::size_t slotsOffset = leasesOffset + leasesSize;
+    mappingSize = slotsOffset + slotsNum * slotStride;
+
+    // Readers of the previous object keep their mapping and see it finished
+    shm_unlink(name.c_str());
+    int fd = shm_open(name.c_str(), O_CREAT | O_EXCL | O_RDWR, 0644);
+    if (fd < 0) {
+        throw systemError("Can't create shared memory object", name);
+    }
+    if (ftruncate(fd, static_cast<off_t>(mappingSize)) != 0) {
+        close(fd);
+        shm_unlink(name.c_str());
+        throw systemError("Can't resize shared memory object", name);
+    }
+    mapping = mmap(nullptr, mappingSize, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    close(fd);
+    if (mapping == MAP_FAILED) {
+        shm_unlink(name.c_str());
+        throw systemError("Can't map shared memory object", name);
+    }
+
+    // The object is zero-filled, so readers which open it now see no frames
+    header = static_cast<ShmRingHeader*>(mapping);
+    header->slotsNum = slotsNum;
+    header->leasesOffset = leasesOffset;
+    header->leasesSize = leasesSize;
+    header->slotsOffset = slotsOffset;
+    header->slotStride = slotStride;
+    header->dataOffset = dataOffset;
+    header->step = step;
+    header->rows = frameSize.height;
+    header->cols = frameSize.width;
+    header->type = frameType;
+    header->magic.store(kMagic, std::memory_order_release);
+}
+
+ShmRingWriter::~ShmRingWriter() {
+    if (header) {
+        header->finished.store(1, std::memory_order_release);
+    }
+    if (mapping != MAP_FAILED) {
+        munmap(mapping, mappingSize);
+    }
+    shm_unlink(name.c_str());
+}
+
+bool ShmRingWriter::write(const cv::Mat& frame, std::chrono::steady_clock::time_point timestamp) {
+    const cv::Size size(header->cols, header->rows);
+    if (frame.type() != header->type) {
+        throw std::invalid_argument("Frame type differs from the type of shared memory ring " + name);
+    }
+    const cv::Mat* source = &frame;
+    if (frame.size() != size) {
+        cv::resize(frame, resized, size);
+        source = &resized;
+    }
+
+    // Leased slots are skipped, so sequence numbers of published frames may have gaps. The slot of the newest
+    // frame is never taken, readers always find a frame there
+    std::atomic<std::uint32_t>* leases = reinterpret_cast<std::atomic<std::uint32_t>*>(
+        static_cast<char*>(mapping) + header->leasesOffset);
+    const std::uint64_t publishedSeq = header->publishedSeq.load(std::memory_order_relaxed);
+    std::uint64_t seq = 0;
+    ShmSlotHeader* slot = nullptr;
+    for (std::uint64_t i = 1; i < header->slotsNum && nullptr == slot; ++i) {
+        seq = publishedSeq + i;
+        ShmSlotHeader* candidate = getSlot(header, seq);
+        const std::uint64_t previousSeq = candidate->seq.load(std::memory_order_relaxed);
+        // A reader leases a slot and then checks its seq, the writer invalidates the seq and then checks the lease.
+        // Both are sequentially consistent, so at least one of them sees the other
+        candidate->seq.store(0, std::memory_order_seq_cst);
+        if (0 == leases[seq % header->slotsNum].load(std::memory_order_seq_cst)) {
+            slot = candidate;
+        } else {
+            candidate->seq.store(previousSeq, std::memory_order_release);
+        }
+    }
+    if (nullptr == slot) {
+        return false;
+    }
+    std::atomic_thread_fence(std::memory_order_release);
+
+    cv::Mat slotFrame(size, header->type, reinterpret_cast<char*>(slot) + header->dataOffset, header->step);
+    source->copyTo(slotFrame);
+    slot->timestampNs = toNanoseconds(timestamp);
+
+    slot->seq.store(seq, std::memory_order_release);
+    header->publishedSeq.store(seq, std::memory_order_release);
+    return true;
+}
+
+ShmRingReader::ShmRingReader(const std::string& name, bool zeroCopy)
+        : name(name), mapping(std::make_shared<ShmRingMapping>()), header(nullptr), lastSeq(0) {
+    // Leases need write access, without it frames are copied
+    int fd = zeroCopy ? shm_open(name.c_str(), O_RDWR, 0) : -1;
+    if (fd < 0) {
+        zeroCopy = false;
+        fd = shm_open(name.c_str(), O_RDONLY, 0);
+    }
+    if (fd < 0) {
+        throw systemError("Can't open shared memory object (is the producer running?)", name);
+    }
+    struct stat sb;
+    if (fstat(fd, &sb) != 0 || static_cast<std::size_t>(sb.st_size) < sizeof(ShmRingHeader)) {
+        close(fd);
+        throw std::runtime_error("Invalid shared memory object " + name);
+    }
+    const std::size_t size = static_cast<std::size_t>(sb.st_size);
+    void* data = mmap(nullptr, size, PROT_READ, MAP_SHARED, fd, 0);
+    if (data == MAP_FAILED) {
+        close(fd);
+        throw systemError("Can't map shared memory object", name);
+    }
+    mapping->data = data;
+    mapping->size = size;
+
+    header = static_cast<const ShmRingHeader*>(data);
+    const std::size_t pageSize = static_cast<std::size_t>(sysconf(_SC_PAGESIZE));
+    if (header->magic.load(std::memory_order_acquire) != kMagic
+            || header->leasesOffset % pageSize != 0
+            || header->leasesOffset + header->leasesSize > header->slotsOffset
+            || header->slotsNum * sizeof(std::atomic<std::uint32_t>) > header->leasesSize
+            || header->slotsOffset + header->slotsNum * header->slotStride > size) {
+        close(fd);
+        throw std::runtime_error("Shared memory object " + name + " is not a frame ring or is not initialized yet");
+    }
+
+    if (zeroCopy) {
+        void* leases = mmap(nullptr, header->leasesSize, PROT_READ | PROT_WRITE, MAP_SHARED, fd,
+            static_cast<off_t>(header->leasesOffset));
+        if (leases != MAP_FAILED) {
+            mapping->leases = static_cast<std::atomic<std::uint32_t>*>(leases);
+            mapping->leasesSize = header->leasesSize;
+        }
+    }
+    close(fd);
+}
+
+ShmRingReader::~ShmRingReader() {}
+
+bool ShmRingReader::read(cv::Mat& frame, std::chrono::steady_clock::time_point& timestamp) {
+    while (true) {
+        const std::uint64_t seq = header->publishedSeq.load(std::memory_order_acquire);
+        if (seq == lastSeq) {
+            if (header->finished.load(std::memory_order_acquire)) {
+                return false;
+            }
+            std::this_thread::sleep_for(kPollingPeriod);
+            continue;
+        }
+
+        const ShmSlotHeader* slot = getSlot(header, seq);
+        std::int64_t timestampNs;
+        if (isZeroCopy()) {
+            // The writer doesn't take a leased slot, so the frame stays valid while the lease is held
+            std::unique_ptr<ShmLease> lease(new ShmLease{mapping, &mapping->leases[seq % header->slotsNum]});
+            lease->counter->fetch_add(1, std::memory_order_seq_cst);
+            if (slot->seq.load(std::memory_order_seq_cst) != seq) {
+                continue;  // the writer has already taken the slot, take the newer frame
+            }
+            timestampNs = slot->timestampNs;
+            frame = wrapLeased(header, slot, std::move(lease));
+        } else {
+            // Seqlock: the slot is valid if it holds the same frame before and after the copy
+            if (slot->seq.load(std::memory_order_acquire) != seq) {
+                continue;  // the writer has already wrapped around, take the newer frame
+            }
+            timestampNs = slot->timestampNs;
+            const cv::Mat slotFrame(header->rows, header->cols, header->type,
+                const_cast<char*>(reinterpret_cast<const char*>(slot) + header->dataOffset), header->step);
+            // The copy is a new matrix, since consumers may still hold the previous frame
+            cv::Mat copy;
+            slotFrame.copyTo(copy);
+            std::atomic_thread_fence(std::memory_order_acquire);
+            if (slot->seq.load(std::memory_order_relaxed) != seq) {
+                continue;  // the slot was overwritten during the copy
+            }
+            frame = copy;
+        }
+        lastSeq = seq;
+        timestamp = std::chrono::steady_clock::time_point(
+            std::chrono::duration_cast<std::chrono::steady_clock::duration>(std::chrono::nanoseconds(timestampNs)));
+        return true;
+    }
+}
+
+std::size_t ShmRingReader::getSlotsNum() const {
+    return header->slotsNum;
+}
+
+bool ShmRingReader::isZeroCopy() const {
+    return nullptr != mapping->leases;
+}
+
+#else
+
+ShmRingMapping::~ShmRingMapping() {}
+
+ShmRingWriter::ShmRingWriter(const std::string&, std::size_t, cv::Size, int)
+        : mapping(nullptr), mappingSize(0), header(nullptr) {
+    throw std::runtime_error("Shared memory frame rings are supported only on POSIX systems");
+}
+
+ShmRingWriter::~ShmRingWriter() {}
+
+bool ShmRingWriter::write(const cv::Mat&, std::chrono::steady_clock::time_point) {
+    return false;
+}
+
+ShmRingReader::ShmRingReader(const std::string&, bool)
+        : header(nullptr), lastSeq(0) {
+    throw std::runtime_error("Shared memory frame rings are supported only on POSIX systems");
+}
+
+ShmRingReader::~ShmRingReader() {}
+
+bool ShmRingReader::read(cv::Mat&, std::chrono::steady_clock::time_point&) {
+    return false;
+}
+
+std::size_t ShmRingReader::getSlotsNum() const {
+    return 0;
+}
+
+bool ShmRingReader::isZeroCopy() const {
+    return false;
+}
+
+#endif
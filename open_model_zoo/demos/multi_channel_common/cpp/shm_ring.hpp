@@ -0,0 +1,78 @@
+// Copyright (C) 2021 Intel Corporation
+// SPDX-License-Identifier: Apache-2.0
+//
+
+#pragma once
+
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <string>
+
+#include <opencv2/core.hpp>
+
+struct ShmRingHeader;
+struct ShmRingMapping;
+
+/// Publishes decoded frames through a ring of fixed-size slots in a POSIX shared memory object,
+/// so capture and decoding may run in a separate process and feed any number of consumers.
+/// Every frame gets a new sequence number, the slot is marked invalid while it is being overwritten.
+/// Slots leased by zero-copy readers are skipped, so the frames they hold are never overwritten.
+class ShmRingWriter {
+public:
+    /// Creates the shared memory object, an existing object with the same name is replaced
+    /// @param name - name of the object, e.g. "/cam0"
+    /// @param slotsNum - number of frames kept in the ring
+    /// @param frameSize, frameType - geometry of every frame, frames of other size are resized
+    ShmRingWriter(const std::string& name, std::size_t slotsNum, cv::Size frameSize, int frameType);
+    /// Tells readers that there are no more frames and unlinks the name. Readers keep their mappings
+    ~ShmRingWriter();
+
+    ShmRingWriter(const ShmRingWriter&) = delete;
+    ShmRingWriter& operator=(const ShmRingWriter&) = delete;
+
+    /// @returns false if the frame was dropped because readers lease every slot but the newest one
+    bool write(const cv::Mat& frame, std::chrono::steady_clock::time_point timestamp);
+
+private:
+    std::string name;
+    void* mapping;
+    std::size_t mappingSize;
+    ShmRingHeader* header;
+    cv::Mat resized;
+};
+
+/// Maps frames of a ring created by ShmRingWriter read-only.
+/// In zero-copy mode a frame is returned in place: the reader leases its slot and the writer skips leased slots
+/// until the last cv::Mat referencing the frame is released. Leasing needs write access to the lease table,
+/// if it can't be mapped writable, the reader falls back to copy mode.
+/// In copy mode every frame is copied out of its slot once and validated after the copy.
+/// Either way, a consumer may hold the frames it gets for any time and never sees a torn frame
+class ShmRingReader {
+public:
+    /// @param zeroCopy - lease slots instead of copying frames if the lease table is writable
+    explicit ShmRingReader(const std::string& name, bool zeroCopy = false);
+    ~ShmRingReader();
+
+    ShmRingReader(const ShmRingReader&) = delete;
+    ShmRingReader& operator=(const ShmRingReader&) = delete;
+
+    /// Waits for a frame newer than the previous one and returns the newest frame, frames which were
+    /// published in between are skipped. If the writer overwrites the slot before it is leased or during the copy,
+    /// the next newest frame is taken. Zero-copy frames are read-only memory, they must not be written in place.
+    /// Not thread-safe: a reader serves one consumer, concurrent consumers need their own readers or a lock
+    /// @returns false if the writer has finished and there are no new frames
+    bool read(cv::Mat& frame, std::chrono::steady_clock::time_point& timestamp);
+
+    std::size_t getSlotsNum() const;
+
+    bool isZeroCopy() const;
+
+private:
+    std::string name;
+    // Shared with zero-copy frames, so the mapping outlives the reader while they are held
+    std::shared_ptr<ShmRingMapping> mapping;
+    const ShmRingHeader* header;
+    std::uint64_t lastSeq;
+};
@@ -26,6 +26,7 @@
 #include <ngraph/ngraph.hpp>
 
 #include <monitors/presenter.h>
+#include <utils/frame_pool.hpp>
 #include <utils/ocv_common.hpp>
 #include <utils/slog.hpp>
 
@@ -57,6 +58,7 @@ void showUsage() {
     std::cout << "    -d \"<device>\"                " << target_device_message << std::endl;
     std::cout << "    -bs                          " << batch_size << std::endl;
     std::cout << "    -nireq                       " << num_infer_requests << std::endl;
+    std::cout << "    -batch_wait                  " << batch_wait_message << std::endl;
     std::cout << "    -n_iqs                       " << input_queue_size << std::endl;
     std::cout << "    -fps_sp                      " << fps_sampling_period << std::endl;
     std::cout << "    -n_sp                        " << num_sampling_periods << std::endl;
@@ -286,14 +288,15 @@ void displayNSources(const std::vector<std::shared_ptr<VideoFrame>>& data,
                      const std::string& stats,
                      const DisplayParams& params,
                      const std::vector<cv::Scalar> &colors,
+                     cv::Mat& mosaic,
                      Presenter& presenter,
                      PerformanceMetrics& metrics) {
-    cv::Mat windowImage = cv::Mat::zeros(params.windowSize, CV_8UC3);
+    cv::Mat windowImage;
     auto loopBody = [&](size_t i) {
         auto& elem = data[i];
         if (!elem->frame.empty()) {
-            cv::Rect rectFrame = cv::Rect(params.points[i], params.frameSize);
-            cv::Mat windowPart = windowImage(rectFrame);
+            cv::Rect rectFrame = cv::Rect(params.points[elem->sourceIdx], params.frameSize);
+            cv::Mat windowPart = mosaic(rectFrame);
             cv::resize(elem->frame, windowPart, params.frameSize);
             drawDetections(windowPart, elem->detections.get<std::vector<DetectionObject>>(), colors);
         }
@@ -329,6 +332,8 @@ void displayNSources(const std::vector<std::shared_ptr<VideoFrame>>& data,
         loopBody(i);
     }
 #endif
+    // Channels which are not in the group keep showing their previous frames
+    mosaic.copyTo(windowImage);
     presenter.drawGraphs(windowImage);
     drawStats();
     for (size_t i = 0; i < data.size() - 1; ++i) {
@@ -349,6 +354,9 @@ int main(int argc, char* argv[]) {
             return 0;
         }
 
+        // Frames, resized images and rendered outputs reuse buffers of previous frames
+        FramePool::enable();
+
         std::string modelPath = FLAGS_m;
         std::size_t found = modelPath.find_last_of(".");
         if (found > modelPath.size()) {
@@ -361,6 +369,7 @@ int main(int argc, char* argv[]) {
         IEGraph::InitParams graphParams;
         graphParams.batchSize       = FLAGS_bs;
         graphParams.maxRequests     = FLAGS_nireq;
+        graphParams.maxWaitTime     = std::chrono::milliseconds(FLAGS_batch_wait);
         graphParams.collectStats    = FLAGS_show_stats;
         graphParams.modelPath       = modelPath;
         graphParams.cpuExtPath      = FLAGS_l;
@@ -371,6 +380,8 @@ int main(int argc, char* argv[]) {
                                                         yoloParams = GetYoloParams(outputDataBlobNames, network);
                                                     };
 
+        // Sinks of the network reference the grouper, so it is declared first and is destroyed after the network
+        std::unique_ptr<FrameGrouper> grouper;
         std::shared_ptr<IEGraph> network(new IEGraph(graphParams));
         auto inputDims = network->getInputDims();
         if (4 != inputDims.size()) {
@@ -390,18 +401,52 @@ int main(int argc, char* argv[]) {
         DisplayParams params = prepareDisplayParams(sources.numberOfInputs() * FLAGS_duplicate_num);
         sources.start();
 
-        size_t currentFrame = 0;
-
         std::vector<cv::Scalar> colors;
         if (yoloParams.size() > 0)
             for (int i = 0; i < static_cast<int>(yoloParams.begin()->second.classes); ++i)
                 colors.push_back(cv::Scalar(rand() % 256, rand() % 256, rand() % 256));
 
-        network->start([&](VideoFrame& img) {
-            img.sourceIdx = currentFrame;
-            size_t camIdx = currentFrame / FLAGS_duplicate_num;
-            currentFrame = (currentFrame + 1) % (sources.numberOfInputs() * FLAGS_duplicate_num);
-            return sources.getFrame(camIdx, img);
+        network->setDetectionConfidence(static_cast<float>(FLAGS_t));
+
+        std::mutex statMutex;
+        std::stringstream statStream;
+
+        cv::Size graphSize{static_cast<int>(params.windowSize.width / 4), 60};
+        Presenter presenter(FLAGS_u, params.windowSize.height - graphSize.height - 10, graphSize);
+        PerformanceMetrics metrics;
+
+        cv::Mat mosaic = cv::Mat::zeros(params.windowSize, CV_8UC3);
+        const size_t outputQueueSize = 1;
+        AsyncOutput output(FLAGS_show_stats, outputQueueSize,
+        [&](const std::vector<std::shared_ptr<VideoFrame>>& result) {
+            std::string str;
+            if (FLAGS_show_stats) {
+                std::unique_lock<std::mutex> lock(statMutex);
+                str = statStream.str();
+            }
+            displayNSources(result, str, params, colors, mosaic, presenter, metrics);
+            int key = cv::waitKey(1);
+            presenter.handleKey(key);
+
+            return (key != 27);
+        });
+
+        output.start();
+
+        // Sinks are called from inference callbacks, which are finished before the network is destroyed,
+        // so the raw pointer stays valid in them
+        IEGraph* graph = network.get();
+        grouper.reset(new FrameGrouper(sources.numberOfInputs() * FLAGS_duplicate_num,
+                                       [&output, graph](std::vector<std::shared_ptr<VideoFrame>>&& group) {
+            if (!output.isAlive()) {
+                graph->stop();
+            } else if (!FLAGS_no_show) {
+                output.push(std::move(group));
+            }
+        }));
+
+        network->start([&](size_t channel, VideoFrame& img) {
+            return sources.getFrame(channel / FLAGS_duplicate_num, img);
         }, [&yoloParams](InferenceEngine::InferRequest::Ptr req,
                 const std::vector<std::string>& outputDataBlobNames,
                 cv::Size frameSize
@@ -434,80 +479,17 @@ int main(int argc, char* argv[]) {
             }
 
             return detections;
-        });
-
-        network->setDetectionConfidence(static_cast<float>(FLAGS_t));
-
-        std::vector<std::shared_ptr<VideoFrame>> batchRes;
-
-        std::mutex statMutex;
-        std::stringstream statStream;
-
-        cv::Size graphSize{static_cast<int>(params.windowSize.width / 4), 60};
-        Presenter presenter(FLAGS_u, params.windowSize.height - graphSize.height - 10, graphSize);
-        PerformanceMetrics metrics;
-
-        const size_t outputQueueSize = 1;
-        AsyncOutput output(FLAGS_show_stats, outputQueueSize,
-        [&](const std::vector<std::shared_ptr<VideoFrame>>& result) {
-            std::string str;
-            if (FLAGS_show_stats) {
-                std::unique_lock<std::mutex> lock(statMutex);
-                str = statStream.str();
-            }
-            displayNSources(result, str, params, colors, presenter, metrics);
-            int key = cv::waitKey(1);
-            presenter.handleKey(key);
-
-            return (key != 27);
-        });
-
-        output.start();
-
-        using timer = std::chrono::high_resolution_clock;
-        using duration = std::chrono::duration<float, std::milli>;
-        timer::time_point lastTime = timer::now();
-        duration samplingTimeout(FLAGS_fps_sp);
+        }, grouper->getSinks(), params.frameSize);
 
+        const std::chrono::milliseconds samplingTimeout(FLAGS_fps_sp);
         size_t perfItersCounter = 0;
-
-        while (sources.isRunning() || network->isRunning()) {
-            bool readData = true;
-            while (readData) {
-                auto br = network->getBatchData(params.frameSize);
-                if (br.empty()) {
-                    break;
-                }
-                for (size_t i = 0; i < br.size(); i++) {
-                    auto val = static_cast<unsigned int>(br[i]->sourceIdx);
-                    auto it = find_if(batchRes.begin(), batchRes.end(), [val] (const std::shared_ptr<VideoFrame>& vf) { return vf->sourceIdx == val; } );
-                    if (it != batchRes.end()) {
-                        if (!FLAGS_no_show) {
-                            output.push(std::move(batchRes));
-                        }
-                        batchRes.clear();
-                        readData = false;
-                    }
-                    batchRes.push_back(std::move(br[i]));
-                }
-            }
-
-            if (!output.isAlive()) {
-                break;
-            }
-
-            auto currTime = timer::now();
-            auto deltaTime = (currTime - lastTime);
-            if (deltaTime >= samplingTimeout) {
-                lastTime = currTime;
-
+        try {
+            while (network->waitFor(samplingTimeout)) {
                 if (FLAGS_show_stats) {
                     if (++perfItersCounter >= FLAGS_n_sp) {
                         break;
                     }
-                }
 
-                if (FLAGS_show_stats) {
                     std::unique_lock<std::mutex> lock(statMutex);
                     slog::debug << "------------------- Frame # " << perfItersCounter << "------------------" << slog::endl;
                     writeStats(slog::debug, slog::endl, sources.getStats(), network->getStats(), output.getStats());
@@ -515,12 +497,17 @@ int main(int argc, char* argv[]) {
                     writeStats(statStream, '\n', sources.getStats(), network->getStats(), output.getStats());
                 }
             }
+        } catch (...) {
+            // The network delivers frames to the output, so it is destroyed first
+            network.reset();
+            throw;
         }
 
         network.reset();
 
         slog::info << "Metrics report:" << slog::endl;
         metrics.logTotal();
+        FramePool::getInstance().logCounters();
         slog::info << presenter.reportMeans() << slog::endl;
     }
     catch (const std::exception& error) {
@@ -7,7 +7,10 @@
 * \file noise_suppression_demo/main.cpp
 * \example noise_suppression_demo/main.cpp
 */
+#include <algorithm>
 #include <climits>
+#include <cstring>
+#include <exception>
 #include <vector>
 #include <string>
 #include <chrono>
@@ -15,17 +18,25 @@
 #include <iostream>
 #include <fstream>
 
+#include <opencv2/core.hpp>
 #include "openvino/openvino.hpp"
 
 #include "gflags/gflags.h"
 #include "utils/common.hpp"
+#include "utils/latency_histogram.hpp"
 #include "utils/slog.hpp"
 
+#ifdef _WIN32
+#include <fcntl.h>
+#include <io.h>
+#endif
+
 typedef std::chrono::steady_clock Time;
 
 static const char help_message[] = "Print a usage message.";
-static const char inp_wav_message[] = "Required. Path to a input WAV file.";
-static const char out_wav_message[] = "Optional. Path to a output WAV file.";
+static const char inp_wav_message[] = "Required. Path to a input WAV file. Use \"-\" to read it from the standard input.";
+static const char out_wav_message[] = "Optional. Path to a output WAV file. Use \"-\" to write it to the standard output, "
+                                      "logs are written to the standard error then.";
 static const char model_message[] = "Required. Path to an .xml file with a trained model.";
 static const char target_device_message[] = "Optional. Specify the target device to infer on (the list of available "
                                             "devices is shown below). Default value is CPU. "
@@ -86,13 +97,7 @@ const unsigned int fourcc(const char c[4]) {
     return (c[3] << 24) | (c[2] << 16) | (c[1] << 8) | (c[0]);
 }
 
-void read_wav(const std::string& file_name, RiffWaveHeader& wave_header, std::vector<int16_t>& wave) {
-    std::ifstream inp_wave(file_name, std::ios::in|std::ios::binary);
-    if(!inp_wave.is_open())
-        throw std::logic_error("fail to open " + file_name);
-
-    inp_wave.read((char*)&wave_header, sizeof(RiffWaveHeader));
-
+void check_wav_header(const RiffWaveHeader& wave_header, const std::string& file_name) {
     std::string error_msg = "";
     #define CHECK_IF(cond) if(cond){ error_msg = error_msg + #cond + ", "; }
 
@@ -115,20 +120,107 @@ void read_wav(const std::string& file_name, RiffWaveHeader& wave_header, std::ve
     if (!error_msg.empty()) {
         throw std::logic_error(error_msg + "for '" + file_name + "' file.");
     }
+}
 
-    size_t wave_size = wave_header.data_length / sizeof(int16_t);
-    wave.resize(wave_size);
+// Reads samples of a WAV file or of the standard input ("-") incrementally, so memory doesn't depend on the length
+class WavReader {
+public:
+    explicit WavReader(const std::string& file_name) : stream(&std::cin) {
+        if (file_name != "-") {
+            file.open(file_name, std::ios::in|std::ios::binary);
+            if(!file.is_open())
+                throw std::logic_error("fail to open " + file_name);
+            stream = &file;
+        }
+        stream->read((char*)&wave_header, sizeof(RiffWaveHeader));
+        if (stream->gcount() != sizeof(RiffWaveHeader))
+            throw std::logic_error("fail to read WAV header of " + file_name);
+        check_wav_header(wave_header, file_name);
+        // Streaming writers don't know the length in advance and put 0 or 0xFFFFFFFF there
+        sized = wave_header.data_length > 0;
+        remaining = sized ? wave_header.data_length / sizeof(int16_t) : 0;
+    }
 
-    inp_wave.read((char*)&(wave.front()), wave_size * sizeof(int16_t));
-}
+    const RiffWaveHeader& header() const {
+        return wave_header;
+    }
 
-void write_wav(const std::string& file_name, const RiffWaveHeader& wave_header, const std::vector<int16_t>& wave) {
-    std::ofstream out_wave(file_name, std::ios::out|std::ios::binary);
-    if(!out_wave.is_open())
-        throw std::logic_error("fail to open " + file_name);
+    // returns number of samples read, less than count only at the end of data
+    size_t read(int16_t* samples, size_t count) {
+        if (sized)
+            count = std::min<size_t>(count, remaining);
+        stream->read((char*)samples, count * sizeof(int16_t));
+        size_t samples_read = stream->gcount() / sizeof(int16_t);
+        remaining -= sized ? samples_read : 0;
+        return samples_read;
+    }
+
+private:
+    std::ifstream file;
+    std::istream* stream;
+    RiffWaveHeader wave_header;
+    bool sized;
+    size_t remaining;
+};
+
+// Writes samples to a WAV file or to the standard output ("-") as they come.
+// Lengths in the header of a file are fixed up when the writer is destroyed
+class WavWriter {
+public:
+    WavWriter(const std::string& file_name, const RiffWaveHeader& input_header, std::ostream& stdout_stream)
+        : stream(&stdout_stream), wave_header(input_header), samples_written(0) {
+        if (file_name != "-") {
+            file.open(file_name, std::ios::out|std::ios::binary);
+            if(!file.is_open())
+                throw std::logic_error("fail to open " + file_name);
+            stream = &file;
+        }
+        stream->write((char*)&wave_header, sizeof(RiffWaveHeader));
+    }
+
+    ~WavWriter() {
+        if (file.is_open()) {
+            wave_header.data_length = static_cast<int>(samples_written * sizeof(int16_t));
+            wave_header.riff_length = wave_header.data_length + sizeof(RiffWaveHeader) - 8;
+            file.seekp(0);
+            file.write((char*)&wave_header, sizeof(RiffWaveHeader));
+        }
+    }
 
-    out_wave.write((char*)&wave_header, sizeof(RiffWaveHeader));
-    out_wave.write((char*)&(wave.front()), wave.size() * sizeof(int16_t));
+    void write(const int16_t* samples, size_t count) {
+        stream->write((const char*)samples, count * sizeof(int16_t));
+        if (!*stream)
+            throw std::logic_error("fail to write output samples");
+        samples_written += count;
+    }
+
+    void flush() {
+        stream->flush();
+    }
+
+private:
+    std::ofstream file;
+    std::ostream* stream;
+    RiffWaveHeader wave_header;
+    size_t samples_written;
+};
+
+// Conversions go through OpenCV, which vectorizes them
+void s16_to_f32(const int16_t* src, float* dst, size_t count) {
+    if (count == 0)
+        return;
+    cv::Mat dst_mat(1, static_cast<int>(count), CV_32FC1, dst);
+    cv::Mat(1, static_cast<int>(count), CV_16SC1, const_cast<int16_t*>(src))
+        .convertTo(dst_mat, CV_32F, 1.0 / std::numeric_limits<int16_t>::max());
+}
+
+// values are rounded and saturated
+void f32_to_s16(const float* src, int16_t* dst, size_t count) {
+    if (count == 0)
+        return;
+    cv::Mat dst_mat(1, static_cast<int>(count), CV_16SC1, dst);
+    cv::Mat(1, static_cast<int>(count), CV_32FC1, const_cast<float*>(src))
+        .convertTo(dst_mat, CV_16S, std::numeric_limits<int16_t>::max());
 }
 
 int main(int argc, char* argv[]) {
@@ -138,6 +230,19 @@ int main(int argc, char* argv[]) {
             return EXIT_FAILURE;
         }
 
+        // The file is processed patch by patch as it is read, so the demo can work as a live filter in a pipe
+#ifdef _WIN32
+        if (FLAGS_i == "-")
+            _setmode(_fileno(stdin), _O_BINARY);
+        if (FLAGS_o == "-")
+            _setmode(_fileno(stdout), _O_BINARY);
+#endif
+        std::ostream audio_out(std::cout.rdbuf());
+        if (FLAGS_o == "-") {
+            // keep the standard output for samples only
+            std::cout.rdbuf(std::cerr.rdbuf());
+        }
+
         slog::info << ov::get_openvino_version() << slog::endl;
 
         // Loading Inference Engine
@@ -182,7 +287,23 @@ int main(int argc, char* argv[]) {
         ov::runtime::CompiledModel compiled_model = core.compile_model(model, FLAGS_d);
         logCompiledModelInfo(compiled_model, FLAGS_m, FLAGS_d);
 
-        ov::runtime::InferRequest infer_request = compiled_model.create_infer_request();
+        // Two requests are used in turn. Output states of one request are input states of the other one,
+        // so states are carried over without copying, and next patch is prepared while current one is inferred
+        ov::runtime::InferRequest infer_requests[2] = {
+            compiled_model.create_infer_request(), compiled_model.create_infer_request()};
+        for (auto& state_name: state_names) {
+            const std::string& inp_state_name = state_name.first;
+            const std::string& out_state_name = state_name.second;
+            ov::Shape state_shape = model->input(inp_state_name).get_shape();
+            ov::runtime::Tensor states[2] = {
+                ov::runtime::Tensor(ov::element::f32, state_shape), ov::runtime::Tensor(ov::element::f32, state_shape)};
+            // first patch starts with zero state
+            memset(states[0].data<float>(), 0, states[0].get_byte_size());
+            infer_requests[0].set_tensor(inp_state_name, states[0]);
+            infer_requests[0].set_tensor(out_state_name, states[1]);
+            infer_requests[1].set_tensor(inp_state_name, states[1]);
+            infer_requests[1].set_tensor(out_state_name, states[0]);
+        }
 
         // Prepare input
         // get size of network input (patch_size)
@@ -190,71 +311,73 @@ int main(int argc, char* argv[]) {
         ov::Shape inp_shape = model->input(input_name).get_shape();
         size_t patch_size = inp_shape[1];
 
-        // read input wav file
-        RiffWaveHeader wave_header;
-        std::vector<int16_t> inp_wave_s16;
-        read_wav(FLAGS_i, wave_header, inp_wave_s16);
-
-        std::vector<int16_t> out_wave_s16;
-        out_wave_s16.resize(inp_wave_s16.size());
-
-        std::vector<float> inp_wave_fp32;
-        std::vector<float> out_wave_fp32;
-        // fp32 input wave will be expanded to be divisible by patch_size
-        size_t iter = 1 + (inp_wave_s16.size() / patch_size);
-        size_t inp_size = patch_size * iter;
-        inp_wave_fp32.resize(inp_size, 0);
-        out_wave_fp32.resize(inp_size, 0);
-
-        // convert sint16_t to float
-        float scale = 1.0f / std::numeric_limits<int16_t>::max();
-        for(size_t i = 0; i < inp_wave_s16.size(); ++i) {
-            inp_wave_fp32[i] = (float)inp_wave_s16[i] * scale;
+        WavReader reader(FLAGS_i);
+        WavWriter writer(FLAGS_o, reader.header(), audio_out);
+        std::vector<int16_t> patch_s16(patch_size);
+
+        // reads next patch into the input of the request, the last patch is padded with zeros
+        auto read_patch = [&](ov::runtime::InferRequest& infer_request) {
+            size_t samples = reader.read(patch_s16.data(), patch_size);
+            float* dst = infer_request.get_tensor(input_name).data<float>();
+            s16_to_f32(patch_s16.data(), dst, samples);
+            std::fill(dst + samples, dst + patch_size, 0.0f);
+            return samples;
+        };
+        auto write_patch = [&](ov::runtime::InferRequest& infer_request, size_t samples) {
+            const float* src = infer_request.get_tensor("output").data<float>();
+            f32_to_s16(src, patch_s16.data(), samples);
+            writer.write(patch_s16.data(), samples);
+        };
+
+        LatencyHistogram patch_latency;
+        Time::time_point patch_start_times[2];
+        for (int i = 0; i < 2; ++i) {
+            infer_requests[i].set_callback([&patch_latency, &patch_start_times, i](std::exception_ptr) {
+                patch_latency.record(Time::now() - patch_start_times[i]);
+            });
         }
 
         auto start_time = Time::now();
-        for(size_t i = 0; i < iter; ++i) {
-            ov::runtime::Tensor input_tensor(ov::element::f32, inp_shape, &inp_wave_fp32[i * patch_size]);
-            infer_request.set_tensor(input_name, input_tensor);
-
-            for (auto& state_name: state_names) {
-                const std::string& inp_state_name = state_name.first;
-                const std::string& out_state_name = state_name.second;
-                ov::runtime::Tensor state_tensor;
-                if (i > 0) {
-                    // set input state by coresponding output state from prev infer
-                    state_tensor = infer_request.get_tensor(out_state_name);
-                } else {
-                    // first iteration. set input state to zero tensor.
-                    ov::Shape state_shape = model->input(inp_state_name).get_shape();
-                    state_tensor = ov::runtime::Tensor(ov::element::f32, state_shape);
-                    memset(state_tensor.data<float>(), 0, state_tensor.get_byte_size());
-                }
-                infer_request.set_tensor(inp_state_name, state_tensor);
+        size_t total_samples = 0;
+        size_t patch_samples[2] = {read_patch(infer_requests[0]), 0};
+        for (size_t cur = 0; patch_samples[cur] > 0; cur = 1 - cur) {
+            size_t next = 1 - cur;
+            patch_start_times[cur] = Time::now();
+            infer_requests[cur].start_async();
+            // while current patch is inferred, previous output is written and next input is read
+            if (patch_samples[next] > 0) {
+                write_patch(infer_requests[next], patch_samples[next]);
+                writer.flush();
             }
-
-            // make infer
-            infer_request.infer();
-
-            {
-                // process output
-                float* src = infer_request.get_tensor("output").data<float>();
-                float* dst = &out_wave_fp32[i * patch_size];
-                memcpy(dst, src, patch_size * sizeof(float));
+            patch_samples[next] = read_patch(infer_requests[next]);
+            infer_requests[cur].wait();
+            total_samples += patch_samples[cur];
+            if (patch_samples[next] == 0) {
+                write_patch(infer_requests[cur], patch_samples[cur]);
+                writer.flush();
             }
-        } // for iter
+        }
+        for (auto& infer_request : infer_requests) {
+            infer_request.set_callback([](std::exception_ptr) {});
+        }
 
         using ms = std::chrono::duration<double, std::ratio<1, 1000>>;
         double total_latency = std::chrono::duration_cast<ms>(Time::now() - start_time).count();
+        double sample_length = total_samples / 16.0;
+        LatencyHistogram::Snapshot patch_latency_snapshot = patch_latency.getSnapshot();
         slog::info << "Metrics report:" << slog::endl;
         slog::info << "\tLatency: " << std::fixed << std::setprecision(1) << total_latency << " ms" << slog::endl;
-        slog::info << "\tSample length: " << std::fixed << std::setprecision(1) << patch_size * iter / 16.0f << " ms" << slog::endl;
-
-        // convert fp32 to int16_t
-        for(size_t i = 0; i < out_wave_s16.size(); ++i) {
-            out_wave_s16[i] = (int16_t)(out_wave_fp32[i] * std::numeric_limits<int16_t>::max());
+        slog::info << "\tSample length: " << std::fixed << std::setprecision(1) << sample_length << " ms" << slog::endl;
+        if (total_samples > 0) {
+            slog::info << "\tReal-time factor: " << std::fixed << std::setprecision(3) << total_latency / sample_length
+                << " (inference only: " << patch_latency_snapshot.getMean() * patch_latency_snapshot.totalCount / sample_length
+                << ")" << slog::endl;
+            slog::info << "\tPatch latency: mean " << std::setprecision(2) << patch_latency_snapshot.getMean() << " ms"
+                << ", p50 " << patch_latency_snapshot.getPercentile(50) << " ms"
+                << ", p90 " << patch_latency_snapshot.getPercentile(90) << " ms"
+                << ", p99 " << patch_latency_snapshot.getPercentile(99) << " ms"
+                << ", max " << patch_latency_snapshot.getMax() << " ms" << slog::endl;
         }
-        write_wav(FLAGS_o, wave_header, out_wave_s16);
     }
     catch (const std::exception& error) {
         std::cerr << error.what() << std::endl;
@@ -26,6 +26,7 @@
 #include <utils/slog.hpp>
 #include <utils/images_capture.h>
 #include <utils/default_flags.hpp>
+#include <utils/frame_pool.hpp>
 #include <utils/performance_metrics.hpp>
 #include <unordered_map>
 #include <gflags/gflags.h>
@@ -57,7 +58,13 @@ static const char thresh_output_message[] = "Optional. Probability threshold for
 static const char raw_output_message[] = "Optional. Inference results as raw values.";
 static const char input_resizable_message[] = "Optional. Enables resizable input with support of ROI crop & auto resize.";
 static const char nireq_message[] = "Optional. Number of infer requests. If this option is omitted, number of infer requests is determined automatically.";
+static const char batch_size_message[] = "Optional. Number of frames packed into one inference request. "
+"Default value is 1 (no batching). Not supported together with -auto_resize.";
+static const char batch_wait_message[] = "Optional. Maximum time in milliseconds the first frame of a batch waits "
+"for other frames before incomplete batch is submitted. Default value is 30.";
 static const char num_threads_message[] = "Optional. Number of threads.";
+static const char postproc_threads_message[] = "Optional. Number of threads postprocessing inference results in background. "
+"0 postprocesses them in the main loop. Default value is 0.";
 static const char num_streams_message[] = "Optional. Number of streams to use for inference on the CPU or/and GPU in "
 "throughput mode (for HETERO and MULTI device cases use format "
 "<device1>:<nstreams1>,<device2>:<nstreams2> or just <nstreams>)";
@@ -65,6 +72,8 @@ static const char no_show_message[] = "Optional. Don't show output.";
 static const char utilization_monitors_message[] = "Optional. List of monitors to show initially.";
 static const char iou_thresh_output_message[] = "Optional. Filtering intersection over union threshold for overlapping boxes.";
 static const char yolo_af_message[] = "Optional. Use advanced postprocessing/filtering algorithm for YOLO.";
+static const char soft_nms_sigma_message[] = "Optional. Sigma of gaussian soft-NMS for YOLO. If positive, confidence "
+    "of overlapping boxes decays instead of removing them at -iou_t. Default value is 0, which disables soft-NMS.";
 static const char output_resolution_message[] = "Optional. Specify the maximum output window resolution "
     "in (width x height) format. Example: 1280x720. Input frame size used by default.";
 static const char anchors_message[] = "Optional. A comma separated list of anchors. "
@@ -75,6 +84,10 @@ static const char reverse_input_channels_message[] = "Optional. Switch the input
 static const char mean_values_message[] = "Optional. Normalize input by subtracting the mean values per channel. Example: \"255.0 255.0 255.0\"";
 static const char scale_values_message[] = "Optional. Divide input by scale values per channel. Division is applied "
     "after mean values subtraction. Example: \"255.0 255.0 255.0\"";
+static const char latency_log_message[] = "Optional. Path to a file to append per-stage latency percentiles to "
+    "as JSON lines.";
+static const char latency_log_interval_message[] = "Optional. Interval in milliseconds between lines written to "
+    "the -latency_log file. Default value is 1000.";
 
 DEFINE_bool(h, false, help_message);
 DEFINE_string(at, "", at_message);
@@ -88,17 +101,23 @@ DEFINE_double(t, 0.5, thresh_output_message);
 DEFINE_double(iou_t, 0.5, iou_thresh_output_message);
 DEFINE_bool(auto_resize, false, input_resizable_message);
 DEFINE_uint32(nireq, 0, nireq_message);
+DEFINE_uint32(bs, 1, batch_size_message);
+DEFINE_uint32(batch_wait, 30, batch_wait_message);
 DEFINE_uint32(nthreads, 0, num_threads_message);
+DEFINE_uint32(postproc_threads, 0, postproc_threads_message);
 DEFINE_string(nstreams, "", num_streams_message);
 DEFINE_bool(no_show, false, no_show_message);
 DEFINE_string(u, "", utilization_monitors_message);
 DEFINE_bool(yolo_af, true, yolo_af_message);
+DEFINE_double(soft_nms_sigma, 0, soft_nms_sigma_message);
 DEFINE_string(output_resolution, "", output_resolution_message);
 DEFINE_string(anchors, "", anchors_message);
 DEFINE_string(masks, "", masks_message);
 DEFINE_bool(reverse_input_channels, false, reverse_input_channels_message);
 DEFINE_string(mean_values, "", mean_values_message);
 DEFINE_string(scale_values, "", scale_values_message);
+DEFINE_string(latency_log, "", latency_log_message);
+DEFINE_uint32(latency_log_interval, 1000, latency_log_interval_message);
 
 /**
 * \brief This function shows a help message
@@ -124,18 +143,24 @@ static void showUsage() {
     std::cout << "    -iou_t                    " << iou_thresh_output_message << std::endl;
     std::cout << "    -auto_resize              " << input_resizable_message << std::endl;
     std::cout << "    -nireq \"<integer>\"        " << nireq_message << std::endl;
+    std::cout << "    -bs \"<integer>\"           " << batch_size_message << std::endl;
+    std::cout << "    -batch_wait \"<integer>\"   " << batch_wait_message << std::endl;
     std::cout << "    -nthreads \"<integer>\"     " << num_threads_message << std::endl;
+    std::cout << "    -postproc_threads \"<integer>\" " << postproc_threads_message << std::endl;
     std::cout << "    -nstreams                 " << num_streams_message << std::endl;
     std::cout << "    -loop                     " << loop_message << std::endl;
     std::cout << "    -no_show                  " << no_show_message << std::endl;
     std::cout << "    -output_resolution        " << output_resolution_message << std::endl;
     std::cout << "    -u                        " << utilization_monitors_message << std::endl;
     std::cout << "    -yolo_af                  " << yolo_af_message << std::endl;
+    std::cout << "    -soft_nms_sigma           " << soft_nms_sigma_message << std::endl;
     std::cout << "    -anchors                  " << anchors_message << std::endl;
     std::cout << "    -masks                    " << masks_message << std::endl;
     std::cout << "    -reverse_input_channels   " << reverse_input_channels_message << std::endl;
     std::cout << "    -mean_values              " << mean_values_message << std::endl;
     std::cout << "    -scale_values             " << scale_values_message << std::endl;
+    std::cout << "    -latency_log \"<path>\"     " << latency_log_message << std::endl;
+    std::cout << "    -latency_log_interval     " << latency_log_interval_message << std::endl;
 }
 
 class ColorPalette {
@@ -253,7 +278,7 @@ cv::Mat renderDetectionData(DetectionResult& result, const ColorPalette& palette
     for (auto& obj : result.objects) {
         if (FLAGS_r) {
             slog::debug << " "
-                << std::left << std::setw(9) << obj.label << " | "
+                << std::left << std::setw(9) << obj.getLabel() << " | "
                 << std::setw(10) << obj.confidence << " | "
                 << std::setw(4) << int(obj.x) << " | "
                 << std::setw(4) << int(obj.y) << " | "
@@ -265,7 +290,7 @@ cv::Mat renderDetectionData(DetectionResult& result, const ColorPalette& palette
         std::ostringstream conf;
         conf << ":" << std::fixed << std::setprecision(1) << obj.confidence * 100 << '%';
         const auto& color = palette[obj.labelID];
-        putHighlightedText(outputImg, obj.label + conf.str(),
+        putHighlightedText(outputImg, obj.getLabel() + conf.str(),
             cv::Point2f(obj.x, obj.y - 5), cv::FONT_HERSHEY_COMPLEX_SMALL, 1, color, 2);
         cv::rectangle(outputImg, obj, color, 2);
     }
@@ -291,6 +316,9 @@ int main(int argc, char *argv[]) {
             return 0;
         }
 
+        // Frames, resized images and rendered outputs reuse buffers of previous frames
+        FramePool::enable();
+
         const auto& strAnchors = split(FLAGS_anchors, ',');
         const auto& strMasks = split(FLAGS_masks, ',');
 
@@ -314,7 +342,8 @@ int main(int argc, char *argv[]) {
         }
 
         //------------------------------- Preparing Input ------------------------------------------------------
-        auto cap = openImagesCapture(FLAGS_i, FLAGS_loop);
+        // Frames are decoded ahead on background threads while the pipeline runs inference
+        auto cap = openImagesCapture(FLAGS_i, FLAGS_loop, 0, std::numeric_limits<size_t>::max(), {1280, 720}, 4);
         cv::Mat curr_frame;
 
         //------------------------------ Running Detection routines ----------------------------------------------
@@ -340,7 +369,8 @@ int main(int argc, char *argv[]) {
             model.reset(new ModelSSD(FLAGS_m, (float)FLAGS_t, FLAGS_auto_resize, labels));
         }
         else if (FLAGS_at == "yolo") {
-            model.reset(new ModelYolo(FLAGS_m, (float)FLAGS_t, FLAGS_auto_resize, FLAGS_yolo_af, (float)FLAGS_iou_t, labels, anchors, masks));
+            model.reset(new ModelYolo(FLAGS_m, (float)FLAGS_t, FLAGS_auto_resize, FLAGS_yolo_af, (float)FLAGS_iou_t, labels, anchors, masks,
+                (float)FLAGS_soft_nms_sigma));
         }
         else {
             slog::err << "No model type or invalid model type (-at) provided: " + FLAGS_at << slog::endl;
@@ -351,10 +381,15 @@ int main(int argc, char *argv[]) {
 
         InferenceEngine::Core core;
 
+        BatchingParams batching;
+        batching.batchSize = FLAGS_bs;
+        batching.maxWaitTime = std::chrono::milliseconds(FLAGS_batch_wait);
+        PostprocessingParams postprocessing;
+        postprocessing.threadsNum = FLAGS_postproc_threads;
         AsyncPipeline pipeline(
             std::move(model),
             ConfigFactory::getUserConfig(FLAGS_d, FLAGS_l, FLAGS_c, FLAGS_nireq, FLAGS_nstreams, FLAGS_nthreads),
-            core);
+            core, AsyncPipeline::OutputsOwnership::Borrow, batching, postprocessing);
         Presenter presenter(FLAGS_u);
 
         bool keepRunning = true;
@@ -366,6 +401,18 @@ int main(int argc, char *argv[]) {
 
         PerformanceMetrics renderMetrics;
 
+        std::unique_ptr<LatencyHistogramWriter> latencyWriter;
+        if (!FLAGS_latency_log.empty()) {
+            latencyWriter.reset(new LatencyHistogramWriter(FLAGS_latency_log,
+                std::chrono::milliseconds(FLAGS_latency_log_interval)));
+            latencyWriter->addStage("decoding", cap->getMetrics());
+            latencyWriter->addStage("preprocessing", pipeline.getPreprocessMetrics());
+            latencyWriter->addStage("inference", pipeline.getInferenceMetircs());
+            latencyWriter->addStage("postprocessing", pipeline.getPostprocessMetrics());
+            latencyWriter->addStage("rendering", renderMetrics);
+            latencyWriter->addStage("total", metrics);
+        }
+
         cv::Size outputResolution;
         OutputTransform outputTransform = OutputTransform();
         size_t found = FLAGS_output_resolution.find("x");
@@ -426,6 +473,9 @@ int main(int argc, char *argv[]) {
                 renderMetrics.update(renderingStart);
                 metrics.update(result->metaData->asRef<ImageMetaData>().timeStamp,
                     outFrame, { 10, 22 }, cv::FONT_HERSHEY_COMPLEX, 0.65);
+                if (latencyWriter) {
+                    latencyWriter->update();
+                }
 
                 if (videoWriter.isOpened() && (FLAGS_limit == 0 || framesProcessed <= FLAGS_limit - 1)) {
                     videoWriter.write(outFrame);
@@ -459,6 +509,9 @@ int main(int argc, char *argv[]) {
                 renderMetrics.update(renderingStart);
                 metrics.update(result->metaData->asRef<ImageMetaData>().timeStamp,
                     outFrame, { 10, 22 }, cv::FONT_HERSHEY_COMPLEX, 0.65);
+                if (latencyWriter) {
+                    latencyWriter->update();
+                }
                 if (videoWriter.isOpened() && (FLAGS_limit == 0 || framesProcessed <= FLAGS_limit - 1)) {
                     videoWriter.write(outFrame);
                 }
@@ -470,11 +523,16 @@ int main(int argc, char *argv[]) {
             }
         }
 
+        if (latencyWriter) {
+            latencyWriter->flush();
+        }
+
         slog::info << "Metrics report:" << slog::endl;
         metrics.logTotal();
-        logLatencyPerStage(cap->getMetrics().getTotal().latency, pipeline.getPreprocessMetrics().getTotal().latency,
-            pipeline.getInferenceMetircs().getTotal().latency, pipeline.getPostprocessMetrics().getTotal().latency,
-            renderMetrics.getTotal().latency);
+        FramePool::getInstance().logCounters();
+        logLatencyPerStage(cap->getMetrics(), pipeline.getPreprocessMetrics(),
+            pipeline.getInferenceMetircs(), pipeline.getPostprocessMetrics(), renderMetrics);
+        pipeline.logQueueMetrics();
         slog::info << presenter.reportMeans() << slog::endl;
     }
     catch (const std::exception& error) {
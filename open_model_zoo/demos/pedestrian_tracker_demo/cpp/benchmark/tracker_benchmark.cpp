@@ -0,0 +1,254 @@
+// Copyright (C) 2021 Intel Corporation
+// SPDX-License-Identifier: Apache-2.0
+//
+
+// Compares PedestrianTracker using distance matrices with the same tracker computing every descriptor distance
+// separately, as it did before, on synthetic crowds of 50, 200 and 500 people.
+// Usage: pedestrian_tracker_benchmark
+
+#include <algorithm>
+#include <cmath>
+#include <iomanip>
+#include <iostream>
+#include <map>
+#include <memory>
+#include <random>
+#include <string>
+#include <tuple>
+#include <vector>
+
+#include <opencv2/core.hpp>
+#include <opencv2/imgproc.hpp>
+
+#include "tracker.hpp"
+#include "descriptor.hpp"
+#include "distance.hpp"
+
+#include "benchmark_utils.hpp"
+
+namespace {
+const cv::Size frameSize(1920, 1080);
+const int framesNum = 10;
+const uint64_t frameDurationMs = 33;
+// Pairwise distances are quadratic in the crowd size, larger crowds are timed with a single run
+const int singleRunPeopleNum = 200;
+// Distance matrices may differ from pairwise distances by rounding
+const float maxDistanceError = 1e-4f;
+const float maxAccuracyLoss = 0.01f;
+
+// Stands in for the re-identification network: a crop resized to 8x16 and stored as a column, as DescriptorIE
+// stores embeddings
+class CropDescriptor : public IImageDescriptor {
+public:
+    cv::Size size() const override { return cv::Size(1, cropSize.area() * 3); }
+
+    void Compute(const cv::Mat &mat, cv::Mat *descr) override {
+        cv::Mat crop;
+        cv::resize(mat, crop, cropSize);
+        crop.convertTo(crop, CV_32F);
+        *descr = crop.reshape(1, size().height);
+    }
+
+    void Compute(const std::vector<cv::Mat> &mats, std::vector<cv::Mat> *descrs) override {
+        descrs->resize(mats.size());
+        for (size_t i = 0; i < mats.size(); i++) {
+            Compute(mats[i], &(*descrs)[i]);
+        }
+    }
+
+private:
+    const cv::Size cropSize{8, 16};
+};
+
+// Computes every distance separately, as the tracker did before distance matrices
+class PairwiseDistance : public IDescriptorDistance {
+public:
+    explicit PairwiseDistance(const std::shared_ptr<IDescriptorDistance> &distance) : distance(distance) {}
+
+    float Compute(const cv::Mat &descr1, const cv::Mat &descr2) override {
+        return distance->Compute(descr1, descr2);
+    }
+
+    std::vector<float> Compute(const std::vector<cv::Mat> &descrs1, const std::vector<cv::Mat> &descrs2) override {
+        std::vector<float> distances;
+        for (size_t i = 0; i < descrs1.size(); i++) {
+            distances.push_back(distance->Compute(descrs1[i], descrs2[i]));
+        }
+        return distances;
+    }
+
+private:
+    std::shared_ptr<IDescriptorDistance> distance;
+};
+
+struct Crowd {
+    std::vector<cv::Mat> frames;
+    std::vector<TrackedObjects> detections;
+    // Person index of every detection, keyed by frame and box
+    std::map<std::tuple<int64_t, int, int, int, int>, int> people;
+};
+
+std::tuple<int64_t, int, int, int, int> detectionKey(const TrackedObject &object) {
+    return std::make_tuple(object.frame_idx, object.rect.x, object.rect.y, object.rect.width, object.rect.height);
+}
+
+// People with their own textures walking straight and bouncing off frame borders
+Crowd makeCrowd(int peopleNum, std::mt19937 &generator) {
+    std::uniform_real_distribution<float> x(0, static_cast<float>(frameSize.width));
+    std::uniform_real_distribution<float> y(0, static_cast<float>(frameSize.height));
+    std::uniform_real_distribution<float> velocity(-8, 8);
+    std::uniform_int_distribution<int> height(60, 120);
+    std::uniform_int_distribution<int> color(0, 255);
+    std::vector<cv::Mat> textures(peopleNum);
+    std::vector<cv::Size> sizes(peopleNum);
+    std::vector<cv::Point2f> positions(peopleNum), velocities(peopleNum);
+    for (int i = 0; i < peopleNum; i++) {
+        textures[i].create(16, 8, CV_8UC3);
+        for (auto it = textures[i].begin<cv::Vec3b>(); it != textures[i].end<cv::Vec3b>(); ++it) {
+            *it = cv::Vec3b(color(generator), color(generator), color(generator));
+        }
+        sizes[i].height = height(generator);
+        sizes[i].width = sizes[i].height * 2 / 5;
+        positions[i] = cv::Point2f(x(generator), y(generator));
+        velocities[i] = cv::Point2f(velocity(generator), velocity(generator));
+    }
+
+    Crowd crowd;
+    const cv::Rect frameRect(cv::Point(), frameSize);
+    for (int frameIdx = 0; frameIdx < framesNum; frameIdx++) {
+        cv::Mat frame(frameSize, CV_8UC3, cv::Scalar::all(127));
+        TrackedObjects detections;
+        for (int i = 0; i < peopleNum; i++) {
+            cv::Point2f &position = positions[i];
+            position += velocities[i];
+            if (position.x < 0 || position.x + sizes[i].width > frameSize.width) {
+                velocities[i].x = -velocities[i].x;
+                position.x = std::min(std::max(position.x, 0.0f), static_cast<float>(frameSize.width - sizes[i].width));
+            }
+            if (position.y < 0 || position.y + sizes[i].height > frameSize.height) {
+                velocities[i].y = -velocities[i].y;
+                position.y = std::min(std::max(position.y, 0.0f),
+                                      static_cast<float>(frameSize.height - sizes[i].height));
+            }
+            const cv::Rect rect = cv::Rect(cv::Point(position), sizes[i]) & frameRect;
+            cv::Mat roi = frame(rect);
+            cv::resize(textures[i], roi, rect.size(), 0, 0, cv::INTER_NEAREST);
+            TrackedObject detection(rect, 0.9f, frameIdx, -1);
+            detection.timestamp = frameIdx * frameDurationMs + 1;
+            crowd.people[detectionKey(detection)] = i;
+            detections.push_back(detection);
+        }
+        crowd.frames.push_back(frame);
+        crowd.detections.push_back(detections);
+    }
+    return crowd;
+}
+
+std::unique_ptr<PedestrianTracker> makeTracker(bool pairwise) {
+    std::unique_ptr<PedestrianTracker> tracker(new PedestrianTracker());
+    std::shared_ptr<IImageDescriptor> descriptorStrong = std::make_shared<CropDescriptor>();
+    std::shared_ptr<IDescriptorDistance> distanceFast = std::make_shared<MatchTemplateDistance>();
+    std::shared_ptr<IDescriptorDistance> distanceStrong = std::make_shared<CosDistance>(descriptorStrong->size());
+    if (pairwise) {
+        distanceFast = std::make_shared<PairwiseDistance>(distanceFast);
+        distanceStrong = std::make_shared<PairwiseDistance>(distanceStrong);
+    }
+    tracker->set_descriptor_fast(
+        std::make_shared<ResizedImageDescriptor>(cv::Size(16, 32), cv::InterpolationFlags::INTER_LINEAR));
+    tracker->set_distance_fast(distanceFast);
+    tracker->set_descriptor_strong(descriptorStrong);
+    tracker->set_distance_strong(distanceStrong);
+    return tracker;
+}
+
+std::unique_ptr<PedestrianTracker> track(const Crowd &crowd, bool pairwise) {
+    std::unique_ptr<PedestrianTracker> tracker = makeTracker(pairwise);
+    for (size_t i = 0; i < crowd.frames.size(); i++) {
+        tracker->Process(crowd.frames[i], crowd.detections[i], crowd.detections[i].front().timestamp);
+    }
+    return tracker;
+}
+
+// Share of detections which belong to the person most frequent in their track
+float trackingAccuracy(const PedestrianTracker &tracker, const Crowd &crowd) {
+    size_t detectionsNum = 0, correctNum = 0;
+    for (const auto &track : tracker.tracks()) {
+        std::map<int, size_t> personCounts;
+        for (const TrackedObject &object : track.second.objects) {
+            auto person = crowd.people.find(detectionKey(object));
+            if (person != crowd.people.end()) {
+                personCounts[person->second]++;
+            }
+        }
+        size_t maxCount = 0;
+        for (const auto &personCount : personCounts) {
+            maxCount = std::max(maxCount, personCount.second);
+        }
+        detectionsNum += track.second.objects.size();
+        correctNum += maxCount;
+    }
+    return detectionsNum ? static_cast<float>(correctNum) / detectionsNum : 0.0f;
+}
+
+std::vector<cv::Mat> frameDescriptors(IImageDescriptor &descriptor, const Crowd &crowd, int frameIdx) {
+    std::vector<cv::Mat> descriptors;
+    for (const TrackedObject &detection : crowd.detections[frameIdx]) {
+        cv::Mat descr;
+        descriptor.Compute(crowd.frames[frameIdx](detection.rect).clone(), &descr);
+        descriptors.push_back(descr);
+    }
+    return descriptors;
+}
+
+// Compares distance matrices with pairwise distances between descriptors of the first two frames
+double maxMatrixError(IDescriptorDistance &distance, IImageDescriptor &descriptor, const Crowd &crowd) {
+    const std::vector<cv::Mat> descrs1 = frameDescriptors(descriptor, crowd, 0);
+    const std::vector<cv::Mat> descrs2 = frameDescriptors(descriptor, crowd, 1);
+    PairwiseDistance pairwiseDistance(std::shared_ptr<IDescriptorDistance>(&distance, [](IDescriptorDistance *) {}));
+    return cv::norm(distance.ComputeMatrix(descrs1, descrs2), pairwiseDistance.ComputeMatrix(descrs1, descrs2),
+                    cv::NORM_INF);
+}
+
+template <typename Function>
+double timeMs(int peopleNum, Function &&function) {
+    return peopleNum > singleRunPeopleNum ? benchmark::medianTimeMs(function, 1, std::chrono::milliseconds(0))
+                                          : benchmark::medianTimeMs(function);
+}
+}  // namespace
+
+int main() {
+    try {
+        std::mt19937 generator(0);
+        std::cout << std::left << std::setw(10) << "People" << std::right << std::setw(12) << "Accuracy"
+                  << std::setw(22) << "Pairwise, ms/frame" << std::setw(20) << "Matrix, ms/frame" << std::setw(10)
+                  << "Speedup" << std::endl;
+        for (int peopleNum : {50, 200, 500}) {
+            const Crowd crowd = makeCrowd(peopleNum, generator);
+            const std::string name = std::to_string(peopleNum) + " people";
+
+            MatchTemplateDistance distanceFast;
+            ResizedImageDescriptor descriptorFast(cv::Size(16, 32), cv::InterpolationFlags::INTER_LINEAR);
+            benchmark::check(maxMatrixError(distanceFast, descriptorFast, crowd) <= maxDistanceError,
+                             "fast distance matrix differs from pairwise distances on " + name);
+            CropDescriptor descriptorStrong;
+            CosDistance distanceStrong(descriptorStrong.size());
+            benchmark::check(maxMatrixError(distanceStrong, descriptorStrong, crowd) <= maxDistanceError,
+                             "strong distance matrix differs from pairwise distances on " + name);
+
+            const float pairwiseAccuracy = trackingAccuracy(*track(crowd, true), crowd);
+            const float accuracy = trackingAccuracy(*track(crowd, false), crowd);
+            benchmark::check(accuracy >= pairwiseAccuracy - maxAccuracyLoss,
+                             "tracking with distance matrices is less accurate on " + name);
+
+            const double pairwiseMs = timeMs(peopleNum, [&] { track(crowd, true); }) / framesNum;
+            const double matrixMs = timeMs(peopleNum, [&] { track(crowd, false); }) / framesNum;
+            std::cout << std::left << std::setw(10) << peopleNum << std::right << std::fixed << std::setprecision(3)
+                      << std::setw(12) << accuracy << std::setw(22) << pairwiseMs << std::setw(20) << matrixMs
+                      << std::setprecision(1) << std::setw(9) << pairwiseMs / matrixMs << "x" << std::endl;
+        }
+    } catch (const std::exception &error) {
+        std::cerr << error.what() << std::endl;
+        return 1;
+    }
+    return 0;
+}
@@ -35,6 +35,16 @@ public:
     virtual std::vector<float> Compute(const std::vector<cv::Mat> &descrs1,
                                        const std::vector<cv::Mat> &descrs2) = 0;
 
+    ///
+    /// \brief Computes distances between every pair of descriptors.
+    /// \param[in] descrs1 First descriptors.
+    /// \param[in] descrs2 Second descriptors.
+    /// \return CV_32F matrix with descrs1.size() rows and descrs2.size()
+    /// columns, element (i, j) is the distance between descrs1[i] and descrs2[j].
+    ///
+    virtual cv::Mat ComputeMatrix(const std::vector<cv::Mat> &descrs1,
+                                  const std::vector<cv::Mat> &descrs2);
+
     virtual ~IDescriptorDistance() {}
 };
 
@@ -68,6 +78,16 @@ public:
         const std::vector<cv::Mat> &descrs1,
         const std::vector<cv::Mat> &descrs2) override;
 
+    ///
+    /// \brief Computes distances between every pair of descriptors with
+    /// a single matrix product of normalized descriptors.
+    /// \param[in] descrs1 First descriptors.
+    /// \param[in] descrs2 Second descriptors.
+    /// \return Matrix of distances.
+    ///
+    cv::Mat ComputeMatrix(const std::vector<cv::Mat> &descrs1,
+                          const std::vector<cv::Mat> &descrs2) override;
+
 private:
     cv::Size descriptor_size_;
 };
@@ -110,6 +130,16 @@ public:
     ///
     std::vector<float> Compute(const std::vector<cv::Mat> &descrs1,
                                const std::vector<cv::Mat> &descrs2) override;
+    ///
+    /// \brief Computes distances between every pair of descriptors. Normed
+    /// cross-correlation of images of the same size is their cosine similarity,
+    /// so it is computed with a single matrix product.
+    /// \param[in] descrs1 First image descriptors.
+    /// \param[in] descrs2 Second image descriptors.
+    /// \return Matrix of distances.
+    ///
+    cv::Mat ComputeMatrix(const std::vector<cv::Mat> &descrs1,
+                          const std::vector<cv::Mat> &descrs2) override;
     virtual ~MatchTemplateDistance() {}
 
 private:
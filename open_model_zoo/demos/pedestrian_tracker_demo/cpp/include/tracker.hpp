@@ -18,6 +18,7 @@
 #include "utils.hpp"
 #include "descriptor.hpp"
 #include "distance.hpp"
+#include <utils/assignment_solver.hpp>
 
 ///
 /// \brief The TrackerParams struct stores parameters of PedestrianTracker
@@ -411,6 +412,9 @@ private:
     // Parameters of the pipeline.
     TrackerParams params_;
 
+    // Track to detection matcher, pairs below strong_affinity_thr are never matched.
+    AssignmentSolver assignment_solver_;
+
     // Indexes of active tracks.
     std::set<size_t> active_track_ids_;
 
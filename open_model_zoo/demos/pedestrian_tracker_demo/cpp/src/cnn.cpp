@@ -70,9 +70,8 @@ void CnnBase::InferBatch(
     size_t num_imgs = frames.size();
     for (size_t batch_i = 0; batch_i < num_imgs; batch_i += batch_size) {
         const size_t current_batch_size = std::min(batch_size, num_imgs - batch_i);
-        for (size_t b = 0; b < current_batch_size; b++) {
-            matToBlob(frames[batch_i + b], input_blob_, b);
-        }
+        matToBlob(std::vector<cv::Mat>(frames.begin() + batch_i, frames.begin() + batch_i + current_batch_size),
+            input_blob_);
 
         infer_request_.Infer();
 
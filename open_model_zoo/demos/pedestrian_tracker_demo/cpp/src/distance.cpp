@@ -7,6 +7,37 @@
 
 #include <vector>
 
+namespace {
+// Stacks descriptors as rows of a CV_32F matrix, every row is divided by its L2 norm
+cv::Mat StackNormalized(const std::vector<cv::Mat> &descrs) {
+    PT_CHECK(!descrs.empty());
+    const cv::Mat &first = descrs.front();
+    cv::Mat rows(static_cast<int>(descrs.size()), static_cast<int>(first.total() * first.channels()), CV_32F);
+    for (size_t i = 0; i < descrs.size(); i++) {
+        const cv::Mat &descr = descrs[i];
+        PT_CHECK(!descr.empty());
+        PT_CHECK_EQ(descr.size(), first.size());
+        PT_CHECK_EQ(descr.type(), first.type());
+        cv::Mat row = rows.row(static_cast<int>(i));
+        (descr.isContinuous() ? descr : descr.clone()).reshape(1, 1).convertTo(row, CV_32F);
+        row *= 1.0 / (cv::norm(row) + 1e-6);
+    }
+    return rows;
+}
+}  // namespace
+
+cv::Mat IDescriptorDistance::ComputeMatrix(const std::vector<cv::Mat> &descrs1,
+                                           const std::vector<cv::Mat> &descrs2) {
+    cv::Mat distances(static_cast<int>(descrs1.size()), static_cast<int>(descrs2.size()), CV_32F);
+    for (size_t i = 0; i < descrs1.size(); i++) {
+        float *row = distances.ptr<float>(static_cast<int>(i));
+        for (size_t j = 0; j < descrs2.size(); j++) {
+            row[j] = Compute(descrs1[i], descrs2[j]);
+        }
+    }
+    return distances;
+}
+
 CosDistance::CosDistance(const cv::Size &descriptor_size)
     : descriptor_size_(descriptor_size) {
     PT_CHECK(descriptor_size.area() != 0);
@@ -30,14 +61,33 @@ std::vector<float> CosDistance::Compute(const std::vector<cv::Mat> &descrs1,
     PT_CHECK(descrs1.size() != 0);
     PT_CHECK(descrs1.size() == descrs2.size());
 
+    PT_CHECK(descrs1.front().size() == descriptor_size_);
+    PT_CHECK(descrs2.front().size() == descriptor_size_);
+
+    // Pairs are stacked, so similarities of all of them are computed by a few vectorized passes
+    cv::Mat similarities;
+    cv::reduce(StackNormalized(descrs1).mul(StackNormalized(descrs2)), similarities, 1, cv::REDUCE_SUM, CV_32F);
+
     std::vector<float> distances(descrs1.size(), 1.f);
     for (size_t i = 0; i < descrs1.size(); i++) {
-        distances.at(i) = Compute(descrs1.at(i), descrs2.at(i));
+        distances[i] = 0.5f * (1.0f - similarities.at<float>(static_cast<int>(i)));
     }
 
     return distances;
 }
 
+cv::Mat CosDistance::ComputeMatrix(const std::vector<cv::Mat> &descrs1,
+                                   const std::vector<cv::Mat> &descrs2) {
+    if (descrs1.empty() || descrs2.empty()) {
+        return cv::Mat(static_cast<int>(descrs1.size()), static_cast<int>(descrs2.size()), CV_32F);
+    }
+    PT_CHECK(descrs1.front().size() == descriptor_size_);
+    PT_CHECK(descrs2.front().size() == descriptor_size_);
+
+    cv::Mat similarities = StackNormalized(descrs1) * StackNormalized(descrs2).t();
+    return 0.5 * (1.0 - similarities);
+}
+
 
 float MatchTemplateDistance::Compute(const cv::Mat &descr1,
                                      const cv::Mat &descr2) {
@@ -59,3 +109,15 @@ std::vector<float> MatchTemplateDistance::Compute(const std::vector<cv::Mat> &de
     }
     return result;
 }
+
+cv::Mat MatchTemplateDistance::ComputeMatrix(const std::vector<cv::Mat> &descrs1,
+                                             const std::vector<cv::Mat> &descrs2) {
+    if (type_ != cv::TemplateMatchModes::TM_CCORR_NORMED || descrs1.empty() || descrs2.empty()) {
+        return IDescriptorDistance::ComputeMatrix(descrs1, descrs2);
+    }
+    PT_CHECK_EQ(descrs1.front().size(), descrs2.front().size());
+    PT_CHECK_EQ(descrs1.front().type(), descrs2.front().type());
+
+    cv::Mat similarities = StackNormalized(descrs1) * StackNormalized(descrs2).t();
+    return scale_ * similarities + offset_;
+}
@@ -11,11 +11,11 @@
 #include <utility>
 #include <limits>
 #include <algorithm>
+#include <cmath>
 
 #include "core.hpp"
 #include "tracker.hpp"
 #include "utils.hpp"
-#include <utils/kuhn_munkres.hpp>
 
 namespace {
 cv::Point Center(const cv::Rect& rect) {
@@ -143,6 +143,7 @@ void ValidateParams(const TrackerParams &p) {
 
 PedestrianTracker::PedestrianTracker(const TrackerParams &params)
     : params_(params),
+    assignment_solver_(1.0f - params.strong_affinity_thr),
     descriptor_strong_(nullptr),
     distance_strong_(nullptr),
     tracks_counter_(0),
@@ -237,7 +238,7 @@ void PedestrianTracker::SolveAssignmentProblem(
     ComputeDissimilarityMatrix(track_ids, detections, descriptors,
                                &dissimilarity);
 
-    auto res = KuhnMunkres().Solve(dissimilarity);
+    auto res = assignment_solver_.Solve(dissimilarity);
 
     for (size_t i = 0; i < detections.size(); i++) {
         unmatched_detections->insert(i);
@@ -523,18 +524,51 @@ void PedestrianTracker::ComputeDissimilarityMatrix(
     const std::set<size_t> &active_tracks, const TrackedObjects &detections,
     const std::vector<cv::Mat> &descriptors_fast,
     cv::Mat *dissimilarity_matrix) {
-    cv::Mat am(active_tracks.size(), detections.size(), CV_32F, cv::Scalar(0));
-    size_t i = 0;
+    std::vector<const Track *> tracks;
+    std::vector<cv::Mat> tracks_descriptors_fast;
+    tracks.reserve(active_tracks.size());
+    tracks_descriptors_fast.reserve(active_tracks.size());
     for (auto id : active_tracks) {
-        auto ptr = am.ptr<float>(i);
-        for (size_t j = 0; j < descriptors_fast.size(); j++) {
-            auto last_det = tracks_.at(id).objects.back();
-            last_det.rect = tracks_.at(id).predicted_rect;
-            ptr[j] = AffinityFast(tracks_.at(id).descriptor_fast, last_det,
-                                  descriptors_fast[j], detections[j]);
+        const Track &track = tracks_.at(id);
+        tracks.push_back(&track);
+        tracks_descriptors_fast.push_back(track.descriptor_fast);
+    }
+
+    // Appearance affinities of all pairs at once
+    cv::Mat am = 1.0 - distance_fast_->ComputeMatrix(tracks_descriptors_fast, descriptors_fast);
+
+    // Same as AffinityFast: shape, motion and time affinities are exponents, so their product is computed
+    // as a single exponent of the sum, and the pair gets zero affinity if any of them is below eps
+    const float log_eps = std::log(1e-6f);
+    const int dets_num = static_cast<int>(detections.size());
+    cv::parallel_for_(cv::Range(0, static_cast<int>(tracks.size())), [&](const cv::Range& range) {
+        cv::Mat exponents(1, dets_num, CV_32F);
+        std::vector<uchar> is_far(dets_num);
+        for (int i = range.start; i < range.end; i++) {
+            const cv::Rect &trk = tracks[i]->predicted_rect;
+            const float trk_time = static_cast<float>(tracks[i]->objects.back().frame_idx);
+            float *exponents_ptr = exponents.ptr<float>();
+            for (int j = 0; j < dets_num; j++) {
+                const cv::Rect &det = detections[j].rect;
+                // Integer division as in ShapeAffinity
+                float shp = -params_.shape_affinity_w * static_cast<float>(
+                    std::abs(trk.width - det.width) / (trk.width + det.width) +
+                    std::abs(trk.height - det.height) / (trk.height + det.height));
+                float mot = -params_.motion_affinity_w * (
+                    static_cast<float>(trk.x - det.x) * (trk.x - det.x) / (det.width * det.width) +
+                    static_cast<float>(trk.y - det.y) * (trk.y - det.y) / (det.height * det.height));
+                float time = -params_.time_affinity_w *
+                    std::fabs(trk_time - static_cast<float>(detections[j].frame_idx));
+                is_far[j] = shp < log_eps || mot < log_eps || time < log_eps;
+                exponents_ptr[j] = is_far[j] ? 0.0f : shp + mot + time;
+            }
+            cv::exp(exponents, exponents);
+            float *am_ptr = am.ptr<float>(i);
+            for (int j = 0; j < dets_num; j++) {
+                am_ptr[j] = is_far[j] ? 0.0f : am_ptr[j] * exponents_ptr[j];
+            }
         }
-        i++;
-    }
+    });
     *dissimilarity_matrix = 1.0 - am;
 }
 
@@ -543,8 +577,9 @@ std::vector<float> PedestrianTracker::ComputeDistances(
     const TrackedObjects& detections,
     const std::vector<std::pair<size_t, size_t>> &track_and_det_ids,
     std::map<size_t, cv::Mat> *det_id_to_descriptor) {
-    std::map<size_t, size_t> det_to_batch_ids;
-    std::map<size_t, size_t> track_to_batch_ids;
+    // Every pair has its detection image in the batch, and its track image if the track has no strong descriptor yet
+    std::vector<size_t> det_batch_ids(track_and_det_ids.size());
+    std::vector<size_t> track_batch_ids(track_and_det_ids.size(), std::numeric_limits<size_t>::max());
 
     std::vector<cv::Mat> images;
     std::vector<cv::Mat> descriptors;
@@ -552,33 +587,36 @@ std::vector<float> PedestrianTracker::ComputeDistances(
         size_t track_id = track_and_det_ids[i].first;
         size_t det_id = track_and_det_ids[i].second;
 
-        if (tracks_.at(track_id).descriptor_strong.empty()) {
-            images.push_back(tracks_.at(track_id).last_image);
-            descriptors.push_back(cv::Mat());
-            track_to_batch_ids[track_id] = descriptors.size() - 1;
+        const auto &track = tracks_.at(track_id);
+        if (track.descriptor_strong.empty()) {
+            images.push_back(track.last_image);
+            track_batch_ids[i] = images.size() - 1;
         }
 
         images.push_back(frame(detections[det_id].rect));
-        descriptors.push_back(cv::Mat());
-        det_to_batch_ids[det_id] = descriptors.size() - 1;
+        det_batch_ids[i] = images.size() - 1;
     }
+    descriptors.resize(images.size());
 
     descriptor_strong_->Compute(images, &descriptors);
 
     std::vector<cv::Mat> descriptors1;
     std::vector<cv::Mat> descriptors2;
+    descriptors1.reserve(track_and_det_ids.size());
+    descriptors2.reserve(track_and_det_ids.size());
     for (size_t i = 0; i < track_and_det_ids.size(); i++) {
         size_t track_id = track_and_det_ids[i].first;
         size_t det_id = track_and_det_ids[i].second;
 
-        if (tracks_.at(track_id).descriptor_strong.empty()) {
-            tracks_.at(track_id).descriptor_strong =
-                descriptors[track_to_batch_ids[track_id]].clone();
+        auto &track = tracks_.at(track_id);
+        if (track.descriptor_strong.empty()) {
+            track.descriptor_strong = descriptors[track_batch_ids[i]].clone();
         }
-        (*det_id_to_descriptor)[det_id] = descriptors[det_to_batch_ids[det_id]];
+        const cv::Mat &det_descriptor = descriptors[det_batch_ids[i]];
+        (*det_id_to_descriptor)[det_id] = det_descriptor;
 
-        descriptors1.push_back(descriptors[det_to_batch_ids[det_id]]);
-        descriptors2.push_back(tracks_.at(track_id).descriptor_strong);
+        descriptors1.push_back(det_descriptor);
+        descriptors2.push_back(track.descriptor_strong);
     }
 
     std::vector<float> distances =
@@ -289,6 +289,7 @@ bool Drawer::isReady() {
         if (std::chrono::steady_clock::now() - prevShow > showPeriod) {
             return true;
         } else {
+            tryNotifyAt(context.drawersContext.drawersWorker, prevShow + showPeriod);
             return false;
         }
     } else {
@@ -302,10 +303,12 @@ bool Drawer::isReady() {
             }
         } else {
             if (1u == gridMatIt->second.getUnupdatedSourceIDs().size()) {
-                if (context.drawersContext.lastShownframeId == sharedVideoFrame->frameId
-                    && std::chrono::steady_clock::now() - prevShow > showPeriod) {
+                if (context.drawersContext.lastShownframeId != sharedVideoFrame->frameId) {
+                    return false;
+                } else if (std::chrono::steady_clock::now() - prevShow > showPeriod) {
                     return true;
                 } else {
+                    tryNotifyAt(context.drawersContext.drawersWorker, prevShow + showPeriod);
                     return false;
                 }
             } else {
@@ -485,6 +488,8 @@ void DetectionsProcessor::process() {
                             }
                             classifiersAggregator->push(BboxAndDescr{BboxAndDescr::ObjectType::VEHICLE, rect, attributes.first + ' ' + attributes.second});
                             context.attributesInfers.inferRequests.lockedPushBack(attributesRequest);
+                            // The request may be what a parked DetectionsProcessor waits for
+                            tryNotify(context.detectionsProcessorsContext.detectionsProcessorsWorker);
                         }, classifiersAggregator,
                            std::ref(attributesRequest),
                            vehicleRect,
@@ -522,6 +527,8 @@ void DetectionsProcessor::process() {
                             }
                             classifiersAggregator->push(BboxAndDescr{BboxAndDescr::ObjectType::PLATE, rect, std::move(result)});
                             context.platesInfers.inferRequests.lockedPushBack(lprRequest);
+                            // The request may be what a parked DetectionsProcessor waits for
+                            tryNotify(context.detectionsProcessorsContext.detectionsProcessorsWorker);
                         }, classifiersAggregator,
                            std::ref(lprRequest),
                            plateRect,
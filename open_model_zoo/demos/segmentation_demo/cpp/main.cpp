@@ -48,8 +48,14 @@ static const char custom_cpu_library_message[] = "Required for CPU custom layers
 "Absolute path to a shared library with the kernel implementations.";
 static const char raw_output_message[] = "Optional. Output inference results as mask histogram.";
 static const char nireq_message[] = "Optional. Number of infer requests. If this option is omitted, number of infer requests is determined automatically.";
+static const char batch_size_message[] = "Optional. Number of frames packed into one inference request. "
+"Default value is 1 (no batching). Not supported together with -auto_resize.";
+static const char batch_wait_message[] = "Optional. Maximum time in milliseconds the first frame of a batch waits "
+"for other frames before incomplete batch is submitted. Default value is 30.";
 static const char input_resizable_message[] = "Optional. Enables resizable input with support of ROI crop & auto resize.";
 static const char num_threads_message[] = "Optional. Number of threads.";
+static const char postproc_threads_message[] = "Optional. Number of threads postprocessing inference results in background. "
+"0 postprocesses them in the main loop. Default value is 0.";
 static const char num_streams_message[] = "Optional. Number of streams to use for inference on the CPU or/and GPU in "
 "throughput mode (for HETERO and MULTI device cases use format "
 "<device1>:<nstreams1>,<device2>:<nstreams2> or just <nstreams>)";
@@ -67,8 +73,11 @@ DEFINE_string(c, "", custom_cldnn_message);
 DEFINE_string(l, "", custom_cpu_library_message);
 DEFINE_bool(r, false, raw_output_message);
 DEFINE_uint32(nireq, 0, nireq_message);
+DEFINE_uint32(bs, 1, batch_size_message);
+DEFINE_uint32(batch_wait, 30, batch_wait_message);
 DEFINE_bool(auto_resize, false, input_resizable_message);
 DEFINE_uint32(nthreads, 0, num_threads_message);
+DEFINE_uint32(postproc_threads, 0, postproc_threads_message);
 DEFINE_string(nstreams, "", num_streams_message);
 DEFINE_bool(no_show, false, no_show_message);
 DEFINE_string(u, "", utilization_monitors_message);
@@ -95,8 +104,11 @@ static void showUsage() {
     std::cout << "    -labels \"<path>\"          " << labels_message << std::endl;
     std::cout << "    -r                        " << raw_output_message << std::endl;
     std::cout << "    -nireq \"<integer>\"        " << nireq_message << std::endl;
+    std::cout << "    -bs \"<integer>\"           " << batch_size_message << std::endl;
+    std::cout << "    -batch_wait \"<integer>\"   " << batch_wait_message << std::endl;
     std::cout << "    -auto_resize              " << input_resizable_message << std::endl;
     std::cout << "    -nthreads \"<integer>\"     " << num_threads_message << std::endl;
+    std::cout << "    -postproc_threads \"<integer>\" " << postproc_threads_message << std::endl;
     std::cout << "    -nstreams                 " << num_streams_message << std::endl;
     std::cout << "    -loop                     " << loop_message << std::endl;
     std::cout << "    -no_show                  " << no_show_message << std::endl;
@@ -153,7 +165,7 @@ static const Color PASCAL_VOC_COLORS[] = {
     { 0,   64,  128 }
 };
 
-cv::Mat applyColorMap(cv::Mat input) {
+const cv::Mat& getColorMap() {
     // Initializing colors array if needed
     static cv::Mat colors;
     static std::mt19937 rng;
@@ -165,18 +177,14 @@ cv::Mat applyColorMap(cv::Mat input) {
         for (; i < arraySize(PASCAL_VOC_COLORS); ++i) {
             colors.at<cv::Vec3b>(i, 0) = { PASCAL_VOC_COLORS[i].blue(), PASCAL_VOC_COLORS[i].green(), PASCAL_VOC_COLORS[i].red() };
         }
-        for (; i < (std::size_t)colors.cols; ++i) {
+        for (; i < (std::size_t)colors.rows; ++i) {
             colors.at<cv::Vec3b>(i, 0) = cv::Vec3b(distr(rng), distr(rng), distr(rng));
         }
     }
-
-    // Converting class to color
-    cv::Mat out;
-    cv::applyColorMap(input, out, colors);
-    return out;
+    return colors;
 }
 
-cv::Mat renderSegmentationData(const ImageResult& result, OutputTransform& outputTransform, bool masks_only) {
+cv::Mat renderSegmentationData(const SegmentationResult& result, OutputTransform& outputTransform, bool masks_only) {
     if (!result.metaData) {
         throw std::invalid_argument("Renderer: metadata is null");
     }
@@ -188,8 +196,8 @@ cv::Mat renderSegmentationData(const ImageResult& result, OutputTransform& outpu
         throw std::invalid_argument("Renderer: image provided in metadata is empty");
     }
 
-    // Visualizing result data over source image
-    cv::Mat output = masks_only ? applyColorMap(result.resultImage) : inputImg / 2 + applyColorMap(result.resultImage) / 2;
+    // Visualizing result data over source image. The model paints the classes while computing them
+    cv::Mat output = masks_only ? result.colorMask : inputImg / 2 + result.colorMask / 2;
     outputTransform.resize(output);
     return output;
 }
@@ -230,17 +238,24 @@ int main(int argc, char* argv[]) {
         }
 
         //------------------------------- Preparing Input ------------------------------------------------------
-        auto cap = openImagesCapture(FLAGS_i, FLAGS_loop);
+        // Frames are decoded ahead on background threads while the pipeline runs inference
+        auto cap = openImagesCapture(FLAGS_i, FLAGS_loop, 0, std::numeric_limits<size_t>::max(), {1280, 720}, 4);
         cv::Mat curr_frame;
 
         //------------------------------ Running Segmentation routines ----------------------------------------------
         slog::info << *InferenceEngine::GetInferenceEngineVersion() << slog::endl;
 
         InferenceEngine::Core core;
-        AsyncPipeline pipeline(
-            std::unique_ptr<SegmentationModel>(new SegmentationModel(FLAGS_m, FLAGS_auto_resize)),
+        BatchingParams batching;
+        batching.batchSize = FLAGS_bs;
+        batching.maxWaitTime = std::chrono::milliseconds(FLAGS_batch_wait);
+        std::unique_ptr<SegmentationModel> model(new SegmentationModel(FLAGS_m, FLAGS_auto_resize));
+        model->setColorMap(getColorMap());
+        PostprocessingParams postprocessing;
+        postprocessing.threadsNum = FLAGS_postproc_threads;
+        AsyncPipeline pipeline(std::move(model),
             ConfigFactory::getUserConfig(FLAGS_d, FLAGS_l, FLAGS_c, FLAGS_nireq, FLAGS_nstreams, FLAGS_nthreads),
-            core);
+            core, AsyncPipeline::OutputsOwnership::Copy, batching, postprocessing);
         Presenter presenter(FLAGS_u);
 
         std::vector<std::string> labels;
@@ -305,11 +320,11 @@ int main(int argc, char* argv[]) {
             pipeline.waitForData();
 
             //--- Checking for results and rendering data if it's ready
-            //--- If you need just plain data without rendering - cast result's underlying pointer to ImageResult*
+            //--- If you need just plain data without rendering - cast result's underlying pointer to SegmentationResult*
             //    and use your own processing instead of calling renderSegmentationData().
             while (keepRunning && (result = pipeline.getResult())) {
                 auto renderingStart = std::chrono::steady_clock::now();
-                cv::Mat outFrame = renderSegmentationData(result->asRef<ImageResult>(), outputTransform, only_masks);
+                cv::Mat outFrame = renderSegmentationData(result->asRef<SegmentationResult>(), outputTransform, only_masks);
                 //--- Showing results and device information
                 if (FLAGS_r) {
                     printRawResults(result->asRef<ImageResult>(), labels);
@@ -344,7 +359,7 @@ int main(int argc, char* argv[]) {
         for (; framesProcessed <= frameNum; framesProcessed++) {
             result = pipeline.getResult();
             if (result != nullptr) {
-                cv::Mat outFrame = renderSegmentationData(result->asRef<ImageResult>(), outputTransform, only_masks);
+                cv::Mat outFrame = renderSegmentationData(result->asRef<SegmentationResult>(), outputTransform, only_masks);
                 //--- Showing results and device information
                 if (FLAGS_r) {
                     printRawResults(result->asRef<ImageResult>(), labels);
@@ -365,9 +380,9 @@ int main(int argc, char* argv[]) {
 
         slog::info << "Metrics report:" << slog::endl;
         metrics.logTotal();
-        logLatencyPerStage(cap->getMetrics().getTotal().latency, pipeline.getPreprocessMetrics().getTotal().latency,
-            pipeline.getInferenceMetircs().getTotal().latency, pipeline.getPostprocessMetrics().getTotal().latency,
-            renderMetrics.getTotal().latency);
+        logLatencyPerStage(cap->getMetrics(), pipeline.getPreprocessMetrics(),
+            pipeline.getInferenceMetircs(), pipeline.getPostprocessMetrics(), renderMetrics);
+        pipeline.logQueueMetrics();
         slog::info << presenter.reportMeans() << slog::endl;
     }
     catch (const std::exception& error) {
@@ -11,6 +11,7 @@
 #include <functional>
 
 #include <utils/ocv_common.hpp>
+#include <utils/roi_infer_queue.hpp>
 
 #include <inference_engine.hpp>
 
@@ -26,6 +27,8 @@ struct CnnConfig {
     std::string model_type;
     /** @brief Maximal size of batch */
     int max_batch_size{1};
+    /** @brief Number of infer requests running in parallel */
+    int num_requests{1};
 
     /** @brief Inference Engine */
     InferenceEngine::Core ie;
@@ -56,23 +59,29 @@ public:
     void Load();
 
 protected:
+    /**
+   * @brief Fetches inference results of one image
+   *
+   * Arguments are the request, the position of the image in the batch and its index in the input vector
+   */
+    using ResultsFetcher = std::function<void(InferenceEngine::InferRequest&, size_t, size_t)>;
+
     /**
    * @brief Run network
    *
    * @param frame Input image
    * @param results_fetcher Callback to fetch inference results
    */
-    void Infer(const cv::Mat& frame,
-               const std::function<void(const InferenceEngine::BlobMap&, size_t)>& results_fetcher) const;
+    void Infer(const cv::Mat& frame, const ResultsFetcher& results_fetcher) const;
 
     /**
-   * @brief Run network in batch mode
+   * @brief Run network in batch mode. Images are packed into batches of several infer requests
+   * running in parallel, and results are fetched from inference threads as requests complete
    *
    * @param frames Vector of input images
    * @param results_fetcher Callback to fetch inference results
    */
-    void InferBatch(const std::vector<cv::Mat>& frames,
-                    const std::function<void(const InferenceEngine::BlobMap&, size_t)>& results_fetcher) const;
+    void InferBatch(const std::vector<cv::Mat>& frames, const ResultsFetcher& results_fetcher) const;
 
     /** @brief Config */
     Config config_;
@@ -82,10 +91,8 @@ protected:
     InferenceEngine::OutputsDataMap outInfo_;
     /** @brief IE network */
     InferenceEngine::ExecutableNetwork executable_network_;
-    /** @brief IE InferRequest */
-    mutable InferenceEngine::InferRequest infer_request_;
-    /** @brief Name of the input blob input blob */
-    std::string input_blob_name_;
+    /** @brief Pool of IE InferRequests */
+    mutable std::unique_ptr<RoiInferQueue> infer_queue_;
     /** @brief Names of output blobs */
     std::vector<std::string> output_blobs_names_;
 };
@@ -98,6 +105,12 @@ public:
                  cv::Mat* vector, cv::Size outp_shape = cv::Size()) const;
     void Compute(const std::vector<cv::Mat>& images,
                  std::vector<cv::Mat>* vectors, cv::Size outp_shape = cv::Size()) const;
+
+    /** @brief Number of elements of the output vector of one image */
+    size_t VectorSize() const { return vector_size_; }
+
+private:
+    size_t vector_size_;
 };
 
 class AsyncAlgorithm {
@@ -5,6 +5,7 @@
 #pragma once
 
 #include <map>
+#include <memory>
 #include <string>
 #include <vector>
 
@@ -12,6 +13,8 @@
 
 #include "cnn.hpp"
 #include "detector.hpp"
+#include "gallery_cache.hpp"
+#include "gallery_index.hpp"
 
 enum class RegistrationStatus {
   SUCCESS,
@@ -29,6 +32,17 @@ struct GalleryObject {
         : embeddings(embeddings), label(label), id(id) {}
 };
 
+struct EmbeddingsGalleryOptions {
+    /// Path to a binary cache of embeddings, the cache isn't used if it's empty
+    std::string cache_path;
+    /// Identifies networks and settings embeddings are computed with. The cache is rebuilt if it changes
+    std::string cache_key;
+    /// Number of clusters of the approximate index, 0 makes the search exact
+    int ivf_lists = 0;
+    /// Number of clusters searched for every face
+    int ivf_probes = 1;
+};
+
 class EmbeddingsGallery {
 public:
     static const char unknown_label[];
@@ -37,7 +51,8 @@ public:
                       bool crop_gallery, const detection::DetectorConfig &detector_config,
                       const VectorCNN& landmarks_det,
                       const VectorCNN& image_reid,
-                      bool use_greedy_matcher=false);
+                      bool use_greedy_matcher=false,
+                      const EmbeddingsGalleryOptions& options=EmbeddingsGalleryOptions());
     size_t size() const;
     std::vector<int> GetIDsByEmbeddings(const std::vector<cv::Mat>& embeddings) const;
     std::string GetLabelByID(int id) const;
@@ -49,7 +64,7 @@ private:
                                         const cv::Mat& image,
                                         int min_size_fr,
                                         bool crop_gallery,
-                                        detection::FaceDetection& detector,
+                                        detection::FaceDetection* detector,
                                         const VectorCNN& landmarks_det,
                                         const VectorCNN& image_reid,
                                         cv::Mat & embedding);
@@ -57,6 +72,10 @@ private:
     double reid_threshold;
     std::vector<GalleryObject> identities;
     bool use_greedy_matcher;
+    // Normalized embeddings, one per row, which may reference the mapped cache
+    GalleryCache cache;
+    cv::Mat embeddings_matrix;
+    std::unique_ptr<GalleryIndex> index;
 };
 
 void AlignFaces(std::vector<cv::Mat>* face_images,
@@ -0,0 +1,79 @@
+// Copyright (C) 2021 Intel Corporation
+// SPDX-License-Identifier: Apache-2.0
+//
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include <opencv2/core/core.hpp>
+
+uint64_t HashBytes(const void* data, size_t size, uint64_t seed = 14695981039346656037ull);
+
+/// Read-only view of a whole file. The file is memory-mapped where it is supported, and read otherwise
+class MappedFile {
+public:
+    MappedFile() = default;
+    ~MappedFile();
+    MappedFile(const MappedFile&) = delete;
+    MappedFile& operator=(const MappedFile&) = delete;
+
+    /// @returns false if the file can't be opened
+    bool Open(const std::string& path);
+    void Close();
+
+    const char* data() const { return data_; }
+    size_t size() const { return size_; }
+
+private:
+    const char* data_ = nullptr;
+    size_t size_ = 0;
+    bool mapped_ = false;
+    std::vector<char> buffer_;
+};
+
+///
+/// \brief Binary cache of face gallery embeddings
+///
+/// The file holds a table of gallery images identified by hashes of their contents, with labels and
+/// rows of their embeddings, and L2-normalized embeddings as one row-major matrix. The file is mapped
+/// on load, so the matrix is used for search without copying. Images which failed registration are
+/// kept with no row, so they are skipped without running the networks again.
+///
+class GalleryCache {
+public:
+    struct Entry {
+        uint64_t image_hash;
+        std::string label;
+        int row;  ///< of the embedding, -1 if the image failed registration
+    };
+
+    ///
+    /// \brief Maps the cache file.
+    /// \param settings_hash Identifies networks and settings embeddings were computed with.
+    /// \param embedding_size Size of embeddings the network outputs.
+    /// \return false if the file doesn't exist, is damaged or has other settings.
+    ///
+    bool Load(const std::string& path, uint64_t settings_hash, size_t embedding_size);
+
+    /// \return Entry of an image with the same contents or nullptr
+    const Entry* Find(uint64_t image_hash) const;
+
+    size_t Size() const { return entries_.size(); }
+
+    /// \return Embeddings matrix which references the mapping
+    const cv::Mat& Embeddings() const { return embeddings_; }
+
+    static void Save(const std::string& path, uint64_t settings_hash,
+                     const std::vector<Entry>& entries, const cv::Mat& embeddings);
+
+private:
+    MappedFile file_;
+    std::vector<Entry> entries_;
+    std::unordered_map<uint64_t, size_t> entries_by_hash_;
+    cv::Mat embeddings_;
+};
@@ -0,0 +1,54 @@
+// Copyright (C) 2021 Intel Corporation
+// SPDX-License-Identifier: Apache-2.0
+//
+
+#pragma once
+
+#include <vector>
+
+#include <opencv2/core/core.hpp>
+
+///
+/// \brief Nearest neighbour search over gallery embeddings by cosine distance
+///
+/// Embeddings are rows of CV_32F matrices normalized to unit length, so similarities of all queries
+/// to all candidates are computed with one matrix product. Large galleries may use an inverted file
+/// index: embeddings are clustered with k-means, and queries are compared only with embeddings of
+/// the clusters which centers are the most similar to them.
+///
+class GalleryIndex {
+public:
+    struct Neighbour {
+        int row;
+        float distance;
+    };
+
+    ///
+    /// \brief Builds the index.
+    /// \param embeddings Gallery embeddings, referenced and not copied if the index is exact.
+    /// \param ivf_lists Number of clusters, 0 makes an exact index.
+    /// \param ivf_probes Number of clusters searched for every query.
+    ///
+    explicit GalleryIndex(const cv::Mat& embeddings, int ivf_lists = 0, int ivf_probes = 1);
+
+    ///
+    /// \brief Finds nearest gallery embeddings.
+    /// \param queries Normalized embeddings, one per row.
+    /// \param k Maximal number of neighbours of every query.
+    /// \return Neighbours of every query ordered by ascending distance.
+    ///
+    std::vector<std::vector<Neighbour>> Search(const cv::Mat& queries, int k) const;
+
+    bool IsExact() const { return centers_.empty(); }
+
+private:
+    // Exact index references the gallery. Inverted file index keeps embeddings reordered by clusters
+    cv::Mat embeddings_;
+    std::vector<int> rows_;
+    std::vector<int> list_begins_;
+    cv::Mat centers_;
+    int probes_;
+};
+
+/// Normalizes a vector of any shape to unit length and returns it as a CV_32F row
+cv::Mat NormalizedRow(const cv::Mat& vector);
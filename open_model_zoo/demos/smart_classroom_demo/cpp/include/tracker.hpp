@@ -13,6 +13,7 @@
 #include <unordered_map>
 #include <utility>
 #include <vector>
+#include <utils/assignment_solver.hpp>
 #include <utils/kuhn_munkres.hpp>
 
 struct TrackedObject {
@@ -155,6 +156,7 @@ public:
     ///
     explicit Tracker(const TrackerParams &params = TrackerParams())
         : params_(params),
+          assignment_solver_(1.0f - params.affinity_thr),
           tracks_counter_(0),
           frame_size_() {}
 
@@ -287,6 +289,9 @@ private:
     // Parameters of the pipeline.
     TrackerParams params_;
 
+    // Track to detection matcher, pairs below affinity_thr are never matched.
+    AssignmentSolver assignment_solver_;
+
     // Indexes of active tracks.
     std::set<size_t> active_track_ids_;
 
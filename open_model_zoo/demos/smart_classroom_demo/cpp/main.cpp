@@ -2,7 +2,11 @@
 // SPDX-License-Identifier: Apache-2.0
 //
 
+#include <sys/stat.h>
+
 #include <chrono>  // NOLINT
+#include <iomanip>
+#include <sstream>
 
 #include <gflags/gflags.h>
 #include <monitors/presenter.h>
@@ -375,6 +379,19 @@ int GetIndexOfTheNearestPerson(const TrackedObject& face, const std::vector<Trac
     return argmax;
 }
 
+// Size and modification time identify a version of a file without reading it
+std::string GetFileStamp(const std::string& path) {
+    struct stat file_stat;
+    if (stat(path.c_str(), &file_stat) != 0) {
+        return path;
+    }
+    return path + ' ' + std::to_string(file_stat.st_size) + ' ' + std::to_string(file_stat.st_mtime);
+}
+
+std::string GetModelStamp(const std::string& model_path) {
+    return GetFileStamp(model_path) + '\n' + GetFileStamp(fileNameNoExt(model_path) + ".bin");
+}
+
 std::map<int, int> GetMapFaceTrackIdToLabel(const std::vector<Track>& face_tracks) {
     std::map<int, int> face_track_id_to_label;
     for (const auto& track : face_tracks) {
@@ -415,6 +432,7 @@ public:
     virtual std::vector<std::string> GetIDToLabelMap() const = 0;
 
     virtual std::vector<int> Recognize(const cv::Mat& frame, const detection::DetectedObjects& faces) = 0;
+    virtual void LogThroughput() const {}
 };
 
 class FaceRecognizerNull : public FaceRecognizer {
@@ -442,13 +460,14 @@ public:
             double reid_threshold,
             int min_size_fr,
             bool crop_gallery,
-            bool greedy_reid_matching
+            bool greedy_reid_matching,
+            const EmbeddingsGalleryOptions& face_gallery_options
     )
         : landmarks_detector(landmarks_detector_config),
           face_reid(reid_config),
           face_gallery(face_gallery_path, reid_threshold, min_size_fr, crop_gallery,
                        face_registration_det_config, landmarks_detector, face_reid,
-                       greedy_reid_matching)
+                       greedy_reid_matching, face_gallery_options)
     {
         if (face_gallery.size() == 0) {
             slog::warn << "Face reid gallery is empty!" << slog::endl;
@@ -478,16 +497,55 @@ public:
 
         std::vector<cv::Mat> landmarks, embeddings;
 
+        auto start_time = std::chrono::steady_clock::now();
         landmarks_detector.Compute(face_rois, &landmarks, cv::Size(2, 5));
+        start_time = landmarks_throughput.Update(start_time, faces.size());
         AlignFaces(&face_rois, &landmarks);
+        start_time = alignment_throughput.Update(start_time, faces.size());
         face_reid.Compute(face_rois, &embeddings);
+        reid_throughput.Update(start_time, faces.size());
         return face_gallery.GetIDsByEmbeddings(embeddings);
     }
 
+    void LogThroughput() const override {
+        slog::info << "Face analysis throughput:" << slog::endl;
+        landmarks_throughput.Log("Landmarks regression");
+        alignment_throughput.Log("Alignment");
+        reid_throughput.Log("Reidentification");
+    }
+
 private:
+    // Time a stage takes and the number of faces it processes
+    class StageThroughput {
+    public:
+        std::chrono::steady_clock::time_point Update(std::chrono::steady_clock::time_point start_time,
+                                                     size_t faces_num) {
+            const auto end_time = std::chrono::steady_clock::now();
+            time += end_time - start_time;
+            this->faces_num += faces_num;
+            return end_time;
+        }
+
+        void Log(const std::string& stage) const {
+            const double seconds = std::chrono::duration<double>(time).count();
+            std::ostringstream report;
+            report << std::fixed << std::setprecision(1)
+                   << (seconds > 0 ? faces_num / seconds : 0.0) << " faces/s, "
+                   << (faces_num > 0 ? 1000 * seconds / faces_num : 0.0) << " ms per face";
+            slog::info << "\t" << stage << ": " << report.str() << slog::endl;
+        }
+
+    private:
+        std::chrono::steady_clock::duration time = std::chrono::steady_clock::duration::zero();
+        size_t faces_num = 0;
+    };
+
     VectorCNN landmarks_detector;
     VectorCNN face_reid;
     EmbeddingsGallery face_gallery;
+    StageThroughput landmarks_throughput;
+    StageThroughput alignment_throughput;
+    StageThroughput reid_throughput;
 };
 
 bool ParseAndCheckCommandLine(int argc, char *argv[]) {
@@ -506,6 +564,9 @@ bool ParseAndCheckCommandLine(int argc, char *argv[]) {
     if (FLAGS_m_act.empty() && FLAGS_m_fd.empty()) {
         throw std::logic_error("At least one parameter -m_act or -m_fd must be set");
     }
+    if (FLAGS_nireq_fr == 0) {
+        throw std::logic_error("Parameter -nireq_fr must be positive");
+    }
 
     return true;
 }
@@ -637,6 +698,7 @@ int main(int argc, char* argv[]) {
                 reid_config.max_batch_size = 16;
             else
                 reid_config.max_batch_size = 1;
+            reid_config.num_requests = static_cast<int>(FLAGS_nireq_fr);
             reid_config.ie = ie;
 
             CnnConfig landmarks_config(lm_model_path, "Facial Landmarks Regression");
@@ -645,12 +707,24 @@ int main(int argc, char* argv[]) {
                 landmarks_config.max_batch_size = 16;
             else
                 landmarks_config.max_batch_size = 1;
+            landmarks_config.num_requests = static_cast<int>(FLAGS_nireq_fr);
             landmarks_config.ie = ie;
 
+            EmbeddingsGalleryOptions face_gallery_options;
+            face_gallery_options.cache_path = FLAGS_fg_cache;
+            // Embeddings depend on the networks and on the registration detector settings. Models are identified
+            // by their files, so the cache is rebuilt if a model is replaced with another version at the same path
+            face_gallery_options.cache_key = GetModelStamp(fd_model_path) + '\n' + GetModelStamp(lm_model_path) + '\n'
+                + GetModelStamp(fr_model_path) + '\n'
+                + std::to_string(FLAGS_t_reg_fd) + '\n' + std::to_string(FLAGS_exp_r_fd);
+            face_gallery_options.ivf_lists = FLAGS_fg_ivf_lists;
+            face_gallery_options.ivf_probes = FLAGS_fg_ivf_probes;
+
             face_recognizer.reset(new FaceRecognizerDefault(
                 landmarks_config, reid_config,
                 face_registration_det_config,
-                FLAGS_fg, FLAGS_t_reid, FLAGS_min_size_fr, FLAGS_crop_gallery, FLAGS_greedy_reid_matching));
+                FLAGS_fg, FLAGS_t_reid, FLAGS_min_size_fr, FLAGS_crop_gallery, FLAGS_greedy_reid_matching,
+                face_gallery_options));
 
             if (actions_type == TEACHER && !face_recognizer->LabelExists(teacher_id)) {
                 slog::err << "Teacher id does not exist in the gallery!" << slog::endl;
@@ -969,6 +1043,7 @@ int main(int argc, char* argv[]) {
 
         slog::info << "Metrics report:" << slog::endl;
         metrics.logTotal();
+        face_recognizer->LogThroughput();
         slog::info << presenter.reportMeans() << slog::endl;
     }
     catch (const std::exception& error) {
@@ -37,6 +37,8 @@ static const char target_device_message_face_reid[] = "Optional. Specify the tar
                                                       "Use \"-d HETERO:<comma-separated_devices_list>\" format to specify HETERO plugin. "
                                                       "The application looks for a suitable plugin for the specified device.";
 static const char greedy_reid_matching_message[] = "Optional. Use faster greedy matching algorithm in face reid.";
+static const char nireq_fr_message[] = "Optional. Number of infer requests for each of Facial Landmarks Regression and "
+                                       "Face Reidentification networks. The default value is 2.";
 static const char custom_cldnn_message[] = "Optional. For GPU custom kernels, if any. "
                                            "Absolute path to an .xml file with the kernels description.";
 static const char custom_cpu_library_message[] = "Optional. For CPU custom layers, if any. "
@@ -46,6 +48,13 @@ static const char person_threshold_output_message[] = "Optional. Probability thr
 static const char action_threshold_output_message[] = "Optional. Probability threshold for action recognition.";
 static const char threshold_output_message_face_reid[] = "Optional. Cosine distance threshold between two vectors for face reidentification.";
 static const char reid_gallery_path_message[] = "Optional. Path to a faces gallery in .json format.";
+static const char reid_gallery_cache_message[] = "Optional. Path to a binary cache of faces gallery embeddings. "
+                                                 "Only new or changed gallery images are processed if the cache exists. "
+                                                 "The cache is rebuilt if a model file changes.";
+static const char reid_gallery_ivf_lists_message[] = "Optional. Number of clusters of an approximate faces gallery index. "
+                                                     "Default value is 0, which makes the search exact.";
+static const char reid_gallery_ivf_probes_message[] = "Optional. Number of clusters of the approximate faces gallery index "
+                                                      "searched for every face.";
 static const char act_stat_output_message[] = "Optional. Output file name to save per-person action statistics in.";
 static const char raw_output_message[] = "Optional. Output Inference results as raw values.";
 static const char no_show_message[] = "Optional. Don't show output.";
@@ -79,6 +88,7 @@ DEFINE_string(d_fd, "CPU", target_device_message_face_detection);
 DEFINE_string(d_lm, "CPU", target_device_message_landmarks_regression);
 DEFINE_string(d_reid, "CPU", target_device_message_face_reid);
 DEFINE_bool(greedy_reid_matching, false, greedy_reid_matching_message);
+DEFINE_uint32(nireq_fr, 2, nireq_fr_message);
 DEFINE_string(c, "", custom_cldnn_message);
 DEFINE_string(l, "", custom_cpu_library_message);
 DEFINE_string(ad, "", act_stat_output_message);
@@ -88,6 +98,9 @@ DEFINE_double(t_ar, 0.75, action_threshold_output_message);
 DEFINE_double(t_fd, 0.6, face_threshold_output_message);
 DEFINE_double(t_reid, 0.7, threshold_output_message_face_reid);
 DEFINE_string(fg, "", reid_gallery_path_message);
+DEFINE_string(fg_cache, "", reid_gallery_cache_message);
+DEFINE_int32(fg_ivf_lists, 0, reid_gallery_ivf_lists_message);
+DEFINE_int32(fg_ivf_probes, 4, reid_gallery_ivf_probes_message);
 DEFINE_bool(no_show, false, no_show_message);
 DEFINE_int32(inh_fd, 600, input_image_height_output_message);
 DEFINE_int32(inw_fd, 600, input_image_width_output_message);
@@ -133,6 +146,7 @@ static void showUsage() {
     std::cout << "    -d_lm '<device>'               " << target_device_message_landmarks_regression << std::endl;
     std::cout << "    -d_reid '<device>'             " << target_device_message_face_reid << std::endl;
     std::cout << "    -greedy_reid_matching          " << greedy_reid_matching_message << std::endl;
+    std::cout << "    -nireq_fr                      " << nireq_fr_message << std::endl;
     std::cout << "    -r                             " << raw_output_message << std::endl;
     std::cout << "    -ad                            " << act_stat_output_message << std::endl;
     std::cout << "    -t_ad                          " << person_threshold_output_message << std::endl;
@@ -143,6 +157,9 @@ static void showUsage() {
     std::cout << "    -exp_r_fd                      " << expand_ratio_output_message << std::endl;
     std::cout << "    -t_reid                        " << threshold_output_message_face_reid << std::endl;
     std::cout << "    -fg                            " << reid_gallery_path_message << std::endl;
+    std::cout << "    -fg_cache                      " << reid_gallery_cache_message << std::endl;
+    std::cout << "    -fg_ivf_lists                  " << reid_gallery_ivf_lists_message << std::endl;
+    std::cout << "    -fg_ivf_probes                 " << reid_gallery_ivf_probes_message << std::endl;
     std::cout << "    -teacher_id                    " << teacher_id_message << std::endl;
     std::cout << "    -no_show                       " << no_show_message << std::endl;
     std::cout << "    -min_ad                        " << min_action_duration_message << std::endl;
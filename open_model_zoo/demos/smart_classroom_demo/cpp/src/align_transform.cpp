@@ -54,19 +54,23 @@ void AlignFaces(std::vector<cv::Mat>* face_images,
         return;
     }
     CV_Assert(face_images->size() == landmarks_vec->size());
-    cv::Mat ref_landmarks = cv::Mat(5, 2, CV_32F);
 
-    for (size_t j = 0; j < face_images->size(); j++) {
-        for (int i = 0; i < ref_landmarks.rows; i++) {
-            ref_landmarks.at<float>(i, 0) =
-                    ref_landmarks_normalized[2 * i] * face_images->at(j).cols;
-            ref_landmarks.at<float>(i, 1) =
-                    ref_landmarks_normalized[2 * i + 1] * face_images->at(j).rows;
-            landmarks_vec->at(j).at<float>(i, 0) *= face_images->at(j).cols;
-            landmarks_vec->at(j).at<float>(i, 1) *= face_images->at(j).rows;
+    // Faces are aligned into new images, since crops of a frame may overlap
+    cv::parallel_for_(cv::Range(0, static_cast<int>(face_images->size())), [&](const cv::Range& range) {
+        cv::Mat ref_landmarks = cv::Mat(5, 2, CV_32F);
+        for (int j = range.start; j < range.end; j++) {
+            cv::Mat& face = face_images->at(j);
+            cv::Mat& landmarks = landmarks_vec->at(j);
+            for (int i = 0; i < ref_landmarks.rows; i++) {
+                ref_landmarks.at<float>(i, 0) = ref_landmarks_normalized[2 * i] * face.cols;
+                ref_landmarks.at<float>(i, 1) = ref_landmarks_normalized[2 * i + 1] * face.rows;
+                landmarks.at<float>(i, 0) *= face.cols;
+                landmarks.at<float>(i, 1) *= face.rows;
+            }
+            cv::Mat m = GetTransform(&ref_landmarks, &landmarks);
+            cv::Mat aligned;
+            cv::warpAffine(face, aligned, m, face.size(), cv::WARP_INVERSE_MAP);
+            face = aligned;
         }
-        cv::Mat m = GetTransform(&ref_landmarks, &landmarks_vec->at(j));
-        cv::warpAffine(face_images->at(j), face_images->at(j), m,
-                       face_images->at(j).size(), cv::WARP_INVERSE_MAP);
-    }
+    });
 }
@@ -29,7 +29,6 @@ void CnnDLSDKBase::Load() {
     }
     in.begin()->second->setPrecision(InferenceEngine::Precision::U8);
     in.begin()->second->setLayout(InferenceEngine::Layout::NCHW);
-    input_blob_name_ = in.begin()->first;
 
     InferenceEngine::OutputsDataMap out = cnnNetwork.getOutputsInfo();
     for (auto&& item : out) {
@@ -45,36 +44,36 @@ void CnnDLSDKBase::Load() {
             {{InferenceEngine::PluginConfigParams::KEY_DYN_BATCH_ENABLED, InferenceEngine::PluginConfigParams::NO}});
     }
     logExecNetworkInfo(executable_network_, config_.path_to_model, config_.deviceName, config_.model_type);
-    infer_request_ = executable_network_.CreateInferRequest();
+    infer_queue_.reset(new RoiInferQueue(executable_network_, static_cast<size_t>(std::max(config_.num_requests, 1)),
+                                         config_.max_batch_size != 1));
 }
 
-void CnnDLSDKBase::InferBatch(
-        const std::vector<cv::Mat>& frames,
-        const std::function<void(const InferenceEngine::BlobMap&, size_t)>& fetch_results) const {
-    InferenceEngine::Blob::Ptr input = infer_request_.GetBlob(input_blob_name_);
-    const size_t batch_size = input->getTensorDesc().getDims()[0];
-
-    size_t num_imgs = frames.size();
-    for (size_t batch_i = 0; batch_i < num_imgs; batch_i += batch_size) {
-        const size_t current_batch_size = std::min(batch_size, num_imgs - batch_i);
-        for (size_t b = 0; b < current_batch_size; b++) {
-            matToBlob(frames[batch_i + b], input, b);
-        }
-
-        if (config_.max_batch_size != 1)
-            infer_request_.SetBatch(current_batch_size);
-        infer_request_.Infer();
-
-        InferenceEngine::BlobMap blobs;
-        for (const auto& name : output_blobs_names_)  {
-            blobs[name] = infer_request_.GetBlob(name);
+void CnnDLSDKBase::InferBatch(const std::vector<cv::Mat>& frames, const ResultsFetcher& fetch_results) const {
+    // Crops are spread over the requests, so that they are inferred in parallel instead of filling a single batch
+    const size_t num_requests = static_cast<size_t>(std::max(config_.num_requests, 1));
+    const size_t batch_size = std::min(infer_queue_->getBatchSize(),
+                                       (frames.size() + num_requests - 1) / num_requests);
+    try {
+        for (size_t i = 0; i < frames.size(); i++) {
+            infer_queue_->push(frames[i], [&fetch_results, i](InferenceEngine::InferRequest& request,
+                                                              size_t batch_index) {
+                fetch_results(request, batch_index, i);
+            });
+            if ((i + 1) % batch_size == 0) {
+                infer_queue_->flush();
+            }
         }
-        fetch_results(blobs, current_batch_size);
+        infer_queue_->waitAll();
+    } catch (...) {
+        // Requests in flight call fetch_results, which refers to the caller's data, so they must complete first
+        try {
+            infer_queue_->waitAll();
+        } catch (...) {}
+        throw;
     }
 }
 
-void CnnDLSDKBase::Infer(const cv::Mat& frame,
-                         const std::function<void(const InferenceEngine::BlobMap&, size_t)>& fetch_results) const {
+void CnnDLSDKBase::Infer(const cv::Mat& frame, const ResultsFetcher& fetch_results) const {
     InferBatch({frame}, fetch_results);
 }
 
@@ -84,6 +83,12 @@ VectorCNN::VectorCNN(const Config& config)
     if (output_blobs_names_.size() != 1) {
         throw std::runtime_error("Demo supports topologies only with 1 output");
     }
+    const InferenceEngine::SizeVector dims =
+        executable_network_.GetOutputsInfo().begin()->second->getTensorDesc().getDims();
+    vector_size_ = 1;
+    for (size_t i = 1; i < dims.size(); i++) {
+        vector_size_ *= dims[i];
+    }
 }
 
 void VectorCNN::Compute(const cv::Mat& frame,
@@ -98,29 +103,23 @@ void VectorCNN::Compute(const std::vector<cv::Mat>& images, std::vector<cv::Mat>
     if (images.empty()) {
         return;
     }
-    vectors->clear();
-    auto results_fetcher = [vectors, outp_shape](const InferenceEngine::BlobMap& outputs, size_t batch_size) {
-        for (auto&& item : outputs) {
-            InferenceEngine::Blob::Ptr blob = item.second;
+    vectors->assign(images.size(), cv::Mat());
+    // Every image has its own element of vectors, so results are written from several threads safely
+    auto results_fetcher = [this, vectors, outp_shape](InferenceEngine::InferRequest& request,
+                                                        size_t batch_index, size_t image_index) {
+        for (const auto& name : output_blobs_names_) {
+            InferenceEngine::Blob::Ptr blob = request.GetBlob(name);
             if (blob == nullptr) {
-                throw std::runtime_error("VectorCNN::Compute() Invalid blob '" + item.first + "'");
-            }
-            InferenceEngine::SizeVector ie_output_dims = blob->getTensorDesc().getDims();
-            std::vector<int> blob_sizes(ie_output_dims.size(), 0);
-            for (size_t i = 0; i < blob_sizes.size(); ++i) {
-                blob_sizes[i] = ie_output_dims[i];
+                throw std::runtime_error("VectorCNN::Compute() Invalid blob '" + name + "'");
             }
+            const size_t vector_size = blob->size() / blob->getTensorDesc().getDims()[0];
             InferenceEngine::LockedMemory<const void> blobMapped =
                 InferenceEngine::as<InferenceEngine::MemoryBlob>(blob)->rmap();
-            cv::Mat out_blob(blob_sizes, CV_32F, blobMapped.as<float*>());
-            for (size_t b = 0; b < batch_size; b++) {
-                cv::Mat blob_wrapper(out_blob.size[1], 1, CV_32F,
-                                     reinterpret_cast<void*>((out_blob.ptr<float>(0) + b * out_blob.size[1])));
-                vectors->emplace_back();
-                if (outp_shape != cv::Size())
-                    blob_wrapper = blob_wrapper.reshape(1, {outp_shape.height, outp_shape.width});
-                blob_wrapper.copyTo(vectors->back());
-            }
+            cv::Mat blob_wrapper(static_cast<int>(vector_size), 1, CV_32F,
+                                 const_cast<float*>(blobMapped.as<const float*>() + batch_index * vector_size));
+            if (outp_shape != cv::Size())
+                blob_wrapper = blob_wrapper.reshape(1, {outp_shape.height, outp_shape.width});
+            blob_wrapper.copyTo(vectors->at(image_index));
         }
     };
     InferBatch(images, results_fetcher);
@@ -0,0 +1,206 @@
+// Copyright (C) 2021 Intel Corporation
+// SPDX-License-Identifier: Apache-2.0
+//
+
+#include "gallery_cache.hpp"
+
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <stdexcept>
+
+#ifndef _WIN32
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+namespace {
+const char kMagic[8] = {'F', 'G', 'C', 'A', 'C', 'H', 'E', '1'};
+const size_t kAlignment = 64;
+
+// The layout has only fixed-size fields, strings are stored after the table
+struct CacheHeader {
+    char magic[8];
+    uint64_t settings_hash;
+    uint64_t entries_num;
+    uint64_t rows;
+    uint64_t cols;
+    uint64_t strings_offset;
+    uint64_t strings_size;
+    uint64_t embeddings_offset;
+};
+
+struct CacheEntry {
+    uint64_t image_hash;
+    uint64_t label_offset;  // in the strings block
+    uint64_t label_size;
+    int64_t row;
+};
+
+size_t AlignUp(size_t value) {
+    return (value + kAlignment - 1) / kAlignment * kAlignment;
+}
+}  // namespace
+
+uint64_t HashBytes(const void* data, size_t size, uint64_t seed) {
+    // FNV-1a
+    const unsigned char* bytes = static_cast<const unsigned char*>(data);
+    uint64_t hash = seed;
+    for (size_t i = 0; i < size; i++) {
+        hash ^= bytes[i];
+        hash *= 1099511628211ull;
+    }
+    return hash;
+}
+
+MappedFile::~MappedFile() {
+    Close();
+}
+
+bool MappedFile::Open(const std::string& path) {
+    Close();
+#ifndef _WIN32
+    int fd = open(path.c_str(), O_RDONLY);
+    if (fd < 0)
+        return false;
+    struct stat sb;
+    if (fstat(fd, &sb) != 0) {
+        close(fd);
+        return false;
+    }
+    size_ = static_cast<size_t>(sb.st_size);
+    if (size_ == 0) {
+        close(fd);
+        return true;
+    }
+    void* mapping = mmap(nullptr, size_, PROT_READ, MAP_PRIVATE, fd, 0);
+    close(fd);
+    if (mapping == MAP_FAILED) {
+        size_ = 0;
+        return false;
+    }
+    data_ = static_cast<const char*>(mapping);
+    mapped_ = true;
+    return true;
+#else
+    std::ifstream file(path, std::ios::binary | std::ios::ate);
+    if (!file)
+        return false;
+    buffer_.resize(static_cast<size_t>(file.tellg()));
+    file.seekg(0);
+    if (!file.read(buffer_.data(), buffer_.size()))
+        return false;
+    data_ = buffer_.data();
+    size_ = buffer_.size();
+    return true;
+#endif
+}
+
+void MappedFile::Close() {
+#ifndef _WIN32
+    if (mapped_)
+        munmap(const_cast<char*>(data_), size_);
+#endif
+    mapped_ = false;
+    buffer_.clear();
+    data_ = nullptr;
+    size_ = 0;
+}
+
+bool GalleryCache::Load(const std::string& path, uint64_t settings_hash, size_t embedding_size) {
+    entries_.clear();
+    entries_by_hash_.clear();
+    embeddings_ = cv::Mat();
+    if (!file_.Open(path))
+        return false;
+
+    CacheHeader header;
+    if (file_.size() < sizeof(header))
+        return false;
+    std::memcpy(&header, file_.data(), sizeof(header));
+    const uint64_t table_end = sizeof(header) + header.entries_num * sizeof(CacheEntry);
+    if (std::memcmp(header.magic, kMagic, sizeof(kMagic)) != 0
+            || header.settings_hash != settings_hash
+            || (header.rows > 0 && header.cols != embedding_size)
+            || header.entries_num > file_.size() / sizeof(CacheEntry)
+            || header.strings_offset < table_end
+            || header.strings_offset + header.strings_size > file_.size()
+            || header.embeddings_offset % kAlignment != 0
+            || header.embeddings_offset > file_.size()
+            || header.rows * header.cols > (file_.size() - header.embeddings_offset) / sizeof(float)) {
+        file_.Close();
+        return false;
+    }
+
+    const char* strings = file_.data() + header.strings_offset;
+    entries_.reserve(header.entries_num);
+    for (uint64_t i = 0; i < header.entries_num; i++) {
+        CacheEntry entry;
+        std::memcpy(&entry, file_.data() + sizeof(header) + i * sizeof(CacheEntry), sizeof(entry));
+        if (entry.label_offset + entry.label_size > header.strings_size
+                || entry.row >= static_cast<int64_t>(header.rows)) {
+            entries_.clear();
+            file_.Close();
+            return false;
+        }
+        entries_.push_back({entry.image_hash, std::string(strings + entry.label_offset, entry.label_size),
+                            static_cast<int>(entry.row)});
+        entries_by_hash_.emplace(entry.image_hash, i);
+    }
+    if (header.rows > 0) {
+        embeddings_ = cv::Mat(static_cast<int>(header.rows), static_cast<int>(header.cols), CV_32F,
+                              const_cast<char*>(file_.data() + header.embeddings_offset));
+    }
+    return true;
+}
+
+const GalleryCache::Entry* GalleryCache::Find(uint64_t image_hash) const {
+    auto it = entries_by_hash_.find(image_hash);
+    return it != entries_by_hash_.end() ? &entries_[it->second] : nullptr;
+}
+
+void GalleryCache::Save(const std::string& path, uint64_t settings_hash,
+                        const std::vector<Entry>& entries, const cv::Mat& embeddings) {
+    CV_Assert(embeddings.empty() || (embeddings.type() == CV_32F && embeddings.isContinuous()));
+
+    std::string strings;
+    std::vector<CacheEntry> table;
+    table.reserve(entries.size());
+    for (const auto& entry : entries) {
+        table.push_back({entry.image_hash, strings.size(), entry.label.size(), entry.row});
+        strings += entry.label;
+    }
+
+    CacheHeader header;
+    std::memcpy(header.magic, kMagic, sizeof(kMagic));
+    header.settings_hash = settings_hash;
+    header.entries_num = table.size();
+    header.rows = embeddings.rows;
+    header.cols = embeddings.cols;
+    header.strings_offset = sizeof(header) + table.size() * sizeof(CacheEntry);
+    header.strings_size = strings.size();
+    header.embeddings_offset = AlignUp(header.strings_offset + header.strings_size);
+
+    // The cache is written aside and renamed, so a mapped or a partially written file is never read
+    const std::string tmp_path = path + ".tmp";
+    {
+        std::ofstream file(tmp_path, std::ios::binary | std::ios::trunc);
+        if (!file)
+            throw std::runtime_error("Can't create faces gallery cache " + tmp_path);
+        file.write(reinterpret_cast<const char*>(&header), sizeof(header));
+        file.write(reinterpret_cast<const char*>(table.data()), table.size() * sizeof(CacheEntry));
+        file.write(strings.data(), strings.size());
+        const std::vector<char> padding(header.embeddings_offset - header.strings_offset - header.strings_size, 0);
+        file.write(padding.data(), padding.size());
+        file.write(reinterpret_cast<const char*>(embeddings.data), embeddings.total() * sizeof(float));
+        if (!file)
+            throw std::runtime_error("Can't write faces gallery cache " + tmp_path);
+    }
+#ifdef _WIN32
+    std::remove(path.c_str());
+#endif
+    if (std::rename(tmp_path.c_str(), path.c_str()) != 0)
+        throw std::runtime_error("Can't replace faces gallery cache " + path);
+}
@@ -0,0 +1,112 @@
+// Copyright (C) 2021 Intel Corporation
+// SPDX-License-Identifier: Apache-2.0
+//
+
+#include "gallery_index.hpp"
+
+#include <algorithm>
+#include <numeric>
+#include <vector>
+
+namespace {
+void KeepNearest(std::vector<GalleryIndex::Neighbour>* neighbours, int k) {
+    auto closer = [](const GalleryIndex::Neighbour& a, const GalleryIndex::Neighbour& b) {
+        return a.distance < b.distance || (a.distance == b.distance && a.row < b.row);
+    };
+    if (static_cast<int>(neighbours->size()) > k) {
+        std::partial_sort(neighbours->begin(), neighbours->begin() + k, neighbours->end(), closer);
+        neighbours->resize(k);
+    } else {
+        std::sort(neighbours->begin(), neighbours->end(), closer);
+    }
+}
+}  // namespace
+
+cv::Mat NormalizedRow(const cv::Mat& vector) {
+    cv::Mat row;
+    (vector.isContinuous() ? vector : vector.clone()).reshape(1, 1).convertTo(row, CV_32F);
+    double norm = cv::norm(row);
+    if (norm > 0)
+        row /= norm;
+    return row;
+}
+
+GalleryIndex::GalleryIndex(const cv::Mat& embeddings, int ivf_lists, int ivf_probes)
+    : probes_(std::max(ivf_probes, 1)) {
+    CV_Assert(embeddings.empty() || embeddings.type() == CV_32F);
+    // Searching all clusters is slower than the exact search
+    if (ivf_lists <= 1 || probes_ >= ivf_lists || embeddings.rows < ivf_lists) {
+        embeddings_ = embeddings;
+        return;
+    }
+
+    cv::Mat labels;
+    cv::kmeans(embeddings, ivf_lists, labels,
+               cv::TermCriteria(cv::TermCriteria::COUNT + cv::TermCriteria::EPS, 20, 1e-4),
+               1, cv::KMEANS_PP_CENTERS, centers_);
+    for (int i = 0; i < centers_.rows; i++) {
+        cv::Mat center = centers_.row(i);
+        double norm = cv::norm(center);
+        if (norm > 0)
+            center /= norm;
+    }
+
+    list_begins_.assign(ivf_lists + 1, 0);
+    for (int i = 0; i < labels.rows; i++) {
+        list_begins_[labels.at<int>(i) + 1]++;
+    }
+    std::partial_sum(list_begins_.begin(), list_begins_.end(), list_begins_.begin());
+    std::vector<int> positions(list_begins_.begin(), list_begins_.end() - 1);
+    rows_.resize(embeddings.rows);
+    embeddings_.create(embeddings.rows, embeddings.cols, CV_32F);
+    for (int i = 0; i < labels.rows; i++) {
+        int position = positions[labels.at<int>(i)]++;
+        rows_[position] = i;
+        embeddings.row(i).copyTo(embeddings_.row(position));
+    }
+}
+
+std::vector<std::vector<GalleryIndex::Neighbour>> GalleryIndex::Search(const cv::Mat& queries, int k) const {
+    std::vector<std::vector<Neighbour>> neighbours(queries.rows);
+    if (queries.empty() || embeddings_.empty() || k <= 0)
+        return neighbours;
+    CV_Assert(queries.type() == CV_32F && queries.cols == embeddings_.cols);
+
+    if (IsExact()) {
+        cv::Mat similarities;
+        cv::gemm(queries, embeddings_, 1, cv::noArray(), 0, similarities, cv::GEMM_2_T);
+        for (int q = 0; q < queries.rows; q++) {
+            const float* row = similarities.ptr<float>(q);
+            neighbours[q].reserve(similarities.cols);
+            for (int i = 0; i < similarities.cols; i++) {
+                neighbours[q].push_back({i, 1.f - row[i]});
+            }
+            KeepNearest(&neighbours[q], k);
+        }
+        return neighbours;
+    }
+
+    cv::Mat center_similarities;
+    cv::gemm(queries, centers_, 1, cv::noArray(), 0, center_similarities, cv::GEMM_2_T);
+    std::vector<int> lists(centers_.rows);
+    cv::Mat list_similarities;
+    for (int q = 0; q < queries.rows; q++) {
+        const float* row = center_similarities.ptr<float>(q);
+        std::iota(lists.begin(), lists.end(), 0);
+        std::partial_sort(lists.begin(), lists.begin() + probes_, lists.end(),
+                          [row](int a, int b) { return row[a] > row[b]; });
+        for (int p = 0; p < probes_; p++) {
+            const int begin = list_begins_[lists[p]];
+            const int end = list_begins_[lists[p] + 1];
+            if (begin == end)
+                continue;
+            cv::gemm(embeddings_.rowRange(begin, end), queries.row(q), 1, cv::noArray(), 0,
+                     list_similarities, cv::GEMM_2_T);
+            for (int i = begin; i < end; i++) {
+                neighbours[q].push_back({rows_[i], 1.f - list_similarities.at<float>(i - begin)});
+            }
+        }
+        KeepNearest(&neighbours[q], k);
+    }
+    return neighbours;
+}
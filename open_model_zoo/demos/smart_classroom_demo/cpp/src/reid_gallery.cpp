@@ -5,21 +5,25 @@
 #include "face_reid.hpp"
 #include "tracker.hpp"
 
+#include <algorithm>
 #include <fstream>
 #include <iostream>
+#include <iterator>
 #include <vector>
 #include <string>
 #include <limits>
 
 #include <opencv2/opencv.hpp>
 
+#include <utils/slog.hpp>
+
 namespace {
-    float ComputeReidDistance(const cv::Mat& descr1, const cv::Mat& descr2) {
-        float xy = static_cast<float>(descr1.dot(descr2));
-        float xx = static_cast<float>(descr1.dot(descr1));
-        float yy = static_cast<float>(descr2.dot(descr2));
-        float norm = sqrt(xx * yy) + 1e-6f;
-        return 1.0f - xy / norm;
+    // Cosine distance between unit vectors never exceeds it
+    const float kMaxReidDistance = 2.0f;
+
+    std::vector<uchar> read_file(const std::string& path) {
+        std::ifstream file(path, std::ios::binary);
+        return std::vector<uchar>(std::istreambuf_iterator<char>(file), std::istreambuf_iterator<char>());
     }
 
     bool file_exists(const std::string& name) {
@@ -51,16 +55,16 @@ const int EmbeddingsGallery::unknown_id = TrackedObject::UNKNOWN_LABEL_IDX;
 RegistrationStatus EmbeddingsGallery::RegisterIdentity(const std::string& identity_label,
                                                        const cv::Mat& image,
                                                        int min_size_fr, bool crop_gallery,
-                                                       detection::FaceDetection& detector,
+                                                       detection::FaceDetection* detector,
                                                        const VectorCNN& landmarks_det,
                                                        const VectorCNN& image_reid,
                                                        cv::Mat& embedding) {
     cv::Mat target = image;
     if (crop_gallery) {
-        detector.enqueue(image);
-        detector.submitRequest();
-        detector.wait();
-        detection::DetectedObjects faces = detector.fetchResults();
+        detector->enqueue(image);
+        detector->submitRequest();
+        detector->wait();
+        detection::DetectedObjects faces = detector->fetchResults();
         if (faces.size() == 0) {
             return RegistrationStatus::FAILURE_NOT_DETECTED;
         }
@@ -85,13 +89,26 @@ EmbeddingsGallery::EmbeddingsGallery(const std::string& ids_list,
                                      bool crop_gallery, const detection::DetectorConfig &detector_config,
                                      const VectorCNN& landmarks_det,
                                      const VectorCNN& image_reid,
-                                     bool use_greedy_matcher)
+                                     bool use_greedy_matcher,
+                                     const EmbeddingsGalleryOptions& options)
     : reid_threshold(threshold), use_greedy_matcher(use_greedy_matcher) {
     if (ids_list.empty()) {
         return;
     }
 
-    detection::FaceDetection detector(detector_config);
+    const std::string settings = options.cache_key + '\n' + std::to_string(crop_gallery) + '\n'
+        + std::to_string(min_size_fr);
+    const uint64_t settings_hash = HashBytes(settings.data(), settings.size());
+    const bool use_cache = !options.cache_path.empty();
+    const bool is_cache_loaded = use_cache && cache.Load(options.cache_path, settings_hash, image_reid.VectorSize());
+
+    // The detector is loaded only if some image isn't cached
+    std::unique_ptr<detection::FaceDetection> detector;
+    std::vector<GalleryCache::Entry> entries;
+    std::vector<cv::Mat> rows;
+    bool is_cache_changed = !is_cache_loaded;
+    bool are_rows_cached_in_order = is_cache_loaded;
+    size_t cached_images_num = 0;
 
     cv::FileStorage fs(ids_list, cv::FileStorage::Mode::READ);
     cv::FileNode fn = fs.root();
@@ -99,7 +116,6 @@ EmbeddingsGallery::EmbeddingsGallery(const std::string& ids_list,
     for (cv::FileNodeIterator fit = fn.begin(); fit != fn.end(); ++fit) {
         cv::FileNode item = *fit;
         std::string label = item.name();
-        std::vector<cv::Mat> embeddings;
 
         // Please, note that the case when there are more than one image in gallery
         // for a person might not work properly with the current implementation
@@ -115,43 +131,109 @@ EmbeddingsGallery::EmbeddingsGallery(const std::string& ids_list,
                 path = folder_name(ids_list) + separator() + item[i].string();
             }
 
-            cv::Mat image = cv::imread(path);
-            CV_Assert(!image.empty());
+            std::vector<uchar> image_data = read_file(path);
+            CV_Assert(!image_data.empty());
+            const uint64_t image_hash = HashBytes(image_data.data(), image_data.size());
+            const GalleryCache::Entry* cached = is_cache_loaded ? cache.Find(image_hash) : nullptr;
             cv::Mat emb;
-            RegistrationStatus status = RegisterIdentity(label, image, min_size_fr, crop_gallery,  detector, landmarks_det, image_reid, emb);
-            if (status == RegistrationStatus::SUCCESS) {
-                embeddings.push_back(emb);
+            bool is_registered;
+            if (cached) {
+                is_registered = cached->row >= 0;
+                if (is_registered) {
+                    emb = cache.Embeddings().row(cached->row);
+                    are_rows_cached_in_order = are_rows_cached_in_order
+                        && cached->row == static_cast<int>(rows.size());
+                }
+                cached_images_num++;
+            } else {
+                cv::Mat image = cv::imdecode(image_data, cv::IMREAD_COLOR);
+                CV_Assert(!image.empty());
+                if (crop_gallery && !detector) {
+                    detector.reset(new detection::FaceDetection(detector_config));
+                }
+                RegistrationStatus status = RegisterIdentity(label, image, min_size_fr, crop_gallery, detector.get(), landmarks_det, image_reid, emb);
+                is_registered = status == RegistrationStatus::SUCCESS;
+                if (is_registered) {
+                    emb = NormalizedRow(emb);
+                }
+                is_cache_changed = true;
+            }
+
+            entries.push_back({image_hash, label, is_registered ? static_cast<int>(rows.size()) : -1});
+            if (is_registered) {
+                rows.push_back(emb);
                 idx_to_id.push_back(id);
-                identities.emplace_back(embeddings, label, id);
+                identities.emplace_back(std::vector<cv::Mat>(), label, id);
                 ++id;
             }
         }
     }
+    is_cache_changed = is_cache_changed || entries.size() != cache.Size();
+
+    if (!is_cache_changed && are_rows_cached_in_order && static_cast<int>(rows.size()) == cache.Embeddings().rows) {
+        embeddings_matrix = cache.Embeddings();
+    } else if (!rows.empty()) {
+        cv::vconcat(rows, embeddings_matrix);
+    }
+    for (size_t i = 0; i < identities.size(); i++) {
+        identities[i].embeddings = {embeddings_matrix.row(static_cast<int>(i))};
+    }
+
+    if (use_cache) {
+        slog::info << "Faces gallery: " << cached_images_num << " of " << entries.size()
+                   << " images are loaded from the cache" << slog::endl;
+        if (is_cache_changed) {
+            try {
+                GalleryCache::Save(options.cache_path, settings_hash, entries, embeddings_matrix);
+            } catch (const std::exception& e) {
+                slog::warn << e.what() << slog::endl;
+            }
+        }
+    }
+    index.reset(new GalleryIndex(embeddings_matrix, options.ivf_lists, options.ivf_probes));
 }
 
 std::vector<int> EmbeddingsGallery::GetIDsByEmbeddings(const std::vector<cv::Mat>& embeddings) const {
     if (embeddings.empty() || idx_to_id.empty())
         return std::vector<int>(embeddings.size(), unknown_id);
 
-    cv::Mat distances(static_cast<int>(embeddings.size()), static_cast<int>(idx_to_id.size()), CV_32F);
+    cv::Mat queries(static_cast<int>(embeddings.size()), embeddings_matrix.cols, CV_32F);
+    for (int i = 0; i < queries.rows; i++) {
+        CV_Assert(static_cast<int>(embeddings[i].total()) == queries.cols);
+        NormalizedRow(embeddings[i]).copyTo(queries.row(i));
+    }
 
-    for (int i = 0; i < distances.rows; i++) {
-        int k = 0;
-        for (size_t j = 0; j < identities.size(); j++) {
-            for (const auto& reference_emb : identities[j].embeddings) {
-                distances.at<float>(i, k) = ComputeReidDistance(embeddings[i], reference_emb);
-                k++;
-            }
+    // In an optimal assignment of n faces every face gets one of its n nearest gallery embeddings,
+    // otherwise the face could take one of the nearer free embeddings. So with the exact index
+    // the assignment is solved only for short-listed embeddings without loss
+    const auto neighbours = index->Search(queries, queries.rows);
+    std::vector<int> candidates;
+    for (const auto& face_neighbours : neighbours) {
+        for (const auto& neighbour : face_neighbours) {
+            candidates.push_back(neighbour.row);
+        }
+    }
+    std::sort(candidates.begin(), candidates.end());
+    candidates.erase(std::unique(candidates.begin(), candidates.end()), candidates.end());
+    if (candidates.empty())
+        return std::vector<int>(embeddings.size(), unknown_id);
+
+    cv::Mat distances(queries.rows, static_cast<int>(candidates.size()), CV_32F, cv::Scalar(kMaxReidDistance));
+    for (int i = 0; i < queries.rows; i++) {
+        for (const auto& neighbour : neighbours[i]) {
+            auto col = std::lower_bound(candidates.begin(), candidates.end(), neighbour.row) - candidates.begin();
+            distances.at<float>(i, static_cast<int>(col)) = neighbour.distance;
         }
     }
     KuhnMunkres matcher(use_greedy_matcher);
     auto matched_idx = matcher.Solve(distances);
     std::vector<int> output_ids;
     for (auto col_idx : matched_idx) {
-        if (distances.at<float>(output_ids.size(), col_idx) > reid_threshold)
+        if (col_idx >= candidates.size()
+                || distances.at<float>(static_cast<int>(output_ids.size()), static_cast<int>(col_idx)) > reid_threshold)
             output_ids.push_back(unknown_id);
         else
-            output_ids.push_back(idx_to_id[col_idx]);
+            output_ids.push_back(idx_to_id[candidates[col_idx]]);
     }
     return output_ids;
 }
@@ -66,7 +66,7 @@ void Tracker::SolveAssignmentProblem(
     cv::Mat dissimilarity;
     ComputeDissimilarityMatrix(track_ids, detections, &dissimilarity);
 
-    auto res = KuhnMunkres().Solve(dissimilarity);
+    auto res = assignment_solver_.Solve(dissimilarity);
 
     for (size_t i = 0; i < detections.size(); i++) {
         unmatched_detections->insert(i);
@@ -321,6 +321,7 @@ bool Drawer::isReady() {
         if (std::chrono::steady_clock::now() - prevShow > showPeriod) {
             return true;
         } else {
+            tryNotifyAt(context.drawersContext.drawersWorker, prevShow + showPeriod);
             return false;
         }
     } else {
@@ -334,10 +335,12 @@ bool Drawer::isReady() {
             }
         } else {
             if (1u == gridMatIt->second.getUnupdatedSourceIDs().size()) {
-                if (context.drawersContext.lastShownframeId == sharedVideoFrame->frameId
-                    && std::chrono::steady_clock::now() - prevShow > showPeriod) {
+                if (context.drawersContext.lastShownframeId != sharedVideoFrame->frameId) {
+                    return false;
+                } else if (std::chrono::steady_clock::now() - prevShow > showPeriod) {
                     return true;
                 } else {
+                    tryNotifyAt(context.drawersContext.drawersWorker, prevShow + showPeriod);
                     return false;
                 }
             } else {
@@ -517,6 +520,8 @@ void DetectionsProcessor::process() {
                                     classifiersAggregator->push(TrackableObject{rect,
                                             std::move(result), {rect.x + rect.width / 2, rect.y + rect.height } });
                                     context.reidInfers.inferRequests.lockedPushBack(reidRequest);
+                                    // The request may be what a parked DetectionsProcessor waits for
+                                    tryNotify(context.detectionsProcessorsContext.reidTasksWorker);
                             },
                             classifiersAggregator, std::ref(reidRequest), personRect, std::ref(context)));
 
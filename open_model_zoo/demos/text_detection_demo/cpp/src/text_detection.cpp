@@ -5,72 +5,154 @@
 #include "text_detection.hpp"
 
 #include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <limits>
+#include <numeric>
 #include <string>
-#include <unordered_map>
 #include <vector>
 
 namespace {
-void softmax(std::vector<float>* data) {
-    auto &rdata = *data;
-    const size_t last_dim = 2;
-    for (size_t i = 0; i < rdata.size(); i += last_dim) {
-       float m = std::max(rdata[i], rdata[i+1]);
-       rdata[i] = std::exp(rdata[i] - m);
-       rdata[i + 1] = std::exp(rdata[i + 1] - m);
-       float s = rdata[i] + rdata[i + 1];
-       rdata[i] /= s;
-       rdata[i + 1] /= s;
-    }
+// Output blobs of PixelLink are NCHW pairs of logits. softmax(c0, c1)[1] >= t is the same as
+// c1 - c0 >= log(t / (1 - t)), so probabilities are never computed
+float logitThreshold(float probability_threshold) {
+    if (probability_threshold <= 0.f)
+        return -std::numeric_limits<float>::infinity();
+    if (probability_threshold >= 1.f)
+        return std::numeric_limits<float>::infinity();
+    return std::log(probability_threshold / (1.f - probability_threshold));
 }
 
-std::vector<float> transpose4d(const std::vector<float>& data, const std::vector<size_t> &shape,
-                               const std::vector<size_t> &axes) {
-    if (shape.size() != axes.size())
-        throw std::runtime_error("Shape and axes must have the same dimension.");
-
-    for (size_t a : axes) {
-        if (a >= shape.size())
-            throw std::runtime_error("Axis must be less than dimension of shape.");
+// Disjoint-set forest over all pixels of the output grid with union by rank and full path compression
+class DisjointSets {
+public:
+    explicit DisjointSets(int size) : parents(size), ranks(size, 0) {
+        std::iota(parents.begin(), parents.end(), 0);
     }
 
-    size_t total_size = shape[0] * shape[1] * shape[2] * shape[3];
-
-    std::vector<size_t> steps{shape[axes[1]] * shape[axes[2]] * shape[axes[3]],
-                shape[axes[2]] * shape[axes[3]], shape[axes[3]], 1};
+    int findRoot(int node) {
+        int root = node;
+        while (parents[root] != root) {
+            root = parents[root];
+        }
+        while (parents[node] != root) {
+            int next = parents[node];
+            parents[node] = root;
+            node = next;
+        }
+        return root;
+    }
 
-    size_t source_data_idx = 0;
-    std::vector<float> new_data(total_size, 0);
+    void join(int node1, int node2) {
+        int root1 = findRoot(node1);
+        int root2 = findRoot(node2);
+        if (root1 == root2)
+            return;
+        if (ranks[root1] < ranks[root2])
+            std::swap(root1, root2);
+        parents[root2] = root1;
+        if (ranks[root1] == ranks[root2])
+            ranks[root1]++;
+    }
 
-    std::vector<size_t> ids(shape.size());
-    for (ids[0] = 0; ids[0] < shape[0]; ids[0]++) {
-        for (ids[1] = 0; ids[1] < shape[1]; ids[1]++) {
-            for (ids[2] = 0; ids[2] < shape[2]; ids[2]++) {
-                for (ids[3]= 0; ids[3] < shape[3]; ids[3]++) {
-                    size_t new_data_idx = ids[axes[0]] * steps[0] + ids[axes[1]] * steps[1] +
-                            ids[axes[2]] * steps[2] + ids[axes[3]] * steps[3];
-                    new_data[new_data_idx] = data[source_data_idx++];
+private:
+    std::vector<int> parents;
+    std::vector<uchar> ranks;
+};
+
+class PixelLinkDecoder {
+public:
+    PixelLinkDecoder(const float* cls_data, const float* link_data, int h, int w,
+                     float cls_conf_threshold, float link_conf_threshold)
+        : cls_data(cls_data), link_data(link_data), h(h), w(w), plane_size(size_t(h) * size_t(w)),
+          cls_logit_threshold(logitThreshold(cls_conf_threshold)),
+          link_logit_threshold(logitThreshold(link_conf_threshold)),
+          pixel_mask(plane_size), sets(h * w) {}
+
+    // Pixels of every strip of rows are joined in parallel, then links crossing strip borders are joined
+    cv::Mat decode() {
+        const int kMinStripRows = 16;
+        const int strips = std::max(1, std::min(cv::getNumThreads(), h / kMinStripRows));
+        cv::parallel_for_(cv::Range(0, strips), [&](const cv::Range& range) {
+            for (int strip = range.start; strip < range.end; strip++) {
+                const int begin = stripBegin(strip, strips);
+                const int end = stripBegin(strip + 1, strips);
+                for (int y = begin; y < end; y++) {
+                    for (int x = 0; x < w; x++) {
+                        size_t i = size_t(y) * size_t(w) + size_t(x);
+                        pixel_mask[i] = cls_data[plane_size + i] - cls_data[i] >= cls_logit_threshold;
+                    }
+                }
+                for (int y = begin; y < end; y++) {
+                    joinNeighbours(y, begin, end);
                 }
             }
+        });
+        for (int strip = 1; strip < strips; strip++) {
+            const int border = stripBegin(strip, strips);
+            joinNeighbours(border - 1, border, border + 1);
+            joinNeighbours(border, border - 1, border);
         }
+        return getLabels();
     }
-    return new_data;
-}
 
-std::vector<size_t> ieSizeToVector(const InferenceEngine::SizeVector& ie_output_dims) {
-    std::vector<size_t> blob_sizes(ie_output_dims.size(), 0);
-    for (size_t i = 0; i < blob_sizes.size(); ++i) {
-        blob_sizes[i] = ie_output_dims[i];
+private:
+    const float* cls_data;
+    const float* link_data;
+    const int h;
+    const int w;
+    const size_t plane_size;
+    const float cls_logit_threshold;
+    const float link_logit_threshold;
+    std::vector<uchar> pixel_mask;
+    DisjointSets sets;
+
+    int stripBegin(int strip, int strips) const {
+        return static_cast<int>(static_cast<int64_t>(h) * strip / strips);
+    }
+
+    // Joins text pixels of row y with linked text pixels among their 8 neighbours which rows are in
+    // [row_begin, row_end). Neighbours are numbered row by row, so link k is in channels 2k and 2k + 1
+    void joinNeighbours(int y, int row_begin, int row_end) {
+        for (int x = 0; x < w; x++) {
+            size_t i = size_t(y) * size_t(w) + size_t(x);
+            if (!pixel_mask[i])
+                continue;
+            size_t neighbour = 0;
+            for (int ny = y - 1; ny <= y + 1; ny++) {
+                for (int nx = x - 1; nx <= x + 1; nx++) {
+                    if (nx == x && ny == y) continue;
+                    if (nx >= 0 && nx < w && ny >= row_begin && ny < row_end) {
+                        size_t ni = size_t(ny) * size_t(w) + size_t(nx);
+                        if (pixel_mask[ni] && link_data[(2 * neighbour + 1) * plane_size + i]
+                                - link_data[2 * neighbour * plane_size + i] >= link_logit_threshold) {
+                            sets.join(static_cast<int>(i), static_cast<int>(ni));
+                        }
+                    }
+                    neighbour++;
+                }
+            }
+        }
     }
-    return blob_sizes;
-}
 
-std::vector<float> sliceAndGetSecondChannel(const std::vector<float> &data) {
-    std::vector<float> new_data(data.size() / 2, 0);
-    for (size_t i = 0; i < data.size() / 2; i++) {
-      new_data[i] = data[2 * i + 1];
+    // Components are numbered from 1 in the order of their first pixels
+    cv::Mat getLabels() {
+        cv::Mat mask(h, w, CV_32S, cv::Scalar(0));
+        std::vector<int> root_labels(plane_size, 0);
+        int labels_num = 0;
+        int* labels = mask.ptr<int>();
+        for (size_t i = 0; i < plane_size; i++) {
+            if (!pixel_mask[i])
+                continue;
+            int& root_label = root_labels[sets.findRoot(static_cast<int>(i))];
+            if (root_label == 0) {
+                root_label = ++labels_num;
+            }
+            labels[i] = root_label;
+        }
+        return mask;
     }
-    return new_data;
-}
+};
 
 std::vector<cv::RotatedRect> maskToBoxes(const cv::Mat &mask, float min_area, float min_height,
                                          const cv::Size &image_size) {
@@ -128,86 +210,6 @@ std::vector<cv::RotatedRect> coordToBoxes(const float* coords,
     return bboxes;
 }
 
-int findRoot(int point, std::unordered_map<int, int> *group_mask) {
-    int root = point;
-    bool update_parent = false;
-    while (group_mask->at(root) != -1) {
-        root = group_mask->at(root);
-        update_parent = true;
-    }
-    if (update_parent) {
-       (*group_mask)[point] = root;
-    }
-    return root;
-}
-
-void join(int p1, int p2, std::unordered_map<int, int> *group_mask) {
-    int root1 = findRoot(p1, group_mask);
-    int root2 = findRoot(p2, group_mask);
-    if (root1 != root2) {
-        (*group_mask)[root1] = root2;
-    }
-}
-
-cv::Mat get_all(const std::vector<cv::Point> &points, int w, int h,
-                std::unordered_map<int, int> *group_mask) {
-    std::unordered_map<int, int> root_map;
-
-    cv::Mat mask(h, w, CV_32S, cv::Scalar(0));
-    for (const auto &point : points) {
-        int point_root = findRoot(point.x + point.y * w, group_mask);
-        if (root_map.find(point_root) == root_map.end()) {
-            root_map.emplace(point_root, static_cast<int>(root_map.size() + 1));
-        }
-        mask.at<int>(point.x + point.y * w) = root_map[point_root];
-    }
-
-    return mask;
-}
-
-cv::Mat decodeImageByJoin(const std::vector<float> &cls_data, const std::vector<int> & cls_data_shape,
-                          const std::vector<float> &link_data, const std::vector<int> & link_data_shape,
-                          float cls_conf_threshold, float link_conf_threshold) {
-    int h = cls_data_shape[1];
-    int w = cls_data_shape[2];
-
-    std::vector<uchar> pixel_mask(h * w, 0);
-    std::unordered_map<int, int> group_mask;
-    std::vector<cv::Point> points;
-    for (size_t i = 0; i < pixel_mask.size(); i++) {
-        pixel_mask[i] = cls_data[i] >= cls_conf_threshold;
-        if (pixel_mask[i]) {
-            points.emplace_back(i % w, i / w);
-            group_mask[i] = -1;
-        }
-    }
-
-    std::vector<uchar> link_mask(link_data.size(), 0);
-    for (size_t i = 0; i < link_mask.size(); i++) {
-        link_mask[i] = link_data[i] >= link_conf_threshold;
-    }
-
-    size_t neighbours = size_t(link_data_shape[3]);
-    for (const auto &point : points) {
-        size_t neighbour = 0;
-        for (int ny = point.y - 1; ny <= point.y + 1; ny++) {
-            for (int nx = point.x - 1; nx <= point.x + 1; nx++) {
-                if (nx == point.x && ny == point.y) continue;
-                if (nx >= 0 && nx < w && ny >= 0 && ny < h) {
-                    uchar pixel_value = pixel_mask[size_t(ny) * size_t(w) + size_t(nx)];
-                    uchar link_value = link_mask[
-                        (size_t(point.y) * size_t(w) + size_t(point.x)) * neighbours + neighbour];
-                    if (pixel_value && link_value) {
-                        join(point.x + point.y * w, nx + ny * w, &group_mask);
-                    }
-                }
-                neighbour++;
-            }
-        }
-    }
-
-    return get_all(points, w, h, &group_mask);
-}
 }  // namespace
 
 std::vector<cv::RotatedRect> postProcess(const InferenceEngine::BlobMap &blobs,
@@ -229,36 +231,18 @@ std::vector<cv::RotatedRect> postProcess(const InferenceEngine::BlobMap &blobs,
     if (!kLocOutputName.empty() && !kClsOutputName.empty()) {
         // PostProcessing for PixelLink Text Detection model
         auto link_shape = blobs.at(kLocOutputName)->getTensorDesc().getDims();
-        size_t link_data_size = link_shape[0] * link_shape[1] * link_shape[2] * link_shape[3];
         InferenceEngine::LockedMemory<const void> locOutputMapped = InferenceEngine::as<InferenceEngine::MemoryBlob>(
             blobs.at(kLocOutputName))->rmap();
-        float *link_data_pointer = locOutputMapped.as<float *>();
-        std::vector<float> link_data(link_data_pointer, link_data_pointer + link_data_size);
-        link_data = transpose4d(link_data, ieSizeToVector(link_shape), {0, 2, 3, 1});
-        softmax(&link_data);
-        link_data = sliceAndGetSecondChannel(link_data);
-        std::vector<int> new_link_data_shape(4);
-        new_link_data_shape[0] = static_cast<int>(link_shape[0]);
-        new_link_data_shape[1] = static_cast<int>(link_shape[2]);
-        new_link_data_shape[2] = static_cast<int>(link_shape[3]);
-        new_link_data_shape[3] = static_cast<int>(link_shape[1]) / 2;
-
         auto cls_shape = blobs.at(kClsOutputName)->getTensorDesc().getDims();
-        size_t cls_data_size = cls_shape[0] * cls_shape[1] * cls_shape[2] * cls_shape[3];
         InferenceEngine::LockedMemory<const void> clsOutputMapped = InferenceEngine::as<InferenceEngine::MemoryBlob>(
             blobs.at(kClsOutputName))->rmap();
-        float *cls_data_pointer = clsOutputMapped.as<float *>();
-        std::vector<float> cls_data(cls_data_pointer, cls_data_pointer + cls_data_size);
-        cls_data = transpose4d(cls_data, ieSizeToVector(cls_shape), {0, 2, 3, 1});
-        softmax(&cls_data);
-        cls_data = sliceAndGetSecondChannel(cls_data);
-        std::vector<int> new_cls_data_shape(4);
-        new_cls_data_shape[0] = static_cast<int>(cls_shape[0]);
-        new_cls_data_shape[1] = static_cast<int>(cls_shape[2]);
-        new_cls_data_shape[2] = static_cast<int>(cls_shape[3]);
-        new_cls_data_shape[3] = static_cast<int>(cls_shape[1]) / 2;
+        if (link_shape[2] != cls_shape[2] || link_shape[3] != cls_shape[3])
+            throw std::runtime_error("PixelLink outputs are expected to have the same spatial size");
 
-        cv::Mat mask = decodeImageByJoin(cls_data, new_cls_data_shape, link_data, new_link_data_shape, cls_conf_threshold, link_conf_threshold);
+        PixelLinkDecoder decoder(clsOutputMapped.as<const float *>(), locOutputMapped.as<const float *>(),
+                                 static_cast<int>(cls_shape[2]), static_cast<int>(cls_shape[3]),
+                                 cls_conf_threshold, link_conf_threshold);
+        cv::Mat mask = decoder.decode();
         std::vector<cv::RotatedRect> rects = maskToBoxes(mask, static_cast<float>(kMinArea),
                                                          static_cast<float>(kMinHeight), image_size);
         return rects;